@@ -26,6 +26,7 @@
 #include "p64_hashtable.h"
 #include "p64_hopscotch.h"
 #include "p64_cuckooht.h"
+#include "p64_cuckookv_template.h"
 #include "build_config.h"
 #include "common.h"
 #include "arch.h"
@@ -39,6 +40,9 @@
 
 #define MAXVECSIZE 32
 
+//Cuckoo hash table with inline keys, the value is the key itself
+P64_CUCKOOKV(kvtab, uint32_t)
+
 enum operation { Insert, Remove, LookupHit, LookupMiss, TheBeyond };
 
 struct object
@@ -65,7 +69,11 @@ static struct object *OBJS;//Array of all objects
 static uint64_t THREAD_BARRIER ALIGNED(CACHE_LINE);
 static bool HOPSCOTCH = false;
 static bool CUCKOOHT = false;
+static bool CUCKOOKV = false;
+static bool RESIZE = false;
+static bool COMPACT = false;
 static bool VERBOSE = false;
+static bool STATS = false;
 static sem_t ALL_DONE ALIGNED(CACHE_LINE);
 static struct timespec END_TIME;
 
@@ -162,10 +170,13 @@ thr_insert(uint32_t tidx)
 	{
 	    success = p64_cuckooht_insert(HT, &obj->ce, hash);
 	}
+	else if (CUCKOOKV)
+	{
+	    success = kvtab_insert(HT, &key, hash, key);
+	}
 	else
 	{
-	    p64_hashtable_insert(HT, &obj->he, hash);
-	    success = true;
+	    success = p64_hashtable_insert(HT, &obj->he, hash);
 	}
 	if (!success)
 	{
@@ -203,6 +214,10 @@ thr_remove(uint32_t tidx)
 	{
 	    success = p64_cuckooht_remove(HT, &obj->ce, hash);
 	}
+	else if (CUCKOOKV)
+	{
+	    success = kvtab_remove(HT, &key, hash, NULL);
+	}
 	else
 	{
 	    success = p64_hashtable_remove(HT, &obj->he, hash);
@@ -215,6 +230,59 @@ thr_remove(uint32_t tidx)
     }
 }
 
+//Insert or remove consecutive keys in bursts of VECSIZE
+static void
+thr_update_vec(uint32_t tidx, bool insert)
+{
+    uint32_t vecsize = VECSIZE;
+    for (uint32_t i = tidx * vecsize; i < NUMKEYS; i += NUMTHREADS * vecsize)
+    {
+	uint32_t num = NUMKEYS - i < vecsize ? NUMKEYS - i : vecsize;
+	void *elems[MAXVECSIZE];
+	uintptr_t hashes[MAXVECSIZE];
+	bool success[MAXVECSIZE];
+	for (uint32_t j = 0; j < num; j++)
+	{
+	    struct object *obj = &OBJS[i + j];
+	    hashes[j] = compute_hash(obj->key);
+	    if (HOPSCOTCH)
+	    {
+		elems[j] = obj;
+	    }
+	    else if (CUCKOOHT)
+	    {
+		elems[j] = &obj->ce;
+	    }
+	    else
+	    {
+		elems[j] = &obj->he;
+	    }
+	}
+	uint32_t n;
+	if (HOPSCOTCH)
+	{
+	    n = insert ? p64_hopscotch_insert_vec(HT, num, elems, hashes, success)
+		       : p64_hopscotch_remove_vec(HT, num, elems, hashes, success);
+	}
+	else if (CUCKOOHT)
+	{
+	    n = insert ? p64_cuckooht_insert_vec(HT, num, (void *)elems, hashes, success)
+		       : p64_cuckooht_remove_vec(HT, num, (void *)elems, hashes, success);
+	}
+	else
+	{
+	    n = insert ? p64_hashtable_insert_vec(HT, num, (void *)elems, hashes, success)
+		       : p64_hashtable_remove_vec(HT, num, (void *)elems, hashes, success);
+	}
+	if (n != num)
+	{
+	    fprintf(stderr, "Failed to %s %u of %u keys\n",
+		    insert ? "insert" : "remove", num - n, num);
+	    exit(EXIT_FAILURE);
+	}
+    }
+}
+
 static void
 thr_lookup_hit(uint32_t tidx)
 {
@@ -243,6 +311,22 @@ thr_lookup_hit(uint32_t tidx)
 		    k[j] = i + j; //Keys are unique
 		    hashes[j] = compute_hash(k[j]);//Hashes may not be unique
 		}
+		if (CUCKOOKV)
+		{
+		    uintptr_t vals[MAXVECSIZE];
+		    bool hits[MAXVECSIZE];
+		    kvtab_lookup_vec(HT, vecsize, k, hashes, vals, hits);
+		    for (uint32_t j = 0; j < vecsize; j++)
+		    {
+			if (!hits[j] || vals[j] != k[j])
+			{
+			    fprintf(stderr, "Lookup failed to find key %u\n",
+				    k[j]);
+			    exit(EXIT_FAILURE);
+			}
+		    }
+		    continue;
+		}
 		if (HOPSCOTCH)
 		{
 		    p64_hopscotch_lookup_vec(HT, vecsize, keys, hashes, res);
@@ -293,6 +377,16 @@ thr_lookup_hit(uint32_t tidx)
 		struct object *obj = NULL;
 		uint32_t key = idx;//Keys are unique
 		uintptr_t hash = compute_hash(key);//Hashes may not be unique
+		if (CUCKOOKV)
+		{
+		    uintptr_t val;
+		    if (!kvtab_lookup(HT, &key, hash, &val) || val != key)
+		    {
+			fprintf(stderr, "Lookup failed to find key %u\n", key);
+			exit(EXIT_FAILURE);
+		    }
+		    continue;
+		}
 		if (HOPSCOTCH)
 		{
 		    //UBSAN complains if &hp is not specified
@@ -364,6 +458,17 @@ thr_lookup_miss(uint32_t tidx)
 		    k[j] = numkeys + i + j;
 		    hashes[j] = compute_hash(k[j]);//Hashes may not be unique
 		}
+		if (CUCKOOKV)
+		{
+		    uintptr_t vals[MAXVECSIZE];
+		    bool hits[MAXVECSIZE];
+		    if (kvtab_lookup_vec(HT, vecsize, k, hashes, vals, hits) != 0)
+		    {
+			fprintf(stderr, "Lookup non-existent key found something\n");
+			exit(EXIT_FAILURE);
+		    }
+		    continue;
+		}
 		if (HOPSCOTCH)
 		{
 		    p64_hopscotch_lookup_vec(HT, vecsize, keys, hashes, res);
@@ -393,6 +498,17 @@ thr_lookup_miss(uint32_t tidx)
 		struct object *obj = NULL;
 		uint32_t key = numkeys + idx;
 		uintptr_t hash = compute_hash(key);//Hashes may not be unique
+		if (CUCKOOKV)
+		{
+		    uintptr_t val;
+		    if (kvtab_lookup(HT, &key, hash, &val))
+		    {
+			fprintf(stderr, "Lookup non-existent key %u found key %lu\n",
+				key, val);
+			exit(EXIT_FAILURE);
+		    }
+		    continue;
+		}
 		if (HOPSCOTCH)
 		{
 		    //UBSAN complains if &hp is not specified
@@ -435,11 +551,25 @@ thr_execute(uint32_t tidx)
 {
     if (OPER == Insert)
     {
-	thr_insert(tidx);
+	if (VECSIZE != 0 && !CUCKOOKV)
+	{
+	    thr_update_vec(tidx, true);
+	}
+	else
+	{
+	    thr_insert(tidx);
+	}
     }
     else if (OPER == Remove)
     {
-	thr_remove(tidx);
+	if (VECSIZE != 0 && !CUCKOOKV)
+	{
+	    thr_update_vec(tidx, false);
+	}
+	else
+	{
+	    thr_remove(tidx);
+	}
     }
     else if (OPER == LookupHit)
     {
@@ -620,6 +750,47 @@ compare_ht_key(const p64_hashelem_t *he, const void *key)
     return obj->key - *(const uint32_t *)key;
 }
 
+static void
+print_stats(void)
+{
+    p64_hashstats_t st;
+    if (CUCKOOKV)
+    {
+	return;
+    }
+    //Reading the current table requires QSBR
+    p64_qsbr_register(QSBR);
+    if (HOPSCOTCH)
+    {
+	p64_hopscotch_stats(HT, &st);
+    }
+    else if (CUCKOOHT)
+    {
+	p64_cuckooht_stats(HT, &st);
+    }
+    else
+    {
+	p64_hashtable_stats(HT, &st);
+    }
+    p64_qsbr_unregister();
+    printf("nelems %"PRIu64", capacity %"PRIu64", load factor %.2f\n",
+	   st.nelems, st.capacity,
+	   st.capacity != 0 ? (double)st.nelems / st.capacity : 0.0);
+    printf("cellar %"PRIu64"/%"PRIu64"\n", st.cellar_used, st.cellar_size);
+    printf("lookups %"PRIu64" (misses %"PRIu64"), probes:",
+	   st.lookups, st.lookup_misses);
+    for (uint32_t i = 0; i < P64_HASHSTATS_NPROBES; i++)
+    {
+	printf(" %"PRIu64, st.probes[i]);
+    }
+    printf("\n");
+    printf("inserts %"PRIu64" (failed %"PRIu64"), "
+	   "removes %"PRIu64" (failed %"PRIu64")\n",
+	   st.inserts, st.insert_fails, st.removes, st.remove_fails);
+    printf("relocations %"PRIu64", CAS retries %"PRIu64"\n",
+	   st.relocations, st.cas_retries);
+}
+
 static int
 compare_hs_key(const void *he, const void *key)
 {
@@ -641,7 +812,7 @@ main(int argc, char *argv[])
     uint32_t numelems = NUMKEYS;
     uint32_t numcells = 0;
 
-    while ((c = getopt(argc, argv, "a:c:Cf:Hk:m:s:t:v:V")) != -1)
+    while ((c = getopt(argc, argv, "a:c:Cf:HKk:m:orSs:t:v:V")) != -1)
     {
 	switch (c)
 	{
@@ -688,6 +859,18 @@ main(int argc, char *argv[])
 	    case 'H' :
 		HOPSCOTCH = true;
 		break;
+	    case 'K' :
+		CUCKOOKV = true;
+		break;
+	    case 'o' :
+		COMPACT = true;
+		break;
+	    case 'r' :
+		RESIZE = true;
+		break;
+	    case 'S' :
+		STATS = true;
+		break;
 	    case 'k' :
 		{
 		    int nk = atoi(optarg);
@@ -732,10 +915,14 @@ usage :
 			"-C               Use cuckoo hash table\n"
 			"-f <cpufreq>     CPU frequency in kHz\n"
 			"-H               Use hopscotch hash table\n"
+			"-K               Use cuckoo hash table with inline keys\n"
 			"-k <numkeys>     Number of keys\n"
 			"-m <size>        Size of main hash table\n"
+			"-o               Use compact mode (michaelht only)\n"
+			"-r               Resize automatically (michaelht and cuckooht only)\n"
+			"-S               Collect and print statistics (not cuckookv)\n"
 			"-t <numthr>      Number of threads\n"
-			"-v <vecsize>     Use vector lookup\n"
+			"-v <vecsize>     Use vector lookup, insert and remove\n"
 			"-V               Verbose\n"
 		       );
 		exit(EXIT_FAILURE);
@@ -748,7 +935,9 @@ usage :
 
     printf("%s: main size %u, cellar size %u, %u keys, "
 	   "%u thread%s, affinity mask=0x%lx\n",
-	    HOPSCOTCH ? "hopscotch" : CUCKOOHT ? "cuckooht" : "michaelht",
+	    HOPSCOTCH ? "hopscotch" : CUCKOOHT ? "cuckooht" :
+	    CUCKOOKV ? "cuckookv" :
+	    COMPACT ? "michaelht (compact)" : "michaelht",
 	    numelems,
 	    numcells,
 	    NUMKEYS,
@@ -774,19 +963,31 @@ usage :
 
     if (HOPSCOTCH)
     {
-	HT = p64_hopscotch_alloc(numelems, numcells, compare_hs_key, 0);
+	HT = p64_hopscotch_alloc(numelems, numcells, compare_hs_key,
+				 STATS ? P64_HOPSCOTCH_F_STATS : 0);
 	if (HT == NULL)
 	    perror("p64_hopscotch_alloc"), abort();
     }
     else if (CUCKOOHT)
     {
-	HT = p64_cuckooht_alloc(numelems, numcells, compare_cc_key, 0);
+	HT = p64_cuckooht_alloc(numelems, numcells, compare_cc_key,
+				(RESIZE ? P64_CUCKOOHT_F_GROW : 0) |
+				(STATS ? P64_CUCKOOHT_F_STATS : 0));
 	if (HT == NULL)
 	    perror("p64_cuckooht_alloc"), abort();
     }
+    else if (CUCKOOKV)
+    {
+	HT = kvtab_alloc(numelems);
+	if (HT == NULL)
+	    perror("p64_cuckookv_alloc"), abort();
+    }
     else
     {
-	HT = p64_hashtable_alloc(numelems, compare_ht_key, 0);
+	HT = p64_hashtable_alloc(numelems, compare_ht_key,
+				 (RESIZE ? P64_HASHTAB_F_AUTORESIZE : 0) |
+				 (STATS ? P64_HASHTAB_F_STATS : 0) |
+				 (COMPACT ? P64_HASHTAB_F_COMPACT : 0));
 	if (HT == NULL)
 	    perror("p64_hashtable_alloc"), abort();
     }
@@ -797,6 +998,10 @@ usage :
 	benchmark(NUMTHREADS, Insert);
 	benchmark(NUMTHREADS, LookupHit);
 	benchmark(NUMTHREADS, LookupMiss);
+	if (STATS)
+	{
+	    print_stats();
+	}
 	if (VERBOSE)
 	{
 	    if (HOPSCOTCH)
@@ -811,6 +1016,10 @@ usage :
 	    }
 	}
 	benchmark(NUMTHREADS, Remove);
+	if (STATS)
+	{
+	    print_stats();
+	}
     }
 
     //Clean up
@@ -827,6 +1036,10 @@ usage :
     {
 	p64_cuckooht_free(HT);
     }
+    else if (CUCKOOKV)
+    {
+	kvtab_free(HT);
+    }
     else
     {
 	p64_hashtable_free(HT);
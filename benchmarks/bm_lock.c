@@ -420,8 +420,8 @@ restart:
     NUMFAILWR_RD[tidx] = numfailwr_rd;
     NUMMULTRD[tidx] = nummultrd;
     NUMOPSDONE[tidx] = lap;
-    free(clhnode);
-    free(rwclhnode);
+    p64_clhlock_free_node(clhnode);
+    p64_rwclhlock_free_node(rwclhnode);
 }
 
 static void *
@@ -23,6 +23,7 @@
 #include <unistd.h>
 
 #include "p64_ringbuf.h"
+#include "p64_ringbuf_template.h"
 #include "p64_lfring.h"
 #include "p64_buckring.h"
 #include "p64_stack.h"
@@ -583,6 +584,80 @@ static char *percent(uint32_t x, uint32_t y)
     }
 }
 
+/******************************************************************************
+ * Element size sweep using the ring buffer template
+ *****************************************************************************/
+
+#define SWEEP_BURST 32
+
+#define SWEEP_ELEM(_size) \
+struct desc##_size { uint64_t w[_size / 8]; }; \
+P64_RINGBUF(ringbuf##_size, struct desc##_size) \
+\
+static void \
+sweep##_size(uint32_t flags) \
+{ \
+    static struct desc##_size src[SWEEP_BURST], dst[SWEEP_BURST]; \
+    for (uint32_t i = 0; i < SWEEP_BURST; i++) \
+    { \
+	src[i].w[0] = i; \
+    } \
+    ringbuf##_size##_t *rb = ringbuf##_size##_alloc(RINGSIZE, flags); \
+    if (rb == NULL) \
+    { \
+	fprintf(stderr, "Failed to create ring buffer\n"); \
+	exit(EXIT_FAILURE); \
+    } \
+    uint32_t index; \
+    /* Offset enqueue and dequeue so that bursts wrap around the ring */ \
+    (void)ringbuf##_size##_enqueue(rb, src, SWEEP_BURST / 2); \
+    struct timespec ts; \
+    clock_gettime(CLOCK_MONOTONIC, &ts); \
+    uint64_t start = ts.tv_sec * 1000000000ULL + ts.tv_nsec; \
+    uint64_t numelems = (uint64_t)NUMLAPS * NUMELEMS; \
+    for (uint64_t n = 0; n < numelems; n += SWEEP_BURST) \
+    { \
+	if (ringbuf##_size##_enqueue(rb, src, SWEEP_BURST) != SWEEP_BURST || \
+	    ringbuf##_size##_dequeue(rb, dst, SWEEP_BURST, &index) != SWEEP_BURST) \
+	{ \
+	    fprintf(stderr, "Unexpected enqueue/dequeue failure\n"); \
+	    abort(); \
+	} \
+    } \
+    clock_gettime(CLOCK_MONOTONIC, &ts); \
+    uint64_t elapsed_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec - start; \
+    (void)ringbuf##_size##_dequeue(rb, dst, SWEEP_BURST, &index); \
+    ringbuf##_size##_free(rb); \
+    if (elapsed_ns == 0) \
+    { \
+	elapsed_ns = 1; \
+    } \
+    /* Each element is copied twice, into and out of the ring */ \
+    printf("%3u bytes: %"PRIu64".%02"PRIu64" ns/element, %"PRIu64" MB/s\n", \
+	   _size, \
+	   elapsed_ns / numelems, \
+	   (100 * elapsed_ns / numelems) % 100, \
+	   2 * numelems * _size * 1000 / elapsed_ns); \
+}
+
+SWEEP_ELEM(8)
+SWEEP_ELEM(16)
+SWEEP_ELEM(32)
+SWEEP_ELEM(64)
+SWEEP_ELEM(128)
+
+static void
+sweep(uint32_t flags)
+{
+    printf("Element size sweep, burst %u, %u elements\n",
+	   SWEEP_BURST, NUMLAPS * NUMELEMS);
+    sweep8(flags);
+    sweep16(flags);
+    sweep32(flags);
+    sweep64(flags);
+    sweep128(flags);
+}
+
 static void benchmark(uint32_t numthreads, uint64_t affinity)
 {
     struct timespec ts;
@@ -699,9 +774,10 @@ static void benchmark(uint32_t numthreads, uint64_t affinity)
 int main(int argc, char *argv[])
 {
     int rbmode = 0;
+    bool do_sweep = false;
     int c;
 
-    while ((c = getopt(argc, argv, "A:a:e:f:l:m:pr:t:T:vw:")) != -1)
+    while ((c = getopt(argc, argv, "A:a:e:f:l:m:pr:st:T:vw:")) != -1)
     {
 	switch (c)
 	{
@@ -766,6 +842,9 @@ int main(int argc, char *argv[])
 		    NUMRINGBUFS = (unsigned)numringbufs;
 		    break;
 		}
+	    case 's' :
+		do_sweep = true;
+		break;
 	    case 't' :
 		{
 		    int numthreads = atoi(optarg);
@@ -813,6 +892,7 @@ usage :
 			"-l <numlaps>     Number of laps\n"
 			"-m <mode>        Ring buffer mode\n"
 			"-r <numringbufs> Number of ring buffers\n"
+			"-s               Sweep element size (modes 0-5, single thread)\n"
 			"-t <numthr>      Number of threads\n"
 			"-T <numthr>      Iterate over 1..T number of threads\n"
 			"-v               Verbose\n"
@@ -920,6 +1000,21 @@ usage :
 	    NUMTHREADS != 1 ? "s" : "",
 	    AFFINITY);
 
+    if (do_sweep)
+    {
+	if (RING_IMPL != classic)
+	{
+	    fprintf(stderr, "Element size sweep requires mode 0-5\n");
+	    exit(EXIT_FAILURE);
+	}
+	uint32_t flags = 0;
+	flags |= (rbmode & 1) ? P64_RINGBUF_F_NBENQ : 0;
+	flags |= (rbmode & 2) ? P64_RINGBUF_F_NBDEQ : 0;
+	flags |= (rbmode & 4) ? P64_RINGBUF_F_LFDEQ : 0;
+	sweep(flags);
+	return 0;
+    }
+
     for (unsigned i = 0; i < NUMRAND; i += 2)
     {
 	unsigned r = rand();
@@ -22,6 +22,8 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "p64_ebr.h"
+#include "p64_hazardera.h"
 #include "p64_hazardptr.h"
 #include "p64_qsbr.h"
 #include "build_config.h"
@@ -46,11 +48,16 @@ xorshift64star(uint64_t xor_state[1])
 struct object
 {
     uint32_t idx;
+    uint64_t birth;//Birth era when using hazard eras
 } ALIGNED(CACHE_LINE);
 
+enum smr { SMR_HP, SMR_QSBR, SMR_EBR, SMR_HE };
+static const char *const smr_name[] = { "HP", "QSBR", "EBR", "HE" };
 
 static p64_hpdomain_t *HPDOM = NULL;
 static p64_qsbrdomain_t *QSBRDOM = NULL;
+static p64_ebrdomain_t *EBRDOM = NULL;
+static p64_hedomain_t *HEDOM = NULL;
 static pthread_t tid[MAXTHREADS];
 static uint32_t NUMTHREADS = 2;
 static int cpus[MAXTHREADS];
@@ -61,7 +68,7 @@ static uint32_t NUMOBJS = 100;
 static struct object *OBJS;//Array of all objects
 static struct object **TABLE;//Pointer to array of object pointers
 static uint64_t THREAD_BARRIER ALIGNED(CACHE_LINE);
-static bool USEHP = true;
+static enum smr SMR = SMR_HP;
 static bool VERBOSE = false;
 static sem_t ALL_DONE ALIGNED(CACHE_LINE);
 static struct timespec END_TIME;
@@ -141,6 +148,56 @@ callback(void *_obj)
     stack[stkptr++] = obj;
 }
 
+static void
+retire_object(struct object *obj)
+{
+    switch (SMR)
+    {
+	case SMR_HP :
+	    while (!p64_hazptr_retire(obj, callback))
+	    {
+		(void)p64_hazptr_reclaim();
+	    }
+	    break;
+	case SMR_QSBR :
+	    p64_qsbr_quiescent();
+	    while (!p64_qsbr_retire(obj, callback))
+	    {
+		(void)p64_qsbr_reclaim();
+	    }
+	    break;
+	case SMR_EBR :
+	    while (!p64_ebr_retire(obj, callback))
+	    {
+		(void)p64_ebr_reclaim();
+	    }
+	    break;
+	case SMR_HE :
+	    while (!p64_hazera_retire(obj, obj->birth, callback))
+	    {
+		(void)p64_hazera_reclaim();
+	    }
+	    break;
+    }
+}
+
+static uint32_t
+reclaim_objects(void)
+{
+    switch (SMR)
+    {
+	case SMR_HP :
+	    return p64_hazptr_reclaim();
+	case SMR_QSBR :
+	    return p64_qsbr_reclaim();
+	case SMR_EBR :
+	    return p64_ebr_reclaim();
+	case SMR_HE :
+	    return p64_hazera_reclaim();
+    }
+    return 0;
+}
+
 static void
 thr_execute(uint32_t tidx)
 {
@@ -159,26 +216,16 @@ thr_execute(uint32_t tidx)
 	    {
 		obj = stack[--stkptr];
 		obj->idx = idx;
+		if (SMR == SMR_HE)
+		{
+		    obj->birth = p64_hazera_birth();
+		}
 	    }
 	    obj = __atomic_exchange_n(&TABLE[idx], obj, __ATOMIC_ACQ_REL);
 	    if (obj != NULL)
 	    {
 		assert(obj->idx == idx);
-		if (USEHP)
-		{
-		    while(!p64_hazptr_retire(obj, callback))
-		    {
-			(void)p64_hazptr_reclaim();
-		    }
-		}
-		else
-		{
-		    p64_qsbr_quiescent();
-		    while (!p64_qsbr_retire(obj, callback))
-		    {
-			(void)p64_qsbr_reclaim();
-		    }
-		}
+		retire_object(obj);
 	    }
 	    else
 	    {
@@ -186,16 +233,9 @@ thr_execute(uint32_t tidx)
 	    }
 	    numwrites++;
 	    //Try to reclaim pending objects
-	    if (USEHP)
-	    {
-		(void)p64_hazptr_reclaim();
-	    }
-	    else
-	    {
-		(void)p64_qsbr_reclaim();
-	    }
+	    (void)reclaim_objects();
 	}
-	if (!USEHP)
+	if (SMR == SMR_QSBR)
 	{
 	    p64_qsbr_quiescent();
 	}
@@ -207,10 +247,7 @@ thr_execute(uint32_t tidx)
 	    //Clear stack to make room for more objects
 	    stkptr = 0;
 	    //Try to reclaim pending objects
-	    if (USEHP)
-		npend = p64_hazptr_reclaim();
-	    else
-		npend = p64_qsbr_reclaim();
+	    npend = reclaim_objects();
 	    //Break if there are no more remaining pending objects
 	    if (npend == 0)
 		break;
@@ -231,15 +268,20 @@ thr_execute(uint32_t tidx)
 	for (uint32_t lap = 0; lap < NUMLAPS; lap++)
 	{
 	    p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
+	    p64_hazardera_t he = P64_HAZARDERA_NULL;
 	    uint32_t idx;
 	    struct object *obj;
-	    if (!USEHP)
+	    if (SMR == SMR_QSBR)
 		p64_qsbr_acquire();
+	    else if (SMR == SMR_EBR)
+		p64_ebr_enter();
 	    do
 	    {
 		idx = xorshift64star(xor_state) % NUMOBJS;
-		if (USEHP)
+		if (SMR == SMR_HP)
 		    obj = p64_hazptr_acquire(&TABLE[idx], &hp);
+		else if (SMR == SMR_HE)
+		    obj = p64_hazera_acquire(&TABLE[idx], &he);
 		else
 		    obj = __atomic_load_n(&TABLE[idx], __ATOMIC_ACQUIRE);
 		if (obj == NULL)
@@ -256,20 +298,24 @@ thr_execute(uint32_t tidx)
 	    {
 		numfail++;
 	    }
-	    if (USEHP)
+	    if (SMR == SMR_HP)
 		p64_hazptr_release(&hp);
+	    else if (SMR == SMR_HE)
+		p64_hazera_release(&he);
+	    else if (SMR == SMR_EBR)
+		p64_ebr_exit();
 	    else
 		p64_qsbr_release();
 	    if (lap % 10 == 0)
 	    {
 		//Verify that active/inactive works
-		if (USEHP)
+		if (SMR == SMR_HP)
 		{
 		    p64_hazptr_deactivate();
 		    delay_loop(1);
 		    p64_hazptr_reactivate();
 		}
-		else
+		else if (SMR == SMR_QSBR)
 		{
 		    p64_qsbr_deactivate();
 		    delay_loop(1);
@@ -286,20 +332,28 @@ static void *
 entrypoint(void *arg)
 {
     unsigned tidx = (uintptr_t)arg;
-    if (USEHP)
+    if (SMR == SMR_HP)
 	p64_hazptr_register(HPDOM);
-    else
+    else if (SMR == SMR_QSBR)
 	p64_qsbr_register(QSBRDOM);
+    else if (SMR == SMR_EBR)
+	p64_ebr_register(EBRDOM);
+    else
+	p64_hazera_register(HEDOM);
 
     //Wait for my signal to start
     barrier_thr_begin(tidx);
 
     thr_execute(tidx);
 
-    if (USEHP)
+    if (SMR == SMR_HP)
 	p64_hazptr_unregister();
-    else
+    else if (SMR == SMR_QSBR)
 	p64_qsbr_unregister();
+    else if (SMR == SMR_EBR)
+	p64_ebr_unregister();
+    else
+	p64_hazera_unregister();
 
     //Signal I am done
     barrier_thr_done(tidx);
@@ -489,7 +543,7 @@ main(int argc, char *argv[])
     uint32_t NREFS = 1;
     int c;
 
-    while ((c = getopt(argc, argv, "a:f:l:o:qr:t:v")) != -1)
+    while ((c = getopt(argc, argv, "a:eEf:l:o:qr:t:v")) != -1)
     {
 	switch (c)
 	{
@@ -503,6 +557,12 @@ main(int argc, char *argv[])
 		    AFFINITY = strtoul(optarg, NULL, 2);
 		}
 		break;
+	    case 'e' :
+		SMR = SMR_EBR;
+		break;
+	    case 'E' :
+		SMR = SMR_HE;
+		break;
 	    case 'f' :
 		{
 		    CPUFREQ = atol(optarg);
@@ -531,7 +591,7 @@ main(int argc, char *argv[])
 		    break;
 		}
 	    case 'q' :
-		USEHP = false;
+		SMR = SMR_QSBR;
 		break;
 	    case 'r' :
 		{
@@ -562,11 +622,13 @@ main(int argc, char *argv[])
 usage :
 		fprintf(stderr, "Usage: bm_smr <options>\n"
 			"-a <binmask>     CPU affinity mask (default base 2)\n"
+			"-e               Use EBR instead of hazard pointers\n"
+			"-E               Use hazard eras instead of hazard pointers\n"
 			"-f <cpufreq>     CPU frequency in kHz\n"
 			"-l <numlaps>     Number of laps\n"
 			"-o <numobjs>     Number of objects\n"
 			"-q               Use QSBR instead of hazard pointers\n"
-			"-r <numrefs>     Number of HP references\n"
+			"-r <numrefs>     Number of HP/HE references\n"
 			"-t <numthr>      Number of threads\n"
 			"-v               Verbose\n"
 		       );
@@ -579,7 +641,7 @@ usage :
     }
 
     printf("%s: %u objects, %u laps, %u thread%s, affinity mask=0x%"PRIx64", ",
-	    USEHP ? "HP" : "QSBR",
+	    smr_name[SMR],
 	    NUMOBJS,
 	    NUMLAPS,
 	    NUMTHREADS,
@@ -587,7 +649,7 @@ usage :
 	    AFFINITY);
     fflush(stdout);
 
-    if (USEHP)
+    if (SMR == SMR_HP)
     {
 	printf("%u HP/thread, ", NREFS);
 	HPDOM = p64_hazptr_alloc(5, NREFS);
@@ -597,7 +659,7 @@ usage :
 	    exit(EXIT_FAILURE);
 	}
     }
-    else
+    else if (SMR == SMR_QSBR)
     {
 	QSBRDOM = p64_qsbr_alloc(5);
 	if (QSBRDOM == NULL)
@@ -606,6 +668,25 @@ usage :
 	    exit(EXIT_FAILURE);
 	}
     }
+    else if (SMR == SMR_EBR)
+    {
+	EBRDOM = p64_ebr_alloc(5);
+	if (EBRDOM == NULL)
+	{
+	    fprintf(stderr, "Failed to allocate EBR domain\n");
+	    exit(EXIT_FAILURE);
+	}
+    }
+    else
+    {
+	printf("%u HE/thread, ", NREFS);
+	HEDOM = p64_hazera_alloc(5, NREFS);
+	if (HEDOM == NULL)
+	{
+	    fprintf(stderr, "Failed to allocate HE domain\n");
+	    exit(EXIT_FAILURE);
+	}
+    }
     OBJS = aligned_alloc(CACHE_LINE, NUMOBJS * sizeof(struct object));
     if (OBJS == NULL)
     {
@@ -619,6 +700,7 @@ usage :
     for (uint32_t i = 0; i < NUMOBJS; i++)
     {
 	OBJS[i].idx = i;
+	OBJS[i].birth = 0;//Older than all eras
 	TABLE[i] = &OBJS[i];
     }
 
@@ -642,9 +724,13 @@ usage :
     (void)sem_destroy(&ALL_DONE);
     free(TABLE);
     free(OBJS);
-    if (USEHP)
+    if (SMR == SMR_HP)
 	p64_hazptr_free(HPDOM);
-    else
+    else if (SMR == SMR_QSBR)
 	p64_qsbr_free(QSBRDOM);
+    else if (SMR == SMR_EBR)
+	p64_ebr_free(EBRDOM);
+    else
+	p64_hazera_free(HEDOM);
     return 0;
 }
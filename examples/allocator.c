@@ -0,0 +1,167 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64_allocator.h"
+#include "p64_lfring.h"
+#include "p64_ringbuf.h"
+#include "p64_segqueue.h"
+#include "p64_qsbr.h"
+
+#include "expect.h"
+
+//Process-wide allocator which counts allocations
+static uint32_t nallocs, nfrees;
+
+static void *
+count_alloc(size_t size, size_t alignment, void *arg)
+{
+    EXPECT(arg == &nallocs);
+    nallocs++;
+    if (alignment < sizeof(void *))
+    {
+	alignment = sizeof(void *);
+    }
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+static void
+count_free(void *ptr, void *arg)
+{
+    EXPECT(arg == &nallocs);
+    nfrees++;
+    free(ptr);
+}
+
+//Arena with bump allocation, memory is only reclaimed when all allocations
+//have been freed
+struct arena
+{
+    char *base;
+    size_t size;
+    size_t used;
+    uint32_t nlive;
+};
+
+static void *
+arena_alloc(size_t size, size_t alignment, void *arg)
+{
+    struct arena *ar = arg;
+    if (alignment == 0)
+    {
+	alignment = 1;
+    }
+    size_t start = (ar->used + alignment - 1) & ~(alignment - 1);
+    if (start + size > ar->size)
+    {
+	return NULL;
+    }
+    ar->used = start + size;
+    ar->nlive++;
+    return ar->base + start;
+}
+
+static void
+arena_free(void *ptr, void *arg)
+{
+    struct arena *ar = arg;
+    EXPECT((char *)ptr >= ar->base && (char *)ptr < ar->base + ar->size);
+    if (--ar->nlive == 0)
+    {
+	ar->used = 0;
+    }
+}
+
+static void *
+free_ringbuf(void *arg)
+{
+    //Memory is returned to the arena also from other threads
+    p64_ringbuf_free(arg);
+    return NULL;
+}
+
+int main(void)
+{
+    printf("testing process-wide allocator\n");
+    p64_allocator_install(&(p64_allocator_t){ count_alloc, count_free, &nallocs });
+    p64_lfring_t *lfr = p64_lfring_alloc(16, 0);
+    EXPECT(lfr != NULL);
+    EXPECT(nallocs == 1);
+    p64_lfring_free(lfr);
+    EXPECT(nfrees == 1);
+    //Internal allocations also use the allocator
+    p64_qsbrdomain_t *qsbr = p64_qsbr_alloc(10);
+    EXPECT(qsbr != NULL);
+    p64_qsbr_register(qsbr);
+    p64_segqueue_t *sq = p64_segqueue_alloc(2, 0);
+    EXPECT(sq != NULL);
+    for (uintptr_t i = 1; i <= 5; i++)
+    {
+	EXPECT(p64_segqueue_enqueue(sq, (void *)i));
+    }
+    for (uintptr_t i = 1; i <= 5; i++)
+    {
+	EXPECT(p64_segqueue_dequeue(sq) == (void *)i);
+    }
+    p64_segqueue_free(sq);
+    p64_qsbr_quiescent();
+    EXPECT(p64_qsbr_reclaim() == 0);
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbr);
+    EXPECT(nallocs > 3 && nallocs == nfrees);
+
+    printf("testing per-thread allocator\n");
+    static char mem[4096] __attribute__((aligned(64)));
+    struct arena ar = { mem, sizeof mem, 0, 0 };
+    p64_allocator_set(&(p64_allocator_t){ arena_alloc, arena_free, &ar });
+    p64_ringbuf_t *rb = p64_ringbuf_alloc(8, 0, sizeof(void *));
+    p64_allocator_set(NULL);
+    EXPECT(rb != NULL);
+    EXPECT(ar.nlive == 1);//Ring buffer including allocation header
+    uint32_t allocs = nallocs;
+    pthread_t tid;
+    EXPECT(pthread_create(&tid, NULL, free_ringbuf, rb) == 0);
+    EXPECT(pthread_join(tid, NULL) == 0);
+    EXPECT(ar.nlive == 0 && ar.used == 0);
+    EXPECT(nallocs == allocs);
+    //Allocation failure in arena
+    p64_allocator_set(&(p64_allocator_t){ arena_alloc, arena_free, &ar });
+    rb = p64_ringbuf_alloc(1024, 0, sizeof(void *));
+    p64_allocator_set(NULL);
+    EXPECT(rb == NULL);
+    //Segments come from the allocator of the queue, not of the caller
+    qsbr = p64_qsbr_alloc(10);
+    EXPECT(qsbr != NULL);
+    p64_qsbr_register(qsbr);
+    p64_allocator_set(&(p64_allocator_t){ arena_alloc, arena_free, &ar });
+    sq = p64_segqueue_alloc(2, 0);
+    p64_allocator_set(NULL);
+    EXPECT(sq != NULL);
+    EXPECT(ar.nlive == 2);
+    allocs = nallocs;
+    for (uintptr_t i = 1; i <= 5; i++)
+    {
+	EXPECT(p64_segqueue_enqueue(sq, (void *)i));
+    }
+    EXPECT(ar.nlive == 4);
+    EXPECT(nallocs == allocs);
+    for (uintptr_t i = 1; i <= 5; i++)
+    {
+	EXPECT(p64_segqueue_dequeue(sq) == (void *)i);
+    }
+    p64_segqueue_free(sq);
+    p64_qsbr_quiescent();
+    EXPECT(p64_qsbr_reclaim() == 0);
+    EXPECT(ar.nlive == 0 && ar.used == 0);
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbr);
+
+    p64_allocator_install(NULL);
+    printf("allocator test complete\n");
+    return 0;
+}
@@ -13,6 +13,7 @@
 #define TWO (void *)(2<<2)
 #define THREE (void *)(3<<2)
 #define FOUR (void *)(4<<2)
+#define FIVE (void *)(5<<2)
 
 static void
 test_rb(void)
@@ -53,10 +54,44 @@ test_rb(void)
     p64_buckring_free(rb);
 }
 
+static void
+test_min(void)
+{
+    void *vec[4];
+    uint32_t ret, index;
+
+    p64_buckring_t *rb = p64_buckring_alloc(4, 0);
+    EXPECT(rb != NULL);
+
+    ret = p64_buckring_enqueue(rb, (void *[]){ ONE, TWO, THREE }, 3);
+    EXPECT(ret == 3);
+    //Too few elements, nothing dequeued
+    ret = p64_buckring_dequeue_min(rb, vec, 4, &index, 4);
+    EXPECT(ret == 0);
+    //At least 2 elements
+    ret = p64_buckring_dequeue_min(rb, vec, 4, &index, 2);
+    EXPECT(ret == 3);
+    EXPECT(index == 0);
+    EXPECT(vec[0] == ONE && vec[1] == TWO && vec[2] == THREE);
+    ret = p64_buckring_enqueue(rb, (void *[]){ FOUR, FIVE }, 2);
+    EXPECT(ret == 2);
+    //Exactly 2 elements
+    ret = p64_buckring_dequeue_min(rb, vec, 2, &index, 2);
+    EXPECT(ret == 2);
+    EXPECT(index == 3);
+    EXPECT(vec[0] == FOUR && vec[1] == FIVE);
+    ret = p64_buckring_dequeue_min(rb, vec, 1, &index, 1);
+    EXPECT(ret == 0);
+
+    p64_buckring_free(rb);
+}
+
 int main(void)
 {
     printf("testing buckring\n");
     test_rb();
+    printf("testing buckring dequeue min\n");
+    test_min();
     printf("buckring test complete\n");
     return 0;
 }
@@ -16,7 +16,7 @@ int main(void)
     p64_clhlock_acquire(&lock, &node);
     p64_clhlock_release(&node);
     p64_clhlock_fini(&lock);
-    free(node);
+    p64_clhlock_free_node(node);
 
     printf("clhlock tests complete\n");
     return 0;
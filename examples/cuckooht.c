@@ -0,0 +1,201 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64_cuckooht.h"
+#include "p64_ebr.h"
+#include "p64_qsbr.h"
+#include "expect.h"
+
+#define NUMELEMS 1000
+
+//Elements must be 32-byte aligned
+struct elem
+{
+    p64_cuckooelem_t ce;
+    uint32_t key;
+} __attribute__((aligned(32)));
+
+static struct elem elems[NUMELEMS];
+
+static int
+compare_key(const p64_cuckooelem_t *ce, const void *key)
+{
+    const struct elem *e = (const struct elem *)ce;
+    return e->key == *(const uint32_t *)key ? 0 : 1;
+}
+
+static p64_cuckoohash_t
+hash_key(uint32_t key)
+{
+    return (p64_cuckoohash_t)(key * 0x9E3779B97F4A7C15ULL);
+}
+
+static void
+test_grow(void)
+{
+    p64_hashstats_t st;
+    p64_qsbrdomain_t *qsbr = p64_qsbr_alloc(100);
+    EXPECT(qsbr != NULL);
+    p64_qsbr_register(qsbr);
+    p64_cuckooht_t *ht = p64_cuckooht_alloc(16, 0, compare_key,
+					    P64_CUCKOOHT_F_GROW |
+					    P64_CUCKOOHT_F_STATS);
+    EXPECT(ht != NULL);
+    p64_cuckooht_stats(ht, &st);
+    uint64_t capacity = st.capacity;
+    EXPECT(capacity < NUMELEMS);
+    //Table grows when full, insertions must not fail
+    for (uint32_t i = 0; i < NUMELEMS; i++)
+    {
+	elems[i].key = i;
+	EXPECT(p64_cuckooht_insert(ht, &elems[i].ce, hash_key(i)));
+	p64_qsbr_quiescent();
+    }
+    p64_cuckooht_stats(ht, &st);
+    EXPECT(st.capacity > capacity);
+    EXPECT(st.nelems == NUMELEMS);
+    EXPECT(st.insert_fails == 0);
+    //All elements must be found also if migration is still in progress
+    p64_qsbr_acquire();
+    for (uint32_t i = 0; i < NUMELEMS; i++)
+    {
+	p64_cuckooelem_t *ce = p64_cuckooht_lookup(ht, &i, hash_key(i), NULL);
+	EXPECT(ce == &elems[i].ce);
+    }
+    uint32_t key = NUMELEMS;
+    EXPECT(p64_cuckooht_lookup(ht, &key, hash_key(key), NULL) == NULL);
+    p64_qsbr_release();
+    for (uint32_t i = 0; i < NUMELEMS; i++)
+    {
+	EXPECT(p64_cuckooht_remove(ht, &elems[i].ce, hash_key(i)));
+	p64_qsbr_quiescent();
+    }
+    p64_cuckooht_stats(ht, &st);
+    EXPECT(st.nelems == 0);
+    p64_cuckooht_free(ht);
+    //Retired tables are reclaimed when we are quiescent
+    p64_qsbr_quiescent();
+    EXPECT(p64_qsbr_reclaim() == 0);
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbr);
+}
+
+static void
+test_vec(void)
+{
+    const uint32_t num = 20;
+    p64_cuckooelem_t *ptrs[num];
+    p64_cuckoohash_t hashes[num];
+    bool success[num];
+    const void *keys[num + 1];
+    p64_cuckoohash_t khashes[num + 1];
+    p64_cuckooelem_t *result[num + 1];
+    uint32_t keyvals[num + 1];
+    p64_qsbrdomain_t *qsbr = p64_qsbr_alloc(100);
+    EXPECT(qsbr != NULL);
+    p64_qsbr_register(qsbr);
+    p64_cuckooht_t *ht = p64_cuckooht_alloc(64, 16, compare_key, 0);
+    EXPECT(ht != NULL);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	elems[i].key = i;
+	ptrs[i] = &elems[i].ce;
+	hashes[i] = hash_key(i);
+    }
+    EXPECT(p64_cuckooht_insert_vec(ht, num, ptrs, hashes, success) == num);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	EXPECT(success[i]);
+    }
+    //Look up all elements in reverse order and one missing key
+    for (uint32_t i = 0; i <= num; i++)
+    {
+	keyvals[i] = i < num ? num - 1 - i : NUMELEMS;
+	keys[i] = &keyvals[i];
+	khashes[i] = hash_key(keyvals[i]);
+    }
+    p64_qsbr_acquire();
+    p64_cuckooht_lookup_vec(ht, num + 1, keys, khashes, result);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	EXPECT(result[i] == &elems[num - 1 - i].ce);
+    }
+    EXPECT(result[num] == NULL);
+    p64_qsbr_release();
+    EXPECT(p64_cuckooht_remove_vec(ht, num, ptrs, hashes, success) == num);
+    EXPECT(p64_cuckooht_remove_vec(ht, num, ptrs, hashes, success) == 0);
+    p64_qsbr_acquire();
+    p64_cuckooht_lookup_vec(ht, num + 1, keys, khashes, result);
+    for (uint32_t i = 0; i <= num; i++)
+    {
+	EXPECT(result[i] == NULL);
+    }
+    p64_qsbr_release();
+    p64_cuckooht_free(ht);
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbr);
+}
+
+//Insert, lookup, remove and grow using epoch based reclamation
+static void
+test_ebr(void)
+{
+    p64_hashstats_t st;
+    p64_ebrdomain_t *ebr = p64_ebr_alloc(100);
+    EXPECT(ebr != NULL);
+    p64_ebr_register(ebr);
+    p64_cuckooht_t *ht = p64_cuckooht_alloc(16, 0, compare_key,
+					    P64_CUCKOOHT_F_EBR |
+					    P64_CUCKOOHT_F_GROW |
+					    P64_CUCKOOHT_F_STATS);
+    EXPECT(ht != NULL);
+    p64_cuckooht_stats(ht, &st);
+    uint64_t capacity = st.capacity;
+    for (uint32_t i = 0; i < NUMELEMS; i++)
+    {
+	elems[i].key = i;
+	EXPECT(p64_cuckooht_insert(ht, &elems[i].ce, hash_key(i)));
+    }
+    p64_cuckooht_stats(ht, &st);
+    EXPECT(st.capacity > capacity);
+    EXPECT(st.nelems == NUMELEMS);
+    p64_ebr_enter();
+    for (uint32_t i = 0; i < NUMELEMS; i++)
+    {
+	p64_cuckooelem_t *ce = p64_cuckooht_lookup(ht, &i, hash_key(i), NULL);
+	EXPECT(ce == &elems[i].ce);
+    }
+    uint32_t key = NUMELEMS;
+    EXPECT(p64_cuckooht_lookup(ht, &key, hash_key(key), NULL) == NULL);
+    p64_ebr_exit();
+    for (uint32_t i = 0; i < NUMELEMS; i++)
+    {
+	EXPECT(p64_cuckooht_remove(ht, &elems[i].ce, hash_key(i)));
+    }
+    EXPECT(!p64_cuckooht_remove(ht, &elems[0].ce, hash_key(0)));
+    p64_cuckooht_stats(ht, &st);
+    EXPECT(st.nelems == 0);
+    p64_cuckooht_free(ht);
+    //Retired tables are reclaimed outside of critical sections
+    EXPECT(p64_ebr_reclaim() == 0);
+    p64_ebr_unregister();
+    p64_ebr_free(ebr);
+}
+
+int main(void)
+{
+    printf("testing cuckooht grow\n");
+    test_grow();
+    printf("testing cuckooht vector functions\n");
+    test_vec();
+    printf("testing cuckooht with EBR\n");
+    test_ebr();
+    printf("cuckooht test complete\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "p64_cuckookv_template.h"
+#include "p64_hashtable_template.h"
+#include "expect.h"
+
+//IPv4 5-tuple padded to 16 bytes
+struct flow
+{
+    uint32_t saddr;
+    uint32_t daddr;
+    uint16_t sport;
+    uint16_t dport;
+    uint8_t proto;
+    uint8_t pad[3];
+};
+
+//Instantiate the cuckoo hash table template using the 5-tuple as key
+P64_CUCKOOKV(flowtab, struct flow)
+
+#define NUMFLOWS 1000
+
+static p64_cuckookvhash_t
+hash_flow(const struct flow *f)
+{
+    uint64_t h = ((uint64_t)f->saddr << 32 | f->daddr) * 0x9E3779B97F4A7C15ULL;
+    h ^= ((uint64_t)f->sport << 24 | (uint64_t)f->dport << 8 | f->proto) *
+	 0xC2B2AE3D27D4EB4FULL;
+    return (p64_cuckookvhash_t)(h ^ (h >> 29));
+}
+
+static struct flow
+make_flow(uint32_t i)
+{
+    struct flow f;
+    memset(&f, 0, sizeof f);//Clear padding, keys are compared bitwise
+    f.saddr = 0x0a000000 + i;
+    f.daddr = 0xc0a80001;
+    f.sport = 1024 + i % 60000;
+    f.dport = 80;
+    f.proto = 6;
+    return f;
+}
+
+static void
+test_generic(void)
+{
+    uintptr_t val;
+    p64_cuckookv_t *kv = p64_cuckookv_alloc(8, sizeof(uint32_t));
+    EXPECT(kv != NULL);
+    uint32_t k = 1;
+    EXPECT(!p64_cuckookv_lookup(kv, &k, k, &val));
+    EXPECT(p64_cuckookv_insert(kv, &k, k, 100));
+    EXPECT(!p64_cuckookv_insert(kv, &k, k, 101));
+    EXPECT(p64_cuckookv_lookup(kv, &k, k, &val) && val == 100);
+    k = 2;
+    EXPECT(!p64_cuckookv_lookup(kv, &k, k, &val));
+    EXPECT(!p64_cuckookv_remove(kv, &k, k, &val));
+    k = 1;
+    EXPECT(p64_cuckookv_remove(kv, &k, k, &val) && val == 100);
+    EXPECT(!p64_cuckookv_lookup(kv, &k, k, &val));
+    p64_cuckookv_free(kv);
+}
+
+//Key with padding which is not cleared, compared field by field
+struct port
+{
+    uint16_t num;
+    uint32_t ifindex;
+};
+
+static inline p64_cuckookvhash_t
+hash_port(const struct port *p)
+{
+    return ((uint64_t)p->ifindex << 16 | p->num) * 0x9E3779B97F4A7C15ULL;
+}
+
+static inline bool
+eq_port(const struct port *a, const struct port *b)
+{
+    return a->num == b->num && a->ifindex == b->ifindex;
+}
+
+P64_HASHTABLE(porttab, struct port, uint16_t, hash_port, eq_port)
+
+static void
+test_template(void)
+{
+    porttab_t *pt = porttab_alloc(100);
+    EXPECT(pt != NULL);
+    struct port p;
+    uint16_t val;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+	memset(&p, i, sizeof p);//Garbage in padding
+	p.num = i;
+	p.ifindex = i % 4;
+	EXPECT(porttab_insert(pt, &p, 1000 + i));
+    }
+    memset(&p, 0xff, sizeof p);
+    p.num = 10;
+    p.ifindex = 2;
+    EXPECT(!porttab_insert(pt, &p, 0));
+    EXPECT(porttab_lookup(pt, &p, &val) && val == 1010);
+    p.ifindex = 3;
+    EXPECT(!porttab_lookup(pt, &p, &val));
+    struct port keys[3] = { { 1, 1 }, { 2, 2 }, { 3, 0 } };
+    uint16_t vals[3];
+    bool hits[3];
+    EXPECT(porttab_lookup_vec(pt, 3, keys, vals, hits) == 2);
+    EXPECT(hits[0] && vals[0] == 1001);
+    EXPECT(hits[1] && vals[1] == 1002);
+    EXPECT(!hits[2]);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+	memset(&p, 0, sizeof p);
+	p.num = i;
+	p.ifindex = i % 4;
+	EXPECT(porttab_remove(pt, &p, &val) && val == 1000 + i);
+    }
+    porttab_free(pt);
+}
+
+int main(void)
+{
+    test_generic();
+    test_template();
+
+    flowtab_t *ft = flowtab_alloc(NUMFLOWS);
+    EXPECT(ft != NULL);
+    for (uint32_t i = 0; i < NUMFLOWS; i++)
+    {
+	struct flow f = make_flow(i);
+	EXPECT(flowtab_insert(ft, &f, hash_flow(&f), i));
+    }
+    //Elements have been moved around to make room, check all are found
+    for (uint32_t i = 0; i < NUMFLOWS; i++)
+    {
+	struct flow f = make_flow(i);
+	uintptr_t val;
+	EXPECT(flowtab_lookup(ft, &f, hash_flow(&f), &val) && val == i);
+    }
+    struct flow f = make_flow(NUMFLOWS);
+    uintptr_t val;
+    EXPECT(!flowtab_lookup(ft, &f, hash_flow(&f), &val));
+    //Vector lookup with one miss
+    struct flow keys[4];
+    p64_cuckookvhash_t hashes[4];
+    uintptr_t vals[4];
+    bool hits[4];
+    for (uint32_t i = 0; i < 4; i++)
+    {
+	keys[i] = make_flow(i == 3 ? NUMFLOWS : 10 * i);
+	hashes[i] = hash_flow(&keys[i]);
+    }
+    EXPECT(flowtab_lookup_vec(ft, 4, keys, hashes, vals, hits) == 3);
+    EXPECT(hits[0] && vals[0] == 0);
+    EXPECT(hits[1] && vals[1] == 10);
+    EXPECT(hits[2] && vals[2] == 20);
+    EXPECT(!hits[3]);
+    for (uint32_t i = 0; i < NUMFLOWS; i++)
+    {
+	struct flow f = make_flow(i);
+	EXPECT(flowtab_remove(ft, &f, hash_flow(&f), &val) && val == i);
+    }
+    flowtab_free(ft);
+
+    printf("cuckookv test complete\n");
+    return 0;
+}
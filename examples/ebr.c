@@ -0,0 +1,62 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "p64_ebr.h"
+#include "expect.h"
+
+static const char *expect = NULL;
+
+static void
+callback(void *ptr)
+{
+    EXPECT(expect != NULL);
+    printf("Reclaiming %s\n", (const char *)ptr);
+    EXPECT(strcmp(ptr, expect) == 0);
+}
+
+int main(void)
+{
+    bool b;
+    uint32_t r;
+    p64_ebrdomain_t *ebr = p64_ebr_alloc(10);
+    EXPECT(ebr != NULL)
+    p64_ebr_register(ebr);
+    //Object retired while inside critical section cannot be reclaimed
+    p64_ebr_enter();
+    b = p64_ebr_retire("X", callback);
+    EXPECT(b == true);
+    r = p64_ebr_reclaim();
+    EXPECT(r == 1);//1 unreclaimed object
+    //Nested critical section
+    p64_ebr_enter();
+    p64_ebr_exit();
+    r = p64_ebr_reclaim();
+    EXPECT(r == 1);
+    p64_ebr_exit();
+    //Thread is outside critical section, X can now be reclaimed
+    expect = "X";
+    r = p64_ebr_reclaim();
+    EXPECT(r == 0);
+    expect = NULL;
+    //Critical section entered after object was retired does not delay
+    //reclamation
+    b = p64_ebr_retire("Y", callback);
+    EXPECT(b == true);
+    p64_ebr_enter();
+    expect = "Y";
+    r = p64_ebr_reclaim();
+    EXPECT(r == 0);
+    expect = NULL;
+    p64_ebr_exit();
+    p64_ebr_unregister();
+    p64_ebr_free(ebr);
+
+    printf("ebr tests complete\n");
+    return 0;
+}
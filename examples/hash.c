@@ -0,0 +1,77 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "p64_hash.h"
+#include "expect.h"
+
+#define NUMKEYS 37
+#define MAXLEN 40
+
+int main(void)
+{
+    //Standard CRC-32C check value
+    EXPECT(~p64_hash_crc32c("123456789", 9, ~0U) == 0xe3069283);
+    uint32_t k32 = 0x12345678;
+    uint64_t k64 = 0x123456789abcdef0;
+    EXPECT(p64_hash_crc32c_u32(k32, 1) == p64_hash_crc32c(&k32, sizeof k32, 1));
+    EXPECT(p64_hash_crc32c_u64(k64, 1) == p64_hash_crc32c(&k64, sizeof k64, 1));
+
+    //Vector functions must compute the same hashes as the scalar functions
+    static uint8_t data[NUMKEYS][MAXLEN];
+    const void *keys[NUMKEYS];
+    for (uint32_t i = 0; i < NUMKEYS; i++)
+    {
+	for (uint32_t j = 0; j < MAXLEN; j++)
+	{
+	    data[i][j] = i * 31 + j * 7;
+	}
+	keys[i] = data[i];
+    }
+    for (size_t len = 0; len <= MAXLEN; len++)
+    {
+	uint32_t crcs[NUMKEYS];
+	uint64_t wys[NUMKEYS];
+	p64_hash_crc32c_vec(NUMKEYS, keys, len, 5, crcs);
+	p64_hash_wyhash_vec(NUMKEYS, keys, len, 5, wys);
+	for (uint32_t i = 0; i < NUMKEYS; i++)
+	{
+	    EXPECT(crcs[i] == p64_hash_crc32c(keys[i], len, 5));
+	    EXPECT(wys[i] == p64_hash_wyhash(keys[i], len, 5));
+	}
+	//All input bytes must affect the hash
+	if (len != 0)
+	{
+	    uint8_t buf[MAXLEN];
+	    memcpy(buf, data[0], len);
+	    buf[len - 1] ^= 1;
+	    EXPECT(p64_hash_wyhash(buf, len, 5) != wys[0]);
+	    EXPECT(p64_hash_crc32c(buf, len, 5) != crcs[0]);
+	}
+    }
+    //Seed must affect the hash
+    EXPECT(p64_hash_wyhash(data[0], 16, 0) != p64_hash_wyhash(data[0], 16, 1));
+
+    uint32_t ikeys32[NUMKEYS], ihashes32[NUMKEYS];
+    uint64_t ikeys64[NUMKEYS], ihashes64[NUMKEYS];
+    for (uint32_t i = 0; i < NUMKEYS; i++)
+    {
+	ikeys32[i] = i * 0x9e3779b9U;
+	ikeys64[i] = i * 0x9e3779b97f4a7c15ULL;
+    }
+    p64_hash_mix32_vec(NUMKEYS, ikeys32, ihashes32);
+    p64_hash_mix64_vec(NUMKEYS, ikeys64, ihashes64);
+    for (uint32_t i = 0; i < NUMKEYS; i++)
+    {
+	EXPECT(ihashes32[i] == p64_hash_mix32(ikeys32[i]));
+	EXPECT(ihashes64[i] == p64_hash_mix64(ikeys64[i]));
+    }
+
+    printf("hash test complete\n");
+    return 0;
+}
@@ -8,8 +8,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "p64_ebr.h"
 #include "p64_hazardptr.h"
 #include "p64_hashtable.h"
+#include "p64_qsbr.h"
 #include "expect.h"
 
 //Hashtable requires 2 hazard pointers per thread
@@ -86,6 +88,372 @@ compf(const p64_hashelem_t *he,
     return m->key < k ? -1 : m->key > k ? 1 : 0;
 }
 
+static void
+count_cb(void *arg,
+	 p64_hashelem_t *he,
+	 size_t idx)
+{
+    (void)he;
+    (void)idx;
+    (*(size_t *)arg)++;
+}
+
+static size_t
+count(p64_hashtable_t *ht)
+{
+    size_t nelems = 0;
+    p64_hashtable_traverse(ht, count_cb, &nelems);
+    return nelems;
+}
+
+#define NUM_RESIZE_ELEMS 1000
+
+static void
+test_resize(void)
+{
+    p64_qsbrdomain_t *qsbrd = p64_qsbr_alloc(10);
+    EXPECT(qsbrd != NULL);
+    p64_qsbr_register(qsbrd);
+    static struct my_elem *elems[NUM_RESIZE_ELEMS];
+    p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
+
+    //Explicit resize
+    p64_hashtable_t *ht = p64_hashtable_alloc(1, compf, P64_HASHTAB_F_RESIZE);
+    EXPECT(ht != NULL);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+	elems[i] = he_alloc(i);
+	p64_hashtable_insert(ht, &elems[i]->next, elems[i]->hash);
+    }
+    EXPECT(count(ht) == 100);
+    printf("Resize to 1000 elements\n");
+    EXPECT(p64_hashtable_resize(ht, 1000));
+    EXPECT(count(ht) == 100);
+    p64_qsbr_acquire();
+    for (uint32_t i = 0; i < 100; i++)
+    {
+	EXPECT(p64_hashtable_lookup(ht, &i, hash(i), &hp) ==
+	       &elems[i]->next);
+    }
+    p64_qsbr_release();
+    printf("Resize to 8 elements\n");
+    EXPECT(p64_hashtable_resize(ht, 8));
+    EXPECT(count(ht) == 100);
+    for (uint32_t i = 0; i < 100; i += 2)
+    {
+	EXPECT(p64_hashtable_remove(ht, &elems[i]->next, elems[i]->hash));
+    }
+    p64_qsbr_acquire();
+    for (uint32_t i = 1; i < 100; i += 2)
+    {
+	EXPECT(p64_hashtable_remove_by_key(ht, &i, hash(i), &hp) ==
+	       &elems[i]->next);
+    }
+    EXPECT(p64_hashtable_lookup(ht, &(uint32_t){1}, hash(1), &hp) == NULL);
+    p64_qsbr_release();
+    EXPECT(count(ht) == 0);
+    p64_hashtable_free(ht);
+
+    //Automatic resize, grow and then shrink
+    ht = p64_hashtable_alloc(4, compf, P64_HASHTAB_F_AUTORESIZE);
+    EXPECT(ht != NULL);
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i++)
+    {
+	if (i >= 100)
+	{
+	    elems[i] = he_alloc(i);
+	}
+	p64_hashtable_insert(ht, &elems[i]->next, elems[i]->hash);
+    }
+    p64_qsbr_acquire();
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i++)
+    {
+	EXPECT(p64_hashtable_lookup(ht, &i, hash(i), &hp) ==
+	       &elems[i]->next);
+    }
+    p64_qsbr_release();
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i++)
+    {
+	EXPECT(p64_hashtable_remove(ht, &elems[i]->next, elems[i]->hash));
+    }
+    EXPECT(count(ht) == 0);
+    p64_hashtable_free(ht);
+
+    //Vector insert and remove in bursts
+    ht = p64_hashtable_alloc(4, compf,
+			     P64_HASHTAB_F_AUTORESIZE | P64_HASHTAB_F_STATS);
+    EXPECT(ht != NULL);
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i += 25)
+    {
+	p64_hashelem_t *hes[25];
+	p64_hashvalue_t hashes[25];
+	for (uint32_t j = 0; j < 25; j++)
+	{
+	    hes[j] = &elems[i + j]->next;
+	    hashes[j] = elems[i + j]->hash;
+	}
+	bool success[25];
+	EXPECT(p64_hashtable_insert_vec(ht, 25, hes, hashes, success) == 25);
+    }
+    EXPECT(count(ht) == NUM_RESIZE_ELEMS);
+    p64_qsbr_acquire();
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS + 10; i++)
+    {
+	(void)p64_hashtable_lookup(ht, &i, hash(i), &hp);
+    }
+    p64_qsbr_release();
+    p64_hashstats_t st;
+    p64_hashtable_stats(ht, &st);
+    EXPECT(st.inserts == NUM_RESIZE_ELEMS);
+    EXPECT(st.nelems == NUM_RESIZE_ELEMS);
+    EXPECT(st.lookups == NUM_RESIZE_ELEMS + 10);
+    EXPECT(st.lookup_misses == 10);
+    EXPECT(st.capacity >= NUM_RESIZE_ELEMS);
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i += 25)
+    {
+	p64_hashelem_t *hes[26];
+	p64_hashvalue_t hashes[26];
+	bool success[26];
+	for (uint32_t j = 0; j < 25; j++)
+	{
+	    hes[j] = &elems[i + j]->next;
+	    hashes[j] = elems[i + j]->hash;
+	}
+	//Last element already removed
+	hes[25] = hes[0];
+	hashes[25] = hashes[0];
+	EXPECT(p64_hashtable_remove_vec(ht, 26, hes, hashes, success) == 25);
+	EXPECT(success[0] && success[24] && !success[25]);
+    }
+    EXPECT(count(ht) == 0);
+    p64_hashtable_stats(ht, &st);
+    EXPECT(st.removes == NUM_RESIZE_ELEMS);
+    EXPECT(st.remove_fails == NUM_RESIZE_ELEMS / 25);
+    EXPECT(st.nelems == 0);
+    p64_hashtable_free(ht);
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i++)
+    {
+	free(elems[i]);
+    }
+
+    p64_qsbr_quiescent();
+    EXPECT(p64_qsbr_reclaim() == 0);
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbrd);
+}
+
+#define NUM_EBR_ELEMS 100
+
+static void
+test_ebr(void)
+{
+    p64_ebrdomain_t *ebr = p64_ebr_alloc(10);
+    EXPECT(ebr != NULL);
+    p64_ebr_register(ebr);
+    static struct my_elem *elems[NUM_EBR_ELEMS];
+    p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
+    p64_hashtable_t *ht = p64_hashtable_alloc(1, compf,
+					      P64_HASHTAB_F_EBR |
+					      P64_HASHTAB_F_RESIZE);
+    EXPECT(ht != NULL);
+    for (uint32_t i = 0; i < NUM_EBR_ELEMS; i++)
+    {
+	elems[i] = he_alloc(i);
+	p64_hashtable_insert(ht, &elems[i]->next, elems[i]->hash);
+    }
+    //Old table is retired using EBR
+    EXPECT(p64_hashtable_resize(ht, 1000));
+    EXPECT(count(ht) == NUM_EBR_ELEMS);
+    p64_ebr_enter();
+    for (uint32_t i = 0; i < NUM_EBR_ELEMS; i++)
+    {
+	EXPECT(p64_hashtable_remove_by_key(ht, &i, hash(i), &hp) ==
+	       &elems[i]->next);
+    }
+    p64_ebr_exit();
+    EXPECT(count(ht) == 0);
+    p64_hashtable_free(ht);
+    EXPECT(p64_ebr_reclaim() == 0);
+    for (uint32_t i = 0; i < NUM_EBR_ELEMS; i++)
+    {
+	free(elems[i]);
+    }
+    p64_ebr_unregister();
+    p64_ebr_free(ebr);
+}
+
+#define NUM_PARTS 3
+
+struct expiry
+{
+    p64_hashtable_t *ht;
+    uint32_t seen[NUM_RESIZE_ELEMS];
+};
+
+//Count reported elements and remove those with odd keys
+static void
+expire_cb(void *arg,
+	  p64_hashelem_t *he,
+	  size_t idx)
+{
+    (void)idx;
+    struct expiry *ex = arg;
+    struct my_elem *me = (struct my_elem *)he;
+    ex->seen[me->key]++;
+    if (me->key % 2 != 0)
+    {
+	(void)p64_hashtable_remove(ex->ht, he, me->hash);
+    }
+}
+
+static void
+test_traverse_step(void)
+{
+    p64_qsbrdomain_t *qsbrd = p64_qsbr_alloc(10);
+    EXPECT(qsbrd != NULL);
+    p64_qsbr_register(qsbrd);
+    static struct my_elem *elems[NUM_RESIZE_ELEMS];
+    static struct expiry ex;
+
+    p64_hashtable_t *ht = p64_hashtable_alloc(100, compf,
+					      P64_HASHTAB_F_RESIZE);
+    EXPECT(ht != NULL);
+    ex.ht = ht;
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i++)
+    {
+	elems[i] = he_alloc(i);
+	p64_hashtable_insert(ht, &elems[i]->next, elems[i]->hash);
+    }
+    //Traverse partitions in round-robin, a few buckets at a time
+    //Resize after the first round, the partitions restart in the new table
+    p64_hashtable_cursor_t cursors[NUM_PARTS];
+    for (uint32_t p = 0; p < NUM_PARTS; p++)
+    {
+	p64_hashtable_cursor_init(&cursors[p], p, NUM_PARTS);
+    }
+    uint32_t active = (1U << NUM_PARTS) - 1;
+    for (uint32_t round = 0; active != 0; round++)
+    {
+	for (uint32_t p = 0; p < NUM_PARTS; p++)
+	{
+	    if ((active & (1U << p)) != 0 &&
+		!p64_hashtable_traverse_step(ht, &cursors[p], 3,
+					     expire_cb, &ex))
+	    {
+		active &= ~(1U << p);
+	    }
+	}
+	if (round == 0)
+	{
+	    printf("Resize to 1000 elements during traversal\n");
+	    EXPECT(p64_hashtable_resize(ht, 1000));
+	}
+	p64_qsbr_quiescent();
+    }
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i++)
+    {
+	EXPECT(ex.seen[i] != 0);
+    }
+    EXPECT(count(ht) == NUM_RESIZE_ELEMS / 2);
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i += 2)
+    {
+	EXPECT(p64_hashtable_remove(ht, &elems[i]->next, elems[i]->hash));
+    }
+    EXPECT(count(ht) == 0);
+    p64_hashtable_free(ht);
+    for (uint32_t i = 0; i < NUM_RESIZE_ELEMS; i++)
+    {
+	free(elems[i]);
+    }
+
+    p64_qsbr_quiescent();
+    EXPECT(p64_qsbr_reclaim() == 0);
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbrd);
+}
+
+//Compact mode elements do not embed a p64_hashelem_t
+struct compact_elem
+{
+    uint32_t key;
+};
+
+static int
+compf_compact(const p64_hashelem_t *he,
+	      const void *key)
+{
+    uint32_t k = *(const uint32_t*)key;
+    const struct compact_elem *ce = (const struct compact_elem *)he;
+    return ce->key < k ? -1 : ce->key > k ? 1 : 0;
+}
+
+#define NUM_COMPACT_ELEMS 12
+
+static void
+test_compact(void)
+{
+    p64_qsbrdomain_t *qsbrd = p64_qsbr_alloc(10);
+    EXPECT(qsbrd != NULL);
+    p64_qsbr_register(qsbrd);
+    p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
+
+    p64_hashtable_t *ht = p64_hashtable_alloc(NUM_COMPACT_ELEMS,
+					      compf_compact,
+					      P64_HASHTAB_F_COMPACT |
+					      P64_HASHTAB_F_STATS);
+    EXPECT(ht != NULL);
+    p64_hashstats_t st;
+    p64_hashtable_stats(ht, &st);
+    printf("Compact hash table capacity %"PRIu64"\n", st.capacity);
+    EXPECT(st.capacity >= NUM_COMPACT_ELEMS);
+    //Capacity depends on the pointer size, one extra element does not fit
+    uint32_t cap = st.capacity;
+    struct compact_elem *elems = malloc((cap + 1) * sizeof elems[0]);
+    EXPECT(elems != NULL);
+    //Use the same hash value for all elements so that they overflow from
+    //their home bucket until the table is full
+    for (uint32_t i = 0; i < cap; i++)
+    {
+	elems[i].key = i;
+	EXPECT(p64_hashtable_insert(ht, (p64_hashelem_t *)&elems[i], 0));
+    }
+    elems[cap].key = cap;
+    EXPECT(!p64_hashtable_insert(ht, (p64_hashelem_t *)&elems[cap], 0));
+    EXPECT(count(ht) == cap);
+    p64_qsbr_acquire();
+    for (uint32_t i = 0; i < cap; i++)
+    {
+	EXPECT(p64_hashtable_lookup(ht, &i, 0, &hp) ==
+	       (p64_hashelem_t *)&elems[i]);
+    }
+    EXPECT(p64_hashtable_lookup(ht, &cap, 0, &hp) == NULL);
+    p64_qsbr_release();
+    //Remove elements from the home bucket, those which overflowed must
+    //still be found
+    EXPECT(p64_hashtable_remove(ht, (p64_hashelem_t *)&elems[0], 0));
+    EXPECT(!p64_hashtable_remove(ht, (p64_hashelem_t *)&elems[0], 0));
+    p64_qsbr_acquire();
+    EXPECT(p64_hashtable_remove_by_key(ht, &(uint32_t){1}, 0, &hp) ==
+	   (p64_hashelem_t *)&elems[1]);
+    uint32_t last = cap - 1;
+    EXPECT(p64_hashtable_lookup(ht, &last, 0, &hp) ==
+	   (p64_hashelem_t *)&elems[last]);
+    p64_qsbr_release();
+    for (uint32_t i = 2; i < cap; i++)
+    {
+	EXPECT(p64_hashtable_remove(ht, (p64_hashelem_t *)&elems[i], 0));
+    }
+    EXPECT(count(ht) == 0);
+    p64_hashtable_stats(ht, &st);
+    EXPECT(st.nelems == 0);
+    EXPECT(st.insert_fails == 1);
+    p64_hashtable_free(ht);
+    free(elems);
+
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbrd);
+}
+
 int main(void)
 {
     p64_hpdomain_t *hpd = p64_hazptr_alloc(10, NUM_HAZARD_POINTERS);
@@ -186,6 +554,11 @@ int main(void)
     p64_hazptr_unregister();
     p64_hazptr_free(hpd);
 
+    test_resize();
+    test_ebr();
+    test_traverse_step();
+    test_compact();
+
     printf("hashtable test complete\n");
     return 0;
 }
@@ -0,0 +1,130 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "p64_hazardera.h"
+#include "expect.h"
+
+static const char *expect = NULL;
+
+static void
+callback(void *ptr)
+{
+    EXPECT(expect != NULL);
+    printf("Reclaiming %s\n", (const char *)ptr);
+    EXPECT(strcmp(ptr, expect) == 0);
+}
+
+static char reclaimed[16];
+static uint32_t nreclaimed = 0;
+
+static void
+collect(void *ptr)
+{
+    printf("Reclaiming %s\n", (const char *)ptr);
+    EXPECT(nreclaimed < sizeof reclaimed - 1);
+    reclaimed[nreclaimed++] = *(const char *)ptr;
+    reclaimed[nreclaimed] = 0;
+}
+
+static void
+expect_reclaimed(const char *objs)
+{
+    EXPECT(strcmp(reclaimed, objs) == 0);
+    nreclaimed = 0;
+    reclaimed[0] = 0;
+}
+
+//Objects are only kept if some hazard era lies in their lifetime
+static void
+test_multiple_eras(void)
+{
+    uint32_t r;
+    char *loc = "Z";
+    p64_hazardera_t he[3] = { NULL, NULL, NULL };
+    p64_hedomain_t *hed = p64_hazera_alloc(10, 3);
+    EXPECT(hed != NULL)
+    p64_hazera_register(hed);
+    uint64_t birth = p64_hazera_birth();
+    EXPECT(p64_hazera_acquire(&loc, &he[0]) == loc);
+    EXPECT(p64_hazera_retire("A", birth, collect));
+    birth = p64_hazera_birth();
+    EXPECT(p64_hazera_retire("B", birth, collect));
+    birth = p64_hazera_birth();
+    EXPECT(p64_hazera_acquire(&loc, &he[1]) == loc);
+    EXPECT(p64_hazera_retire("C", birth, collect));
+    birth = p64_hazera_birth();
+    EXPECT(p64_hazera_retire("D", birth, collect));
+    birth = p64_hazera_birth();
+    EXPECT(p64_hazera_acquire(&loc, &he[2]) == loc);
+    EXPECT(p64_hazera_retire("E", birth, collect));
+    r = p64_hazera_reclaim();
+    EXPECT(r == 3);
+    expect_reclaimed("BD");
+    p64_hazera_release(&he[1]);
+    r = p64_hazera_reclaim();
+    EXPECT(r == 2);
+    expect_reclaimed("C");
+    p64_hazera_release(&he[0]);
+    p64_hazera_release(&he[2]);
+    r = p64_hazera_reclaim();
+    EXPECT(r == 0);
+    expect_reclaimed("AE");
+    p64_hazera_unregister();
+    p64_hazera_free(hed);
+}
+
+int main(void)
+{
+    bool b;
+    uint32_t r;
+    p64_hedomain_t *hed = p64_hazera_alloc(10, 1);
+    EXPECT(hed != NULL)
+    p64_hazera_register(hed);
+    uint64_t birth_x = p64_hazera_birth();
+    char *loc = "X";
+    p64_hazardera_t he = P64_HAZARDERA_NULL;
+    char *ptr = p64_hazera_acquire(&loc, &he);
+    EXPECT(ptr == loc);
+    EXPECT(he != P64_HAZARDERA_NULL);
+    b = p64_hazera_retire("X", birth_x, callback);
+    EXPECT(b == true);
+    //Object born after retirement of X
+    uint64_t birth_y = p64_hazera_birth();
+    EXPECT(birth_y > birth_x);
+    r = p64_hazera_reclaim();
+    EXPECT(r == 1);//X still protected by hazard era
+    p64_hazera_release(&he);
+    EXPECT(he == P64_HAZARDERA_NULL);
+    expect = "X";
+    r = p64_hazera_reclaim();
+    EXPECT(r == 0);
+    expect = NULL;
+    //A hazard era published after Y was born protects Y but not objects
+    //retired before that era
+    loc = "Y";
+    ptr = p64_hazera_acquire(&loc, &he);
+    EXPECT(ptr == loc);
+    b = p64_hazera_retire("Y", birth_y, callback);
+    EXPECT(b == true);
+    r = p64_hazera_reclaim();
+    EXPECT(r == 1);
+    p64_hazera_release(&he);
+    expect = "Y";
+    r = p64_hazera_reclaim();
+    EXPECT(r == 0);
+    expect = NULL;
+    p64_hazera_unregister();
+    p64_hazera_free(hed);
+
+    printf("testing multiple hazard eras\n");
+    test_multiple_eras();
+
+    printf("hazardera tests complete\n");
+    return 0;
+}
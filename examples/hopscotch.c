@@ -0,0 +1,112 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64_hopscotch.h"
+#include "p64_qsbr.h"
+#include "expect.h"
+
+#define NUMELEMS 200
+
+struct elem
+{
+    uint32_t key;
+} __attribute__((aligned(16)));
+
+static struct elem elems[NUMELEMS];
+
+static int
+compare_key(const void *elem, const void *key)
+{
+    const struct elem *e = elem;
+    return e->key == *(const uint32_t *)key ? 0 : 1;
+}
+
+static p64_hopschash_t
+hash_key(uint32_t key)
+{
+    return (p64_hopschash_t)(key * 0x9E3779B97F4A7C15ULL);
+}
+
+//Insert, look up and remove elements 'first'..'first + num - 1' using the
+//vector functions, 'num' above 8 uses a different prefetch path
+static void
+test_vec(p64_hopscotch_t *ht, uint32_t first, uint32_t num)
+{
+    void *ptrs[num];
+    p64_hopschash_t hashes[num];
+    bool success[num];
+    const void *keys[num + 1];
+    p64_hopschash_t khashes[num + 1];
+    void *result[num + 1];
+    uint32_t keyvals[num + 1];
+    for (uint32_t i = 0; i < num; i++)
+    {
+	elems[first + i].key = first + i;
+	ptrs[i] = &elems[first + i];
+	hashes[i] = hash_key(first + i);
+    }
+    EXPECT(p64_hopscotch_insert_vec(ht, num, ptrs, hashes, success) == num);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	EXPECT(success[i]);
+    }
+    //Look up all elements in reverse order and one missing key
+    for (uint32_t i = 0; i <= num; i++)
+    {
+	keyvals[i] = i < num ? first + num - 1 - i : NUMELEMS;
+	keys[i] = &keyvals[i];
+	khashes[i] = hash_key(keyvals[i]);
+    }
+    p64_qsbr_acquire();
+    p64_hopscotch_lookup_vec(ht, num + 1, keys, khashes, result);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	EXPECT(result[i] == &elems[first + num - 1 - i]);
+    }
+    EXPECT(result[num] == NULL);
+    p64_qsbr_release();
+    EXPECT(p64_hopscotch_remove_vec(ht, num, ptrs, hashes, success) == num);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	EXPECT(success[i]);
+    }
+    //Elements already removed
+    EXPECT(p64_hopscotch_remove_vec(ht, num, ptrs, hashes, success) == 0);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	EXPECT(!success[i]);
+    }
+    p64_qsbr_acquire();
+    p64_hopscotch_lookup_vec(ht, num + 1, keys, khashes, result);
+    for (uint32_t i = 0; i <= num; i++)
+    {
+	EXPECT(result[i] == NULL);
+    }
+    p64_qsbr_release();
+    p64_qsbr_quiescent();
+}
+
+int main(void)
+{
+    p64_qsbrdomain_t *qsbr = p64_qsbr_alloc(2 * NUMELEMS);
+    EXPECT(qsbr != NULL);
+    p64_qsbr_register(qsbr);
+    p64_hopscotch_t *ht = p64_hopscotch_alloc(2 * NUMELEMS, 16, compare_key, 0);
+    EXPECT(ht != NULL);
+    printf("testing hopscotch vector functions\n");
+    test_vec(ht, 0, 4);
+    test_vec(ht, 4, 8);
+    test_vec(ht, 12, 100);
+    p64_hopscotch_free(ht);
+    EXPECT(p64_qsbr_reclaim() == 0);
+    p64_qsbr_unregister();
+    p64_qsbr_free(qsbr);
+    printf("hopscotch test complete\n");
+    return 0;
+}
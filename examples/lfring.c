@@ -2,13 +2,20 @@
 //
 //SPDX-License-Identifier:        BSD-3-Clause
 
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "p64_lfring.h"
 
 #include "expect.h"
 
+#define ROUNDUP(a, b) ((((a) + (b) - 1) / (b)) * (b))
+
 static void
 test_rb(uint32_t flags)
 {
@@ -48,6 +55,187 @@ test_rb(uint32_t flags)
     p64_lfring_free(rb);
 }
 
+static void
+test_inplace(uint32_t flags)
+{
+    p64_lfring_result_t r;
+    uint32_t idx;
+    void *vec[4];
+
+    p64_lfring_t *rb = p64_lfring_alloc(4, flags);
+    EXPECT(rb != NULL);
+
+    r = p64_lfring_acquire(rb, 4, false);
+    EXPECT(r.actual == 0);
+    if (flags & P64_LFRING_F_SPENQ)
+    {
+	//Write elements directly into the ring, enqueue only 2 of 3
+	r = p64_lfring_acquire(rb, 3, true);
+	EXPECT(r.actual == 3);
+	for (uint32_t i = 0; i < r.actual; i++)
+	{
+	    *p64_lfring_slot(r, i) = (void *)(uintptr_t)(i + 1);
+	}
+	r.actual = 2;
+	EXPECT(p64_lfring_release(rb, r, true));
+	r = p64_lfring_acquire(rb, 5, true);
+	EXPECT(r.actual == 2);
+	EXPECT(r.index == 2);
+	r.actual = 0;
+	EXPECT(p64_lfring_release(rb, r, true));
+    }
+    else
+    {
+	EXPECT(p64_lfring_enqueue(rb, (void *[]){ (void*)1, (void*)2 }, 2) == 2);
+    }
+
+    //Read elements directly from the ring, dequeue only the first
+    r = p64_lfring_acquire(rb, 4, false);
+    EXPECT(r.actual == 2);
+    EXPECT(r.index == 0);
+    EXPECT(*p64_lfring_slot(r, 0) == (void*)1);
+    EXPECT(*p64_lfring_slot(r, 1) == (void*)2);
+    r.actual = 1;
+    EXPECT(p64_lfring_release(rb, r, false));
+    if (!(flags & P64_LFRING_F_SCDEQ))
+    {
+	//Stale acquire, head has moved
+	EXPECT(!p64_lfring_release(rb, r, false));
+    }
+
+    EXPECT(p64_lfring_dequeue(rb, vec, 4, &idx) == 1);
+    EXPECT(idx == 1);
+    EXPECT(vec[0] == (void*)2);
+
+    p64_lfring_free(rb);
+}
+
+static void
+sleep_ms(long ms)
+{
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = ms * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+static void *
+delayed_enqueue(void *arg)
+{
+    sleep_ms(20);
+    uint32_t ret = p64_lfring_enqueue(arg, (void *[]){ (void *)1, (void *)2 }, 2);
+    EXPECT(ret == 2);
+    return NULL;
+}
+
+static void *
+delayed_dequeue(void *arg)
+{
+    void *vec[1];
+    uint32_t idx;
+    sleep_ms(20);
+    uint32_t ret = p64_lfring_dequeue(arg, vec, 1, &idx);
+    EXPECT(ret == 1);
+    EXPECT(vec[0] == (void *)1);
+    return NULL;
+}
+
+static void
+test_wait(uint32_t flags)
+{
+    void *vec[4];
+    uint32_t ret, idx;
+    pthread_t tid;
+
+    p64_lfring_t *rb = p64_lfring_alloc(2, flags | P64_LFRING_F_WAIT);
+    EXPECT(rb != NULL);
+
+    //Timeout on empty ring
+    ret = p64_lfring_dequeue_wait(rb, vec, 1, &idx, 1, 1000000);
+    EXPECT(ret == 0);
+    //Timeout with too few elements returns the available elements
+    ret = p64_lfring_enqueue(rb, (void *[]){ (void *)1 }, 1);
+    EXPECT(ret == 1);
+    ret = p64_lfring_dequeue_wait(rb, vec, 4, &idx, 2, 1000000);
+    EXPECT(ret == 1);
+    EXPECT(vec[0] == (void *)1);
+
+    //Sleep until a producer enqueues elements
+    EXPECT(pthread_create(&tid, NULL, delayed_enqueue, rb) == 0);
+    ret = p64_lfring_dequeue_wait(rb, vec, 4, &idx, 2, P64_LFRING_WAIT_FOREVER);
+    EXPECT(pthread_join(tid, NULL) == 0);
+    EXPECT(ret == 2);
+    EXPECT(vec[0] == (void *)1);
+    EXPECT(vec[1] == (void *)2);
+
+    //Timeout on full ring
+    ret = p64_lfring_enqueue_wait(rb, (void *[]){ (void *)1, (void *)2, (void *)3 }, 3, 1000000);
+    EXPECT(ret == 2);
+    //Sleep until a consumer dequeues an element
+    EXPECT(pthread_create(&tid, NULL, delayed_dequeue, rb) == 0);
+    ret = p64_lfring_enqueue_wait(rb, (void *[]){ (void *)3 }, 1, P64_LFRING_WAIT_FOREVER);
+    EXPECT(pthread_join(tid, NULL) == 0);
+    EXPECT(ret == 1);
+    ret = p64_lfring_dequeue_wait(rb, vec, 4, &idx, 2, P64_LFRING_WAIT_FOREVER);
+    EXPECT(ret == 2);
+    EXPECT(vec[0] == (void *)2);
+    EXPECT(vec[1] == (void *)3);
+
+    p64_lfring_free(rb);
+}
+
+static void
+test_min(uint32_t flags)
+{
+    void *vec[4];
+    uint32_t ret, index;
+
+    p64_lfring_t *rb = p64_lfring_alloc(4, flags);
+    EXPECT(rb != NULL);
+
+    ret = p64_lfring_enqueue(rb, (void *[]){ (void *)1, (void *)2, (void *)3 }, 3);
+    EXPECT(ret == 3);
+    //Too few elements, nothing dequeued
+    ret = p64_lfring_dequeue_min(rb, vec, 4, &index, 4);
+    EXPECT(ret == 0);
+    //At least 2 elements
+    ret = p64_lfring_dequeue_min(rb, vec, 4, &index, 2);
+    EXPECT(ret == 3);
+    EXPECT(index == 0);
+    EXPECT(vec[0] == (void *)1 && vec[1] == (void *)2 && vec[2] == (void *)3);
+    ret = p64_lfring_enqueue(rb, (void *[]){ (void *)4, (void *)5 }, 2);
+    EXPECT(ret == 2);
+    //Exactly 2 elements
+    ret = p64_lfring_dequeue_min(rb, vec, 2, &index, 2);
+    EXPECT(ret == 2);
+    EXPECT(index == 3);
+    EXPECT(vec[0] == (void *)4 && vec[1] == (void *)5);
+    ret = p64_lfring_dequeue_min(rb, vec, 1, &index, 1);
+    EXPECT(ret == 0);
+
+    p64_lfring_free(rb);
+}
+
+static void
+test_init(uint32_t flags)
+{
+    void *vec[4];
+    uint32_t ret, index;
+    size_t sz = p64_lfring_size(4);
+    EXPECT(sz != 0);
+    void *mem = aligned_alloc(64, ROUNDUP(sz, 64));
+    EXPECT(mem != NULL);
+    p64_lfring_t *lfr = p64_lfring_init(mem, 4, flags);
+    EXPECT(lfr != NULL);
+    ret = p64_lfring_enqueue(lfr, (void *[]){ (void *)1, (void *)2 }, 2);
+    EXPECT(ret == 2);
+    //A second handle for the same ring, e.g. in another process
+    p64_lfring_t *lfr2 = p64_lfring_attach(mem);
+    EXPECT(lfr2 != NULL);
+    ret = p64_lfring_dequeue(lfr2, vec, 4, &index);
+    EXPECT(ret == 2);
+    EXPECT(vec[0] == (void *)1 && vec[1] == (void *)2);
+    free(mem);
+}
+
 int main(void)
 {
     printf("testing MPMC lock-free ring\n");
@@ -58,6 +246,20 @@ int main(void)
     test_rb(P64_LFRING_F_SPENQ | P64_LFRING_F_MCDEQ);
     printf("testing SPSC lock-free ring\n");
     test_rb(P64_LFRING_F_SPENQ | P64_LFRING_F_SCDEQ);
+    printf("testing in-place enqueue and dequeue\n");
+    test_inplace(P64_LFRING_F_MPENQ | P64_LFRING_F_MCDEQ);
+    test_inplace(P64_LFRING_F_MPENQ | P64_LFRING_F_SCDEQ);
+    test_inplace(P64_LFRING_F_SPENQ | P64_LFRING_F_MCDEQ);
+    test_inplace(P64_LFRING_F_SPENQ | P64_LFRING_F_SCDEQ);
+    printf("testing dequeue min\n");
+    test_min(P64_LFRING_F_MPENQ | P64_LFRING_F_MCDEQ);
+    test_min(P64_LFRING_F_SPENQ | P64_LFRING_F_SCDEQ);
+    printf("testing init in place\n");
+    test_init(P64_LFRING_F_MPENQ | P64_LFRING_F_MCDEQ);
+    test_init(P64_LFRING_F_SPENQ | P64_LFRING_F_SCDEQ);
+    printf("testing blocking wait\n");
+    test_wait(P64_LFRING_F_MPENQ | P64_LFRING_F_MCDEQ);
+    test_wait(P64_LFRING_F_SPENQ | P64_LFRING_F_SCDEQ);
     printf("lock-free ring tests complete\n");
     return 0;
 }
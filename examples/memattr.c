@@ -0,0 +1,62 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64_memattr.h"
+#include "p64_lfring.h"
+
+#include "expect.h"
+
+static void
+test_ring(void)
+{
+    void *vec[1];
+    uint32_t ret, index;
+    p64_lfring_t *lfr = p64_lfring_alloc(1U << 16, 0);
+    EXPECT(lfr != NULL);
+    ret = p64_lfring_enqueue(lfr, (void *[]){ (void *)1 }, 1);
+    EXPECT(ret == 1);
+    ret = p64_lfring_dequeue(lfr, vec, 1, &index);
+    EXPECT(ret == 1);
+    EXPECT(vec[0] == (void *)1);
+    p64_lfring_free(lfr);
+}
+
+int main(void)
+{
+    p64_memattr_t attr;
+
+    p64_memattr_get(&attr);
+    EXPECT(attr.flags == 0);
+
+    printf("testing hugepage allocation\n");
+    p64_memattr_set(&(p64_memattr_t){ .flags = P64_MEMATTR_F_HUGEPAGE |
+						P64_MEMATTR_F_PREFAULT,
+				      .minsize = 65536 });
+    p64_memattr_get(&attr);
+    EXPECT(attr.flags == (P64_MEMATTR_F_HUGEPAGE | P64_MEMATTR_F_PREFAULT));
+    EXPECT(attr.minsize == 65536);
+    test_ring();
+
+    printf("testing NUMA node binding\n");
+    p64_memattr_set(&(p64_memattr_t){ .flags = P64_MEMATTR_F_BIND, .node = 0 });
+    test_ring();
+
+    printf("testing NUMA interleave\n");
+    p64_memattr_set(&(p64_memattr_t){ .flags = P64_MEMATTR_F_INTERLEAVE |
+						P64_MEMATTR_F_HUGEPAGE_1G,
+				      .nodemask = 1 });
+    test_ring();
+
+    p64_memattr_set(NULL);
+    p64_memattr_get(&attr);
+    EXPECT(attr.flags == 0);
+    test_ring();
+
+    printf("memattr test complete\n");
+    return 0;
+}
@@ -0,0 +1,109 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64_prioring.h"
+
+#include "expect.h"
+
+//Element value encodes level and sequence number
+#define ELEM(prio, seq) (void *)(uintptr_t)(((prio) << 8) | (seq))
+#define PRIO(elem) ((uintptr_t)(elem) >> 8)
+
+static void
+test_strict(uint32_t flags)
+{
+    void *vec[8];
+    uint32_t ret;
+
+    p64_prioring_t *pr = p64_prioring_alloc(3, 4, NULL, flags);
+    EXPECT(pr != NULL);
+    ret = p64_prioring_dequeue(pr, vec, 8);
+    EXPECT(ret == 0);
+    ret = p64_prioring_enqueue(pr, (void *[]){ ELEM(2, 0), ELEM(2, 1) }, 2, 2);
+    EXPECT(ret == 2);
+    ret = p64_prioring_enqueue(pr, (void *[]){ ELEM(1, 0) }, 1, 1);
+    EXPECT(ret == 1);
+    ret = p64_prioring_enqueue(pr, (void *[]){ ELEM(0, 0), ELEM(0, 1) }, 2, 0);
+    EXPECT(ret == 2);
+    //Higher priority levels first
+    ret = p64_prioring_dequeue(pr, vec, 1);
+    EXPECT(ret == 1);
+    EXPECT(vec[0] == ELEM(0, 0));
+    //One call dequeues from multiple levels
+    ret = p64_prioring_dequeue(pr, vec, 8);
+    EXPECT(ret == 4);
+    EXPECT(vec[0] == ELEM(0, 1));
+    EXPECT(vec[1] == ELEM(1, 0));
+    EXPECT(vec[2] == ELEM(2, 0));
+    EXPECT(vec[3] == ELEM(2, 1));
+    ret = p64_prioring_dequeue(pr, vec, 8);
+    EXPECT(ret == 0);
+    p64_prioring_free(pr);
+}
+
+static void
+test_wrr(uint32_t flags)
+{
+    void *vec[8];
+    uint32_t ret;
+
+    p64_prioring_t *pr = p64_prioring_alloc(2, 8, (uint32_t[]){ 3, 1 }, flags);
+    EXPECT(pr != NULL);
+    for (uintptr_t i = 0; i < 6; i++)
+    {
+	ret = p64_prioring_enqueue(pr, (void *[]){ ELEM(0, i) }, 1, 0);
+	EXPECT(ret == 1);
+	ret = p64_prioring_enqueue(pr, (void *[]){ ELEM(1, i) }, 1, 1);
+	EXPECT(ret == 1);
+    }
+    //Three elements from level 0 for each element from level 1
+    static const uintptr_t expected[] = { 0, 0, 0, 1, 0, 0, 0, 1 };
+    for (uint32_t i = 0; i < 8; i++)
+    {
+	ret = p64_prioring_dequeue(pr, vec, 1);
+	EXPECT(ret == 1);
+	EXPECT(PRIO(vec[0]) == expected[i]);
+    }
+    //Level 0 is empty, remaining elements are from level 1
+    ret = p64_prioring_dequeue(pr, vec, 8);
+    EXPECT(ret == 4);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+	EXPECT(vec[i] == ELEM(1, i + 2));
+    }
+    ret = p64_prioring_dequeue(pr, vec, 8);
+    EXPECT(ret == 0);
+    //Weighted round robin within one call
+    for (uintptr_t i = 0; i < 4; i++)
+    {
+	ret = p64_prioring_enqueue(pr, (void *[]){ ELEM(0, i) }, 1, 0);
+	EXPECT(ret == 1);
+	ret = p64_prioring_enqueue(pr, (void *[]){ ELEM(1, i) }, 1, 1);
+	EXPECT(ret == 1);
+    }
+    ret = p64_prioring_dequeue(pr, vec, 8);
+    EXPECT(ret == 8);
+    static const uintptr_t expected2[] = { 0, 0, 0, 1, 0, 1, 1, 1 };
+    for (uint32_t i = 0; i < 8; i++)
+    {
+	EXPECT(PRIO(vec[i]) == expected2[i]);
+    }
+    p64_prioring_free(pr);
+}
+
+int main(void)
+{
+    printf("testing strict priority ring\n");
+    test_strict(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_MCDEQ);
+    test_strict(P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_SCDEQ);
+    printf("testing weighted round robin priority ring\n");
+    test_wrr(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_MCDEQ);
+    test_wrr(P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_LFDEQ);
+    printf("prioring test complete\n");
+    return 0;
+}
@@ -3,6 +3,7 @@
 //SPDX-License-Identifier:        BSD-3-Clause
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,6 +21,81 @@ callback(void *ptr)
     EXPECT(strcmp(ptr, expect) == 0);
 }
 
+static p64_qsbrdomain_t *slow;
+static int state = 0;
+
+//Thread which is only registered in the slow domain and does not quiesce
+static void *
+slow_thread(void *arg)
+{
+    (void)arg;
+    p64_qsbr_register(slow);
+    __atomic_store_n(&state, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&state, __ATOMIC_ACQUIRE) != 2)
+    {
+    }
+    p64_qsbr_unregister();
+    __atomic_store_n(&state, 3, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void
+test_domains(void)
+{
+    uint32_t r;
+    pthread_t tid;
+    p64_qsbrdomain_t *fast = p64_qsbr_alloc(10);
+    EXPECT(fast != NULL);
+    slow = p64_qsbr_alloc(10);
+    EXPECT(slow != NULL);
+    p64_qsbr_register(slow);
+    p64_qsbr_register(fast);
+    EXPECT(pthread_create(&tid, NULL, slow_thread, NULL) == 0);
+    while (__atomic_load_n(&state, __ATOMIC_ACQUIRE) != 1)
+    {
+    }
+    //Retire object in each domain
+    EXPECT(p64_qsbr_retire("F", callback));
+    EXPECT(p64_qsbr_select(slow) == fast);
+    EXPECT(p64_qsbr_retire("S", callback));
+    //Quiescent state is signalled in both domains
+    p64_qsbr_quiescent();
+    //The slow thread does not delay reclamation in the fast domain
+    r = p64_qsbr_reclaim();
+    EXPECT(r == 1);
+    EXPECT(p64_qsbr_select(fast) == slow);
+    expect = "F";
+    r = p64_qsbr_reclaim();
+    EXPECT(r == 0);
+    expect = NULL;
+    //Retire object into a domain which is not the current domain
+    EXPECT(p64_qsbr_domain() == fast);
+    EXPECT(p64_qsbr_select(slow) == fast);
+    EXPECT(p64_qsbr_retire_domain(fast, "G", callback));
+    p64_qsbr_quiescent();
+    r = p64_qsbr_reclaim();
+    EXPECT(r == 1);
+    EXPECT(p64_qsbr_select(fast) == slow);
+    expect = "G";
+    r = p64_qsbr_reclaim();
+    EXPECT(r == 0);
+    expect = NULL;
+    //Unregister from the fast domain, the slow domain becomes current
+    p64_qsbr_unregister();
+    p64_qsbr_free(fast);
+    __atomic_store_n(&state, 2, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&state, __ATOMIC_ACQUIRE) != 3)
+    {
+    }
+    EXPECT(pthread_join(tid, NULL) == 0);
+    expect = "S";
+    r = p64_qsbr_reclaim();
+    EXPECT(r == 0);
+    expect = NULL;
+    p64_qsbr_unregister();
+    p64_qsbr_free(slow);
+}
+
 int main(void)
 {
     bool b;
@@ -51,6 +127,9 @@ int main(void)
     p64_qsbr_unregister();
     p64_qsbr_free(qsbr);
 
+    printf("testing multiple domains\n");
+    test_domains();
+
     printf("qsbr tests complete\n");
     return 0;
 }
@@ -0,0 +1,199 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "p64_allocator.h"
+#include "p64_hazardptr.h"
+#include "p64_qsbr.h"
+#include "p64_reclaimer.h"
+#include "expect.h"
+
+static char reclaimed[16];
+static uint32_t nreclaimed = 0;
+
+static void
+callback(void *ptr)
+{
+    printf("Reclaiming %s\n", (const char *)ptr);
+    EXPECT(nreclaimed < sizeof reclaimed - 1);
+    reclaimed[nreclaimed++] = *(const char *)ptr;
+    reclaimed[nreclaimed] = 0;
+}
+
+static void
+expect_reclaimed(const char *objs)
+{
+    EXPECT(strcmp(reclaimed, objs) == 0);
+    nreclaimed = 0;
+    reclaimed[0] = 0;
+}
+
+static void
+test_qsbr(void)
+{
+    uint32_t r;
+    p64_reclaimer_stats_t st;
+    p64_reclaimer_t *rcl = p64_reclaimer_alloc(3);
+    EXPECT(rcl != NULL);
+    p64_qsbrdomain_t *qsbr = p64_qsbr_alloc(2);
+    EXPECT(qsbr != NULL);
+    p64_qsbr_set_reclaimer(qsbr, rcl);
+    p64_qsbr_register(qsbr);
+    EXPECT(p64_qsbr_retire("A", callback));
+    EXPECT(p64_qsbr_retire("B", callback));
+    //List of retired objects full, A and B are handed off to reclaimer
+    EXPECT(p64_qsbr_retire("C", callback));
+    expect_reclaimed("");
+    //Thread has not passed a quiescent state
+    r = p64_reclaimer_run(rcl);
+    EXPECT(r == 2);
+    expect_reclaimed("");
+    p64_qsbr_quiescent();
+    r = p64_reclaimer_run(rcl);
+    EXPECT(r == 0);
+    expect_reclaimed("AB");
+    //Forced reclamation is performed inline
+    r = p64_qsbr_reclaim();
+    EXPECT(r == 0);
+    expect_reclaimed("C");
+    EXPECT(p64_qsbr_retire("D", callback));
+    EXPECT(p64_qsbr_retire("E", callback));
+    EXPECT(p64_qsbr_retire("F", callback));
+    EXPECT(p64_qsbr_retire("G", callback));
+    p64_qsbr_quiescent();
+    //Backlog limit exceeded, F and G are reclaimed inline
+    EXPECT(p64_qsbr_retire("H", callback));
+    expect_reclaimed("FG");
+    p64_reclaimer_stats(rcl, &st);
+    EXPECT(st.batches == 2);
+    EXPECT(st.objects == 4);
+    EXPECT(st.reclaimed == 2);
+    EXPECT(st.overflows == 1);
+    EXPECT(st.backlog == 2);
+    r = p64_reclaimer_run(rcl);
+    EXPECT(r == 0);
+    expect_reclaimed("DE");
+    p64_qsbr_quiescent();
+    r = p64_qsbr_reclaim();
+    EXPECT(r == 0);
+    expect_reclaimed("H");
+    p64_qsbr_unregister();
+    p64_qsbr_set_reclaimer(qsbr, NULL);
+    p64_qsbr_free(qsbr);
+    p64_reclaimer_free(rcl);
+}
+
+static void
+test_hazptr(void)
+{
+    uint32_t r;
+    p64_reclaimer_stats_t st;
+    p64_reclaimer_t *rcl = p64_reclaimer_alloc(10);
+    EXPECT(rcl != NULL);
+    p64_hpdomain_t *hpd = p64_hazptr_alloc(2, 1);
+    EXPECT(hpd != NULL);
+    p64_hazptr_set_reclaimer(hpd, rcl);
+    p64_hazptr_register(hpd);
+    char *loc = "X";
+    p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
+    char *ptr = p64_hazptr_acquire(&loc, &hp);
+    EXPECT(ptr == loc);
+    EXPECT(p64_hazptr_retire(ptr, callback));
+    EXPECT(p64_hazptr_retire("Y", callback));
+    //List of retired objects full, X and Y are handed off to reclaimer
+    EXPECT(p64_hazptr_retire("Z", callback));
+    expect_reclaimed("");
+    //X is still referenced
+    r = p64_reclaimer_run(rcl);
+    EXPECT(r == 1);
+    expect_reclaimed("Y");
+    p64_hazptr_release(&hp);
+    r = p64_reclaimer_run(rcl);
+    EXPECT(r == 0);
+    expect_reclaimed("X");
+    r = p64_hazptr_reclaim();
+    EXPECT(r == 0);
+    expect_reclaimed("Z");
+    p64_reclaimer_stats(rcl, &st);
+    EXPECT(st.batches == 1);
+    EXPECT(st.objects == 2);
+    EXPECT(st.reclaimed == 2);
+    EXPECT(st.overflows == 0);
+    EXPECT(st.backlog == 0);
+    p64_hazptr_unregister();
+    p64_hazptr_free(hpd);
+    p64_reclaimer_free(rcl);
+}
+
+static uint32_t nallocs = 0;
+
+static void *
+count_alloc(size_t size, size_t alignment, void *arg)
+{
+    (void)arg;
+    nallocs++;
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+static void
+count_free(void *ptr, void *arg)
+{
+    (void)arg;
+    free(ptr);
+}
+
+static void
+test_reuse(void)
+{
+    uint32_t r;
+    //Batches come from the allocator in effect when the reclaimer was
+    //allocated, not from the allocator of the retiring thread
+    const p64_allocator_t counter = { count_alloc, count_free, NULL };
+    p64_allocator_set(&counter);
+    p64_reclaimer_t *rcl = p64_reclaimer_alloc(10);
+    p64_allocator_set(NULL);
+    EXPECT(rcl != NULL);
+    EXPECT(nallocs == 1);
+    p64_hpdomain_t *hpd = p64_hazptr_alloc(2, 1);
+    EXPECT(hpd != NULL);
+    p64_hazptr_set_reclaimer(hpd, rcl);
+    p64_hazptr_register(hpd);
+    EXPECT(p64_hazptr_retire("A", callback));
+    EXPECT(p64_hazptr_retire("B", callback));
+    //First hand-off allocates a batch
+    EXPECT(p64_hazptr_retire("C", callback));
+    EXPECT(nallocs == 2);
+    r = p64_reclaimer_run(rcl);
+    EXPECT(r == 0);
+    expect_reclaimed("AB");
+    EXPECT(p64_hazptr_retire("D", callback));
+    //Emptied batch is reused
+    EXPECT(p64_hazptr_retire("E", callback));
+    EXPECT(nallocs == 2);
+    r = p64_reclaimer_run(rcl);
+    EXPECT(r == 0);
+    expect_reclaimed("CD");
+    r = p64_hazptr_reclaim();
+    EXPECT(r == 0);
+    expect_reclaimed("E");
+    p64_hazptr_unregister();
+    p64_hazptr_free(hpd);
+    p64_reclaimer_free(rcl);
+}
+
+int main(void)
+{
+    printf("testing reclaimer with QSBR\n");
+    test_qsbr();
+    printf("testing reclaimer with hazard pointers\n");
+    test_hazptr();
+    printf("testing reuse of reclaimer batches\n");
+    test_reuse();
+    printf("reclaimer test complete\n");
+    return 0;
+}
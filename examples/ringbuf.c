@@ -2,11 +2,18 @@
 //
 //SPDX-License-Identifier:        BSD-3-Clause
 
+#define _GNU_SOURCE
+
 #include <inttypes.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "p64_errhnd.h"
 #include "p64_ringbuf_template.h"
@@ -14,6 +21,13 @@
 //Instantiate the ring buffer template using uintptr_t as the ring element
 P64_RINGBUF(p64_ringbuf_uip, uintptr_t)
 
+//Instantiate the template with a 32-byte descriptor which uses the SIMD copy
+struct desc
+{
+    uint64_t w[4];
+};
+P64_RINGBUF(p64_ringbuf_desc, struct desc)
+
 #include "expect.h"
 
 static jmp_buf jmpbuf;
@@ -75,6 +89,205 @@ test_rb(uint32_t flags)
     p64_ringbuf_uip_free(rb);
 }
 
+static void
+sleep_ms(long ms)
+{
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = ms * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+static void *
+delayed_enqueue(void *arg)
+{
+    sleep_ms(20);
+    uint32_t ret = p64_ringbuf_enqueue(arg, (void *[]){ (void *)1, (void *)2 }, 2);
+    EXPECT(ret == 2);
+    return NULL;
+}
+
+static void *
+delayed_dequeue(void *arg)
+{
+    void *vec[1];
+    uint32_t index;
+    sleep_ms(20);
+    uint32_t ret = p64_ringbuf_dequeue(arg, vec, 1, &index);
+    EXPECT(ret == 1);
+    EXPECT(vec[0] == (void *)1);
+    return NULL;
+}
+
+static void
+test_wait(uint32_t flags)
+{
+    void *vec[4];
+    uint32_t ret, index;
+    pthread_t tid;
+
+    p64_ringbuf_t *rb = p64_ringbuf_alloc(2, flags | P64_RINGBUF_F_WAIT, sizeof(void *));
+    EXPECT(rb != NULL);
+
+    //Timeout on empty ring
+    ret = p64_ringbuf_dequeue_wait(rb, vec, 1, &index, 1, 1000000);
+    EXPECT(ret == 0);
+    //Timeout with too few elements returns the available elements
+    ret = p64_ringbuf_enqueue(rb, (void *[]){ (void *)1 }, 1);
+    EXPECT(ret == 1);
+    ret = p64_ringbuf_dequeue_wait(rb, vec, 4, &index, 2, 1000000);
+    EXPECT(ret == 1);
+    EXPECT(vec[0] == (void *)1);
+
+    //Sleep until a producer enqueues elements
+    EXPECT(pthread_create(&tid, NULL, delayed_enqueue, rb) == 0);
+    ret = p64_ringbuf_dequeue_wait(rb, vec, 4, &index, 2, P64_RINGBUF_WAIT_FOREVER);
+    EXPECT(pthread_join(tid, NULL) == 0);
+    EXPECT(ret == 2);
+    EXPECT(vec[0] == (void *)1);
+    EXPECT(vec[1] == (void *)2);
+
+    //Timeout on full ring
+    ret = p64_ringbuf_enqueue_wait(rb, (void *[]){ (void *)1, (void *)2, (void *)3 }, 3, 1000000);
+    EXPECT(ret == 2);
+    //Sleep until a consumer dequeues an element
+    EXPECT(pthread_create(&tid, NULL, delayed_dequeue, rb) == 0);
+    ret = p64_ringbuf_enqueue_wait(rb, (void *[]){ (void *)3 }, 1, P64_RINGBUF_WAIT_FOREVER);
+    EXPECT(pthread_join(tid, NULL) == 0);
+    EXPECT(ret == 1);
+    ret = p64_ringbuf_dequeue_wait(rb, vec, 4, &index, 2, P64_RINGBUF_WAIT_FOREVER);
+    EXPECT(ret == 2);
+    EXPECT(vec[0] == (void *)2);
+    EXPECT(vec[1] == (void *)3);
+
+    p64_ringbuf_free(rb);
+}
+
+static void
+test_min(uint32_t flags)
+{
+    void *vec[4];
+    uint32_t ret, index;
+
+    p64_ringbuf_t *rb = p64_ringbuf_alloc(4, flags, sizeof(void *));
+    EXPECT(rb != NULL);
+
+    ret = p64_ringbuf_enqueue(rb, (void *[]){ (void *)1, (void *)2, (void *)3 }, 3);
+    EXPECT(ret == 3);
+    //Too few elements, nothing dequeued
+    ret = p64_ringbuf_dequeue_min(rb, vec, 4, &index, 4);
+    EXPECT(ret == 0);
+    //At least 2 elements
+    ret = p64_ringbuf_dequeue_min(rb, vec, 4, &index, 2);
+    EXPECT(ret == 3);
+    EXPECT(index == 0);
+    EXPECT(vec[0] == (void *)1 && vec[1] == (void *)2 && vec[2] == (void *)3);
+    ret = p64_ringbuf_enqueue(rb, (void *[]){ (void *)4, (void *)5 }, 2);
+    EXPECT(ret == 2);
+    //Exactly 2 elements
+    ret = p64_ringbuf_dequeue_min(rb, vec, 2, &index, 2);
+    EXPECT(ret == 2);
+    EXPECT(index == 3);
+    EXPECT(vec[0] == (void *)4 && vec[1] == (void *)5);
+    ret = p64_ringbuf_dequeue_min(rb, vec, 1, &index, 1);
+    EXPECT(ret == 0);
+
+    p64_ringbuf_free(rb);
+}
+
+static void
+test_desc(uint32_t flags)
+{
+    struct desc src[4], dst[4];
+    uint32_t ret, index;
+
+    p64_ringbuf_desc_t *rb = p64_ringbuf_desc_alloc(4, flags);
+    EXPECT(rb != NULL);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+	for (uint32_t j = 0; j < 4; j++)
+	{
+	    src[i].w[j] = 10 * i + j;
+	}
+    }
+    ret = p64_ringbuf_desc_enqueue(rb, src, 3);
+    EXPECT(ret == 3);
+    ret = p64_ringbuf_desc_dequeue(rb, dst, 3, &index);
+    EXPECT(ret == 3);
+    EXPECT(memcmp(dst, src, 3 * sizeof(struct desc)) == 0);
+    //Enqueue and dequeue wrap around the end of the ring
+    ret = p64_ringbuf_desc_enqueue(rb, src, 4);
+    EXPECT(ret == 4);
+    memset(dst, 0, sizeof dst);
+    ret = p64_ringbuf_desc_dequeue(rb, dst, 4, &index);
+    EXPECT(ret == 4);
+    EXPECT(index == 3);
+    EXPECT(memcmp(dst, src, sizeof dst) == 0);
+    p64_ringbuf_desc_free(rb);
+}
+
+#define NBUFS 8
+#define BUFSIZE 64
+
+//Consumer process, sums the contents of all buffers
+static int
+consumer(void *mem, size_t ringsz)
+{
+    p64_ringbuf_t *rb = p64_ringbuf_attach(mem);
+    uint32_t sum = 0;
+    uint32_t ndeq = 0;
+    while (ndeq < NBUFS)
+    {
+	void *vec[NBUFS];
+	uint32_t index;
+	uint32_t ret = p64_ringbuf_dequeue_wait(rb, vec, NBUFS, &index, 1,
+						P64_RINGBUF_WAIT_FOREVER);
+	for (uint32_t i = 0; i < ret; i++)
+	{
+	    //Elements are offsets from the start of the mapping
+	    uintptr_t off = (uintptr_t)vec[i];
+	    if (off < ringsz || off >= ringsz + NBUFS * BUFSIZE)
+	    {
+		return EXIT_FAILURE;
+	    }
+	    sum += ((uint8_t *)mem)[off];
+	}
+	ndeq += ret;
+    }
+    return sum == NBUFS * (NBUFS + 1) / 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void
+test_shared(uint32_t flags)
+{
+    size_t ringsz = p64_ringbuf_size(NBUFS, sizeof(void *));
+    EXPECT(ringsz != 0 && ringsz % 64 == 0);
+    size_t mapsz = ringsz + NBUFS * BUFSIZE;
+    void *mem = mmap(NULL, mapsz, PROT_READ | PROT_WRITE,
+		     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    EXPECT(mem != MAP_FAILED);
+    p64_ringbuf_t *rb = p64_ringbuf_init(mem, NBUFS, flags | P64_RINGBUF_F_WAIT,
+					 sizeof(void *));
+    EXPECT(rb != NULL);
+    pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0)
+    {
+	_exit(consumer(mem, ringsz));
+    }
+    //Give the consumer time to go to sleep
+    sleep_ms(20);
+    for (uint32_t i = 0; i < NBUFS; i++)
+    {
+	uintptr_t off = ringsz + i * BUFSIZE;
+	((uint8_t *)mem)[off] = i + 1;
+	uint32_t ret = p64_ringbuf_enqueue(rb, (void *[]){ (void *)off }, 1);
+	EXPECT(ret == 1);
+    }
+    int status;
+    EXPECT(waitpid(pid, &status, 0) == pid);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    EXPECT(munmap(mem, mapsz) == 0);
+}
+
 int main(void)
 {
     printf("testing MP/MC ring buffer\n");
@@ -101,6 +314,30 @@ int main(void)
     test_rb(P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_NBDEQ);
     printf("testing NBENQ/LFDEQ ring buffer\n");
     test_rb(P64_RINGBUF_F_NBENQ | P64_RINGBUF_F_LFDEQ);
+    printf("testing dequeue min SP/SC ring buffer\n");
+    test_min(P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_SCDEQ);
+    printf("testing dequeue min MP/MC ring buffer\n");
+    test_min(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_MCDEQ);
+    printf("testing dequeue min MP/LFC ring buffer\n");
+    test_min(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_LFDEQ);
+    printf("testing dequeue min NBMP/NBMC ring buffer\n");
+    test_min(P64_RINGBUF_F_NBENQ | P64_RINGBUF_F_NBDEQ);
+    printf("testing SP/SC ring buffer of 32-byte descriptors\n");
+    test_desc(P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_SCDEQ);
+    printf("testing MP/MC ring buffer of 32-byte descriptors\n");
+    test_desc(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_MCDEQ);
+    printf("testing blocking wait SP/SC ring buffer\n");
+    test_wait(P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_SCDEQ);
+    printf("testing blocking wait MP/MC ring buffer\n");
+    test_wait(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_MCDEQ);
+    printf("testing blocking wait MP/LFC ring buffer\n");
+    test_wait(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_LFDEQ);
+    printf("testing blocking wait NBMP/NBMC ring buffer\n");
+    test_wait(P64_RINGBUF_F_NBENQ | P64_RINGBUF_F_NBDEQ);
+    printf("testing SP/SC ring buffer in shared memory\n");
+    test_shared(P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_SCDEQ);
+    printf("testing MP/MC ring buffer in shared memory\n");
+    test_shared(P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_MCDEQ);
     printf("testing NBDEQ/LFDEQ ring buffer (invalid)\n");//Invalid flags
     p64_errhnd_install(error_handler);
     if (setjmp(jmpbuf) == 0)
@@ -0,0 +1,106 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "p64_ringset.h"
+
+#include "expect.h"
+
+static void *
+delayed_enqueue(void *arg)
+{
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = 20000000 };
+    nanosleep(&ts, NULL);
+    uint32_t ret = p64_lfring_enqueue(arg, (void *[]){ (void *)7 }, 1);
+    EXPECT(ret == 1);
+    return NULL;
+}
+
+int main(void)
+{
+    void *vec[4];
+    uint32_t ret, ringidx;
+    pthread_t tid;
+
+    printf("testing ring set\n");
+    p64_ringset_t *set = p64_ringset_alloc(P64_RINGSET_F_WAIT);
+    EXPECT(set != NULL);
+    p64_ringbuf_t *rb0 = p64_ringbuf_alloc(4, P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_SCDEQ, sizeof(void *));
+    p64_ringbuf_t *rb1 = p64_ringbuf_alloc(4, P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_MCDEQ, sizeof(void *));
+    p64_ringbuf_t *rb2 = p64_ringbuf_alloc(4, P64_RINGBUF_F_MPENQ | P64_RINGBUF_F_LFDEQ, sizeof(void *));
+    p64_lfring_t *lfr = p64_lfring_alloc(4, P64_LFRING_F_MPENQ | P64_LFRING_F_MCDEQ);
+    EXPECT(p64_ringset_add_ringbuf(set, rb0) == 0);
+    EXPECT(p64_ringset_add_ringbuf(set, rb1) == 1);
+    EXPECT(p64_ringset_add_ringbuf(set, rb2) == 2);
+    EXPECT(p64_ringset_add_lfring(set, lfr) == 3);
+
+    //Newly added rings are marked ready until found empty
+    EXPECT(p64_ringset_ready(set) == 0xF);
+    ret = p64_ringset_dequeue(set, vec, 4, &ringidx);
+    EXPECT(ret == 0);
+    EXPECT(p64_ringset_ready(set) == 0);
+
+    //Ring stays ready while it might contain more elements
+    ret = p64_ringbuf_enqueue(rb1, (void *[]){ (void *)1, (void *)2, (void *)3 }, 3);
+    EXPECT(ret == 3);
+    EXPECT(p64_ringset_ready(set) == 0x2);
+    ret = p64_ringset_dequeue(set, vec, 2, &ringidx);
+    EXPECT(ret == 2);
+    EXPECT(ringidx == 1);
+    EXPECT(vec[0] == (void *)1 && vec[1] == (void *)2);
+    EXPECT(p64_ringset_ready(set) == 0x2);
+    ret = p64_ringset_dequeue(set, vec, 2, &ringidx);
+    EXPECT(ret == 1);
+    EXPECT(ringidx == 1);
+    EXPECT(vec[0] == (void *)3);
+    EXPECT(p64_ringset_ready(set) == 0);
+
+    //Rings are serviced in round-robin order, starting after ring 1
+    ret = p64_ringbuf_enqueue(rb0, (void *[]){ (void *)4 }, 1);
+    EXPECT(ret == 1);
+    ret = p64_ringbuf_enqueue(rb2, (void *[]){ (void *)5 }, 1);
+    EXPECT(ret == 1);
+    ret = p64_lfring_enqueue(lfr, (void *[]){ (void *)6 }, 1);
+    EXPECT(ret == 1);
+    EXPECT(p64_ringset_ready(set) == 0xD);
+    ret = p64_ringset_dequeue(set, vec, 4, &ringidx);
+    EXPECT(ret == 1 && ringidx == 2 && vec[0] == (void *)5);
+    ret = p64_ringset_dequeue(set, vec, 4, &ringidx);
+    EXPECT(ret == 1 && ringidx == 3 && vec[0] == (void *)6);
+    ret = p64_ringset_dequeue(set, vec, 4, &ringidx);
+    EXPECT(ret == 1 && ringidx == 0 && vec[0] == (void *)4);
+    ret = p64_ringset_dequeue(set, vec, 4, &ringidx);
+    EXPECT(ret == 0);
+
+    printf("testing ring set wait\n");
+    ret = p64_ringset_dequeue_wait(set, vec, 4, &ringidx, 1000000);
+    EXPECT(ret == 0);
+    EXPECT(pthread_create(&tid, NULL, delayed_enqueue, lfr) == 0);
+    ret = p64_ringset_dequeue_wait(set, vec, 4, &ringidx, P64_RINGSET_WAIT_FOREVER);
+    EXPECT(pthread_join(tid, NULL) == 0);
+    EXPECT(ret == 1 && ringidx == 3 && vec[0] == (void *)7);
+
+    //Removed rings are not marked
+    p64_ringset_remove(set, 1);
+    ret = p64_ringbuf_enqueue(rb1, (void *[]){ (void *)8 }, 1);
+    EXPECT(ret == 1);
+    EXPECT(p64_ringset_ready(set) == 0);
+    ret = p64_ringbuf_dequeue(rb1, vec, 4, &ringidx);
+    EXPECT(ret == 1);
+
+    p64_ringset_free(set);
+    p64_ringbuf_free(rb0);
+    p64_ringbuf_free(rb1);
+    p64_ringbuf_free(rb2);
+    p64_lfring_free(lfr);
+    printf("ring set tests complete\n");
+    return 0;
+}
@@ -0,0 +1,290 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64_barrier.h"
+#include "p64_ebr.h"
+#include "p64_hazardera.h"
+#include "p64_hazardptr.h"
+#include "p64_qsbr.h"
+#include "p64_segqueue.h"
+#include "expect.h"
+
+#define NUM_HAZARD_POINTERS 1
+#define NUM_ELEMS 1000
+#define NUM_THREADS 4
+
+#define USE_QSBR(f) \
+    (((f) & (P64_SEGQUEUE_F_HP | P64_SEGQUEUE_F_EBR | P64_SEGQUEUE_F_HE)) == 0)
+
+static void
+test_sq(uint32_t flags)
+{
+    p64_hpdomain_t *hpd = NULL;
+    p64_qsbrdomain_t *qsbr = NULL;
+    p64_ebrdomain_t *ebr = NULL;
+    p64_hedomain_t *hed = NULL;
+    if (flags & P64_SEGQUEUE_F_HP)
+    {
+	hpd = p64_hazptr_alloc(10, NUM_HAZARD_POINTERS);
+	EXPECT(hpd != NULL);
+	p64_hazptr_register(hpd);
+    }
+    else if (flags & P64_SEGQUEUE_F_EBR)
+    {
+	ebr = p64_ebr_alloc(10);
+	EXPECT(ebr != NULL);
+	p64_ebr_register(ebr);
+    }
+    else if (flags & P64_SEGQUEUE_F_HE)
+    {
+	hed = p64_hazera_alloc(10, NUM_HAZARD_POINTERS);
+	EXPECT(hed != NULL);
+	p64_hazera_register(hed);
+    }
+    else
+    {
+	qsbr = p64_qsbr_alloc(10);
+	EXPECT(qsbr != NULL);
+	p64_qsbr_register(qsbr);
+    }
+
+    p64_segqueue_t *sq = p64_segqueue_alloc(16, flags);
+    EXPECT(sq != NULL);
+    EXPECT(p64_segqueue_dequeue(sq) == NULL);
+    EXPECT(p64_segqueue_enqueue(sq, (void *)1));
+    EXPECT(p64_segqueue_dequeue(sq) == (void *)1);
+    EXPECT(p64_segqueue_dequeue(sq) == NULL);
+
+    //Queue grows beyond one segment and shrinks again
+    for (uintptr_t i = 1; i <= NUM_ELEMS; i++)
+    {
+	EXPECT(p64_segqueue_enqueue(sq, (void *)i));
+    }
+    for (uintptr_t i = 1; i <= NUM_ELEMS / 2; i++)
+    {
+	EXPECT(p64_segqueue_dequeue(sq) == (void *)i);
+    }
+    //Interleave enqueue and dequeue
+    for (uintptr_t i = NUM_ELEMS + 1; i <= 2 * NUM_ELEMS; i++)
+    {
+	EXPECT(p64_segqueue_enqueue(sq, (void *)i));
+	EXPECT(p64_segqueue_dequeue(sq) == (void *)(i - NUM_ELEMS / 2));
+    }
+    for (uintptr_t i = 3 * NUM_ELEMS / 2 + 1; i <= 2 * NUM_ELEMS; i++)
+    {
+	EXPECT(p64_segqueue_dequeue(sq) == (void *)i);
+    }
+    EXPECT(p64_segqueue_dequeue(sq) == NULL);
+
+    p64_segqueue_free(sq);
+    //Retired segments are reclaimed
+    if (flags & P64_SEGQUEUE_F_HP)
+    {
+	EXPECT(p64_hazptr_reclaim() == 0);
+	p64_hazptr_unregister();
+	p64_hazptr_free(hpd);
+    }
+    else if (flags & P64_SEGQUEUE_F_EBR)
+    {
+	EXPECT(p64_ebr_reclaim() == 0);
+	p64_ebr_unregister();
+	p64_ebr_free(ebr);
+    }
+    else if (flags & P64_SEGQUEUE_F_HE)
+    {
+	EXPECT(p64_hazera_reclaim() == 0);
+	p64_hazera_unregister();
+	p64_hazera_free(hed);
+    }
+    else
+    {
+	p64_qsbr_quiescent();
+	EXPECT(p64_qsbr_reclaim() == 0);
+	p64_qsbr_unregister();
+	p64_qsbr_free(qsbr);
+    }
+}
+
+//Shared state for the multi-threaded test
+static p64_segqueue_t *SQ;
+static uint32_t FLAGS;
+static void *DOMAIN;
+static p64_barrier_t BARRIER;
+static uint32_t NDEQUEUED;
+static uint32_t SEEN[NUM_THREADS * NUM_ELEMS];
+
+static void
+mark_dequeued(void *elem)
+{
+    uintptr_t v = (uintptr_t)elem;
+    EXPECT(v >= 1 && v <= NUM_THREADS * NUM_ELEMS);
+    __atomic_fetch_add(&SEEN[v - 1], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&NDEQUEUED, 1, __ATOMIC_RELAXED);
+}
+
+static void
+try_dequeue(void)
+{
+    void *elem = p64_segqueue_dequeue(SQ);
+    if (elem != NULL)
+    {
+	mark_dequeued(elem);
+    }
+    if (USE_QSBR(FLAGS))
+    {
+	p64_qsbr_quiescent();
+    }
+}
+
+//Every thread is both producer and consumer
+static void *
+mpmc_thread(void *arg)
+{
+    uintptr_t tidx = (uintptr_t)arg;
+    if (FLAGS & P64_SEGQUEUE_F_HP)
+    {
+	p64_hazptr_register(DOMAIN);
+    }
+    else if (FLAGS & P64_SEGQUEUE_F_EBR)
+    {
+	p64_ebr_register(DOMAIN);
+    }
+    else if (FLAGS & P64_SEGQUEUE_F_HE)
+    {
+	p64_hazera_register(DOMAIN);
+    }
+    else
+    {
+	p64_qsbr_register(DOMAIN);
+    }
+    p64_barrier_wait(&BARRIER);
+    for (uintptr_t i = 1; i <= NUM_ELEMS; i++)
+    {
+	EXPECT(p64_segqueue_enqueue(SQ, (void *)(tidx * NUM_ELEMS + i)));
+	try_dequeue();
+    }
+    while (__atomic_load_n(&NDEQUEUED, __ATOMIC_RELAXED) !=
+	   NUM_THREADS * NUM_ELEMS)
+    {
+	try_dequeue();
+    }
+    //Don't hold up reclamation by threads still dequeuing
+    if (USE_QSBR(FLAGS))
+    {
+	p64_qsbr_deactivate();
+    }
+    //No thread accesses the queue after this barrier
+    p64_barrier_wait(&BARRIER);
+    if (FLAGS & P64_SEGQUEUE_F_HP)
+    {
+	EXPECT(p64_hazptr_reclaim() == 0);
+	p64_hazptr_unregister();
+    }
+    else if (FLAGS & P64_SEGQUEUE_F_EBR)
+    {
+	EXPECT(p64_ebr_reclaim() == 0);
+	p64_ebr_unregister();
+    }
+    else if (FLAGS & P64_SEGQUEUE_F_HE)
+    {
+	EXPECT(p64_hazera_reclaim() == 0);
+	p64_hazera_unregister();
+    }
+    else
+    {
+	EXPECT(p64_qsbr_reclaim() == 0);
+	p64_qsbr_unregister();
+    }
+    return NULL;
+}
+
+//Multiple producers and consumers, every element must be dequeued exactly
+//once
+static void
+test_mpmc(uint32_t flags)
+{
+    pthread_t tid[NUM_THREADS];
+    FLAGS = flags;
+    if (flags & P64_SEGQUEUE_F_HP)
+    {
+	DOMAIN = p64_hazptr_alloc(100, NUM_HAZARD_POINTERS);
+    }
+    else if (flags & P64_SEGQUEUE_F_EBR)
+    {
+	DOMAIN = p64_ebr_alloc(100);
+    }
+    else if (flags & P64_SEGQUEUE_F_HE)
+    {
+	DOMAIN = p64_hazera_alloc(100, NUM_HAZARD_POINTERS);
+    }
+    else
+    {
+	DOMAIN = p64_qsbr_alloc(100);
+    }
+    EXPECT(DOMAIN != NULL);
+    SQ = p64_segqueue_alloc(16, flags);
+    EXPECT(SQ != NULL);
+    NDEQUEUED = 0;
+    for (uint32_t i = 0; i < NUM_THREADS * NUM_ELEMS; i++)
+    {
+	SEEN[i] = 0;
+    }
+    p64_barrier_init(&BARRIER, NUM_THREADS);
+    for (uintptr_t t = 0; t < NUM_THREADS; t++)
+    {
+	EXPECT(pthread_create(&tid[t], NULL, mpmc_thread, (void *)t) == 0);
+    }
+    for (uint32_t t = 0; t < NUM_THREADS; t++)
+    {
+	EXPECT(pthread_join(tid[t], NULL) == 0);
+    }
+    for (uint32_t i = 0; i < NUM_THREADS * NUM_ELEMS; i++)
+    {
+	EXPECT(SEEN[i] == 1);
+    }
+    p64_segqueue_free(SQ);
+    if (flags & P64_SEGQUEUE_F_HP)
+    {
+	p64_hazptr_free(DOMAIN);
+    }
+    else if (flags & P64_SEGQUEUE_F_EBR)
+    {
+	p64_ebr_free(DOMAIN);
+    }
+    else if (flags & P64_SEGQUEUE_F_HE)
+    {
+	p64_hazera_free(DOMAIN);
+    }
+    else
+    {
+	p64_qsbr_free(DOMAIN);
+    }
+}
+
+int main(void)
+{
+    printf("testing segmented queue with hazard pointers\n");
+    test_sq(P64_SEGQUEUE_F_HP);
+    printf("testing segmented queue with QSBR\n");
+    test_sq(0);
+    printf("testing segmented queue with EBR\n");
+    test_sq(P64_SEGQUEUE_F_EBR);
+    printf("testing segmented queue with hazard eras\n");
+    test_sq(P64_SEGQUEUE_F_HE);
+    printf("testing segmented queue MPMC with hazard pointers\n");
+    test_mpmc(P64_SEGQUEUE_F_HP);
+    printf("testing segmented queue MPMC with QSBR\n");
+    test_mpmc(0);
+    printf("testing segmented queue MPMC with EBR\n");
+    test_mpmc(P64_SEGQUEUE_F_EBR);
+    printf("testing segmented queue MPMC with hazard eras\n");
+    test_mpmc(P64_SEGQUEUE_F_HE);
+    printf("segmented queue test complete\n");
+    return 0;
+}
@@ -0,0 +1,92 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64_errhnd.h"
+#include "p64_hazardptr.h"
+#include "p64_qsbr.h"
+#include "p64_threads.h"
+#include "expect.h"
+
+//More than the default maximum number of threads
+#define NUMTHREADS 160
+
+static p64_qsbrdomain_t *qsbr;
+static p64_hpdomain_t *hpd;
+static pthread_barrier_t barrier;
+static char objs[NUMTHREADS];
+static uint32_t nreclaimed = 0;
+
+static void
+callback(void *ptr)
+{
+    (void)ptr;
+    __atomic_fetch_add(&nreclaimed, 1, __ATOMIC_RELAXED);
+}
+
+static void *
+entrypoint(void *arg)
+{
+    p64_qsbr_register(qsbr);
+    p64_hazptr_register(hpd);
+    //Wait until all threads have registered
+    pthread_barrier_wait(&barrier);
+    EXPECT(p64_qsbr_retire(arg, callback));
+    EXPECT(p64_hazptr_retire(arg, callback));
+    EXPECT(p64_hazptr_reclaim() == 0);
+    pthread_barrier_wait(&barrier);
+    p64_qsbr_quiescent();
+    pthread_barrier_wait(&barrier);
+    //All threads have passed a quiescent state after retiring
+    EXPECT(p64_qsbr_reclaim() == 0);
+    p64_hazptr_unregister();
+    p64_qsbr_unregister();
+    return NULL;
+}
+
+static int
+error_handler(const char *module, const char *error, uintptr_t val)
+{
+    printf("Expected error: %s: %s (%"PRIuPTR")\n", module, error, val);
+    return P64_ERRHND_RETURN;
+}
+
+int main(void)
+{
+    static pthread_t tid[NUMTHREADS];
+    p64_errhnd_install(error_handler);
+    EXPECT(!p64_threads_setmax(0));
+    EXPECT(!p64_threads_setmax(P64_THREADS_LIMIT + 1));
+    EXPECT(p64_threads_setmax(NUMTHREADS));
+    EXPECT(p64_threads_getmax() == NUMTHREADS);
+    qsbr = p64_qsbr_alloc(10);
+    EXPECT(qsbr != NULL);
+    hpd = p64_hazptr_alloc(10, 1);
+    EXPECT(hpd != NULL);
+    //Limit cannot be changed after it has been used
+    EXPECT(!p64_threads_setmax(2 * NUMTHREADS));
+    EXPECT(p64_threads_getmax() == NUMTHREADS);
+    p64_errhnd_install(NULL);
+    EXPECT(pthread_barrier_init(&barrier, NULL, NUMTHREADS) == 0);
+    for (uint32_t i = 0; i < NUMTHREADS; i++)
+    {
+	EXPECT(pthread_create(&tid[i], NULL, entrypoint, &objs[i]) == 0);
+    }
+    for (uint32_t i = 0; i < NUMTHREADS; i++)
+    {
+	EXPECT(pthread_join(tid[i], NULL) == 0);
+    }
+    EXPECT(nreclaimed == 2 * NUMTHREADS);
+    pthread_barrier_destroy(&barrier);
+    p64_hazptr_free(hpd);
+    p64_qsbr_free(qsbr);
+    printf("threads test complete\n");
+    return 0;
+}
@@ -0,0 +1,57 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Allocator API for Progress64
+//All memory allocated by Progress64 (objects, internal nodes, thread state)
+//can be provided by user-defined allocators instead of libc malloc
+//Each allocation is preceded by a header which records how to free it, also
+//with the default allocator, so memory returned by Progress64 (objects, CLH
+//lock nodes) cannot be passed to free(), use the matching p64_*_free function
+//The header is padded to the alignment of the allocation, e.g. 64 bytes for
+//cache line aligned objects
+
+#ifndef P64_ALLOCATOR_H
+#define P64_ALLOCATOR_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct p64_allocator
+{
+    //Allocate 'size' bytes aligned to 'alignment' (0 or a power of two)
+    //Return NULL on failure
+    void *(*alloc)(size_t size, size_t alignment, void *arg);
+    //Free memory returned by 'alloc'
+    void (*free)(void *ptr, void *arg);
+    void *arg;
+} p64_allocator_t;
+
+//Install process-wide allocator
+//Must be installed before any Progress64 objects are allocated and remain
+//installed while they are in use
+//Specify NULL to revert to the default (libc) allocator
+void
+p64_allocator_install(const p64_allocator_t *alloc);
+
+//Set allocator for the calling thread, overriding the process-wide allocator
+//E.g. set around a p64_*_alloc() call to allocate a specific object from a
+//specific arena
+//Memory from a per-thread allocator is returned to it when freed, also when
+//freed by other threads
+//Later allocations by the object (e.g. new segments or tables, thread state)
+//come from the allocator in effect when the object was allocated, also when
+//made by other threads
+//Specify NULL to revert to the process-wide allocator
+void
+p64_allocator_set(const p64_allocator_t *alloc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -30,6 +30,7 @@ p64_antireplay_t *
 p64_antireplay_alloc(uint32_t winsize,
 		     bool swizzle);
 
+//Memory from p64_antireplay_alloc() cannot be passed to free()
 void
 p64_antireplay_free(p64_antireplay_t *arwin);
 
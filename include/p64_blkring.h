@@ -28,6 +28,7 @@ p64_blkring_alloc(uint32_t nelems);
 
 //Free ring buffer
 //The ring buffer must be empty
+//Memory from p64_blkring_alloc() cannot be passed to free()
 void
 p64_blkring_free(p64_blkring_t *rb);
 
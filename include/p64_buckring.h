@@ -23,6 +23,7 @@ p64_buckring_alloc(uint32_t nelems, uint32_t flags);
 
 //Free a buck ring buffer
 //The ring buffer must be empty
+//Memory from p64_buckring_alloc() cannot be passed to free()
 void
 p64_buckring_free(p64_buckring_t *rb);
 
@@ -37,6 +38,15 @@ uint32_t
 p64_buckring_dequeue(p64_buckring_t *rb, void *ev[], uint32_t num,
 		     uint32_t *index);
 
+//Dequeue at least 'min' and at most 'num' elements from a buck ring buffer
+//If fewer than 'min' elements are available, nothing is dequeued
+//'min' == 'num' dequeues exactly 'num' elements or nothing
+//'min' <= 'num'
+//Return the number of actually dequeued elements, 0 or 'min'..'num'
+uint32_t
+p64_buckring_dequeue_min(p64_buckring_t *rb, void *ev[], uint32_t num,
+			 uint32_t *index, uint32_t min);
+
 #ifdef __cplusplus
 }
 #endif
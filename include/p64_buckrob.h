@@ -32,6 +32,7 @@ p64_buckrob_t *p64_buckrob_alloc(uint32_t nelems,
 
 //Free a reorder buffer
 //The reorder buffer must be empty
+//Memory from p64_buckrob_alloc() cannot be passed to free()
 void p64_buckrob_free(p64_buckrob_t *rob);
 
 //Acquire space in the reorder buffer
@@ -29,12 +29,16 @@ void p64_clhlock_fini(p64_clhlock_t *lock);
 
 //Acquire a CLH lock
 //*nodep will be written with a pointer to a p64_clhnode_t object, this
-//object must eventually be freed
+//object must eventually be freed using p64_clhlock_free_node(), it cannot be
+//passed to free()
 void p64_clhlock_acquire(p64_clhlock_t *lock, p64_clhnode_t **nodep);
 
 //Release a CLH lock
 void p64_clhlock_release(p64_clhnode_t **nodep);
 
+//Free a p64_clhnode_t object (NULL is allowed)
+void p64_clhlock_free_node(p64_clhnode_t *node);
+
 #ifdef __cplusplus
 }
 #endif
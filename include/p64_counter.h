@@ -23,6 +23,7 @@ p64_cntdomain_t *p64_cntdomain_alloc(uint32_t ncounters, uint32_t flags);
 
 //Free a counter domain
 //No registered threads may remain
+//Memory from p64_cntdomain_alloc() cannot be passed to free()
 void p64_cntdomain_free(p64_cntdomain_t *cntd);
 
 //Register a thread, allocate per-thread resources
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "p64_hazardptr.h"
+#include "p64_hashstats.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -17,6 +18,9 @@ extern "C"
 #endif
 
 #define P64_CUCKOOHT_F_HP      0x0001 //Use hazard pointers (default QSBR)
+#define P64_CUCKOOHT_F_GROW    0x0002 //Grow when full (requires QSBR or EBR)
+#define P64_CUCKOOHT_F_STATS   0x0004 //Collect statistics
+#define P64_CUCKOOHT_F_EBR     0x0008 //Use epoch based reclamation
 
 typedef uintptr_t p64_cuckoohash_t;
 
@@ -38,6 +42,8 @@ typedef void (*p64_cuckooht_trav_cb)(void *arg,
 //Allocate a hash table with space for at least 'nelems' elements in the main
 //hash table and 'ncells' elements in the backup cellar
 //Specify a key compare function which is used when hashes are identical
+//With P64_CUCKOOHT_F_GROW, a full table is replaced by a table twice the size
+//and elements are migrated incrementally by inserting and removing threads
 p64_cuckooht_t *
 p64_cuckooht_alloc(size_t nelems,
 		   size_t ncells,
@@ -46,13 +52,15 @@ p64_cuckooht_alloc(size_t nelems,
 
 //Free a hash table
 //The hash table must be empty
+//Memory from p64_cuckooht_alloc() cannot be passed to free()
 void
 p64_cuckooht_free(p64_cuckooht_t *);
 
 //Lookup an element in the hash table, given the key and a hash value of the key
 //If the element is found, the hazard pointer will contain a reference which
 //must eventually be released
-//Caller must call QSBR acquire/release/quiescent as appropriate
+//Caller must call QSBR acquire/release/quiescent (or EBR enter/exit) as
+//appropriate
 p64_cuckooelem_t *
 p64_cuckooht_lookup(p64_cuckooht_t *ht,
 		    const void *key,
@@ -60,8 +68,9 @@ p64_cuckooht_lookup(p64_cuckooht_t *ht,
 		    p64_hazardptr_t *hp);
 
 //Look up a vector of elements, given the keys and corresponding hashes
-//Must only be used with QSBR!
-//Caller must call QSBR acquire/release/quiescent as appropriate
+//Must only be used with QSBR or EBR!
+//Caller must call QSBR acquire/release/quiescent (or EBR enter/exit) as
+//appropriate
 void
 p64_cuckooht_lookup_vec(p64_cuckooht_t *ht,
 			uint32_t num,
@@ -70,13 +79,24 @@ p64_cuckooht_lookup_vec(p64_cuckooht_t *ht,
 			p64_cuckooelem_t *result[num]);
 
 //Insert an element into the hash table
-//Return true if insertion succeeds, false otherwise
+//Return true if insertion succeeds, false otherwise (table full and cannot
+//grow)
 //Element must be 32-byte aligned (5-lsb must be zero)
 bool
 p64_cuckooht_insert(p64_cuckooht_t *ht,
 		    p64_cuckooelem_t *elem,
 		    p64_cuckoohash_t hash);
 
+//Insert multiple elements, success[i] indicates if elems[i] was inserted
+//All target buckets are prefetched before any element is inserted
+//Return number of inserted elements
+uint32_t
+p64_cuckooht_insert_vec(p64_cuckooht_t *ht,
+			uint32_t num,
+			p64_cuckooelem_t *elems[num],
+			p64_cuckoohash_t hashes[num],
+			bool success[num]);
+
 //Remove specified element
 //Return true if removal successful, false otherwise (element not found)
 bool
@@ -84,10 +104,21 @@ p64_cuckooht_remove(p64_cuckooht_t *ht,
 		    p64_cuckooelem_t *elem,
 		    p64_cuckoohash_t hash);
 
+//Remove multiple elements, success[i] indicates if elems[i] was removed
+//All target buckets are prefetched before any element is removed
+//Return number of removed elements
+uint32_t
+p64_cuckooht_remove_vec(p64_cuckooht_t *ht,
+			uint32_t num,
+			p64_cuckooelem_t *elems[num],
+			p64_cuckoohash_t hashes[num],
+			bool success[num]);
+
 #if 0
 //Remove and return element specified by key & hash
 //Return NULL if element not found
-//Caller must call QSBR acquire/release/quiescent as appropriate
+//Caller must call QSBR acquire/release/quiescent (or EBR enter/exit) as
+//appropriate
 void *
 p64_cuckooht_remove_by_key(p64_cuckooht_t *ht,
 			   const void *key,
@@ -96,11 +127,18 @@ p64_cuckooht_remove_by_key(p64_cuckooht_t *ht,
 #endif
 
 //Traverse hash table, calling user-defined call-back for every element
+//Elements may be reported twice if a grow is in progress
 void
 p64_cuckooht_traverse(p64_cuckooht_t *ht,
 		       p64_cuckooht_trav_cb cb,
 		       void *arg);
 
+//Read statistics, counters are only valid if P64_CUCKOOHT_F_STATS was
+//specified
+void
+p64_cuckooht_stats(p64_cuckooht_t *ht,
+		   p64_hashstats_t *st);
+
 #ifdef __cplusplus
 }
 #endif
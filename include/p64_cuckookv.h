@@ -0,0 +1,369 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Cuckoo hash table with fixed-size keys and word-sized values stored inline
+//in the buckets
+//A lookup only reads the two candidate buckets and never dereferences any
+//element or calls any user-defined compare function
+//Lookups are optimistic (each bucket is protected by a seqlock) and never
+//write to shared memory, insertions and removals lock the affected buckets
+//Keys are compared bitwise so any padding in the key type must be cleared
+//See p64_cuckookv_template.h for a version specialised for the key type
+
+#ifndef P64_CUCKOOKV_H
+#define P64_CUCKOOKV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef uintptr_t p64_cuckookvhash_t;
+
+//Internal representation, exposed for the benefit of the inline lookup
+typedef struct p64_cuckookv
+{
+    uint32_t nbkts;//Number of buckets
+    uint32_t ksize;//Size of key
+    char *buckets;
+} p64_cuckookv_t;
+
+//Allocate a hash table with space for at least 'nelems' elements with keys
+//of size 'ksize'
+//The table is sized for a maximum load factor of 80%
+p64_cuckookv_t *
+p64_cuckookv_alloc(size_t nelems, size_t ksize);
+
+//Free a hash table
+//The hash table must be empty
+//Memory from p64_cuckookv_alloc() cannot be passed to free()
+void
+p64_cuckookv_free(p64_cuckookv_t *kv);
+
+//Lookup a key in the hash table, given the key and a hash value of the key
+//Return true and write the associated value to '*val' if found
+bool
+p64_cuckookv_lookup(p64_cuckookv_t *kv,
+		    const void *key,
+		    p64_cuckookvhash_t hash,
+		    uintptr_t *val);
+
+//Insert a key and associated value into the hash table
+//Return false if the key is already present or the table is full
+bool
+p64_cuckookv_insert(p64_cuckookv_t *kv,
+		    const void *key,
+		    p64_cuckookvhash_t hash,
+		    uintptr_t val);
+
+//Remove a key from the hash table
+//Return true and write the associated value to '*val' (unless NULL) if found
+bool
+p64_cuckookv_remove(p64_cuckookv_t *kv,
+		    const void *key,
+		    p64_cuckookvhash_t hash,
+		    uintptr_t *val);
+
+//Special functions and definitions used by templates
+
+//Bucket layout: seqlock, signatures, values, keys
+//Buckets are a multiple of P64_CUCKOOKV_BKTSIZE bytes
+#define P64_CUCKOOKV_BKTSIZE 64
+
+//Key stride, keys are aligned so that they can be read using word loads
+static inline size_t
+p64_cuckookv_kstride_(size_t ksize)
+{
+    if (ksize >= sizeof(uintptr_t))
+    {
+	return (ksize + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+    }
+    size_t stride = 1;
+    while (stride < ksize)
+    {
+	stride <<= 1;
+    }
+    return stride;
+}
+
+static inline size_t
+p64_cuckookv_valoff_(uint32_t nslots)
+{
+    size_t off = sizeof(uint32_t) * (1 + nslots);
+    return (off + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+}
+
+static inline size_t
+p64_cuckookv_keyoff_(uint32_t nslots)
+{
+    return p64_cuckookv_valoff_(nslots) + sizeof(uintptr_t) * nslots;
+}
+
+//Number of slots per bucket, as many as fit in P64_CUCKOOKV_BKTSIZE bytes
+//At least two slots, cuckoo hashing with one-slot buckets only reaches 50% load
+static inline uint32_t
+p64_cuckookv_nslots_(size_t ksize)
+{
+    size_t stride = p64_cuckookv_kstride_(ksize);
+    uint32_t nslots = 2;
+    while (p64_cuckookv_keyoff_(nslots + 1) + (nslots + 1) * stride <=
+	   P64_CUCKOOKV_BKTSIZE)
+    {
+	nslots++;
+    }
+    return nslots;
+}
+
+static inline size_t
+p64_cuckookv_bktsize_(size_t ksize)
+{
+    uint32_t nslots = p64_cuckookv_nslots_(ksize);
+    size_t sz = p64_cuckookv_keyoff_(nslots) +
+		nslots * p64_cuckookv_kstride_(ksize);
+    return (sz + P64_CUCKOOKV_BKTSIZE - 1) & ~(size_t)(P64_CUCKOOKV_BKTSIZE - 1);
+}
+
+//Signature stored in bucket, 0 marks an empty slot
+static inline uint32_t
+p64_cuckookv_sig_(p64_cuckookvhash_t hash)
+{
+    uint32_t sig = (uint32_t)hash ^ (uint32_t)((uint64_t)hash >> 32);
+    return sig != 0 ? sig : 1;
+}
+
+//Both bucket indices are computed from the signature so that an element
+//can be moved to its alternative bucket without knowing the full hash
+static inline uint32_t
+p64_cuckookv_bix0_(uint32_t sig, uint32_t nbkts)
+{
+    return (uint32_t)(((uint64_t)sig * nbkts) >> 32);
+}
+
+static inline uint32_t
+p64_cuckookv_bix1_(uint32_t sig, uint32_t nbkts)
+{
+    uint32_t bix0 = p64_cuckookv_bix0_(sig, nbkts);
+    uint32_t bix1 = p64_cuckookv_bix0_(sig * 2654435769U, nbkts);
+    if (bix1 == bix0)
+    {
+	bix1 = bix1 + 1 < nbkts ? bix1 + 1 : 0;
+    }
+    return bix1;
+}
+
+//Compare key in bucket (which may be written concurrently) with 'key'
+__attribute__((always_inline))
+static inline bool
+p64_cuckookv_keyeq_(const char *slot, const void *k_, size_t ksize)
+{
+    const char *key = k_;
+    uintptr_t diff = 0;
+#if __SIZEOF_POINTER__ == 8
+    for (; ksize >= sizeof(uint64_t); ksize -= sizeof(uint64_t))
+    {
+	uint64_t k;
+	memcpy(&k, key, sizeof k);
+	diff |= __atomic_load_n((const uint64_t *)slot, __ATOMIC_RELAXED) ^ k;
+	slot += sizeof k;
+	key += sizeof k;
+    }
+#endif
+    for (; ksize >= sizeof(uint32_t); ksize -= sizeof(uint32_t))
+    {
+	uint32_t k;
+	memcpy(&k, key, sizeof k);
+	diff |= __atomic_load_n((const uint32_t *)slot, __ATOMIC_RELAXED) ^ k;
+	slot += sizeof k;
+	key += sizeof k;
+    }
+    if (ksize >= sizeof(uint16_t))
+    {
+	uint16_t k;
+	memcpy(&k, key, sizeof k);
+	diff |= __atomic_load_n((const uint16_t *)slot, __ATOMIC_RELAXED) ^ k;
+	slot += sizeof k;
+	key += sizeof k;
+	ksize -= sizeof k;
+    }
+    if (ksize != 0)
+    {
+	diff |= __atomic_load_n((const uint8_t *)slot, __ATOMIC_RELAXED) ^
+		*(const uint8_t *)key;
+    }
+    return diff == 0;
+}
+
+//Copy key from bucket (which may be written concurrently) to 'dst'
+__attribute__((always_inline))
+static inline void
+p64_cuckookv_keycpy_(void *dst, const char *slot, size_t ksize)
+{
+    char *d = dst;
+#if __SIZEOF_POINTER__ == 8
+    for (; ksize >= sizeof(uint64_t); ksize -= sizeof(uint64_t))
+    {
+	uint64_t k = __atomic_load_n((const uint64_t *)slot, __ATOMIC_RELAXED);
+	memcpy(d, &k, sizeof k);
+	slot += sizeof k;
+	d += sizeof k;
+    }
+#endif
+    for (; ksize >= sizeof(uint32_t); ksize -= sizeof(uint32_t))
+    {
+	uint32_t k = __atomic_load_n((const uint32_t *)slot, __ATOMIC_RELAXED);
+	memcpy(d, &k, sizeof k);
+	slot += sizeof k;
+	d += sizeof k;
+    }
+    if (ksize >= sizeof(uint16_t))
+    {
+	uint16_t k = __atomic_load_n((const uint16_t *)slot, __ATOMIC_RELAXED);
+	memcpy(d, &k, sizeof k);
+	slot += sizeof k;
+	d += sizeof k;
+	ksize -= sizeof k;
+    }
+    if (ksize != 0)
+    {
+	*d = __atomic_load_n((const char *)slot, __ATOMIC_RELAXED);
+    }
+}
+
+//Key compare function used by the inline lookup, 'slot' points to a key
+//in a bucket which may be written concurrently
+typedef bool (*p64_cuckookv_slotcmp_)(const char *slot,
+				       const void *key,
+				       size_t ksize);
+
+//Search bucket for matching key, bucket must be validated by caller
+__attribute__((always_inline))
+static inline bool
+p64_cuckookv_search_(const char *bkt,
+		     uint32_t sig,
+		     const void *key,
+		     uintptr_t *val,
+		     size_t ksize,
+		     p64_cuckookv_slotcmp_ eq)
+{
+    const uint32_t nslots = p64_cuckookv_nslots_(ksize);
+    const uint32_t *sigs = (const uint32_t *)bkt + 1;
+    const uintptr_t *vals =
+	(const uintptr_t *)(bkt + p64_cuckookv_valoff_(nslots));
+    const char *keys = bkt + p64_cuckookv_keyoff_(nslots);
+    for (uint32_t i = 0; i < nslots; i++)
+    {
+	if (__atomic_load_n(&sigs[i], __ATOMIC_RELAXED) == sig &&
+	    eq(keys + i * p64_cuckookv_kstride_(ksize), key, ksize))
+	{
+	    *val = __atomic_load_n(&vals[i], __ATOMIC_RELAXED);
+	    return true;
+	}
+    }
+    return false;
+}
+
+//Wait for any writer to go away and return the seqlock value
+static inline uint32_t
+p64_cuckookv_acquire_rd_(const char *bkt)
+{
+    uint32_t seq;
+    while (((seq = __atomic_load_n((const uint32_t *)bkt,
+				   __ATOMIC_ACQUIRE)) & 1) != 0)
+    {
+    }
+    return seq;
+}
+
+static inline bool
+p64_cuckookv_release_rd_(const char *bkt, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n((const uint32_t *)bkt, __ATOMIC_RELAXED) == seq;
+}
+
+//Lookup using the specified key compare function, when 'eq' is a constant
+//the compare function is inlined
+__attribute__((always_inline))
+static inline bool
+p64_cuckookv_lookup_eq_(p64_cuckookv_t *kv,
+			const void *key,
+			p64_cuckookvhash_t hash,
+			uintptr_t *val,
+			size_t ksize,
+			p64_cuckookv_slotcmp_ eq)
+{
+    const size_t bktsize = p64_cuckookv_bktsize_(ksize);
+    uint32_t sig = p64_cuckookv_sig_(hash);
+    const char *bkt0 = kv->buckets +
+		       bktsize * p64_cuckookv_bix0_(sig, kv->nbkts);
+    const char *bkt1 = kv->buckets +
+		       bktsize * p64_cuckookv_bix1_(sig, kv->nbkts);
+    __builtin_prefetch(bkt0, 0, 3);
+    __builtin_prefetch(bkt1, 0, 3);
+    for (;;)
+    {
+	//A hit only needs to validate the bucket where it was found
+	uint32_t seq0 = p64_cuckookv_acquire_rd_(bkt0);
+	if (p64_cuckookv_search_(bkt0, sig, key, val, ksize, eq) &&
+	    p64_cuckookv_release_rd_(bkt0, seq0))
+	{
+	    return true;
+	}
+	uint32_t seq1 = p64_cuckookv_acquire_rd_(bkt1);
+	if (p64_cuckookv_search_(bkt1, sig, key, val, ksize, eq) &&
+	    p64_cuckookv_release_rd_(bkt1, seq1))
+	{
+	    return true;
+	}
+	//A miss must validate both buckets as elements are moved between
+	//them with both buckets locked
+	if (p64_cuckookv_release_rd_(bkt0, seq0) &&
+	    p64_cuckookv_release_rd_(bkt1, seq1))
+	{
+	    return false;
+	}
+    }
+}
+
+__attribute__((always_inline))
+static inline bool
+p64_cuckookv_lookup_(p64_cuckookv_t *kv,
+		     const void *key,
+		     p64_cuckookvhash_t hash,
+		     uintptr_t *val,
+		     size_t ksize)
+{
+    return p64_cuckookv_lookup_eq_(kv, key, hash, val, ksize,
+				   p64_cuckookv_keyeq_);
+}
+
+//Insert and remove using a user-defined key compare function
+//'eq' is only called for keys with matching signatures, with the bucket
+//locked, NULL means bitwise compare
+typedef bool (*p64_cuckookv_keycmp_)(const void *a, const void *b);
+
+bool
+p64_cuckookv_insert_(p64_cuckookv_t *kv,
+		     const void *key,
+		     p64_cuckookvhash_t hash,
+		     uintptr_t val,
+		     p64_cuckookv_keycmp_ eq);
+
+bool
+p64_cuckookv_remove_(p64_cuckookv_t *kv,
+		     const void *key,
+		     p64_cuckookvhash_t hash,
+		     uintptr_t *val,
+		     p64_cuckookv_keycmp_ eq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Cuckoo hash table with inline keys of user defined type
+//The key size is a compile time constant so bucket layout and key compare
+//are specialised for the key type
+
+#ifndef P64_CUCKOOKV_TEMPLATE_H
+#define P64_CUCKOOKV_TEMPLATE_H
+
+#include "p64_cuckookv.h"
+
+#ifndef P64_CONCAT
+#define P64_CONCAT(x, y) x ## y
+#endif
+
+#define P64_CUCKOOKV(_name, _key_t) \
+typedef p64_cuckookv_t P64_CONCAT(_name,_t); \
+\
+static inline P64_CONCAT(_name,_t) * \
+P64_CONCAT(_name,_alloc)(size_t nelems) \
+{ \
+    return p64_cuckookv_alloc(nelems, sizeof(_key_t)); \
+} \
+\
+static inline void \
+P64_CONCAT(_name,_free)(P64_CONCAT(_name,_t) *kv) \
+{ \
+    p64_cuckookv_free(kv); \
+} \
+\
+static inline bool \
+P64_CONCAT(_name,_lookup)(P64_CONCAT(_name,_t) *kv, const _key_t *key, p64_cuckookvhash_t hash, uintptr_t *val) \
+{ \
+    return p64_cuckookv_lookup_(kv, key, hash, val, sizeof(_key_t)); \
+} \
+\
+/* Return number of hits, hits[i] indicates if vals[i] is valid */ \
+static inline uint32_t \
+P64_CONCAT(_name,_lookup_vec)(P64_CONCAT(_name,_t) *kv, uint32_t num, const _key_t keys[], const p64_cuckookvhash_t hashes[], uintptr_t vals[], bool hits[]) \
+{ \
+    const size_t bktsize = p64_cuckookv_bktsize_(sizeof(_key_t)); \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+	uint32_t sig = p64_cuckookv_sig_(hashes[i]); \
+	__builtin_prefetch(kv->buckets + bktsize * p64_cuckookv_bix0_(sig, kv->nbkts), 0, 3); \
+	__builtin_prefetch(kv->buckets + bktsize * p64_cuckookv_bix1_(sig, kv->nbkts), 0, 3); \
+    } \
+    uint32_t nhits = 0; \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+	hits[i] = p64_cuckookv_lookup_(kv, &keys[i], hashes[i], &vals[i], sizeof(_key_t)); \
+	nhits += hits[i]; \
+    } \
+    return nhits; \
+} \
+\
+static inline bool \
+P64_CONCAT(_name,_insert)(P64_CONCAT(_name,_t) *kv, const _key_t *key, p64_cuckookvhash_t hash, uintptr_t val) \
+{ \
+    return p64_cuckookv_insert(kv, key, hash, val); \
+} \
+\
+static inline bool \
+P64_CONCAT(_name,_remove)(P64_CONCAT(_name,_t) *kv, const _key_t *key, p64_cuckookvhash_t hash, uintptr_t *val) \
+{ \
+    return p64_cuckookv_remove(kv, key, hash, val); \
+}
+
+#endif
@@ -0,0 +1,60 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Safe memory reclamation using epoch based reclamation
+//Threads access shared objects inside explicit critical sections, threads
+//outside critical sections never delay reclamation
+//Reading is cheap (no per-object overhead) but a thread which stays in a
+//critical section delays reclamation of all objects (unbounded memory)
+
+#ifndef P64_EBR_H
+#define P64_EBR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct p64_ebrdomain p64_ebrdomain_t;
+
+//Allocate an EBR domain where each thread will be able to have up to
+//'maxobjs' retired objects waiting for reclamation (0 < maxobjs <= 0x80000000)
+p64_ebrdomain_t *p64_ebr_alloc(uint32_t maxobjs);
+
+//Free an EBR domain
+//Memory from p64_ebr_alloc() cannot be passed to free()
+void p64_ebr_free(p64_ebrdomain_t *ebr);
+
+//Register a thread, allocate per-thread resources
+void p64_ebr_register(p64_ebrdomain_t *ebr);
+
+//Unregister a thread, free any per-thread resources
+void p64_ebr_unregister(void);
+
+//Enter critical section, references to shared objects may be acquired
+//Critical sections may be nested
+void p64_ebr_enter(void);
+
+//Exit critical section, all references acquired in the (outermost)
+//critical section have been released
+void p64_ebr_exit(void);
+
+//Retire a removed shared object
+//Call 'callback' when object is no longer referenced and can be destroyed
+//Return true if object could be retired, false otherwise (no space remaining)
+bool p64_ebr_retire(void *ptr, void (*callback)(void *ptr));
+
+//Force garbage reclamation
+//Return number of remaining unreclaimed objects
+uint32_t p64_ebr_reclaim(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Hash functions for use with the hash tables
+//CRC32C uses ARMv8 CRC32 or SSE4.2 instructions when available
+//The vector functions hash multiple keys at once using SIMD instructions
+//or by interleaving independent computations
+//The hash tables take p64_hashvalue_t (uintptr_t) hashes, on 64-bit targets
+//the output of the 64-bit functions can be passed directly to the
+//*_lookup_vec functions, 32-bit hashes must first be widened
+
+#ifndef P64_HASH_H
+#define P64_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined __ARM_FEATURE_CRC32
+#include <arm_acle.h>
+#elif defined __SSE4_2__
+#include <x86intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//CRC32C (Castagnoli polynomial) of 'len' bytes, 'seed' is the initial CRC
+//No pre- or post-inversion is performed, for standard CRC-32C use
+//~p64_hash_crc32c(data, len, ~0U)
+uint32_t
+p64_hash_crc32c(const void *data, size_t len, uint32_t seed);
+
+//Hash 'len' bytes using a wyhash style multiply-and-fold function
+uint64_t
+p64_hash_wyhash(const void *data, size_t len, uint64_t seed);
+
+//Hash 'num' keys of 'len' bytes each using CRC32C
+void
+p64_hash_crc32c_vec(uint32_t num,
+		    const void *keys[num],
+		    size_t len,
+		    uint32_t seed,
+		    uint32_t hashes[num]);
+
+//Hash 'num' keys of 'len' bytes each using wyhash
+void
+p64_hash_wyhash_vec(uint32_t num,
+		    const void *keys[num],
+		    size_t len,
+		    uint64_t seed,
+		    uint64_t hashes[num]);
+
+//Hash 'num' integer keys using p64_hash_mix32()/p64_hash_mix64()
+void
+p64_hash_mix32_vec(uint32_t num,
+		   const uint32_t keys[num],
+		   uint32_t hashes[num]);
+
+void
+p64_hash_mix64_vec(uint32_t num,
+		   const uint64_t keys[num],
+		   uint64_t hashes[num]);
+
+//Finalisation mix functions from MurmurHash3
+//All input bits affect all output bits, 0 maps to 0
+static inline uint32_t
+p64_hash_mix32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline uint64_t
+p64_hash_mix64(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+//CRC32C of a single integer key
+static inline uint32_t
+p64_hash_crc32c_u32(uint32_t key, uint32_t seed)
+{
+#if defined __ARM_FEATURE_CRC32
+    return __crc32cw(seed, key);
+#elif defined __SSE4_2__
+    return _mm_crc32_u32(seed, key);
+#else
+    return p64_hash_crc32c(&key, sizeof key, seed);
+#endif
+}
+
+static inline uint32_t
+p64_hash_crc32c_u64(uint64_t key, uint32_t seed)
+{
+#if defined __ARM_FEATURE_CRC32
+    return __crc32cd(seed, key);
+#elif defined __SSE4_2__ && defined __x86_64__
+    return (uint32_t)_mm_crc32_u64(seed, key);
+#else
+    return p64_hash_crc32c(&key, sizeof key, seed);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Statistics for hash tables (hashtable, cuckooht, hopscotch)
+//Enabled per hash table using the corresponding *_F_STATS flag
+//Counters are sharded per thread and can be read at any time, concurrent
+//updates may or may not be included in a snapshot
+
+#ifndef P64_HASHSTATS_H
+#define P64_HASHSTATS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//Number of entries in probe length histogram
+#define P64_HASHSTATS_NPROBES 8
+
+typedef struct p64_hashstats
+{
+    uint64_t nelems;//Current number of elements
+    uint64_t capacity;//Number of element slots in (current) main table
+    uint64_t cellar_size;//Number of cells in cellar
+    uint64_t cellar_used;//Current number of elements in cellar
+    uint64_t lookups;
+    uint64_t lookup_misses;
+    //Histogram of probe lengths for lookups, probes[i] counts lookups which
+    //examined i + 1 buckets (cuckooht), neighbourhood slots (hopscotch) or
+    //bucket and list elements (hashtable), a cellar search counts as one
+    //probe, the last entry includes all longer probe lengths
+    uint64_t probes[P64_HASHSTATS_NPROBES];
+    uint64_t inserts;//Successful insertions
+    uint64_t insert_fails;//Insertions failed due to table full
+    uint64_t removes;//Successful removals
+    uint64_t remove_fails;//Removals failed due to element not found
+    uint64_t relocations;//Elements moved to make room for insertion
+    uint64_t cas_retries;//Failed CAS operations that had to be retried
+} p64_hashstats_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,14 @@
 //A special twist is the set associative buckets
 //This is essentially a variation of the hash table described in Michael:
 //"High Performance Dynamic Lock-Free Hash Tables and List-Based Sets"
+//
+//With P64_HASHTAB_F_COMPACT, element pointers and hash fragments are stored
+//directly in cache line sized buckets and elements which do not fit in their
+//home bucket overflow into the following buckets (open addressing)
+//Elements do not need to embed a p64_hashelem_t, any object pointer may be
+//passed (cast to p64_hashelem_t *) and is never written by the hash table
+//A compact hash table cannot be resized and insertions fail when it is full,
+//lookups slow down as the load approaches 1 so allow for some headroom
 
 #ifndef P64_HASHTABLE_H
 #define P64_HASHTABLE_H
@@ -13,6 +21,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "p64_hazardptr.h"
+#include "p64_hashstats.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -20,6 +29,11 @@ extern "C"
 #endif
 
 #define P64_HASHTAB_F_HP      0x0001 //Use hazard pointers (default QSBR)
+#define P64_HASHTAB_F_RESIZE  0x0002 //Support resize (requires QSBR or EBR)
+#define P64_HASHTAB_F_AUTORESIZE 0x0004 //Resize automatically on load factor
+#define P64_HASHTAB_F_STATS   0x0008 //Collect statistics
+#define P64_HASHTAB_F_COMPACT 0x0010 //Open addressing, no per-element header
+#define P64_HASHTAB_F_EBR     0x0020 //Use epoch based reclamation
 
 typedef uintptr_t p64_hashvalue_t;
 
@@ -48,13 +62,14 @@ p64_hashtable_t *p64_hashtable_alloc(size_t nelems,
 
 //Free a hash table
 //The hash table must be empty
+//Memory from p64_hashtable_alloc() cannot be passed to free()
 void p64_hashtable_free(p64_hashtable_t *);
 
 //Lookup an element in the hash table, given the key and a hash value of the key
 //If using hazard pointers, the hazard pointer must always be released, even
 //when no matching element was found
 //If using QSBR, the caller must call QSBR acquire/release/quiescent as
-//appropriate
+//appropriate, if using EBR the caller must call EBR enter/exit
 p64_hashelem_t *p64_hashtable_lookup(p64_hashtable_t *ht,
 				     const void *key,
 				     p64_hashvalue_t hash,
@@ -78,19 +93,39 @@ void p64_hashtable_lookup_vec(p64_hashtable_t *ht,
 			      p64_hashelem_t *result[num]);
 
 //Insert an element into the hash table
-void p64_hashtable_insert(p64_hashtable_t *ht,
+//Return false if insertion fails, compact hash table full
+bool p64_hashtable_insert(p64_hashtable_t *ht,
 			  p64_hashelem_t *he,
 			  p64_hashvalue_t hash);
 
+//Insert multiple elements, success[i] indicates if hes[i] was inserted
+//All target buckets are prefetched before any element is inserted
+//Return number of inserted elements
+uint32_t p64_hashtable_insert_vec(p64_hashtable_t *ht,
+				  uint32_t num,
+				  p64_hashelem_t *hes[num],
+				  p64_hashvalue_t hashes[num],
+				  bool success[num]);
+
 //Remove specified element
 //Return false if removal fails, element not found
 bool p64_hashtable_remove(p64_hashtable_t *ht,
 			  p64_hashelem_t *he,
 			  p64_hashvalue_t hash);
 
+//Remove multiple elements, success[i] indicates if hes[i] was removed
+//All target buckets are prefetched before any element is removed
+//Return number of removed elements
+uint32_t p64_hashtable_remove_vec(p64_hashtable_t *ht,
+				  uint32_t num,
+				  p64_hashelem_t *hes[num],
+				  p64_hashvalue_t hashes[num],
+				  bool success[num]);
+
 //Remove and return element specified by key
 //Return NULL if element not found
-//Caller must call QSBR acquire/release/quiescent as appropriate
+//Caller must call QSBR acquire/release/quiescent (or EBR enter/exit) as
+//appropriate
 p64_hashelem_t *p64_hashtable_remove_by_key(p64_hashtable_t *ht,
 					    const void *key,
 					    p64_hashvalue_t hash,
@@ -108,11 +143,64 @@ p64_hashelem_t *p64_hashtable_remove_by_key(p64_hashtable_t *ht,
 #endif
 
 //Traverse hash table, calling user-defined call-back for every element
+//Elements may be reported twice if a resize is in progress
 void
 p64_hashtable_traverse(p64_hashtable_t *ht,
 		       p64_hashtable_trav_cb cb,
 		       void *arg);
 
+//Cursor for partitioned and resumable traversal
+typedef struct p64_hashtable_cursor
+{
+    p64_hashvalue_t gen;//Generation of table being traversed
+    size_t next;//Next bucket to traverse
+    size_t end;//End of partition
+    uint32_t part;
+    uint32_t nparts;
+} p64_hashtable_cursor_t;
+
+//Initialise cursor for partition 'part' of 'nparts'
+//The buckets are divided evenly between the partitions so that 'nparts'
+//threads can traverse the hash table in parallel, one partition each
+void
+p64_hashtable_cursor_init(p64_hashtable_cursor_t *cur,
+			  uint32_t part,
+			  uint32_t nparts);
+
+//Traverse at most 'nbkts' buckets of the cursor's partition, calling the
+//user-defined call-back for every element, and advance the cursor
+//Return false when the whole partition has been traversed
+//QSBR (or EBR) is acquired and released internally so the caller may go
+//quiescent between steps, the call-back may remove the reported element
+//Elements present during the whole traversal are reported at least once,
+//elements inserted or removed concurrently may or may not be reported
+//A resize restarts the partition in the new table, elements may then be
+//reported again
+bool
+p64_hashtable_traverse_step(p64_hashtable_t *ht,
+			    p64_hashtable_cursor_t *cur,
+			    size_t nbkts,
+			    p64_hashtable_trav_cb cb,
+			    void *arg);
+
+//Resize hash table to have space for at least 'nelems' elements
+//Buckets are migrated incrementally to the new table, concurrent lookups,
+//insertions and removals are allowed, insertions and removals help with the
+//migration while lookups only follow it (searching both tables as needed)
+//With P64_HASHTAB_F_AUTORESIZE, the table grows when the load factor exceeds
+//1 and shrinks (but not below the original size) when it drops below 1/4
+//Requires P64_HASHTAB_F_RESIZE or P64_HASHTAB_F_AUTORESIZE
+//Return false if a resize is already in progress
+bool p64_hashtable_resize(p64_hashtable_t *ht, size_t nelems);
+
+//Read statistics, counters are only valid if P64_HASHTAB_F_STATS was
+//specified
+//Elements in the linked lists do not use bucket slots so the load factor
+//(nelems / capacity) may exceed 1
+void
+p64_hashtable_stats(p64_hashtable_t *ht,
+		    p64_hashstats_t *st);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,124 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Hash table specialised at compile time for key type, value type, hash
+//function and key compare function
+//Built on the cuckoo hash table with inline keys and values (p64_cuckookv)
+//Hashing and key compare are inlined in the lookup functions, insert and
+//remove call the compare function only for keys with matching signatures
+//
+//hash_fn: p64_cuckookvhash_t hash_fn(const key_type *key)
+//eq_fn: bool eq_fn(const key_type *a, const key_type *b)
+//Keys which compare equal must have the same hash value
+//value_type must not be larger than uintptr_t
+
+#ifndef P64_HASHTABLE_TEMPLATE_H
+#define P64_HASHTABLE_TEMPLATE_H
+
+#include <assert.h>
+#include "p64_cuckookv.h"
+
+#ifndef P64_CONCAT
+#define P64_CONCAT(x, y) x ## y
+#endif
+
+#define P64_HASHTABLE(_name, _key_t, _val_t, _hash_fn, _eq_fn) \
+static_assert(sizeof(_val_t) <= sizeof(uintptr_t), "sizeof(" #_val_t ") <= sizeof(uintptr_t)"); \
+\
+typedef p64_cuckookv_t P64_CONCAT(_name,_t); \
+\
+static inline P64_CONCAT(_name,_t) * \
+P64_CONCAT(_name,_alloc)(size_t nelems) \
+{ \
+    return p64_cuckookv_alloc(nelems, sizeof(_key_t)); \
+} \
+\
+static inline void \
+P64_CONCAT(_name,_free)(P64_CONCAT(_name,_t) *ht) \
+{ \
+    p64_cuckookv_free(ht); \
+} \
+\
+/* Compare key in bucket which may be written concurrently */ \
+__attribute__((always_inline)) \
+static inline bool \
+P64_CONCAT(_name,_slotcmp_)(const char *slot, const void *key, size_t ksize) \
+{ \
+    _key_t k; \
+    p64_cuckookv_keycpy_(&k, slot, ksize); \
+    return _eq_fn(&k, (const _key_t *)key); \
+} \
+\
+/* Compare key in locked bucket */ \
+static bool \
+P64_CONCAT(_name,_keycmp_)(const void *a, const void *b) \
+{ \
+    return _eq_fn((const _key_t *)a, (const _key_t *)b); \
+} \
+\
+static inline bool \
+P64_CONCAT(_name,_lookup)(P64_CONCAT(_name,_t) *ht, const _key_t *key, _val_t *val) \
+{ \
+    uintptr_t v; \
+    if (p64_cuckookv_lookup_eq_(ht, key, _hash_fn(key), &v, sizeof(_key_t), P64_CONCAT(_name,_slotcmp_))) \
+    { \
+	memcpy(val, &v, sizeof(_val_t)); \
+	return true; \
+    } \
+    return false; \
+} \
+\
+/* Return number of hits, hits[i] indicates if vals[i] is valid */ \
+static inline uint32_t \
+P64_CONCAT(_name,_lookup_vec)(P64_CONCAT(_name,_t) *ht, uint32_t num, const _key_t keys[], _val_t vals[], bool hits[]) \
+{ \
+    const size_t bktsize = p64_cuckookv_bktsize_(sizeof(_key_t)); \
+    p64_cuckookvhash_t hashes[num]; \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+	hashes[i] = _hash_fn(&keys[i]); \
+	uint32_t sig = p64_cuckookv_sig_(hashes[i]); \
+	__builtin_prefetch(ht->buckets + bktsize * p64_cuckookv_bix0_(sig, ht->nbkts), 0, 3); \
+	__builtin_prefetch(ht->buckets + bktsize * p64_cuckookv_bix1_(sig, ht->nbkts), 0, 3); \
+    } \
+    uint32_t nhits = 0; \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+	uintptr_t v; \
+	hits[i] = p64_cuckookv_lookup_eq_(ht, &keys[i], hashes[i], &v, sizeof(_key_t), P64_CONCAT(_name,_slotcmp_)); \
+	if (hits[i]) \
+	{ \
+	    memcpy(&vals[i], &v, sizeof(_val_t)); \
+	    nhits++; \
+	} \
+    } \
+    return nhits; \
+} \
+\
+/* Return false if key already present or table full */ \
+static inline bool \
+P64_CONCAT(_name,_insert)(P64_CONCAT(_name,_t) *ht, const _key_t *key, _val_t val) \
+{ \
+    uintptr_t v = 0; \
+    memcpy(&v, &val, sizeof(_val_t)); \
+    return p64_cuckookv_insert_(ht, key, _hash_fn(key), v, P64_CONCAT(_name,_keycmp_)); \
+} \
+\
+/* Return true and write associated value to '*val' (unless NULL) if found */ \
+static inline bool \
+P64_CONCAT(_name,_remove)(P64_CONCAT(_name,_t) *ht, const _key_t *key, _val_t *val) \
+{ \
+    uintptr_t v; \
+    if (p64_cuckookv_remove_(ht, key, _hash_fn(key), &v, P64_CONCAT(_name,_keycmp_))) \
+    { \
+	if (val != NULL) \
+	{ \
+	    memcpy(val, &v, sizeof(_val_t)); \
+	} \
+	return true; \
+    } \
+    return false; \
+}
+
+#endif
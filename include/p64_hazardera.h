@@ -0,0 +1,77 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Safe memory reclamation using hazard eras as described in Ramalhete &
+//Correia: "Brief Announcement: Hazard Eras - Non-Blocking Memory Reclamation"
+//Objects record the era in which they were created (birth era) and the era
+//in which they were retired, readers publish the current era instead of the
+//address of the object
+//Like hazard pointers, memory usage is bounded but readers only need to
+//publish a new era when the global era clock has changed
+
+#ifndef P64_HAZARDERA_H
+#define P64_HAZARDERA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef uint64_t *p64_hazardera_t;
+#define P64_HAZARDERA_NULL NULL
+
+typedef struct p64_hedomain p64_hedomain_t;
+
+//Allocate a hazard era domain where each thread will be able to have up to
+//'maxobjs' objects waiting for reclamation and keep up to 'nrefs'
+//(1 <= nrefs <= 32) references safe from premature reclamation
+p64_hedomain_t *p64_hazera_alloc(uint32_t maxobjs, uint32_t nrefs);
+
+//Free a hazard era domain
+//Memory from p64_hazera_alloc() cannot be passed to free()
+void p64_hazera_free(p64_hedomain_t *hed);
+
+//Register a thread, allocate per-thread resources
+void p64_hazera_register(p64_hedomain_t *hed);
+
+//Unregister a thread, free any per-thread resources
+void p64_hazera_unregister(void);
+
+//Return the current era
+//Store the current era in new objects before they are made visible to other
+//threads, the birth era must later be passed to p64_hazera_retire()
+uint64_t p64_hazera_birth(void);
+
+//Acquire a reference to the object which '*pptr' points to
+//Return a pointer to the object or NULL (*pptr was NULL)
+//Re-use the specified hazard era (if *he != P64_HAZARDERA_NULL)
+//Write any allocated hazard era to *he
+//Note that a hazard era may have been allocated even if NULL is returned
+//p64_hazera_acquire() has acquire memory ordering
+void *p64_hazera_acquire(void **pptr, p64_hazardera_t *he);
+#define p64_hazera_acquire(_p, _h) \
+    (__typeof(*_p))p64_hazera_acquire((void **)(_p), (_h))
+
+//Release the reference, updates may have been made
+//p64_hazera_release() has release memory ordering
+void p64_hazera_release(p64_hazardera_t *he);
+
+//Retire a removed object with the specified birth era
+//Call 'callback' when object is no longer referenced and can be destroyed
+//Return true if object could be retired, false otherwise (no space remaining)
+bool p64_hazera_retire(void *ptr, uint64_t birth, void (*callback)(void *ptr));
+
+//Force garbage reclamation
+//Return number of remaining unreclaimed objects
+uint32_t p64_hazera_reclaim(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
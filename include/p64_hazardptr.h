@@ -14,6 +14,8 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "p64_reclaimer.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -27,12 +29,22 @@ typedef struct p64_hpdomain p64_hpdomain_t;
 //Allocate a hazard pointer domain where each thread will be able to have up to
 //'maxobjs' objects waiting for reclamation and keep up to 'nrefs' objects safe
 //from premature reclamation
+//Garbage collection is performed when a thread's list of retired objects is
+//full, the cost of a scan is linear in the number of retired objects and
+//active hazard pointers, with 'maxobjs' larger than (e.g. twice) the total
+//number of hazard pointers, the retire cost is O(1) amortised
 //If 'nrefs' equals 0, the QSBR implementation will be invoked instead
 p64_hpdomain_t *p64_hazptr_alloc(uint32_t maxobjs, uint32_t nrefs);
 
 //Free a hazard pointer domain
+//Memory from p64_hazptr_alloc() cannot be passed to free()
 void p64_hazptr_free(p64_hpdomain_t *hdom);
 
+//Attach a background reclaimer to the domain (NULL to detach)
+//Threads hand off retired objects to the reclaimer when their list of
+//retired objects is full, p64_hazptr_reclaim() still reclaims inline
+void p64_hazptr_set_reclaimer(p64_hpdomain_t *hdom, p64_reclaimer_t *rcl);
+
 //Register a thread, allocate per-thread resources
 void p64_hazptr_register(p64_hpdomain_t *hdom);
 
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "p64_hazardptr.h"
+#include "p64_hashstats.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -18,6 +19,8 @@ extern "C"
 #endif
 
 #define P64_HOPSCOTCH_F_HP      0x0001 //Use hazard pointers (default QSBR)
+#define P64_HOPSCOTCH_F_STATS   0x0002 //Collect statistics
+#define P64_HOPSCOTCH_F_EBR     0x0004 //Use epoch based reclamation
 
 typedef uintptr_t p64_hopschash_t;
 
@@ -41,6 +44,7 @@ p64_hopscotch_alloc(size_t nbkts,
 
 //Free a hash table
 //The hash table must be empty
+//Memory from p64_hopscotch_alloc() cannot be passed to free()
 void
 p64_hopscotch_free(p64_hopscotch_t *);
 
@@ -48,7 +52,7 @@ p64_hopscotch_free(p64_hopscotch_t *);
 //If using hazard pointers, the hazard pointer must always be released, even
 //when no matching element was found
 //If using QSBR, the caller must call QSBR acquire/release/quiescent as
-//appropriate
+//appropriate, if using EBR the caller must call EBR enter/exit
 void *
 p64_hopscotch_lookup(p64_hopscotch_t *ht,
 		     const void *key,
@@ -68,8 +72,9 @@ p64_hopscotch_lookup(p64_hopscotch_t *ht,
 
 //Look up a vector of elements, given the keys and corresponding hashes
 //Return bitmask with successful lookups (result[i] != NULL)
-//Must only be used with QSBR!
-//Caller must call QSBR acquire/release/quiescent as appropriate
+//Must only be used with QSBR or EBR!
+//Caller must call QSBR acquire/release/quiescent (or EBR enter/exit) as
+//appropriate
 void
 p64_hopscotch_lookup_vec(p64_hopscotch_t *ht,
 			 uint32_t num,
@@ -84,6 +89,16 @@ p64_hopscotch_insert(p64_hopscotch_t *ht,
 		     void *elem,
 		     p64_hopschash_t hash);
 
+//Insert multiple elements, success[i] indicates if elems[i] was inserted
+//All target buckets are prefetched before any element is inserted
+//Return number of inserted elements
+uint32_t
+p64_hopscotch_insert_vec(p64_hopscotch_t *ht,
+			 uint32_t num,
+			 void *elems[num],
+			 p64_hopschash_t hashes[num],
+			 bool success[num]);
+
 //Remove specified element
 //Return true if removal successful, false otherwise (element not found)
 bool
@@ -91,9 +106,20 @@ p64_hopscotch_remove(p64_hopscotch_t *ht,
 		     void *elem,
 		     p64_hopschash_t hash);
 
+//Remove multiple elements, success[i] indicates if elems[i] was removed
+//All target buckets are prefetched before any element is removed
+//Return number of removed elements
+uint32_t
+p64_hopscotch_remove_vec(p64_hopscotch_t *ht,
+			 uint32_t num,
+			 void *elems[num],
+			 p64_hopschash_t hashes[num],
+			 bool success[num]);
+
 //Remove and return element specified by key & hash
 //Return NULL if element not found
-//Caller must call QSBR acquire/release/quiescent as appropriate
+//Caller must call QSBR acquire/release/quiescent (or EBR enter/exit) as
+//appropriate
 void *
 p64_hopscotch_remove_by_key(p64_hopscotch_t *ht,
 			    const void *key,
@@ -117,6 +143,12 @@ p64_hopscotch_traverse(p64_hopscotch_t *ht,
 		       p64_hopscotch_trav_cb cb,
 		       void *arg);
 
+//Read statistics, counters are only valid if P64_HOPSCOTCH_F_STATS was
+//specified
+void
+p64_hopscotch_stats(p64_hopscotch_t *ht,
+		    p64_hashstats_t *st);
+
 #ifdef __cplusplus
 }
 #endif
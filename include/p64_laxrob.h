@@ -38,6 +38,7 @@ p64_laxrob_t *p64_laxrob_alloc(uint32_t nslots,
 
 //Free a reorder buffer
 //The reorder buffer must be empty
+//Memory from p64_laxrob_alloc() cannot be passed to free()
 void p64_laxrob_free(p64_laxrob_t *rb);
 
 //Insert list of elements into the reorder buffer
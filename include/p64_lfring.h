@@ -8,6 +8,7 @@
 #ifndef P64_LFRING_H
 #define P64_LFRING_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -20,9 +21,20 @@ extern "C"
 #define P64_LFRING_F_SPENQ      0x0001 //Single producer
 #define P64_LFRING_F_MCDEQ      0x0000 //Multi consumer
 #define P64_LFRING_F_SCDEQ      0x0002 //Single consumer
+#define P64_LFRING_F_WAIT       0x0004 //Support enqueue/dequeue with wait
+
+#define P64_LFRING_WAIT_FOREVER UINT64_MAX
 
 typedef struct p64_lfring p64_lfring_t;
 
+typedef struct p64_lfring_result
+{
+    uint32_t actual;
+    uint32_t mask;
+    uintptr_t index;
+    void *ring;
+} p64_lfring_result_t;
+
 //Allocate ring buffer with space for at least 'nelems' elements
 //'nelems' != 0 and 'nelems' <= 0x80000000
 p64_lfring_t *
@@ -30,9 +42,30 @@ p64_lfring_alloc(uint32_t nelems, uint32_t flags);
 
 //Free ring buffer
 //The ring buffer must be empty
+//Memory from p64_lfring_alloc() cannot be passed to free()
 void
 p64_lfring_free(p64_lfring_t *lfr);
 
+//Return the number of bytes required for a ring buffer with space for at
+//least 'nelems' elements, for use with p64_lfring_init()
+size_t
+p64_lfring_size(uint32_t nelems);
+
+//Initialise ring buffer in caller-supplied memory, e.g. a mapping shared
+//between processes
+//'mem' must be cache line aligned and at least p64_lfring_size() bytes
+//The ring buffer does not contain any absolute pointers, elements are
+//opaque so offsets into a shared mapping can be used as elements
+//Ring buffers in shared memory cannot be added to ring sets
+//The memory is owned by the caller, do not call p64_lfring_free()
+p64_lfring_t *
+p64_lfring_init(void *mem, uint32_t nelems, uint32_t flags);
+
+//Return a handle for a ring buffer initialised by p64_lfring_init(),
+//possibly by another process mapping the memory at a different address
+p64_lfring_t *
+p64_lfring_attach(void *mem);
+
 //Enqueue elements on ring buffer
 //The number of actually enqueued elements is returned
 uint32_t
@@ -48,6 +81,70 @@ p64_lfring_dequeue(p64_lfring_t *lfr,
 		   uint32_t nelems,
 		   uint32_t *index);
 
+//Dequeue at least 'min' and at most 'nelems' elements from ring buffer
+//If fewer than 'min' elements are available, nothing is dequeued
+//'min' == 'nelems' dequeues exactly 'nelems' elements or nothing
+//'min' <= 'nelems'
+//The number of actually dequeued elements is returned, 0 or 'min'..'nelems'
+uint32_t
+p64_lfring_dequeue_min(p64_lfring_t *lfr,
+		       void *elems[],
+		       uint32_t nelems,
+		       uint32_t *index,
+		       uint32_t min);
+
+//Enqueue elements on ring buffer, waiting for space until all elements have
+//been enqueued or 'tmo_ns' nanoseconds have passed
+//Waiting threads first spin, then wait for event (Arm) and finally sleep
+//Sleeping threads are woken up by dequeue, requires P64_LFRING_F_WAIT
+//The number of actually enqueued elements is returned
+uint32_t
+p64_lfring_enqueue_wait(p64_lfring_t *lfr,
+			void *const elems[],
+			uint32_t nelems,
+			uint64_t tmo_ns);
+
+//Dequeue elements from ring buffer, waiting until at least 'min' elements
+//are available or 'tmo_ns' nanoseconds have passed
+//On timeout, any available elements are dequeued
+//Other consumers may take elements first so fewer than 'min' elements can
+//be returned also without timeout
+//Sleeping threads are woken up by enqueue, requires P64_LFRING_F_WAIT
+//The number of actually dequeued elements is returned
+uint32_t
+p64_lfring_dequeue_wait(p64_lfring_t *lfr,
+			void *elems[],
+			uint32_t nelems,
+			uint32_t *index,
+			uint32_t min,
+			uint64_t tmo_ns);
+
+//Acquire up to 'num' slots for in-place enqueue or dequeue
+//The number of actually acquired slots is returned in 'actual'
+//Enqueue: the producer writes element pointers directly into the slots,
+//requires P64_LFRING_F_SPENQ
+//Dequeue: the consumer reads element pointers directly from the slots, with
+//multiple consumers this is speculative until released
+p64_lfring_result_t
+p64_lfring_acquire(p64_lfring_t *lfr, uint32_t num, bool enqueue);
+
+//Release acquired slots, making enqueued elements available to consumers or
+//dequeued slots available to producers
+//'actual' may be decreased before release to enqueue or dequeue fewer elements
+//Return false if a multi-consumer dequeue failed because some other consumer
+//dequeued the elements first, the elements read must then be discarded and
+//the dequeue restarted with a new acquire
+bool
+p64_lfring_release(p64_lfring_t *lfr, p64_lfring_result_t r, bool enqueue);
+
+//Return pointer to slot 'i' (0 <= i < r.actual) of acquired range
+static inline void **
+p64_lfring_slot(p64_lfring_result_t r, uint32_t i)
+{
+    //Each slot is an element pointer followed by a ring index
+    return (void **)r.ring + 2 * ((r.index + i) & r.mask);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,7 @@ p64_mbtrie_alloc(const uint8_t *strides,//0-terminated array of stride sizes
 		 void *refcnt_zero_arg,
 		 uint32_t flags);
 
+//Memory from p64_mbtrie_alloc() cannot be passed to free()
 void
 p64_mbtrie_free(p64_mbtrie_t *mbt);
 
@@ -0,0 +1,53 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Memory allocation attributes
+//Attributes are set per thread and apply to all memory allocated by
+//Progress64 in that thread, e.g. in p64_*_alloc() calls, until reset
+//Later allocations by an object use the attributes in effect when the object
+//was allocated
+//Attributes are hints, allocation falls back to regular pages and the
+//default memory policy if the request cannot be satisfied
+//Currently only supported on Linux, ignored on other OS
+
+#ifndef P64_MEMATTR_H
+#define P64_MEMATTR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define P64_MEMATTR_F_HUGEPAGE    0x0001 //Use 2MB pages
+#define P64_MEMATTR_F_HUGEPAGE_1G 0x0002 //Use 1GB pages
+#define P64_MEMATTR_F_BIND        0x0004 //Bind memory to NUMA node 'node'
+#define P64_MEMATTR_F_INTERLEAVE  0x0008 //Interleave memory over 'nodemask'
+#define P64_MEMATTR_F_PREFAULT    0x0010 //Pre-fault all pages on allocation
+
+typedef struct p64_memattr
+{
+    uint32_t flags;
+    uint32_t node;//NUMA node for P64_MEMATTR_F_BIND, 0..63
+    uint64_t nodemask;//NUMA nodes for P64_MEMATTR_F_INTERLEAVE
+    size_t minsize;//Smaller allocations are not affected
+} p64_memattr_t;
+
+//Set allocation attributes for the calling thread
+//Specify NULL to reset to default attributes
+//If no hugepages are reserved, transparent hugepages are requested instead
+void
+p64_memattr_set(const p64_memattr_t *attr);
+
+//Get allocation attributes for the calling thread
+void
+p64_memattr_get(p64_memattr_t *attr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Multi-priority ring buffer
+//One ring buffer (p64_ringbuf) per priority level, all levels share one
+//allocation
+//Dequeue services the levels using either strict priority (level 0 is the
+//highest priority) or weighted round robin in a single call
+//The element size is sizeof(void *)
+
+#ifndef P64_PRIORING_H
+#define P64_PRIORING_H
+
+#include <stdint.h>
+
+#include "p64_ringbuf.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define P64_PRIORING_MAXPRIOS 16
+
+typedef struct p64_prioring p64_prioring_t;
+
+//Allocate a priority ring with 'nprios' levels, each level has space for
+//at least 'nelems' elements
+//'weights' == NULL selects strict priority dequeue, else 'weights[i]' (!= 0)
+//is the number of elements dequeued from level 'i' per round
+//'flags' are ring buffer flags (P64_RINGBUF_F_*) used for all levels,
+//P64_RINGBUF_F_WAIT is not supported
+p64_prioring_t *
+p64_prioring_alloc(uint32_t nprios,
+		   uint32_t nelems,
+		   const uint32_t weights[],
+		   uint32_t flags);
+
+//Free priority ring
+//All levels must be empty
+//Memory from p64_prioring_alloc() cannot be passed to free()
+void
+p64_prioring_free(p64_prioring_t *pr);
+
+//Enqueue elements on level 'prio'
+//Return the number of actually enqueued elements
+uint32_t
+p64_prioring_enqueue(p64_prioring_t *pr,
+		     void *const ev[],
+		     uint32_t num,
+		     uint32_t prio);
+
+//Dequeue up to 'num' elements from one or more levels
+//Strict priority: levels are emptied in priority order
+//Weighted round robin: up to 'weights[i]' elements are dequeued from level
+//'i' before moving on to the next non-empty level, the current level and
+//remaining weight are kept between calls (but may be approximate when
+//multiple consumers dequeue concurrently)
+//Return the number of actually dequeued elements
+uint32_t
+p64_prioring_dequeue(p64_prioring_t *pr,
+		     void *ev[],
+		     uint32_t num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,6 +3,15 @@
 //SPDX-License-Identifier:        BSD-3-Clause
 
 //Safe memory reclamation using quiescent state based reclamation
+//A thread can be registered in multiple domains, e.g. so that threads which
+//rarely call p64_qsbr_quiescent() do not delay reclamation in domains they
+//are not registered in
+//All calls except p64_qsbr_quiescent() and p64_qsbr_retire_domain() operate
+//on the current domain of the thread
+//Objects must be retired into the domain of the threads which may reference
+//them, a data structure using QSBR binds to the current domain of the thread
+//which allocates it and retires its internal objects into that domain
+//regardless of the current domain of the retiring thread
 
 #ifndef P64_QSBR_H
 #define P64_QSBR_H
@@ -11,6 +20,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "p64_reclaimer.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -18,18 +29,38 @@ extern "C"
 
 typedef struct p64_qsbrdomain p64_qsbrdomain_t;
 
+//Maximum number of domains a thread can be registered in
+#define P64_QSBR_MAXDOMAINS 8
+
 //Allocate a QSBR domain where each thread will be able to have up to
 //'maxobjs' retired objects waiting for reclamation (0 < maxobjs <= 0x80000000).
 //An unlimited number of objects will be safe from premature reclamation
 p64_qsbrdomain_t *p64_qsbr_alloc(uint32_t maxobjs);
 
 //Free a QSBR domain
+//Memory from p64_qsbr_alloc() cannot be passed to free()
 void p64_qsbr_free(p64_qsbrdomain_t *qsbr);
 
+//Attach a background reclaimer to the domain (NULL to detach)
+//Threads hand off retired objects to the reclaimer when their list of
+//retired objects is full, p64_qsbr_reclaim() still reclaims inline
+void p64_qsbr_set_reclaimer(p64_qsbrdomain_t *qsbr, p64_reclaimer_t *rcl);
+
 //Register and activate a thread, allocate per-thread resources
+//The domain becomes the current domain of the thread
 void p64_qsbr_register(p64_qsbrdomain_t *qsbr);
 
-//Deactivate and unregister a thread, free any per-thread resources
+//Make a domain the thread is registered in the current domain
+//Must not be called between p64_qsbr_acquire() and p64_qsbr_release()
+//Return the previous current domain
+p64_qsbrdomain_t *p64_qsbr_select(p64_qsbrdomain_t *qsbr);
+
+//Return the current domain of the thread or NULL if not registered
+p64_qsbrdomain_t *p64_qsbr_domain(void);
+
+//Deactivate and unregister a thread from the current domain, free any
+//per-thread resources
+//Any other domain the thread is registered in becomes the current domain
 void p64_qsbr_unregister(void);
 
 //Reactivate an inactive thread, it is again acquiring references to shared
@@ -43,8 +74,10 @@ void p64_qsbr_reactivate(void);
 //reclamation
 void p64_qsbr_deactivate(void);
 
-//Signal QSBR domain that this thread has released all previous
+//Signal QSBR domains that this thread has released all previous
 //references to shared objects
+//Applies to all active domains the thread is registered in, except domains
+//between p64_qsbr_acquire() and p64_qsbr_release()
 //p64_qsbr_quiescent() is expected to be called from some application main loop
 void p64_qsbr_quiescent(void);
 
@@ -59,6 +92,12 @@ void p64_qsbr_release(void);
 //Return true if object could be retired, false otherwise (no space remaining)
 bool p64_qsbr_retire(void *ptr, void (*callback)(void *ptr));
 
+//Like p64_qsbr_retire() but retire the object into the specified domain which
+//the thread must be registered in (NULL for the current domain)
+bool p64_qsbr_retire_domain(p64_qsbrdomain_t *qsbr,
+			    void *ptr,
+			    void (*callback)(void *ptr));
+
 //Force garbage reclamation
 //Return number of remaining unreclaimed objects
 uint32_t p64_qsbr_reclaim(void);
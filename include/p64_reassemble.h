@@ -42,6 +42,7 @@ p64_reassemble_t *p64_reassemble_alloc(uint32_t size,
 
 //Free a fragment table
 //Pass any remaining fragments to the stale callback
+//Memory from p64_reassemble_alloc() cannot be passed to free()
 void p64_reassemble_free(p64_reassemble_t *re);
 
 //Insert a (single) fragment, perform reassembly if possible
@@ -0,0 +1,58 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Background reclaimer for QSBR and hazard pointer domains
+//Threads which retire objects in a domain with an attached reclaimer hand
+//off batches of retired objects to the reclaimer (using a lock-free queue)
+//when their list of retired objects is full, instead of scanning and calling
+//the destructor callbacks themselves
+//The reclaimer does not create any threads, the application calls
+//p64_reclaimer_run() e.g. from a low priority housekeeping thread
+//Destructor callbacks are called by the thread calling p64_reclaimer_run()
+
+#ifndef P64_RECLAIMER_H
+#define P64_RECLAIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct p64_reclaimer p64_reclaimer_t;
+
+typedef struct p64_reclaimer_stats
+{
+    uint64_t batches;//Batches handed off
+    uint64_t objects;//Objects handed off
+    uint64_t reclaimed;//Objects reclaimed by the reclaimer
+    uint64_t overflows;//Hand-offs rejected due to backlog limit
+    uint32_t backlog;//Objects handed off but not yet reclaimed
+} p64_reclaimer_stats_t;
+
+//Allocate a reclaimer which accepts up to 'maxbacklog' unreclaimed objects
+//When the backlog limit is reached, retiring threads fall back to inline
+//garbage collection
+p64_reclaimer_t *p64_reclaimer_alloc(uint32_t maxbacklog);
+
+//Free a reclaimer
+//The backlog must be empty and the reclaimer detached from all domains
+//Memory from p64_reclaimer_alloc() cannot be passed to free()
+void p64_reclaimer_free(p64_reclaimer_t *rcl);
+
+//Attempt to reclaim all handed off objects
+//Only one thread at a time may call p64_reclaimer_run()
+//Domains with handed off objects must not be freed until the backlog is empty
+//Return number of remaining unreclaimed objects
+uint32_t p64_reclaimer_run(p64_reclaimer_t *rcl);
+
+//Read reclaimer statistics
+void p64_reclaimer_stats(p64_reclaimer_t *rcl, p64_reclaimer_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -31,6 +31,7 @@ p64_reorder_t *p64_reorder_alloc(uint32_t nelems,
 
 //Free a reorder buffer
 //The reorder buffer must be empty
+//Memory from p64_reorder_alloc() cannot be passed to free()
 void p64_reorder_free(p64_reorder_t *rob);
 
 //Acquire (consecutive) space in the reorder buffer
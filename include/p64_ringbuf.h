@@ -26,6 +26,9 @@ extern "C"
 #define P64_RINGBUF_F_LFDEQ      0x0004 //Lock-free multi consumer dequeue
 #define P64_RINGBUF_F_NBENQ      0x0008 //Non-blocking multi-producer enqueue
 #define P64_RINGBUF_F_NBDEQ      0x0010 //Non-blocking multi-consumer dequeue
+#define P64_RINGBUF_F_WAIT       0x0020 //Support enqueue/dequeue with wait
+
+#define P64_RINGBUF_WAIT_FOREVER UINT64_MAX
 
 typedef struct p64_ringbuf p64_ringbuf_t;
 
@@ -45,9 +48,31 @@ p64_ringbuf_alloc(uint32_t nelems, uint32_t flags, size_t esize);
 
 //Free ring buffer
 //The ring buffer must be empty
+//Memory from p64_ringbuf_alloc() cannot be passed to free()
 void
 p64_ringbuf_free(p64_ringbuf_t *rb);
 
+//Return the number of bytes required for a ring buffer with space for at
+//least 'nelems' elements of size 'esize', for use with p64_ringbuf_init()
+size_t
+p64_ringbuf_size(uint32_t nelems, size_t esize);
+
+//Initialise ring buffer in caller-supplied memory, e.g. a mapping shared
+//between processes
+//'mem' must be 64-byte aligned and at least p64_ringbuf_size() bytes
+//The ring buffer does not contain any absolute pointers, elements are
+//opaque so offsets into a shared mapping can be used as elements
+//Ring buffers in shared memory cannot be added to ring sets
+//The memory is owned by the caller, do not call p64_ringbuf_free()
+p64_ringbuf_t *
+p64_ringbuf_init(void *mem, uint32_t nelems, uint32_t flags, size_t esize);
+
+//Return a (process-local) handle for a ring buffer initialised by
+//p64_ringbuf_init(), possibly by another process mapping the memory at a
+//different address
+p64_ringbuf_t *
+p64_ringbuf_attach(void *mem);
+
 //Enqueue elements on ring buffer
 //Return the number of actually enqueued elements
 uint32_t
@@ -59,6 +84,35 @@ uint32_t
 p64_ringbuf_dequeue(p64_ringbuf_t *rb, void *ev[], uint32_t num,
 		    uint32_t *index);
 
+//Dequeue at least 'min' and at most 'num' elements from ring buffer
+//If fewer than 'min' elements are available, nothing is dequeued
+//'min' == 'num' dequeues exactly 'num' elements or nothing
+//'min' <= 'num'
+//Return the number of actually dequeued elements, 0 or 'min'..'num'
+uint32_t
+p64_ringbuf_dequeue_min(p64_ringbuf_t *rb, void *ev[], uint32_t num,
+			uint32_t *index, uint32_t min);
+
+//Enqueue elements on ring buffer, waiting for space until all elements have
+//been enqueued or 'tmo_ns' nanoseconds have passed
+//Waiting threads first spin, then wait for event (Arm) and finally sleep
+//Sleeping threads are woken up by dequeue, requires P64_RINGBUF_F_WAIT
+//Return the number of actually enqueued elements
+uint32_t
+p64_ringbuf_enqueue_wait(p64_ringbuf_t *rb, void *const ev[], uint32_t num,
+			 uint64_t tmo_ns);
+
+//Dequeue elements from ring buffer, waiting until at least 'min' elements
+//are available or 'tmo_ns' nanoseconds have passed
+//On timeout, any available elements are dequeued
+//Other consumers may take elements first so fewer than 'min' elements can
+//be returned also without timeout
+//Sleeping threads are woken up by enqueue, requires P64_RINGBUF_F_WAIT
+//Return the number of actually dequeued elements
+uint32_t
+p64_ringbuf_dequeue_wait(p64_ringbuf_t *rb, void *ev[], uint32_t num,
+			 uint32_t *index, uint32_t min, uint64_t tmo_ns);
+
 //Special functions used by templates
 p64_ringbuf_t *
 p64_ringbuf_alloc_(uint32_t nelems, uint32_t flags, size_t esize);
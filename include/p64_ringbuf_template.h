@@ -4,12 +4,25 @@
 
 //Blocking ring buffer with user defined element type
 //Supports blocking MP/MC and SP/SC modes, also lock-free MC dequeue
+//Elements with a size that is a multiple of 16 bytes are copied using
+//vector loads and stores (AVX2, SSE2 or NEON)
+//Ring buffers in shared memory (see p64_ringbuf_init()) can use an offset
+//type (e.g. uint32_t) as element to pass buffers between processes
 
 #ifndef P64_RINGBUF_TEMPLATE_H
 #define P64_RINGBUF_TEMPLATE_H
 
+#include <stddef.h>
+#include <string.h>
+
 #include "p64_ringbuf.h"
 
+#if defined __AVX2__ || defined __SSE2__
+#include <immintrin.h>
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#endif
+
 #ifndef P64_CONCAT
 #define P64_CONCAT(x, y) x ## y
 #endif
@@ -23,6 +36,73 @@
 #define UNROLL_LOOPS
 #endif
 
+//Copy 'nbytes' bytes, 'nbytes' must be a multiple of 16
+__attribute__((always_inline))
+static inline void
+p64_ringbuf_copy16_(void *restrict dst, const void *restrict src, size_t nbytes)
+{
+    char *restrict d = (char *)dst;
+    const char *restrict s = (const char *)src;
+#if defined __AVX2__
+    //Issue all loads before the stores
+    for (; nbytes >= 64; nbytes -= 64, d += 64, s += 64)
+    {
+	__m256i a = _mm256_loadu_si256((const __m256i *)s);
+	__m256i b = _mm256_loadu_si256((const __m256i *)(s + 32));
+	_mm256_storeu_si256((__m256i *)d, a);
+	_mm256_storeu_si256((__m256i *)(d + 32), b);
+    }
+    if (nbytes >= 32)
+    {
+	_mm256_storeu_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+	nbytes -= 32, d += 32, s += 32;
+    }
+    if (nbytes != 0)
+    {
+	_mm_storeu_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+    }
+#elif defined __SSE2__
+    for (; nbytes >= 32; nbytes -= 32, d += 32, s += 32)
+    {
+	__m128i a = _mm_loadu_si128((const __m128i *)s);
+	__m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+	_mm_storeu_si128((__m128i *)d, a);
+	_mm_storeu_si128((__m128i *)(d + 16), b);
+    }
+    if (nbytes != 0)
+    {
+	_mm_storeu_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+    }
+#elif defined __ARM_NEON
+    //Adjacent 16-byte loads and stores are paired (LDP/STP Qn)
+    for (; nbytes >= 64; nbytes -= 64, d += 64, s += 64)
+    {
+	uint8x16_t a = vld1q_u8((const uint8_t *)s);
+	uint8x16_t b = vld1q_u8((const uint8_t *)(s + 16));
+	uint8x16_t c = vld1q_u8((const uint8_t *)(s + 32));
+	uint8x16_t e = vld1q_u8((const uint8_t *)(s + 48));
+	vst1q_u8((uint8_t *)d, a);
+	vst1q_u8((uint8_t *)(d + 16), b);
+	vst1q_u8((uint8_t *)(d + 32), c);
+	vst1q_u8((uint8_t *)(d + 48), e);
+    }
+    if (nbytes >= 32)
+    {
+	uint8x16_t a = vld1q_u8((const uint8_t *)s);
+	uint8x16_t b = vld1q_u8((const uint8_t *)(s + 16));
+	vst1q_u8((uint8_t *)d, a);
+	vst1q_u8((uint8_t *)(d + 16), b);
+	nbytes -= 32, d += 32, s += 32;
+    }
+    if (nbytes != 0)
+    {
+	vst1q_u8((uint8_t *)d, vld1q_u8((const uint8_t *)s));
+    }
+#else
+    memcpy(d, s, nbytes);
+#endif
+}
+
 #define P64_RINGBUF(_name, _type) \
 typedef p64_ringbuf_t P64_CONCAT(_name,_t); \
 \
@@ -38,10 +118,34 @@ P64_CONCAT(_name,_free)(P64_CONCAT(_name,_t) *rb) \
     p64_ringbuf_free_((rb)); \
 } \
 \
+static inline size_t \
+P64_CONCAT(_name,_size)(uint32_t nelems) \
+{ \
+    return p64_ringbuf_size(nelems, sizeof(_type)); \
+} \
+\
+static inline P64_CONCAT(_name,_t) * \
+P64_CONCAT(_name,_init)(void *mem, uint32_t nelems, uint32_t flags) \
+{ \
+    return (P64_CONCAT(_name,_t) *)p64_ringbuf_init(mem, nelems, flags, sizeof(_type)); \
+} \
+\
+static inline P64_CONCAT(_name,_t) * \
+P64_CONCAT(_name,_attach)(void *mem) \
+{ \
+    return (P64_CONCAT(_name,_t) *)p64_ringbuf_attach(mem); \
+} \
+\
 UNROLL_LOOPS \
 static inline void \
 P64_CONCAT(_name,_copy)(_type *restrict dst, const _type *restrict src, uint32_t num) \
 { \
+    if (sizeof(_type) % 16 == 0) \
+    { \
+	/* Resolved at compile time */ \
+	p64_ringbuf_copy16_(dst, src, (size_t)num * sizeof(_type)); \
+	return; \
+    } \
     for (uint32_t i = 0; i < num; i++) \
     { \
 	dst[i] = src[i]; \
@@ -0,0 +1,82 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Set of ring buffers (p64_ringbuf and p64_lfring) serviced by the same
+//consumer(s)
+//Producers mark rings as non-empty in a shared bitmap on enqueue, consumers
+//find ready rings without polling empty rings
+//Up to 64 rings per set, a ring can be member of at most one set
+//Rings must not be enqueued to while they are added or removed
+
+#ifndef P64_RINGSET_H
+#define P64_RINGSET_H
+
+#include <stdint.h>
+
+#include "p64_ringbuf.h"
+#include "p64_lfring.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define P64_RINGSET_F_WAIT 0x0001 //Support dequeue with wait
+
+#define P64_RINGSET_WAIT_FOREVER UINT64_MAX
+
+typedef struct p64_ringset p64_ringset_t;
+
+//Allocate an empty ring set
+p64_ringset_t *
+p64_ringset_alloc(uint32_t flags);
+
+//Free ring set, any remaining rings are removed (but not freed)
+//Memory from p64_ringset_alloc() cannot be passed to free()
+void
+p64_ringset_free(p64_ringset_t *set);
+
+//Add ring to set
+//Return the ring index (0..63) or -1 if the set is full
+int32_t
+p64_ringset_add_ringbuf(p64_ringset_t *set, p64_ringbuf_t *rb);
+
+int32_t
+p64_ringset_add_lfring(p64_ringset_t *set, p64_lfring_t *lfr);
+
+//Remove ring with index 'ringidx' from set
+void
+p64_ringset_remove(p64_ringset_t *set, uint32_t ringidx);
+
+//Return bitmap of possibly non-empty rings
+uint64_t
+p64_ringset_ready(p64_ringset_t *set);
+
+//Dequeue up to 'num' elements from one non-empty ring, rings are serviced
+//in round-robin order
+//The index of the ring is returned in '*ringidx'
+//Return the number of actually dequeued elements
+uint32_t
+p64_ringset_dequeue(p64_ringset_t *set,
+		    void *ev[],
+		    uint32_t num,
+		    uint32_t *ringidx);
+
+//Dequeue up to 'num' elements from one non-empty ring, waiting until some
+//ring is non-empty or 'tmo_ns' nanoseconds have passed
+//Waiting threads first spin, then wait for event (Arm) and finally sleep
+//Requires P64_RINGSET_F_WAIT
+//Return the number of actually dequeued elements, 0 on timeout
+uint32_t
+p64_ringset_dequeue_wait(p64_ringset_t *set,
+			 void *ev[],
+			 uint32_t num,
+			 uint32_t *ringidx,
+			 uint64_t tmo_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
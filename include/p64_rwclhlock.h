@@ -36,7 +36,8 @@ void p64_rwclhlock_fini(p64_rwclhlock_t *lock);
 
 //Acquire a reader/writer CLH lock
 //*nodep will be written with a pointer to a p64_rwclhnode_t, this object must
-//eventually be freed
+//eventually be freed using p64_rwclhlock_free_node(), it cannot be passed to
+//free()
 void p64_rwclhlock_acquire_rd(p64_rwclhlock_t *lock, p64_rwclhnode_t **nodep);
 void p64_rwclhlock_acquire_wr(p64_rwclhlock_t *lock, p64_rwclhnode_t **nodep);
 
@@ -44,6 +45,9 @@ void p64_rwclhlock_acquire_wr(p64_rwclhlock_t *lock, p64_rwclhnode_t **nodep);
 void p64_rwclhlock_release_rd(p64_rwclhnode_t **nodep);
 void p64_rwclhlock_release_wr(p64_rwclhnode_t **nodep);
 
+//Free a p64_rwclhnode_t object (NULL is allowed)
+void p64_rwclhlock_free_node(p64_rwclhnode_t *node);
+
 #ifdef __cplusplus
 }
 #endif
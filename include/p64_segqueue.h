@@ -0,0 +1,55 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Unbounded lock-free MP/MC queue built from a linked list of fixed size
+//segments
+//Producers and consumers claim slots in the tail and head segments using
+//fetch-and-add, new segments are appended when the tail segment is full
+//Exhausted segments are retired using QSBR, hazard pointers, EBR or hazard
+//eras, each thread must register with a domain of the selected kind, hazard
+//pointer and hazard era domains need at least one reference per thread
+
+#ifndef P64_SEGQUEUE_H
+#define P64_SEGQUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//At most one of the SMR flags may be specified
+#define P64_SEGQUEUE_F_HP  0x0001 //Use hazard pointers (default QSBR)
+#define P64_SEGQUEUE_F_EBR 0x0002 //Use epoch based reclamation
+#define P64_SEGQUEUE_F_HE  0x0004 //Use hazard eras
+
+typedef struct p64_segqueue p64_segqueue_t;
+
+//Allocate a queue using segments with 'segsize' slots each
+p64_segqueue_t *
+p64_segqueue_alloc(uint32_t segsize, uint32_t flags);
+
+//Free queue
+//The queue must be empty
+//Memory from p64_segqueue_alloc() cannot be passed to free()
+void
+p64_segqueue_free(p64_segqueue_t *sq);
+
+//Enqueue an element, NULL elements are not supported
+//Return false only if a new segment could not be allocated
+bool
+p64_segqueue_enqueue(p64_segqueue_t *sq, void *elem);
+
+//Dequeue an element
+//Return NULL if the queue is empty
+void *
+p64_segqueue_dequeue(p64_segqueue_t *sq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
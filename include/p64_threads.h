@@ -0,0 +1,37 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Configuration of the maximum number of registered threads
+//Threads registered with e.g. QSBR, hazard pointers or counter domains are
+//allocated a thread index, per-thread arrays in domains are sized by the
+//maximum number of threads when the domain is allocated
+
+#ifndef P64_THREADS_H
+#define P64_THREADS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//Upper limit for the maximum number of threads
+#define P64_THREADS_LIMIT 4096
+
+//Set the maximum number of threads (0 < maxthreads <= P64_THREADS_LIMIT)
+//Must be called before any thread is registered and before any domain
+//is allocated, the limit cannot be changed after it has been used
+//Return true on success, false otherwise
+bool p64_threads_setmax(uint32_t maxthreads);
+
+//Return the maximum number of threads
+uint32_t p64_threads_getmax(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
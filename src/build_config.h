@@ -16,6 +16,7 @@
 #endif
 
 #define CACHE_LINE 64
+//Default maximum number of threads, see p64_threads_setmax()
 #define MAXTHREADS 128
 #define MAXTIMERS 8192
 
@@ -0,0 +1,105 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashstats.h"
+#include "build_config.h"
+
+#include "common.h"
+#include "os_abstraction.h"
+#include "thr_idx.h"
+#include "atomic.h"
+
+//One shard per thread index, the last shard is shared by any threads which
+//did not get a thread index
+struct shard
+{
+    uint64_t cnt[HS_NUM];
+} ALIGNED(CACHE_LINE);
+
+struct hashstats
+{
+    uint32_t nshards;
+    struct shard shards[] ALIGNED(CACHE_LINE);
+};
+
+//Thread index + 1, 0 when not yet allocated, -1 when no thread index was
+//available
+//The thread index is released by thr_idx when the thread exits
+static THREAD_LOCAL int32_t stats_idx;
+
+struct hashstats *
+hashstats_alloc(void)
+{
+    uint32_t nshards = p64_idx_maxthreads() + 1;
+    size_t nbytes = sizeof(struct hashstats) + nshards * sizeof(struct shard);
+    struct hashstats *hs = p64_malloc(nbytes, CACHE_LINE);
+    if (hs != NULL)
+    {
+	memset(hs, 0, nbytes);
+	hs->nshards = nshards;
+    }
+    return hs;
+}
+
+void
+hashstats_free(struct hashstats *hs)
+{
+    p64_mfree(hs);
+}
+
+void
+hashstats_add_(struct hashstats *hs, enum hashstat s, uint64_t val)
+{
+    if (UNLIKELY(stats_idx == 0))
+    {
+	int32_t idx = p64_idx_alloc();
+	stats_idx = idx >= 0 ? idx + 1 : -1;
+    }
+    bool shared = stats_idx < 0;
+    uint32_t idx = !shared ? (uint32_t)stats_idx - 1 : hs->nshards - 1;
+    uint64_t *cnt = &hs->shards[idx].cnt[s];
+    if (LIKELY(!shared))
+    {
+	//Only this thread updates the shard, readers may read it concurrently
+	atomic_store_n(cnt, atomic_load_n(cnt, __ATOMIC_RELAXED) + val,
+		       __ATOMIC_RELAXED);
+    }
+    else
+    {
+	atomic_fetch_add(cnt, val, __ATOMIC_RELAXED);
+    }
+}
+
+void
+hashstats_read(struct hashstats *hs, p64_hashstats_t *st)
+{
+    uint64_t sum[HS_NUM] = { 0 };
+    for (uint32_t i = 0; i < hs->nshards; i++)
+    {
+	for (uint32_t j = 0; j < HS_NUM; j++)
+	{
+	    sum[j] += atomic_load_n(&hs->shards[i].cnt[j], __ATOMIC_RELAXED);
+	}
+    }
+    st->lookups = sum[HS_LOOKUP];
+    st->lookup_misses = sum[HS_LOOKUP_MISS];
+    for (uint32_t i = 0; i < P64_HASHSTATS_NPROBES; i++)
+    {
+	st->probes[i] = sum[HS_PROBE + i];
+    }
+    st->inserts = sum[HS_INSERT];
+    st->insert_fails = sum[HS_INSERT_FAIL];
+    st->removes = sum[HS_REMOVE];
+    st->remove_fails = sum[HS_REMOVE_FAIL];
+    st->relocations = sum[HS_RELOC];
+    st->cas_retries = sum[HS_CAS_RETRY];
+    //Elements may be inserted and removed by different threads, only the
+    //sums are meaningful
+    st->nelems = sum[HS_INSERT] - sum[HS_REMOVE];
+    st->cellar_used = sum[HS_CELLAR_INS] - sum[HS_CELLAR_REM];
+}
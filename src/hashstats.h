@@ -0,0 +1,74 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#ifndef _HASHSTATS_H
+#define _HASHSTATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "p64_hashstats.h"
+#include "common.h"
+
+enum hashstat
+{
+    HS_LOOKUP,
+    HS_LOOKUP_MISS,
+    HS_PROBE,//First of P64_HASHSTATS_NPROBES counters
+    HS_INSERT = HS_PROBE + P64_HASHSTATS_NPROBES,
+    HS_INSERT_FAIL,
+    HS_REMOVE,
+    HS_REMOVE_FAIL,
+    HS_RELOC,
+    HS_CAS_RETRY,
+    HS_CELLAR_INS,
+    HS_CELLAR_REM,
+    HS_NUM
+};
+
+struct hashstats;
+
+//Allocate statistics counters for one hash table
+struct hashstats *hashstats_alloc(void);
+
+void hashstats_free(struct hashstats *hs);
+
+void hashstats_add_(struct hashstats *hs, enum hashstat s, uint64_t val);
+
+//Sum all per-thread counters, other fields of 'st' are left unchanged
+void hashstats_read(struct hashstats *hs, p64_hashstats_t *st);
+
+//Statistics are disabled when 'hs' is NULL
+static inline void
+hashstats_add(struct hashstats *hs, enum hashstat s, uint64_t val)
+{
+    if (UNLIKELY(hs != NULL))
+    {
+	hashstats_add_(hs, s, val);
+    }
+}
+
+static inline void
+hashstats_lookup(struct hashstats *hs, uint32_t nprobes, bool hit)
+{
+    if (UNLIKELY(hs != NULL))
+    {
+	hashstats_add_(hs, HS_LOOKUP, 1);
+	if (!hit)
+	{
+	    hashstats_add_(hs, HS_LOOKUP_MISS, 1);
+	}
+	if (nprobes != 0)
+	{
+	    nprobes--;
+	}
+	if (nprobes >= P64_HASHSTATS_NPROBES)
+	{
+	    nprobes = P64_HASHSTATS_NPROBES - 1;
+	}
+	hashstats_add_(hs, HS_PROBE + nprobes, 1);
+    }
+}
+
+#endif
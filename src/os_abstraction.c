@@ -11,45 +11,138 @@
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
 #endif
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 #endif
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "p64_allocator.h"
+#include "p64_memattr.h"
 #include "os_abstraction.h"
 #include "common.h"
+#include "err_hnd.h"
 
-uint64_t
-p64_gettid(void)
+#define MEMATTR_FLAGS (P64_MEMATTR_F_HUGEPAGE | P64_MEMATTR_F_HUGEPAGE_1G | \
+		       P64_MEMATTR_F_BIND | P64_MEMATTR_F_INTERLEAVE | \
+		       P64_MEMATTR_F_PREFAULT)
+
+static THREAD_LOCAL p64_memattr_t memattr;
+
+void
+p64_memattr_set(const p64_memattr_t *attr)
 {
-#if defined _WIN32
-    return GetCurrentThreadId();
-#elif defined __APPLE__
-    uint64_t tid;
-    pthread_threadid_np(NULL, &tid);
-    return tid;
-#elif defined __linux__
-    return syscall(__NR_gettid);
-#else
-#error Unsupported OS
-#endif
+    if (attr == NULL)
+    {
+	memset(&memattr, 0, sizeof memattr);
+	return;
+    }
+    if ((attr->flags & ~MEMATTR_FLAGS) != 0 ||
+	(attr->flags & P64_MEMATTR_F_BIND &&
+	 attr->flags & P64_MEMATTR_F_INTERLEAVE))
+    {
+	report_error("memattr", "invalid flags", attr->flags);
+	return;
+    }
+    if (attr->flags & P64_MEMATTR_F_BIND && attr->node >= 64)
+    {
+	report_error("memattr", "invalid node", attr->node);
+	return;
+    }
+    if (attr->flags & P64_MEMATTR_F_INTERLEAVE && attr->nodemask == 0)
+    {
+	report_error("memattr", "invalid nodemask", 0);
+	return;
+    }
+    memattr = *attr;
 }
 
-void *
-p64_malloc(size_t size, size_t alignment)
+void
+p64_memattr_get(p64_memattr_t *attr)
+{
+    *attr = memattr;
+}
+
+static p64_allocator_t allocator;//Process-wide allocator
+static THREAD_LOCAL p64_allocator_t thr_allocator;//Per-thread allocator
+
+void
+p64_allocator_install(const p64_allocator_t *alloc)
+{
+    if (alloc == NULL)
+    {
+	memset(&allocator, 0, sizeof allocator);
+	return;
+    }
+    if (alloc->alloc == NULL || alloc->free == NULL)
+    {
+	report_error("allocator", "invalid allocator", 0);
+	return;
+    }
+    allocator = *alloc;
+}
+
+void
+p64_allocator_set(const p64_allocator_t *alloc)
+{
+    if (alloc == NULL)
+    {
+	memset(&thr_allocator, 0, sizeof thr_allocator);
+	return;
+    }
+    if (alloc->alloc == NULL || alloc->free == NULL)
+    {
+	report_error("allocator", "invalid allocator", 0);
+	return;
+    }
+    thr_allocator = *alloc;
+}
+
+//Every allocation is preceded by a header which records how to free it so
+//that p64_mfree() needs neither a lookup nor a lock
+struct alloc_hdr
+{
+    void *base;//Address returned by the underlying allocator or mmap()
+    size_t len;//Length of mapping, 0 if not mapped
+    void (*free)(void *ptr, void *arg);//NULL for the default allocator
+    void *arg;
+};
+
+//Minimum alignment of the header and of the returned memory
+#define HDR_ALIGN _Alignof(max_align_t)
+
+static inline size_t
+hdr_size(size_t alignment)
+{
+    return ROUNDUP(sizeof(struct alloc_hdr), alignment);
+}
+
+static inline void *
+hdr_init(void *base, size_t hdrsz, size_t len, const p64_allocator_t *alloc)
+{
+    void *ptr = (char *)base + hdrsz;
+    struct alloc_hdr *hdr = (struct alloc_hdr *)ptr - 1;
+    hdr->base = base;
+    hdr->len = len;
+    hdr->free = alloc != NULL ? alloc->free : NULL;
+    hdr->arg = alloc != NULL ? alloc->arg : NULL;
+    return ptr;
+}
+
+static void *
+default_malloc(size_t size, size_t alignment)
 {
     void *ptr;
 #ifdef _WIN32
     //Always use _aligned_malloc since it can only be paired with _aligned_free
     ptr = _aligned_malloc(size, alignment != 0 ? alignment : 1);
 #else
-    if (alignment > 1)
+    if (alignment > HDR_ALIGN)
     {
 #ifdef __APPLE__
-	if (alignment < sizeof(void *))
-	{
-	    alignment = sizeof(void *);
-	}
 	if (posix_memalign(&ptr, alignment, size) != 0)
 	{
 	    //Failure
@@ -67,8 +160,8 @@ p64_malloc(size_t size, size_t alignment)
     return ptr;
 }
 
-void
-p64_mfree(void *ptr)
+static void
+default_free(void *ptr)
 {
 #ifdef _WIN32
     _aligned_free(ptr);
@@ -77,6 +170,166 @@ p64_mfree(void *ptr)
 #endif
 }
 
+#ifdef __linux__
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#define MAP_HUGE_2MB_ (21 << MAP_HUGE_SHIFT)
+#define MAP_HUGE_1GB_ (30 << MAP_HUGE_SHIFT)
+#define HUGEPAGE_2MB (UINT64_C(1) << 21)
+#define HUGEPAGE_1GB (UINT64_C(1) << 30)
+
+static void *
+map_memory(size_t size, size_t alignment, const p64_memattr_t *attr)
+{
+    size_t pgsz = (size_t)sysconf(_SC_PAGESIZE);
+    if (alignment > pgsz)
+    {
+	//Use regular allocation
+	return NULL;
+    }
+    size_t hdrsz = hdr_size(alignment);
+    size += hdrsz;
+    size_t hpsz = attr->flags & P64_MEMATTR_F_HUGEPAGE_1G ? HUGEPAGE_1GB :
+		  attr->flags & P64_MEMATTR_F_HUGEPAGE ? HUGEPAGE_2MB : pgsz;
+    size_t len = ROUNDUP(size, hpsz);
+    void *ptr = MAP_FAILED;
+    if (hpsz != pgsz)
+    {
+	int huge = hpsz == HUGEPAGE_1GB ? MAP_HUGE_1GB_ : MAP_HUGE_2MB_;
+	ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge, -1, 0);
+    }
+    if (ptr == MAP_FAILED)
+    {
+	//No hugepages reserved (or not requested), use regular pages
+	len = ROUNDUP(size, pgsz);
+	ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED)
+	{
+	    return NULL;
+	}
+	if (hpsz != pgsz)
+	{
+	    //Request transparent hugepages, best effort
+	    (void)madvise(ptr, len, MADV_HUGEPAGE);
+	}
+    }
+    if (attr->flags & (P64_MEMATTR_F_BIND | P64_MEMATTR_F_INTERLEAVE))
+    {
+	//Memory policy must be set before pages are faulted in
+	//Best effort, fails e.g. if node does not exist
+	uint64_t nodemask = attr->flags & P64_MEMATTR_F_BIND ?
+			    UINT64_C(1) << attr->node : attr->nodemask;
+	int mode = attr->flags & P64_MEMATTR_F_BIND ? MPOL_BIND : MPOL_INTERLEAVE;
+	(void)syscall(SYS_mbind, ptr, len, mode, &nodemask,
+		      sizeof nodemask * 8 + 1, 0);
+    }
+    if (attr->flags & P64_MEMATTR_F_PREFAULT)
+    {
+	for (size_t off = 0; off < len; off += pgsz)
+	{
+	    ((volatile char *)ptr)[off] = 0;
+	}
+    }
+    return hdr_init(ptr, hdrsz, len, NULL);
+}
+
+#endif
+
+uint64_t
+p64_gettid(void)
+{
+#if defined _WIN32
+    return GetCurrentThreadId();
+#elif defined __APPLE__
+    uint64_t tid;
+    pthread_threadid_np(NULL, &tid);
+    return tid;
+#elif defined __linux__
+    return syscall(__NR_gettid);
+#else
+#error Unsupported OS
+#endif
+}
+
+void
+p64_memsrc_get(p64_memsrc_t *src)
+{
+    if (UNLIKELY(thr_allocator.alloc != NULL))
+    {
+	//Memory attributes do not apply to per-thread allocators
+	src->alloc = thr_allocator;
+	memset(&src->attr, 0, sizeof src->attr);
+    }
+    else
+    {
+	src->alloc = allocator;
+	src->attr = memattr;
+    }
+}
+
+void *
+p64_malloc_src(const p64_memsrc_t *src, size_t size, size_t alignment)
+{
+    alignment = MAX(alignment, HDR_ALIGN);
+#ifdef __linux__
+    if (UNLIKELY(src->attr.flags != 0) && size >= src->attr.minsize &&
+	size != 0)
+    {
+	void *ptr = map_memory(size, alignment, &src->attr);
+	if (ptr != NULL)
+	{
+	    return ptr;
+	}
+	//Else fall back to regular allocation
+    }
+#endif
+    const p64_allocator_t *alloc = src->alloc.alloc != NULL ?
+				   &src->alloc : NULL;
+    size_t hdrsz = hdr_size(alignment);
+    void *base = alloc != NULL ?
+		 alloc->alloc(size + hdrsz, alignment, alloc->arg) :
+		 default_malloc(size + hdrsz, alignment);
+    if (UNLIKELY(base == NULL))
+    {
+	return NULL;
+    }
+    return hdr_init(base, hdrsz, 0, alloc);
+}
+
+void *
+p64_malloc(size_t size, size_t alignment)
+{
+    p64_memsrc_t src;
+    p64_memsrc_get(&src);
+    return p64_malloc_src(&src, size, alignment);
+}
+
+void
+p64_mfree(void *ptr)
+{
+    if (ptr == NULL)
+    {
+	return;
+    }
+    const struct alloc_hdr *hdr = (const struct alloc_hdr *)ptr - 1;
+#ifdef __linux__
+    if (UNLIKELY(hdr->len != 0))
+    {
+	(void)munmap(hdr->base, hdr->len);
+	return;
+    }
+#endif
+    if (UNLIKELY(hdr->free != NULL))
+    {
+	hdr->free(hdr->base, hdr->arg);
+	return;
+    }
+    default_free(hdr->base);
+}
+
 #ifdef __linux__
 #include <stdbool.h>
 #include <stdio.h>
@@ -8,12 +8,32 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "p64_allocator.h"
+#include "p64_memattr.h"
+
 #define INVALID_TID (~0UL)
 
 uint64_t p64_gettid(void);
 
+//Allocator and memory attributes in effect when an object was allocated
+//Memory which the object allocates later (e.g. new tables, segments or
+//thread state) comes from the same source, whichever thread allocates it
+typedef struct p64_memsrc
+{
+    p64_allocator_t alloc;//alloc.alloc == NULL selects the default allocator
+    p64_memattr_t attr;
+} p64_memsrc_t;
+
+//Get the memory source of the calling thread
+void p64_memsrc_get(p64_memsrc_t *src);
+
+//Allocate memory from the memory source of the calling thread
 void *p64_malloc(size_t size, size_t alignment);
 
+//Allocate memory from a memory source captured by p64_memsrc_get()
+void *p64_malloc_src(const p64_memsrc_t *src, size_t size, size_t alignment);
+
+//Free memory from p64_malloc() or p64_malloc_src(), also from another thread
 void p64_mfree(void *ptr);
 
 #endif
@@ -150,7 +150,8 @@ static inline struct result
 atomic_rb_acquire(ringidx_t *read_ptr,
 		  ringidx_t *write_ptr,
 		  bool enqueue,
-		  int n)
+		  int n,
+		  int min)
 {
     ringidx_t tail, mask;
     int actual;
@@ -165,7 +166,8 @@ atomic_rb_acquire(ringidx_t *read_ptr,
     {
 	ringidx_t head = atomic_load_n(read_ptr, __ATOMIC_ACQUIRE);
 	actual = MIN(n, (int)(ring_size + head - tail));
-	if (UNLIKELY(actual <= 0))
+	//Fail unless at least 'min' slots can be acquired
+	if (UNLIKELY(actual < min))
 	{
 	    return (struct result){ .index = 0, .actual = 0 };
 	}
@@ -212,6 +214,7 @@ enq_deq(p64_buckring_t *rb,
 	void *ev[],
 	uint32_t num,
 	uint32_t *idx_ptr,
+	uint32_t min,
 	bool enqueue)
 {
     //Step 1: acquire slots
@@ -219,7 +222,8 @@ enq_deq(p64_buckring_t *rb,
 	atomic_rb_acquire(enqueue ? &rb->prod.head : &rb->cons.tail,//read
 			  enqueue ? &rb->prod.tail : &rb->cons.head,//write
 			  enqueue,
-			  num);
+			  num,
+			  min);
     if (UNLIKELY(r.actual == 0))
     {
 	return 0;
@@ -377,7 +381,7 @@ p64_buckring_enqueue(p64_buckring_t *rb,
 		     void *const ev[],
 		     uint32_t num)
 {
-    return enq_deq(rb, (void **)ev, num, NULL, true);
+    return enq_deq(rb, (void **)ev, num, NULL, 1, true);
 }
 
 uint32_t
@@ -386,5 +390,20 @@ p64_buckring_dequeue(p64_buckring_t *rb,
 		     uint32_t num,
 		     uint32_t *index)
 {
-    return enq_deq(rb, ev, num, index, false);
+    return enq_deq(rb, ev, num, index, 1, false);
+}
+
+uint32_t
+p64_buckring_dequeue_min(p64_buckring_t *rb,
+			 void *ev[],
+			 uint32_t num,
+			 uint32_t *index,
+			 uint32_t min)
+{
+    if (UNLIKELY(min > num))
+    {
+	report_error("buckring", "invalid minimum number of elements", min);
+	return 0;
+    }
+    return enq_deq(rb, ev, num, index, MAX(min, 1U), false);
 }
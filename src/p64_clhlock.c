@@ -55,6 +55,12 @@ p64_clhlock_fini(p64_clhlock_t *lock)
     p64_mfree(lock->tail);
 }
 
+void
+p64_clhlock_free_node(p64_clhnode_t *node)
+{
+    p64_mfree(node);
+}
+
 static inline p64_clhnode_t *
 enqueue(p64_clhlock_t *lock, p64_clhnode_t **nodep)
 {
@@ -15,6 +15,7 @@
 
 #include "common.h"
 #include "arch.h"
+#include "lockfree.h"
 #include "thr_idx.h"
 #include "err_hnd.h"
 
@@ -34,8 +35,12 @@ struct p64_cntdomain
 {
     uint32_t ncounters;
     uint8_t use_hp;
+    uint32_t high_wm;//High watermark of thread index
+    uint32_t maxthreads;
     uint64_t *shared;
-    uint64_t *perthread[MAXTHREADS];
+    uint64_t **perthread;
+    p64_qsbrdomain_t *qsbr;//Domain of retired counters when using QSBR
+    p64_memsrc_t mem;//Source of per-thread counters
     uint64_t free[];//Bitmask of free counters
 };
 
@@ -53,17 +58,24 @@ p64_cntdomain_alloc(uint32_t ncounters, uint32_t flags)
     }
     ncounters++;//Allow for null element (cntid=0)
     uint32_t nwords = (ncounters + BITSPERWORD - 1) / BITSPERWORD;
+    uint32_t maxthreads = p64_idx_maxthreads();
     size_t nbytes = sizeof(p64_cntdomain_t) +
-		    (nwords + ncounters) * sizeof(uint64_t);
+		    (nwords + ncounters) * sizeof(uint64_t) +
+		    maxthreads * sizeof(uint64_t *);
     p64_cntdomain_t *cntd = p64_malloc(nbytes, CACHE_LINE);
     if (cntd != NULL)
     {
 	//Clear everything including shared counters
 	memset(cntd, 0, nbytes);
+	p64_memsrc_get(&cntd->mem);
 	cntd->use_hp = (flags & P64_COUNTER_F_HP) != 0;
+	cntd->qsbr = cntd->use_hp ? NULL : p64_qsbr_domain();
 	cntd->ncounters = ncounters;
+	cntd->high_wm = 0;
+	cntd->maxthreads = maxthreads;
 	cntd->shared = &cntd->free[nwords];
-	for (uint32_t t = 0; t < MAXTHREADS; t++)
+	cntd->perthread = (uint64_t **)&cntd->shared[ncounters];
+	for (uint32_t t = 0; t < maxthreads; t++)
 	{
 	    cntd->perthread[t] = NULL;
 	}
@@ -93,7 +105,8 @@ p64_cntdomain_alloc(uint32_t ncounters, uint32_t flags)
 void
 p64_cntdomain_free(p64_cntdomain_t *cntd)
 {
-    for (uint32_t i = 0; i < MAXTHREADS; i++)
+    uint32_t numthrs = __atomic_load_n(&cntd->high_wm, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < numthrs; i++)
     {
 	if (__atomic_load_n(&cntd->perthread[i], __ATOMIC_RELAXED) != NULL)
 	{
@@ -116,6 +129,12 @@ p64_cntdomain_register(p64_cntdomain_t *cntd)
     if (UNLIKELY(pth.count++ == 0))
     {
 	pth.tidx = p64_idx_alloc();
+	if (UNLIKELY(pth.tidx < 0))
+	{
+	    pth.count = 0;
+	    report_error("counter", "too many registered threads", 0);
+	    return;
+	}
     }
     if (UNLIKELY(cntd->perthread[pth.tidx] != NULL))
     {
@@ -123,7 +142,7 @@ p64_cntdomain_register(p64_cntdomain_t *cntd)
 	return;
     }
     size_t sz = cntd->ncounters * sizeof(uint64_t);
-    uint64_t *counters = p64_malloc(sz, 0);
+    uint64_t *counters = p64_malloc_src(&cntd->mem, sz, 0);
     if (counters == NULL)
     {
 	report_error("counter", "failed to allocate private stash", cntd);
@@ -133,6 +152,9 @@ p64_cntdomain_register(p64_cntdomain_t *cntd)
     memset(counters, 0, sz);
     //Publish private counters
     __atomic_store_n(&cntd->perthread[pth.tidx], counters, __ATOMIC_RELEASE);
+    //Conditionally update high watermark of indexes
+    lockfree_fetch_umax_4(&cntd->high_wm, (uint32_t)pth.tidx + 1,
+			  __ATOMIC_RELEASE);
 }
 
 void
@@ -173,7 +195,7 @@ p64_cntdomain_unregister(p64_cntdomain_t *cntd)
     }
     else
     {
-	while (!p64_qsbr_retire(counters, p64_mfree))
+	while (!p64_qsbr_retire_domain(cntd->qsbr, counters, p64_mfree))
 	{
 	    doze();
 	}
@@ -270,8 +292,10 @@ p64_counter_read(p64_cntdomain_t *cntd, p64_counter_t cntid)
 	sh0 = __atomic_load_n(&cntd->shared[cntid], __ATOMIC_RELAXED);
 	sum = sh0;
 	__atomic_thread_fence(__ATOMIC_ACQUIRE);
-	//Add values from private (per thread) locations
-	for (uint32_t t = 0; t < MAXTHREADS; t++)
+	//Add values from private (per thread) locations of all threads which
+	//have registered
+	uint32_t numthrs = __atomic_load_n(&cntd->high_wm, __ATOMIC_ACQUIRE);
+	for (uint32_t t = 0; t < numthrs; t++)
 	{
 	    uint64_t *counters;
 	    if (LIKELY(!cntd->use_hp))
@@ -8,9 +8,6 @@
 #define MURMUR3 3
 #define SCRAMBLE PHIMUL
 #define FASTRANGE //5 cycles faster than modulo and seems to distribute better (?)
-//Statistics are not multithread-safe
-//#define STATS(x) x
-#define STATS(x)
 
 #include <assert.h>
 #include <inttypes.h>
@@ -19,17 +16,28 @@
 #include <string.h>
 
 #include "p64_cuckooht.h"
+#include "p64_ebr.h"
 #include "p64_hazardptr.h"
 #include "p64_qsbr.h"
 #include "build_config.h"
 
 #include "common.h"
+#include "arch.h"
 #include "os_abstraction.h"
 #include "err_hnd.h"
 #include "atomic.h"
+#include "hashstats.h"
 
 #if defined __ARM_NEON
 #include <arm_neon.h>
+#elif defined __SSE2__
+#include <immintrin.h>
+#endif
+
+//Build with -DCUCKOOHT_SIGS2 to match the signatures of both buckets in one
+//AVX2 compare instead of matching bucket 1 only when bucket 0 misses
+#if defined CUCKOOHT_SIGS2 && defined __AVX2__ && !defined __ARM_NEON
+#define FIND_SIGS2
 #endif
 
 #if SCRAMBLE == CRC
@@ -120,14 +128,20 @@ typedef uint16_t sign_t;
 
 //Index into source/destination bucket
 #define BITS_IDX (uintptr_t)(7 << 2)
-#define GET_IDX(ptr)      (((uintptr_t)(ptr) & BITS_IDX) >> 1)
-#define SET_IDX(ptr, idx) (void *)((uintptr_t)(ptr) | ((idx) << 1))
+#define GET_IDX(ptr)      (((uintptr_t)(ptr) & BITS_IDX) >> 2)
+#define SET_IDX(ptr, idx) (void *)((uintptr_t)(ptr) | ((uintptr_t)(idx) << 2))
 
 //All tag bits
 #define BITS_ALL (TAG_DST | TAG_SRC | BITS_IDX)
 #define CLR_ALL(ptr) (void *)((uintptr_t)(ptr) & ~BITS_ALL)
 #define HAS_ANY(ptr) (((uintptr_t)(ptr) & BITS_ALL) != 0)
 
+//Slot or cell is frozen, the element is being migrated to a new table
+//A move-in-progress never has both tags set
+#define TAG_FROZEN (TAG_DST | TAG_SRC)
+#define HAS_FROZEN(ptr) (((uintptr_t)(ptr) & TAG_FROZEN) == TAG_FROZEN)
+#define SET_FROZEN(ptr) (void *)((uintptr_t)(ptr) |  TAG_FROZEN)
+
 //Indicates elements hashing to this bucket exists in cellar
 #define CELLAR_BIT 1
 //Change count increment (leave lsb 0 for cellar bit)
@@ -136,6 +150,9 @@ typedef uint16_t sign_t;
 //Logical implication: if 'p' is true then 'q' must also be true
 #define IMPLIES(p, q) (!(p) || (q))
 
+//Number of buckets (or cellar chunks) migrated when a thread helps a grow
+#define MIGRATE_STEP 4
+
 struct cell
 {
     p64_cuckooelem_t *elem;
@@ -225,32 +242,86 @@ atomic_ptr_release(p64_hazardptr_t *hp, bool use_hp)
     }
 }
 
-struct p64_cuckooht
+//When a table is full, a larger table is allocated and linked from the
+//current table. Slots and cells in the current table are frozen and their
+//elements copied to the new table. Frozen elements remain visible in the old
+//table so lookups can proceed without blocking, first in the old and then in
+//the new table
+struct cuckoo_table
 {
-    p64_cuckooht_compare cf;
+    struct cuckoo_table *next;//Destination table when grow is in progress
     bix_t nbkts;
     bix_t ncells;
-    STATS(uint32_t hit[3];)
-    STATS(uint32_t misses;)
-    STATS(uint32_t insert[2];)
-    STATS(uint32_t move[2];)
-    uint8_t use_hp;//Use hazard pointers for safe memory reclamation
     struct cell *cellar;//Pointer to cell array
+    size_t migrate ALIGNED(CACHE_LINE);//Next bucket or cellar chunk to migrate
+    size_t nmigrated;//Number of buckets and cellar chunks migrated
     struct bucket buckets[] ALIGNED(CACHE_LINE);
     //Cell array follows the last bucket
 };
 
-void
-p64_cuckooht_traverse(p64_cuckooht_t *ht,
-		      p64_cuckooht_trav_cb cb,
-		      void *arg)
+struct p64_cuckooht
+{
+    struct cuckoo_table *cur;//Current table
+    p64_cuckooht_compare cf;
+    struct hashstats *stats;//NULL unless statistics enabled
+    uint8_t use_hp;//Use hazard pointers for safe memory reclamation
+    uint8_t use_ebr;//Use epoch based reclamation
+    p64_qsbrdomain_t *qsbr;//Domain of retired tables when using QSBR
+    uint8_t grow;//Grow table when full
+    p64_memsrc_t mem;//Source of tables allocated by grow
+};
+
+static inline void
+smr_enter(p64_cuckooht_t *ht)
+{
+    if (UNLIKELY(ht->use_ebr))
+    {
+	p64_ebr_enter();
+    }
+    else if (LIKELY(!ht->use_hp))
+    {
+	p64_qsbr_acquire();
+    }
+}
+
+static inline void
+smr_exit(p64_cuckooht_t *ht)
+{
+    if (UNLIKELY(ht->use_ebr))
+    {
+	p64_ebr_exit();
+    }
+    else if (LIKELY(!ht->use_hp))
+    {
+	p64_qsbr_release();
+    }
+}
+
+static inline struct cuckoo_table *
+current_table(p64_cuckooht_t *ht)
+{
+    return atomic_load_ptr(&ht->cur, __ATOMIC_ACQUIRE);
+}
+
+//Buckets first and then cellar chunks of BKT_SIZE cells are migrated
+static inline size_t
+num_units(struct cuckoo_table *tbl)
+{
+    return tbl->nbkts + (tbl->ncells + BKT_SIZE - 1) / BKT_SIZE;
+}
+
+static void
+traverse_table(p64_cuckooht_t *ht,
+	       struct cuckoo_table *tbl,
+	       p64_cuckooht_trav_cb cb,
+	       void *arg)
 {
     p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
-    for (bix_t idx = 0; idx < ht->nbkts; idx++)
+    for (bix_t idx = 0; idx < tbl->nbkts; idx++)
     {
 	for (uint32_t j = 0; j < BKT_SIZE; j++)
 	{
-	    void *elem = atomic_load_acquire(&ht->buckets[idx].elems[j],
+	    void *elem = atomic_load_acquire(&tbl->buckets[idx].elems[j],
 					     &hp,
 					     ~BITS_ALL,
 					     ht->use_hp);
@@ -259,9 +330,9 @@ p64_cuckooht_traverse(p64_cuckooht_t *ht,
 	    {
 		if (LIKELY(!ht->use_hp))
 		{
-		    p64_qsbr_acquire();
+		    smr_enter(ht);
 		    cb(arg, elem, idx * BKT_SIZE + j);
-		    p64_qsbr_release();
+		    smr_exit(ht);
 		}
 		else
 		{
@@ -270,19 +341,20 @@ p64_cuckooht_traverse(p64_cuckooht_t *ht,
 	    }
 	}
     }
-    for (bix_t idx = 0; idx < ht->ncells; idx++)
+    for (bix_t idx = 0; idx < tbl->ncells; idx++)
     {
-	void *elem = atomic_load_acquire(&ht->cellar[idx].elem,
+	void *elem = atomic_load_acquire(&tbl->cellar[idx].elem,
 					 &hp,
 					 ~BITS_ALL,
 					 ht->use_hp);
+	elem = CLR_ALL(elem);
 	if (elem != NULL)
 	{
 	    if (LIKELY(!ht->use_hp))
 	    {
-		p64_qsbr_acquire();
+		smr_enter(ht);
 		cb(arg, elem, idx | (1U << 31));
-		p64_qsbr_release();
+		smr_exit(ht);
 	    }
 	    else
 	    {
@@ -293,54 +365,78 @@ p64_cuckooht_traverse(p64_cuckooht_t *ht,
     atomic_ptr_release(&hp, ht->use_hp);
 }
 
+void
+p64_cuckooht_traverse(p64_cuckooht_t *ht,
+		      p64_cuckooht_trav_cb cb,
+		      void *arg)
+{
+    smr_enter(ht);
+    //If grow is in progress, traverse both the old and the new table
+    //Elements migrated during the traversal may be reported twice
+    struct cuckoo_table *tbl = current_table(ht);
+    do
+    {
+	traverse_table(ht, tbl, cb, arg);
+	tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+    }
+    while (tbl != NULL);
+    smr_exit(ht);
+}
+
 void
 p64_cuckooht_check(p64_cuckooht_t *ht)
 {
+    struct cuckoo_table *tbl = ht->cur;
     bix_t histo[BKT_SIZE + 1] = { 0 };//Zero-init whole array
     bix_t ncellbits = 0;
     size_t nelems = 0;
-    for (bix_t bix = 0; bix < ht->nbkts; bix++)
+    for (bix_t bix = 0; bix < tbl->nbkts; bix++)
     {
 	uint32_t ne = 0;
 	for (uint32_t j = 0; j < BKT_SIZE; j++)
 	{
-	    ne += ht->buckets[bix].elems[j] != NULL;
+	    ne += CLR_ALL(tbl->buckets[bix].elems[j]) != NULL;
 	}
 	histo[ne]++;
 	nelems += ne;
-	if (ht->buckets[bix].chgcnt & CELLAR_BIT)
+	if (tbl->buckets[bix].chgcnt & CELLAR_BIT)
 	{
 	    ncellbits++;
 	}
     }
     size_t ncellar = 0;
-    for (bix_t i = 0; i < ht->ncells; i++)
+    for (bix_t i = 0; i < tbl->ncells; i++)
     {
-	ncellar += (ht->cellar[i].elem != NULL);
+	ncellar += (CLR_ALL(tbl->cellar[i].elem) != NULL);
     }
     nelems += ncellar;
     assert(ncellbits <= ncellar);
     assert(IMPLIES(ncellbits == 0, ncellar == 0));
     printf("Cuckoo hash table: %u buckets @ %u slots, %u cells, "
 	    "%zu elements, load=%.2f\n",
-	    ht->nbkts, BKT_SIZE, ht->ncells,
-	    nelems, (float)nelems / (ht->nbkts * BKT_SIZE + ht->ncells));
+	    tbl->nbkts, BKT_SIZE, tbl->ncells,
+	    nelems, (float)nelems / (tbl->nbkts * BKT_SIZE + tbl->ncells));
     printf("Bucket occupancy histogram\n");
     for (uint32_t i = 0; i < BKT_SIZE + 1; i++)
     {
-	printf("%u: %7u (%.3f)\n", i, histo[i], histo[i] / (float)ht->nbkts);
-    }
-    printf("Cellar: %zu (%.3f)\n", ncellar, ncellar / (float)ht->ncells);
-    STATS(uint32_t inserts = ht->insert[0] + ht->insert[1];)
-    STATS(printf("Insert[0]: %u (%.3f)\n", ht->insert[0], (double)ht->insert[0] / inserts);)
-    STATS(printf("Insert[1]: %u (%.3f)\n", ht->insert[1], (double)ht->insert[1] / inserts);)
-    STATS(printf("Move[0]: %u (%.3f)\n", ht->move[0], (double)ht->move[0] / inserts);)
-    STATS(printf("Move[1]: %u (%.3f)\n", ht->move[1], (double)ht->move[1] / inserts);)
-    STATS(uint32_t hits = ht->hit[0] + ht->hit[1] + ht->hit[2];)
-    STATS(printf("Hit[0]: %u (%.3f)\n", ht->hit[0], (double)ht->hit[0] / hits);)
-    STATS(printf("Hit[1]: %u (%.3f)\n", ht->hit[1], (double)ht->hit[1] / hits);)
-    STATS(printf("Hit[C]: %u (%.3f)\n", ht->hit[2], (double)ht->hit[2] / hits);)
-    STATS(printf("Misses: %u\n", ht->misses);)
+	printf("%u: %7u (%.3f)\n", i, histo[i], histo[i] / (float)tbl->nbkts);
+    }
+    printf("Cellar: %zu (%.3f)\n", ncellar, ncellar / (float)tbl->ncells);
+    if (ht->stats != NULL)
+    {
+	p64_hashstats_t st;
+	hashstats_read(ht->stats, &st);
+	printf("Lookups: %"PRIu64" (misses %"PRIu64")\n",
+	       st.lookups, st.lookup_misses);
+	for (uint32_t i = 0; i < P64_HASHSTATS_NPROBES; i++)
+	{
+	    printf("Probes[%u]: %"PRIu64"\n", i + 1, st.probes[i]);
+	}
+	printf("Inserts: %"PRIu64" (failed %"PRIu64")\n",
+	       st.inserts, st.insert_fails);
+	printf("Relocations: %"PRIu64"\n", st.relocations);
+	printf("CAS retries: %"PRIu64"\n", st.cas_retries);
+    }
 #ifdef FASTRANGE
 #define RINGMOD "fastrange"
 #else
@@ -351,7 +447,30 @@ p64_cuckooht_check(p64_cuckooht_t *ht)
     printf("scramble: %s\n", scramble_str[SCRAMBLE]);
 }
 
-#define VALID_FLAGS P64_CUCKOOHT_F_HP
+static struct cuckoo_table *
+table_alloc(const p64_memsrc_t *mem, size_t nbkts, size_t ncells)
+{
+    size_t sz = sizeof(struct cuckoo_table) +
+		sizeof(struct bucket) * nbkts +
+		sizeof(struct cell) * ncells;
+    struct cuckoo_table *tbl = p64_malloc_src(mem, sz, CACHE_LINE);
+    if (tbl != NULL)
+    {
+	memset(tbl, 0, sz);
+	//All buckets cleared (NULL element pointers)
+	//All cells cleared (NULL element pointers)
+	tbl->next = NULL;
+	tbl->nbkts = nbkts;
+	tbl->ncells = ncells;
+	tbl->cellar = (struct cell *)&tbl->buckets[nbkts];
+	tbl->migrate = 0;
+	tbl->nmigrated = 0;
+    }
+    return tbl;
+}
+
+#define VALID_FLAGS (P64_CUCKOOHT_F_HP | P64_CUCKOOHT_F_GROW | \
+		     P64_CUCKOOHT_F_STATS | P64_CUCKOOHT_F_EBR)
 
 p64_cuckooht_t *
 p64_cuckooht_alloc(size_t nelems,
@@ -381,26 +500,50 @@ p64_cuckooht_alloc(size_t nelems,
 	report_error("cuckooht", "invalid flags", flags);
 	return NULL;
     }
+    if (UNLIKELY((flags & P64_CUCKOOHT_F_HP) != 0 &&
+		 (flags & P64_CUCKOOHT_F_EBR) != 0))
+    {
+	report_error("cuckooht", "conflicting SMR flags", flags);
+	return NULL;
+    }
+    if (UNLIKELY((flags & P64_CUCKOOHT_F_GROW) != 0 &&
+		 (flags & P64_CUCKOOHT_F_HP) != 0))
+    {
+	report_error("cuckooht", "grow requires QSBR or EBR", flags);
+	return NULL;
+    }
     size_t nbkts = (nelems + BKT_SIZE - 1) / BKT_SIZE;
     //Must have at least two buckets
     if (nbkts < 2)
     {
 	nbkts = 2;
     }
-    size_t sz = sizeof(p64_cuckooht_t) +
-		sizeof(struct bucket) * nbkts +
-		sizeof(struct cell) * ncells;
-    p64_cuckooht_t *ht = p64_malloc(sz, CACHE_LINE);
+    p64_cuckooht_t *ht = p64_malloc(sizeof(p64_cuckooht_t), CACHE_LINE);
     if (ht != NULL)
     {
-	memset(ht, 0, sz);
-	//All buckets cleared (NULL element pointers)
-	//All cells cleared (NULL element pointers)
+	memset(ht, 0, sizeof(p64_cuckooht_t));
+	p64_memsrc_get(&ht->mem);
+	ht->cur = table_alloc(&ht->mem, nbkts, ncells);
+	if (ht->cur == NULL)
+	{
+	    p64_mfree(ht);
+	    return NULL;
+	}
 	ht->cf = cf;
-	ht->nbkts = nbkts;
-	ht->ncells = ncells;
 	ht->use_hp = (flags & P64_CUCKOOHT_F_HP) != 0;
-	ht->cellar = (struct cell *)&ht->buckets[nbkts];
+	ht->use_ebr = (flags & P64_CUCKOOHT_F_EBR) != 0;
+	ht->qsbr = !ht->use_hp && !ht->use_ebr ? p64_qsbr_domain() : NULL;
+	ht->grow = (flags & P64_CUCKOOHT_F_GROW) != 0;
+	if ((flags & P64_CUCKOOHT_F_STATS) != 0)
+	{
+	    ht->stats = hashstats_alloc();
+	    if (ht->stats == NULL)
+	    {
+		p64_mfree(ht->cur);
+		p64_mfree(ht);
+		return NULL;
+	    }
+	}
     }
     return ht;
 }
@@ -412,28 +555,39 @@ p64_cuckooht_free(p64_cuckooht_t *ht)
 {
     if (ht != NULL)
     {
-	//Check if hash table is empty
-	for (bix_t i = 0; i < ht->nbkts; i++)
+	//Check if hash table is empty, including any unfinished grow
+	for (struct cuckoo_table *tbl = ht->cur; tbl != NULL; tbl = tbl->next)
 	{
-	    for (uint32_t j = 0; j < BKT_SIZE; j++)
+	    for (bix_t i = 0; i < tbl->nbkts; i++)
+	    {
+		for (uint32_t j = 0; j < BKT_SIZE; j++)
+		{
+		    //No need to use HP or QSBR, elements are not accessed
+		    if (CLR_ALL(tbl->buckets[i].elems[j]) != NULL)
+		    {
+			report_error("cuckooht", "hash table not empty", 0);
+			return;
+		    }
+		}
+	    }
+	    for (bix_t i = 0; i < tbl->ncells; i++)
 	    {
 		//No need to use HP or QSBR, elements are not accessed
-		if (ht->buckets[i].elems[j] != NULL)
+		if (CLR_ALL(tbl->cellar[i].elem) != NULL)
 		{
 		    report_error("cuckooht", "hash table not empty", 0);
 		    return;
 		}
 	    }
 	}
-	for (bix_t i = 0; i < ht->ncells; i++)
+	struct cuckoo_table *tbl = ht->cur;
+	while (tbl != NULL)
 	{
-	    //No need to use HP or QSBR, elements are not accessed
-	    if (ht->cellar[i].elem != NULL)
-	    {
-		report_error("cuckooht", "hash table not empty", 0);
-		return;
-	    }
+	    struct cuckoo_table *next = tbl->next;
+	    p64_mfree(tbl);
+	    tbl = next;
 	}
+	hashstats_free(ht->stats);
 	p64_mfree(ht);
     }
 }
@@ -470,6 +624,15 @@ find_sig(const sign_t sigs[BKT_SIZE], sign_t sig)
     //Generate 1-bit boolean mask
     matches &= 0x010101010101;
 #endif
+#elif defined __SSE2__
+    static_assert(BKT_SIZE <= 8, "BKT_SIZE <= 8");
+    //Read all (up to 8) sigs, reading beyond sigs[] into elems[] is safe
+    __m128i vsigs = _mm_loadu_si128((const __m128i *)sigs);
+    //compare sigs: equality => ~0 (per lane), inequality => 0
+    __m128i vmatch16 = _mm_cmpeq_epi16(vsigs, _mm_set1_epi16(sig));
+    //Narrow to 8-bit lanes and generate 1-bit boolean mask
+    __m128i vmatch8 = _mm_packs_epi16(vmatch16, _mm_setzero_si128());
+    matches = _mm_movemask_epi8(vmatch8) & ((1U << BKT_SIZE) - 1);
 #else
     matches = 0;
     for (uint32_t i = 0; i < BKT_SIZE; i++)
@@ -483,6 +646,33 @@ find_sig(const sign_t sigs[BKT_SIZE], sign_t sig)
     return matches;
 }
 
+#ifdef FIND_SIGS2
+//Match signatures in both buckets in one operation
+//Always reads the signatures of bucket 1, even when bucket 0 has a match
+ALWAYS_INLINE
+static inline void
+find_sigs(const struct bucket *bkt0,
+	  const struct bucket *bkt1,
+	  sign_t sig,
+	  mask_t *mask0,
+	  mask_t *mask1)
+{
+    static_assert(BKT_SIZE <= 8, "BKT_SIZE <= 8");
+    //Read sigs of both buckets into one vector register, one bucket per
+    //128-bit lane, and compare all of them in one operation
+    __m256i vsigs = _mm256_inserti128_si256(
+	_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)bkt0->sigs)),
+	_mm_loadu_si128((const __m128i *)bkt1->sigs), 1);
+    __m256i vmatch16 = _mm256_cmpeq_epi16(vsigs, _mm256_set1_epi16(sig));
+    //Narrow to 8-bit lanes (within each 128-bit lane), bucket 0 matches end
+    //up in bits 0..7 and bucket 1 matches in bits 16..23
+    __m256i vmatch8 = _mm256_packs_epi16(vmatch16, _mm256_setzero_si256());
+    uint32_t matches = _mm256_movemask_epi8(vmatch8);
+    *mask0 = matches & ((1U << BKT_SIZE) - 1);
+    *mask1 = (matches >> 16) & ((1U << BKT_SIZE) - 1);
+}
+#endif
+
 ALWAYS_INLINE
 static inline p64_cuckooelem_t *
 check_matches(p64_cuckooht_t *ht,
@@ -532,29 +722,32 @@ check_matches(p64_cuckooht_t *ht,
 NO_INLINE
 static p64_cuckooelem_t *
 search_cellar(p64_cuckooht_t *ht,
+	      struct cuckoo_table *tbl,
 	      const void *key,
 	      p64_cuckoohash_t hash,
 	      p64_hazardptr_t *hazpp,
 	      bool use_hp,
 	      bool check_key)
 {
-    if (UNLIKELY(ht->ncells == 0))
+    if (UNLIKELY(tbl->ncells == 0))
     {
 	return NULL;
     }
-    bix_t start = ring_mod(hash, ht->ncells);
+    bix_t start = ring_mod(hash, tbl->ncells);
     //Start search from bucket-specific position
     bix_t idx = start;
     do
     {
-	if (atomic_load_n(&ht->cellar[idx].hash, __ATOMIC_RELAXED) == hash)
+	if (atomic_load_n(&tbl->cellar[idx].hash, __ATOMIC_RELAXED) == hash)
 	{
 	    //Wr: load-acquire(cellar.elem), synchronize with Ww
 	    p64_cuckooelem_t *elem =
-		atomic_load_acquire(&ht->cellar[idx].elem,
+		atomic_load_acquire(&tbl->cellar[idx].elem,
 				    hazpp,
 				    ~BITS_ALL,
 				    use_hp);
+	    //Cell may be frozen
+	    elem = CLR_ALL(elem);
 	    if (elem != NULL)
 	    {
 		if (check_key)
@@ -573,7 +766,7 @@ search_cellar(p64_cuckooht_t *ht,
 		}
 	    }
 	}
-	idx = ring_add(idx, 1, ht->ncells);
+	idx = ring_add(idx, 1, tbl->ncells);
     }
     while (idx != start);
     return NULL;
@@ -582,6 +775,7 @@ search_cellar(p64_cuckooht_t *ht,
 ALWAYS_INLINE
 static inline void *
 lookup(p64_cuckooht_t *ht,
+       struct cuckoo_table *tbl,
        const void *key,
        p64_cuckoohash_t hash,
        struct bucket *bkt0,
@@ -591,33 +785,43 @@ lookup(p64_cuckooht_t *ht,
        bool check_key)
 {
     uint32_t chgcnt;
+    uint32_t nprobes = 0;
     p64_cuckooelem_t *elem;
     do
     {
 	//Xr: read chgcnt, synchronize with Xw
 	chgcnt = atomic_load_n(&bkt0->chgcnt, __ATOMIC_ACQUIRE);
 	//Create bit masks with all matching hashes
+#ifdef FIND_SIGS2
+	mask_t mask0, mask1;
+	find_sigs(bkt0, bkt1, hash >> 16, &mask0, &mask1);
+#else
+	//Bucket 1 is only checked if the element is not found in bucket 0
 	mask_t mask0 = find_sig(bkt0->sigs, hash >> 16);
+#endif
 	if (LIKELY(mask0 != 0))
 	{
 	    //Perform complete checks for any matches
 	    elem = check_matches(ht, bkt0, mask0, key, hash, hazpp, use_hp, check_key);
 	    if (elem != NULL)
 	    {
-		STATS(ht->hit[0]++;)
+		hashstats_lookup(ht->stats, nprobes + 1, true);
 		return elem;
 	    }
 	}
+#ifndef FIND_SIGS2
 	mask_t mask1 = find_sig(bkt1->sigs, hash >> 16);
+#endif
 	if (LIKELY(mask1 != 0))
 	{
 	    elem = check_matches(ht, bkt1, mask1, key, hash, hazpp, use_hp, check_key);
 	    if (elem != NULL)
 	    {
-		STATS(ht->hit[1]++;)
+		hashstats_lookup(ht->stats, nprobes + 2, true);
 		return elem;
 	    }
 	}
+	nprobes += 2;
 	//Yr: load-relaxed(elems) + fence-acquire, synchronize with Yw
 	atomic_thread_fence(__ATOMIC_ACQUIRE);
 	//Re-read the change counter too see if we might have missed
@@ -628,17 +832,58 @@ lookup(p64_cuckooht_t *ht,
     //present in the cellar
     if ((chgcnt & CELLAR_BIT) != 0)
     {
-	elem = search_cellar(ht, key, hash, hazpp, use_hp, check_key);
+	nprobes++;
+	elem = search_cellar(ht, tbl, key, hash, hazpp, use_hp, check_key);
 	if (elem != NULL)
 	{
-	    STATS(ht->hit[2]++;)
+	    hashstats_lookup(ht->stats, nprobes, true);
 	    return elem;
 	}
     }
-    STATS(ht->misses++;)
+    hashstats_lookup(ht->stats, nprobes, false);
     return NULL;
 }
 
+ALWAYS_INLINE
+static inline p64_cuckooelem_t *
+lookup_table(p64_cuckooht_t *ht,
+	     struct cuckoo_table *tbl,
+	     const void *key,
+	     p64_cuckoohash_t hash,
+	     p64_hazardptr_t *hazpp)
+{
+    bix_t bix0 = ring_mod(hash, tbl->nbkts);
+    struct bucket *bkt0 = &tbl->buckets[bix0];
+    PREFETCH_FOR_READ(bkt0);
+    bix_t bix1 = ring_mod(scramble(hash), tbl->nbkts);
+    if (UNLIKELY(bix1 == bix0))
+    {
+	bix1 = ring_add(bix1, 1, tbl->nbkts);
+    }
+    struct bucket *bkt1 = &tbl->buckets[bix1];
+    PREFETCH_FOR_READ(bkt1);
+    p64_cuckooelem_t *elem = lookup(ht, tbl, key, hash, bkt0, bkt1, hazpp, ht->use_hp, true);
+    return elem;
+}
+
+//Element not found in table, if grow is in progress then the element may
+//have been inserted into the next table
+NO_INLINE
+static p64_cuckooelem_t *
+lookup_next(p64_cuckooht_t *ht,
+	    struct cuckoo_table *tbl,
+	    const void *key,
+	    p64_cuckoohash_t hash)
+{
+    p64_cuckooelem_t *elem = NULL;
+    while (elem == NULL &&
+	   (tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE)) != NULL)
+    {
+	elem = lookup_table(ht, tbl, key, hash, NULL);
+    }
+    return elem;
+}
+
 p64_cuckooelem_t *
 p64_cuckooht_lookup(p64_cuckooht_t *ht,
 		    const void *key,
@@ -646,17 +891,12 @@ p64_cuckooht_lookup(p64_cuckooht_t *ht,
 		    p64_hazardptr_t *hazpp)
 {
     //Caller must call QSBR acquire/release/quiescent as appropriate
-    bix_t bix0 = ring_mod(hash, ht->nbkts);
-    struct bucket *bkt0 = &ht->buckets[bix0];
-    PREFETCH_FOR_READ(bkt0);
-    bix_t bix1 = ring_mod(scramble(hash), ht->nbkts);
-    if (UNLIKELY(bix1 == bix0))
+    struct cuckoo_table *tbl = current_table(ht);
+    p64_cuckooelem_t *elem = lookup_table(ht, tbl, key, hash, hazpp);
+    if (UNLIKELY(elem == NULL && ht->grow))
     {
-	bix1 = ring_add(bix1, 1, ht->nbkts);
+	elem = lookup_next(ht, tbl, key, hash);
     }
-    struct bucket *bkt1 = &ht->buckets[bix1];
-    PREFETCH_FOR_READ(bkt1);
-    p64_cuckooelem_t *elem = lookup(ht, key, hash, bkt0, bkt1, hazpp, ht->use_hp, true);
     return elem;
 }
 
@@ -672,26 +912,27 @@ p64_cuckooht_lookup_vec(p64_cuckooht_t *ht,
     {
 	report_error("cuckooht", "hazard pointers not supported", 0);
     }
+    struct cuckoo_table *tbl = current_table(ht);
     bix_t bix0[num], bix1[num];
     for (uint32_t i = 0; i < num; i++)
     {
 	//Compute all bucket indexes and prefetch all buckets
-	bix0[i] = ring_mod(hashes[i], ht->nbkts);
-	struct bucket *bkt0 = &ht->buckets[bix0[i]];
+	bix0[i] = ring_mod(hashes[i], tbl->nbkts);
+	struct bucket *bkt0 = &tbl->buckets[bix0[i]];
 	PREFETCH_FOR_READ(bkt0);
-	bix1[i] = ring_mod(scramble(hashes[i]), ht->nbkts);
+	bix1[i] = ring_mod(scramble(hashes[i]), tbl->nbkts);
 	if (UNLIKELY(bix1[i] == bix0[i]))
 	{
-	    bix1[i] = ring_add(bix1[i], 1, ht->nbkts);
+	    bix1[i] = ring_add(bix1[i], 1, tbl->nbkts);
 	}
-	struct bucket *bkt1 = &ht->buckets[bix1[i]];
+	struct bucket *bkt1 = &tbl->buckets[bix1[i]];
 	PREFETCH_FOR_READ(bkt1);
     }
     for (uint32_t i = 0; i < num; i++)
     {
-	struct bucket *bkt0 = &ht->buckets[bix0[i]];
-	struct bucket *bkt1 = &ht->buckets[bix1[i]];
-	result[i] = lookup(ht, keys[i], hashes[i], bkt0, bkt1, NULL, false, false);
+	struct bucket *bkt0 = &tbl->buckets[bix0[i]];
+	struct bucket *bkt1 = &tbl->buckets[bix1[i]];
+	result[i] = lookup(ht, tbl, keys[i], hashes[i], bkt0, bkt1, NULL, false, false);
     }
     for (uint32_t i = 0; i < num; i++)
     {
@@ -703,6 +944,10 @@ p64_cuckooht_lookup_vec(p64_cuckooht_t *ht,
 		result[i] = NULL;
 	    }
 	}
+	if (UNLIKELY(result[i] == NULL && ht->grow))
+	{
+	    result[i] = lookup_next(ht, tbl, keys[i], hashes[i]);
+	}
     }
 }
 
@@ -729,8 +974,10 @@ write_sig(struct bucket *bkt,
 	//Else failed to update sig
 	//Some other thread has written sig and possibly also elem fields
 	//after our write to elem
-	//Check if our element is still present
-	if (atomic_load_ptr(&bkt->elems[idx], __ATOMIC_RELAXED) != elem)
+	//Check if our element is still present (it may have been frozen)
+	p64_cuckooelem_t *cur = atomic_load_ptr(&bkt->elems[idx],
+						__ATOMIC_RELAXED);
+	if (cur != elem && cur != SET_FROZEN(elem))
 	{
 	    //No, element not present anymore, don't write sig
 	    return;
@@ -774,22 +1021,22 @@ bucket_insert(struct bucket *bkt,
 
 //Compute the sibling bucket index
 static inline bix_t
-sibling_bix(p64_cuckooht_t *ht,
+sibling_bix(struct cuckoo_table *tbl,
 	    p64_cuckoohash_t hash,
 	    bix_t bix)
 {
     bix_t sib_bix;
-    bix_t bix0 = ring_mod(hash, ht->nbkts);
+    bix_t bix0 = ring_mod(hash, tbl->nbkts);
     if (bix0 != bix)
     {
 	sib_bix = bix0;//bix0 is sibling bucket index
     }
     else
     {
-	bix_t bix1 = ring_mod(scramble(hash), ht->nbkts);
+	bix_t bix1 = ring_mod(scramble(hash), tbl->nbkts);
 	if (UNLIKELY(bix1 == bix0))
 	{
-	    bix1 = ring_add(bix1, 1, ht->nbkts);
+	    bix1 = ring_add(bix1, 1, tbl->nbkts);
 	}
 	sib_bix = bix1;
     }
@@ -798,14 +1045,14 @@ sibling_bix(p64_cuckooht_t *ht,
 
 //Clean tags from destination slot
 static void
-clean_dst(p64_cuckooht_t *ht,
+clean_dst(struct cuckoo_table *tbl,
 	  p64_cuckooelem_t *elem,
 	  bix_t dst_bix,
 	  uint32_t dst_idx,
 	  uint32_t src_idx)
 {
     assert(!HAS_ANY(elem));
-    struct bucket *dst_bkt = &ht->buckets[dst_bix];
+    struct bucket *dst_bkt = &tbl->buckets[dst_bix];
     p64_cuckooelem_t *old = SET_IDX(SET_SRC(elem), src_idx);
     //Remove the tags, keeping the bare element pointer
     if (atomic_compare_exchange_ptr(&dst_bkt->elems[dst_idx],
@@ -816,7 +1063,7 @@ clean_dst(p64_cuckooht_t *ht,
     {
 	//Tags removed, element is clean, move complete
 #if 0
-	bix_t src_bix = sibling_bix(ht, elem->hash, dst_bix);
+	bix_t src_bix = sibling_bix(tbl, elem->hash, dst_bix);
 	printf("Move %u:%u -> %u:%u complete\n",
 		src_bix, src_idx,
 		dst_bix, dst_idx);
@@ -827,7 +1074,7 @@ clean_dst(p64_cuckooht_t *ht,
 
 //Clear source slot
 static void
-clear_src(p64_cuckooht_t *ht,
+clear_src(struct cuckoo_table *tbl,
 	  p64_cuckooelem_t *elem,
 	  bix_t src_bix,
 	  uint32_t src_idx,
@@ -835,7 +1082,7 @@ clear_src(p64_cuckooht_t *ht,
 	  uint32_t dst_idx)
 {
     assert(!HAS_ANY(elem));
-    struct bucket *src_bkt = &ht->buckets[src_bix];
+    struct bucket *src_bkt = &tbl->buckets[src_bix];
     p64_cuckooelem_t *old = SET_IDX(SET_DST(elem), dst_idx);
     //A pre-check of the elem field, we don't want to unnecessarily increment
     //the change counter
@@ -854,12 +1101,12 @@ clear_src(p64_cuckooht_t *ht,
     }
     //Else source slot already updated
     //Now clean element pointer in destination slot
-    clean_dst(ht, elem, dst_bix, dst_idx, src_idx);
+    clean_dst(tbl, elem, dst_bix, dst_idx, src_idx);
 }
 
 //Move existing element from source to destination bucket
 static void
-move_elem(p64_cuckooht_t *ht,
+move_elem(struct cuckoo_table *tbl,
 	  p64_cuckooelem_t *elem,
 	  bix_t src_bix,
 	  uint32_t src_idx,
@@ -868,8 +1115,8 @@ move_elem(p64_cuckooht_t *ht,
 {
     assert(!HAS_ANY(elem));
     //Write element to destination slot together with info about source slot
-    struct bucket *src_bkt = &ht->buckets[src_bix];
-    struct bucket *dst_bkt = &ht->buckets[dst_bix];
+    struct bucket *src_bkt = &tbl->buckets[src_bix];
+    struct bucket *dst_bkt = &tbl->buckets[dst_bix];
     sign_t oldsig = atomic_load_n(&dst_bkt->sigs[dst_idx], __ATOMIC_RELAXED);
     p64_cuckooelem_t *old = SET_DST(NULL);
     if (atomic_compare_exchange_ptr(&dst_bkt->elems[dst_idx],
@@ -893,18 +1140,18 @@ move_elem(p64_cuckooht_t *ht,
     //Now clear source slot
     //Yw: fence-release + store-relaxed(elem), synchronize with Yr
     atomic_thread_fence(__ATOMIC_RELEASE);
-    clear_src(ht, elem, src_bix, src_idx, dst_bix, dst_idx);
+    clear_src(tbl, elem, src_bix, src_idx, dst_bix, dst_idx);
 }
 
 static void
-help_move(p64_cuckooht_t *ht,
+help_move(struct cuckoo_table *tbl,
 	  p64_cuckooelem_t *elem,
 	  bix_t bix0,
 	  uint32_t idx0)
 {
     assert(HAS_ANY(elem) != 0);
     assert(idx0 < BKT_SIZE);
-    bix_t bix1 = sibling_bix(ht, elem->hash, bix0);
+    bix_t bix1 = sibling_bix(tbl, elem->hash, bix0);
     uint32_t idx1 = GET_IDX(elem);
     assert(idx1 < BKT_SIZE);
     bix_t src_bix, dst_bix;
@@ -927,17 +1174,17 @@ help_move(p64_cuckooht_t *ht,
     {
 	abort();
     }
-    move_elem(ht, CLR_ALL(elem), src_bix, src_idx, dst_bix, dst_idx);
+    move_elem(tbl, CLR_ALL(elem), src_bix, src_idx, dst_bix, dst_idx);
 }
 
 //Find and reserve empty slot in destination bucket, return index
 static bool
-find_empty(p64_cuckooht_t *ht,
+find_empty(struct cuckoo_table *tbl,
 	   bix_t dst_bix,
 	   uint32_t *dst_idx)
 {
     //Check destination bucket for empty slots
-    struct bucket *bkt = &ht->buckets[dst_bix];
+    struct bucket *bkt = &tbl->buckets[dst_bix];
     for (uint32_t i = 0; i < BKT_SIZE; i++)
     {
 	if (bkt->elems[i] == NULL)
@@ -966,10 +1213,11 @@ find_empty(p64_cuckooht_t *ht,
 //(destination) bucket, thus freeing up a slot in this bucket
 static mask_t
 make_room(p64_cuckooht_t *ht,
+	  struct cuckoo_table *tbl,
 	  bix_t src_bix)
 {
     p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
-    struct bucket *bkt = &ht->buckets[src_bix];
+    struct bucket *bkt = &tbl->buckets[src_bix];
     for (uint32_t src_idx = 0; src_idx < BKT_SIZE; src_idx++)
     {
 	p64_cuckooelem_t *elem = atomic_load_acquire(&bkt->elems[src_idx],
@@ -979,24 +1227,28 @@ make_room(p64_cuckooht_t *ht,
 	if (UNLIKELY(elem == NULL))
 	{
 	    //Slot unexpectedly became empty (great!)
-	    assert(bkt->elems[src_idx] == NULL);
 	    return (mask_t)1 << (src_idx << MASK_SHIFT);
 	}
+	else if (UNLIKELY(HAS_FROZEN(elem)))
+	{
+	    //Bucket is being migrated to new table
+	    break;
+	}
 	else if (UNLIKELY(HAS_ANY(elem)))
 	{
 	    //Slot is source or destination of move-in-progress
 	    if (CLR_ALL(elem) != NULL)
 	    {
-		help_move(ht, elem, src_bix, src_idx);
+		help_move(tbl, elem, src_bix, src_idx);
 	    }
 	    //Else slot is reserved but we don't know anything else
 	    continue;
 	}
 	//Else found 'clean' element
 	//Find and reserve empty slot in sibling (destination) bucket
-	bix_t dst_bix = sibling_bix(ht, elem->hash, src_bix);
+	bix_t dst_bix = sibling_bix(tbl, elem->hash, src_bix);
 	uint32_t dst_idx;
-	if (find_empty(ht, dst_bix, &dst_idx))
+	if (find_empty(tbl, dst_bix, &dst_idx))
 	{
 	    //Tag source element with index in destination bucket
 	    //Destination bucket itself can be computed from hash
@@ -1008,13 +1260,16 @@ make_room(p64_cuckooht_t *ht,
 	    {
 		//Move started!
 		//Let's try to complete the move ourselves
-		move_elem(ht, elem, src_bix, src_idx, dst_bix, dst_idx);
-		assert(bkt->elems[src_idx] == NULL);
+		move_elem(tbl, elem, src_bix, src_idx, dst_bix, dst_idx);
+		hashstats_add(ht->stats, HS_RELOC, 1);
+		//Source slot now empty but may be refilled (or frozen) by
+		//other threads before we get to use it
 		return (mask_t)1 << (src_idx << MASK_SHIFT);
 	    }
 	    //Else slot changed
+	    hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 	    //Undo reservation
-	    struct bucket *dst_bkt = &ht->buckets[dst_bix];
+	    struct bucket *dst_bkt = &tbl->buckets[dst_bix];
 	    p64_cuckooelem_t *old = SET_DST(NULL);
 	    if (!atomic_compare_exchange_ptr(&dst_bkt->elems[dst_idx],
 					     &old,
@@ -1038,28 +1293,28 @@ make_room(p64_cuckooht_t *ht,
 
 NO_INLINE
 static bool
-insert_cell(p64_cuckooht_t *ht,
+insert_cell(struct cuckoo_table *tbl,
 	    p64_cuckooelem_t *elem,
 	    p64_cuckoohash_t hash,
 	    struct bucket *bkt)
 {
-    if (UNLIKELY(ht->ncells == 0))
+    if (UNLIKELY(tbl->ncells == 0))
     {
 	return false;
     }
-    bix_t start = ring_mod(hash, ht->ncells);
+    bix_t start = ring_mod(hash, tbl->ncells);
     bix_t idx = start;
     do
     {
-	if (atomic_load_ptr(&ht->cellar[idx].elem, __ATOMIC_RELAXED) == NULL)
+	if (atomic_load_ptr(&tbl->cellar[idx].elem, __ATOMIC_RELAXED) == NULL)
 	{
 	    //Write elem & hash fields atomically
 	    p64_cuckoohash_t oldhash =
-		atomic_load_n(&ht->cellar[idx].hash, __ATOMIC_RELAXED);
+		atomic_load_n(&tbl->cellar[idx].hash, __ATOMIC_RELAXED);
 	    union cellpp old = { .cell.elem = NULL, .cell.hash = oldhash };
 	    union cellpp new = { .cell.elem = elem, .cell.hash = hash };
 	    //Ww: write cellar, synchronize with Wr
-	    if (atomic_compare_exchange_n((ptrpair_t *)&ht->cellar[idx],
+	    if (atomic_compare_exchange_n((ptrpair_t *)&tbl->cellar[idx],
 					  &old.pp,
 					  new.pp,
 					  __ATOMIC_RELEASE,
@@ -1083,7 +1338,7 @@ insert_cell(p64_cuckooht_t *ht,
 		return true;
 	    }
 	}
-	idx = ring_add(idx, 1, ht->ncells);
+	idx = ring_add(idx, 1, tbl->ncells);
     }
     while (idx != start);
     return false;
@@ -1138,31 +1393,22 @@ find_null(p64_cuckooelem_t **elems, uint32_t *count)
 }
 
 UNROLL_LOOPS
-bool
-p64_cuckooht_insert(p64_cuckooht_t *ht,
-		    p64_cuckooelem_t *elem,
-		    p64_cuckoohash_t hash)
+static bool
+insert_table(p64_cuckooht_t *ht,
+	     struct cuckoo_table *tbl,
+	     p64_cuckooelem_t *elem,
+	     p64_cuckoohash_t hash)
 {
-    if (UNLIKELY(HAS_ANY(elem)))
-    {
-	report_error("cuckooht", "element has low bits set", elem);
-	return false;
-    }
-    elem->hash = hash;
-    bix_t bix0 = ring_mod(hash, ht->nbkts);
-    struct bucket *bkt0 = &ht->buckets[bix0];
+    bix_t bix0 = ring_mod(hash, tbl->nbkts);
+    struct bucket *bkt0 = &tbl->buckets[bix0];
     PREFETCH_FOR_READ(bkt0);
-    bix_t bix1 = ring_mod(scramble(hash), ht->nbkts);
+    bix_t bix1 = ring_mod(scramble(hash), tbl->nbkts);
     if (UNLIKELY(bix1 == bix0))
     {
-	bix1 = ring_add(bix1, 1, ht->nbkts);
+	bix1 = ring_add(bix1, 1, tbl->nbkts);
     }
-    struct bucket *bkt1 = &ht->buckets[bix1];
+    struct bucket *bkt1 = &tbl->buckets[bix1];
     PREFETCH_FOR_READ(bkt1);
-    if (LIKELY(!ht->use_hp))
-    {
-	p64_qsbr_acquire();
-    }
     bool success;
     for (;;)
     {
@@ -1175,9 +1421,9 @@ p64_cuckooht_insert(p64_cuckooht_t *ht,
 	    success = bucket_insert(bkt0, empty0, elem, hash);
 	    if (success)
 	    {
-		STATS(ht->insert[0]++;)
 		break;
 	    }
+	    hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 	}
 	mask_t empty1 = find_null(bkt1->elems, &numempt1);
 	assert(numempt1 == __builtin_popcountll(empty1));
@@ -1186,56 +1432,58 @@ p64_cuckooht_insert(p64_cuckooht_t *ht,
 	    success = bucket_insert(bkt1, empty1, elem, hash);
 	    if (success)
 	    {
-		STATS(ht->insert[1]++;)
 		break;
 	    }
+	    hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 	}
 	//Else some other thread(s) stole all the empty slots
-	if ((empty0 = make_room(ht, bix0)))
+	if ((empty0 = make_room(ht, tbl, bix0)))
 	{
-	    STATS(ht->move[0]++;)
 	    success = bucket_insert(bkt0, empty0, elem, hash);
 	    if (success)
 	    {
-		STATS(ht->insert[0]++;)
 		break;
 	    }
 	    //Else some other thread stole our slot
+	    hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 	    continue;
 	}
-	if ((empty1 = make_room(ht, bix1)))
+	if ((empty1 = make_room(ht, tbl, bix1)))
 	{
-	    STATS(ht->move[1]++;)
 	    success = bucket_insert(bkt1, empty1, elem, hash);
 	    if (success)
 	    {
-		STATS(ht->insert[1]++;)
 		break;
 	    }
 	    //Else some other thread stole our slot
+	    hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 	    continue;
 	}
 	//Could not make room in any of the buckets
 	//Try to insert in cellar
-	success = insert_cell(ht, elem, hash, bkt0);
+	success = insert_cell(tbl, elem, hash, bkt0);
 	//If also the cellar is full, we give up
 	break;
     }
-    if (LIKELY(!ht->use_hp))
-    {
-	p64_qsbr_release();
-    }
     return success;
 }
 
+enum remove_result
+{
+    not_found,
+    removed,
+    removed_frozen//Removed from frozen slot, element may have been migrated
+};
+
 ALWAYS_INLINE
-static inline bool
+static inline enum remove_result
 bucket_remove(p64_cuckooht_t *ht,
+	      struct cuckoo_table *tbl,
 	      bix_t bix,
 	      p64_cuckooelem_t *elem,
 	      mask_t mask)
 {
-    struct bucket *bkt = &ht->buckets[bix];
+    struct bucket *bkt = &tbl->buckets[bix];
     p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
     do
     {
@@ -1245,14 +1493,28 @@ bucket_remove(p64_cuckooht_t *ht,
 	{
 	    old = atomic_load_acquire(&bkt->elems[i],
 				      &hp, ~BITS_ALL, ht->use_hp);
-	    if (LIKELY(!HAS_ANY(old)))
+	    if (LIKELY(!HAS_ANY(old)) || CLR_ALL(old) != elem)
 	    {
-		//Slot contains clean element
+		//Slot contains clean element or not our element
 		break;
 	    }
+	    if (UNLIKELY(HAS_FROZEN(old)))
+	    {
+		//Slot frozen, clear it but keep it frozen
+		if (atomic_compare_exchange_ptr(&bkt->elems[i],
+						&old,
+						SET_FROZEN(NULL),
+						__ATOMIC_RELAXED,
+						__ATOMIC_RELAXED))
+		{
+		    atomic_ptr_release(&hp, ht->use_hp);
+		    return removed_frozen;
+		}
+		continue;
+	    }
 	    //Slot contains element tagged with move-in-progress
 	    //Must help complete the move
-	    help_move(ht, CLR_ALL(old), bix, i);
+	    help_move(tbl, old, bix, i);
 	}
 	atomic_ptr_release(&hp, ht->use_hp);
 	//Replace clean element with NULL
@@ -1266,32 +1528,37 @@ bucket_remove(p64_cuckooht_t *ht,
 	{
 	    //Write invalid signature value
 	    write_sig(bkt, i, oldsig, NULL, elem->hash >> 16);
-	    return true;
+	    return removed;
+	}
+	else if (UNLIKELY(old == SET_FROZEN(elem)))
+	{
+	    //Slot frozen before we could remove the element, try again
+	    continue;
 	}
 	//Clear least significant bit
 	mask &= mask - 1;
     }
     while (mask != 0);
-    return false;
+    return not_found;
 }
 
 static void
-update_cellar(p64_cuckooht_t *ht,
+update_cellar(struct cuckoo_table *tbl,
 	      bix_t bix)
 {
     uint32_t old, new;
     do
     {
-	old = atomic_load_n(&ht->buckets[bix].chgcnt, __ATOMIC_ACQUIRE);
+	old = atomic_load_n(&tbl->buckets[bix].chgcnt, __ATOMIC_ACQUIRE);
 	new = old;
 	new &= ~CELLAR_BIT;
-	for (bix_t i = 0; i < ht->ncells; i++)
+	for (bix_t i = 0; i < tbl->ncells; i++)
 	{
 	    p64_cuckoohash_t hash =
-		atomic_load_n(&ht->cellar[i].hash, __ATOMIC_RELAXED);
+		atomic_load_n(&tbl->cellar[i].hash, __ATOMIC_RELAXED);
 	    p64_cuckooelem_t *elem =
-		atomic_load_ptr(&ht->cellar[i].elem, __ATOMIC_RELAXED);
-	    if (elem != NULL && ring_mod(hash, ht->nbkts) == bix)
+		atomic_load_ptr(&tbl->cellar[i].elem, __ATOMIC_RELAXED);
+	    if (CLR_ALL(elem) != NULL && ring_mod(hash, tbl->nbkts) == bix)
 	    {
 		//Found another element which hashes to same bix
 		new |= CELLAR_BIT;
@@ -1307,7 +1574,7 @@ update_cellar(p64_cuckooht_t *ht,
 	//Attempt to update chgcnt, fail if count has changed
     }
     //FIXME what do we synchronize with here?
-    while (!atomic_compare_exchange_n(&ht->buckets[bix].chgcnt,
+    while (!atomic_compare_exchange_n(&tbl->buckets[bix].chgcnt,
 				      &old,
 				      new,
 				      __ATOMIC_RELEASE,
@@ -1315,38 +1582,44 @@ update_cellar(p64_cuckooht_t *ht,
 }
 
 NO_INLINE
-static bool
-remove_cell_by_ptr(p64_cuckooht_t *ht,
+static enum remove_result
+remove_cell_by_ptr(struct cuckoo_table *tbl,
 		   p64_cuckooelem_t *elem,
 		   p64_cuckoohash_t hash)
 {
-    if (UNLIKELY(ht->ncells == 0))
+    if (UNLIKELY(tbl->ncells == 0))
     {
-	return NULL;
+	return not_found;
     }
-    bix_t start = ring_mod(hash, ht->ncells);
+    bix_t start = ring_mod(hash, tbl->ncells);
     bix_t idx = start;
     do
     {
-	if (atomic_load_ptr(&ht->cellar[idx].elem, __ATOMIC_RELAXED) == elem)
+	p64_cuckooelem_t *cur;
+	while (CLR_ALL(cur = atomic_load_ptr(&tbl->cellar[idx].elem,
+					     __ATOMIC_RELAXED)) == elem)
 	{
 	    //Write elem & hash fields atomically
-	    union cellpp old = { .cell.elem = elem, .cell.hash = hash };
-	    union cellpp nul = { .cell.elem = NULL, .cell.hash = ~hash };
-	    if (atomic_compare_exchange_n((ptrpair_t *)&ht->cellar[idx],
+	    //A frozen cell is kept frozen
+	    union cellpp old = { .cell.elem = cur, .cell.hash = hash };
+	    union cellpp nul = { .cell.elem = cur == elem ? NULL :
+						    SET_FROZEN(NULL),
+				 .cell.hash = ~hash };
+	    if (atomic_compare_exchange_n((ptrpair_t *)&tbl->cellar[idx],
 					  &old.pp,
 					  nul.pp,
 					  __ATOMIC_RELAXED,
 					  __ATOMIC_RELAXED))
 	    {
-		update_cellar(ht, ring_mod(hash, ht->nbkts));
-		return true;
+		update_cellar(tbl, ring_mod(hash, tbl->nbkts));
+		return cur == elem ? removed : removed_frozen;
 	    }
+	    //Else cell changed, it may just have been frozen
 	}
-	idx = ring_add(idx, 1, ht->ncells);
+	idx = ring_add(idx, 1, tbl->ncells);
     }
     while (idx != start);
-    return false;
+    return not_found;
 }
 
 UNROLL_LOOPS ALWAYS_INLINE
@@ -1390,6 +1663,20 @@ find_elem(p64_cuckooelem_t **elems, p64_cuckooelem_t *elem)
     vmatch8 = vshr_n_u8(vmatch8, 7);
     uint64x1_t vmatch = vreinterpret_u64_u8(vmatch8);
     matches = vget_lane_u64(vmatch, 0);
+#elif defined __AVX2__ && __SIZEOF_POINTER__ == 8 && BKT_SIZE == 6
+    __m256i vnbits_all = _mm256_set1_epi64x(~BITS_ALL);
+    __m256i velem = _mm256_set1_epi64x((uintptr_t)elem);
+    //Compare elems[0..3] and elems[2..5], overlapping loads avoid reading
+    //beyond the end of the bucket
+    __m256i velemsA = _mm256_loadu_si256((const __m256i *)&elems[0]);
+    __m256i velemsB = _mm256_loadu_si256((const __m256i *)&elems[2]);
+    velemsA = _mm256_and_si256(velemsA, vnbits_all);
+    velemsB = _mm256_and_si256(velemsB, vnbits_all);
+    uint32_t matchA = _mm256_movemask_pd(
+	_mm256_castsi256_pd(_mm256_cmpeq_epi64(velemsA, velem)));
+    uint32_t matchB = _mm256_movemask_pd(
+	_mm256_castsi256_pd(_mm256_cmpeq_epi64(velemsB, velem)));
+    matches = matchA | (matchB << 2);
 #else
     matches = 0;
     for (uint32_t i = 0; i < BKT_SIZE; i++)
@@ -1404,32 +1691,24 @@ find_elem(p64_cuckooelem_t **elems, p64_cuckooelem_t *elem)
 }
 
 UNROLL_LOOPS
-bool
-p64_cuckooht_remove(p64_cuckooht_t *ht,
-		    p64_cuckooelem_t *elem,
-		    p64_cuckoohash_t hash)
+static enum remove_result
+remove_table(p64_cuckooht_t *ht,
+	     struct cuckoo_table *tbl,
+	     p64_cuckooelem_t *elem,
+	     p64_cuckoohash_t hash)
 {
-    if (UNLIKELY(HAS_ANY(elem)))
-    {
-	report_error("cuckooht", "element has low bits set", elem);
-	return false;
-    }
-    bix_t bix0 = ring_mod(hash, ht->nbkts);
-    struct bucket *bkt0 = &ht->buckets[bix0];
+    bix_t bix0 = ring_mod(hash, tbl->nbkts);
+    struct bucket *bkt0 = &tbl->buckets[bix0];
     PREFETCH_FOR_READ(bkt0);
-    bix_t bix1 = ring_mod(scramble(hash), ht->nbkts);
+    bix_t bix1 = ring_mod(scramble(hash), tbl->nbkts);
     if (UNLIKELY(bix1 == bix0))
     {
-	bix1 = ring_add(bix1, 1, ht->nbkts);
+	bix1 = ring_add(bix1, 1, tbl->nbkts);
     }
-    struct bucket *bkt1 = &ht->buckets[bix1];
+    struct bucket *bkt1 = &tbl->buckets[bix1];
     PREFETCH_FOR_READ(bkt1);
-    if (LIKELY(!ht->use_hp))
-    {
-	p64_qsbr_acquire();
-    }
     uint32_t chgcnt;
-    bool success = false;
+    enum remove_result result = not_found;
     do
     {
 	//Xr: read chgcnt, synchronize with Xw
@@ -1437,19 +1716,19 @@ p64_cuckooht_remove(p64_cuckooht_t *ht,
 	mask_t mask0 = find_elem(bkt0->elems, elem);
 	if (LIKELY(mask0 != 0))
 	{
-	    success = bucket_remove(ht, bix0, elem, mask0);
-	    if (success)
+	    result = bucket_remove(ht, tbl, bix0, elem, mask0);
+	    if (result != not_found)
 	    {
-		goto done;
+		return result;
 	    }
 	}
 	mask_t mask1 = find_elem(bkt1->elems, elem);
 	if (LIKELY(mask1 != 0))
 	{
-	    success = bucket_remove(ht, bix1, elem, mask1);
-	    if (success)
+	    result = bucket_remove(ht, tbl, bix1, elem, mask1);
+	    if (result != not_found)
 	    {
-		goto done;
+		return result;
 	    }
 	}
 	//Yr: read elems+fence-acquire, synchronize with Yw
@@ -1460,12 +1739,407 @@ p64_cuckooht_remove(p64_cuckooht_t *ht,
     while (atomic_load_n(&bkt0->chgcnt, __ATOMIC_RELAXED) != chgcnt);
     if ((chgcnt & CELLAR_BIT) != 0)
     {
-	success = remove_cell_by_ptr(ht, elem, hash);
+	result = remove_cell_by_ptr(tbl, elem, hash);
     }
-done:
-    if (LIKELY(!ht->use_hp))
+    return result;
+}
+
+//Freeze slot so that the element cannot be moved, return the element
+static p64_cuckooelem_t *
+freeze_slot(struct cuckoo_table *tbl,
+	    bix_t bix,
+	    uint32_t idx)
+{
+    struct bucket *bkt = &tbl->buckets[bix];
+    for (;;)
     {
-	p64_qsbr_release();
+	p64_cuckooelem_t *old = atomic_load_ptr(&bkt->elems[idx],
+						__ATOMIC_ACQUIRE);
+	if (UNLIKELY(old == SET_DST(NULL)))
+	{
+	    //Slot reserved as destination of a move, the move will either
+	    //be started or the reservation undone
+	    doze();
+	    continue;
+	}
+	else if (UNLIKELY(HAS_ANY(old)))
+	{
+	    //Slot is source or destination of move-in-progress
+	    help_move(tbl, old, bix, idx);
+	    continue;
+	}
+	if (atomic_compare_exchange_ptr(&bkt->elems[idx],
+					&old,
+					SET_FROZEN(old),
+					__ATOMIC_ACQUIRE,
+					__ATOMIC_RELAXED))
+	{
+	    return old;
+	}
+    }
+}
+
+//Freeze cell, return the element
+static p64_cuckooelem_t *
+freeze_cell(struct cuckoo_table *tbl,
+	    bix_t idx)
+{
+    p64_cuckooelem_t *old = atomic_load_ptr(&tbl->cellar[idx].elem,
+					    __ATOMIC_ACQUIRE);
+    while (!atomic_compare_exchange_ptr(&tbl->cellar[idx].elem,
+					&old,
+					SET_FROZEN(old),
+					__ATOMIC_ACQUIRE,
+					__ATOMIC_ACQUIRE))
+    {
+    }
+    return old;
+}
+
+//Table is full, return next (larger) table, allocate it if necessary
+static struct cuckoo_table *
+start_grow(p64_cuckooht_t *ht, struct cuckoo_table *tbl)
+{
+    struct cuckoo_table *next = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+    if (next != NULL)
+    {
+	return next;
+    }
+    next = table_alloc(&ht->mem,
+		       2 * (size_t)tbl->nbkts,
+		       2 * (size_t)tbl->ncells);
+    if (UNLIKELY(next == NULL))
+    {
+	return NULL;
+    }
+    struct cuckoo_table *old = NULL;
+    if (!atomic_compare_exchange_ptr(&tbl->next,
+				     &old,
+				     next,
+				     __ATOMIC_ACQ_REL,
+				     __ATOMIC_ACQUIRE))
+    {
+	//Some other thread started grow
+	p64_mfree(next);
+	next = old;
+    }
+    return next;
+}
+
+//Copy frozen element to the next table
+static void
+copy_elem(p64_cuckooht_t *ht,
+	  struct cuckoo_table *src,
+	  p64_cuckooelem_t **pelem,
+	  p64_cuckooelem_t *elem)
+{
+    struct cuckoo_table *dst = src->next;
+    while (UNLIKELY(!insert_table(ht, dst, elem, elem->hash)))
+    {
+	//Next table filled up by concurrent insertions, continue in its
+	//successor which will be migrated after the next table
+	dst = start_grow(ht, dst);
+	if (UNLIKELY(dst == NULL))
+	{
+	    report_error("cuckooht", "failed to migrate element", elem);
+	    return;
+	}
+    }
+    //The element may have been removed from the frozen slot while we were
+    //copying it, the remover may then have missed it in the new table
+    //Pairs with the fence in p64_cuckooht_remove()
+    atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (atomic_load_ptr(pelem, __ATOMIC_RELAXED) != SET_FROZEN(elem))
+    {
+	(void)remove_table(ht, dst, elem, elem->hash);
+    }
+}
+
+//Migrate bucket or cellar chunk
+static void
+migrate_unit(p64_cuckooht_t *ht,
+	     struct cuckoo_table *src,
+	     size_t unit)
+{
+    if (unit < src->nbkts)
+    {
+	struct bucket *bkt = &src->buckets[unit];
+	for (uint32_t i = 0; i < BKT_SIZE; i++)
+	{
+	    p64_cuckooelem_t *elem = freeze_slot(src, unit, i);
+	    if (elem != NULL)
+	    {
+		copy_elem(ht, src, &bkt->elems[i], elem);
+	    }
+	}
+    }
+    else
+    {
+	bix_t start = (unit - src->nbkts) * BKT_SIZE;
+	for (bix_t i = start; i < start + BKT_SIZE && i < src->ncells; i++)
+	{
+	    p64_cuckooelem_t *elem = freeze_cell(src, i);
+	    if (elem != NULL)
+	    {
+		copy_elem(ht, src, &src->cellar[i].elem, elem);
+	    }
+	}
+    }
+}
+
+//Migrate up to 'num' buckets or cellar chunks of the current table
+static void
+migrate_units(p64_cuckooht_t *ht,
+	      struct cuckoo_table *src,
+	      size_t num)
+{
+    size_t nunits = num_units(src);
+    size_t unit = atomic_fetch_add(&src->migrate, num, __ATOMIC_RELAXED);
+    if (unit >= nunits)
+    {
+	//All units already claimed
+	return;
+    }
+    num = MIN(num, nunits - unit);
+    for (size_t i = 0; i < num; i++)
+    {
+	migrate_unit(ht, src, unit + i);
+    }
+    size_t done = atomic_fetch_add(&src->nmigrated, num, __ATOMIC_ACQ_REL);
+    if (done + num == nunits)
+    {
+	//All elements migrated, make next table current
+	atomic_store_ptr(&ht->cur, src->next, __ATOMIC_RELEASE);
+	//Retire old table, memory will be reclaimed when all threads
+	//have stopped referencing it
+	while (!(ht->use_ebr ? p64_ebr_retire(src, p64_mfree) :
+				p64_qsbr_retire_domain(ht->qsbr, src,
+						       p64_mfree)))
+	{
+	    doze();
+	}
+    }
+}
+
+//Help any ongoing grow
+//Only the current table is migrated, tables further down the chain must wait
+//until all elements of preceding tables have been copied
+static inline void
+help_grow(p64_cuckooht_t *ht)
+{
+    struct cuckoo_table *cur = current_table(ht);
+    if (UNLIKELY(atomic_load_ptr(&cur->next, __ATOMIC_RELAXED) != NULL))
+    {
+	migrate_units(ht, cur, MIGRATE_STEP);
+    }
+}
+
+static bool
+insert_one(p64_cuckooht_t *ht,
+	   p64_cuckooelem_t *elem,
+	   p64_cuckoohash_t hash)
+{
+    if (UNLIKELY(ht->grow))
+    {
+	help_grow(ht);
+    }
+    struct cuckoo_table *tbl = current_table(ht);
+    bool success;
+    for (;;)
+    {
+	if (UNLIKELY(ht->grow))
+	{
+	    //Grow in progress, insert into last table
+	    struct cuckoo_table *next;
+	    while ((next = atomic_load_ptr(&tbl->next,
+					   __ATOMIC_ACQUIRE)) != NULL)
+	    {
+		tbl = next;
+	    }
+	}
+	success = insert_table(ht, tbl, elem, hash);
+	if (LIKELY(success) || !ht->grow)
+	{
+	    break;
+	}
+	//Table full, grow it
+	tbl = start_grow(ht, tbl);
+	if (UNLIKELY(tbl == NULL))
+	{
+	    break;
+	}
+    }
+    hashstats_add(ht->stats, success ? HS_INSERT : HS_INSERT_FAIL, 1);
+    return success;
+}
+
+static bool
+remove_one(p64_cuckooht_t *ht,
+	   p64_cuckooelem_t *elem,
+	   p64_cuckoohash_t hash)
+{
+    struct cuckoo_table *tbl = current_table(ht);
+    bool success = false;
+    for (;;)
+    {
+	enum remove_result result = remove_table(ht, tbl, elem, hash);
+	if (LIKELY(result == removed) || !ht->grow)
+	{
+	    success = result != not_found;
+	    break;
+	}
+	//Element may be (or have been copied) in the next table
+	success |= result == removed_frozen;
+	//Pairs with the fence in copy_elem()
+	atomic_thread_fence(__ATOMIC_SEQ_CST);
+	tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+	if (tbl == NULL)
+	{
+	    break;
+	}
+    }
+    if (UNLIKELY(ht->grow))
+    {
+	help_grow(ht);
+    }
+    hashstats_add(ht->stats, success ? HS_REMOVE : HS_REMOVE_FAIL, 1);
+    return success;
+}
+
+//Prefetch both buckets of every element in the last table (where inserts go)
+//or the current table (where removes start)
+static void
+prefetch_vec(p64_cuckooht_t *ht,
+	     uint32_t num,
+	     p64_cuckoohash_t hashes[num],
+	     bool last)
+{
+    struct cuckoo_table *tbl = current_table(ht);
+    if (UNLIKELY(last && ht->grow))
+    {
+	struct cuckoo_table *next;
+	while ((next = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE)) != NULL)
+	{
+	    tbl = next;
+	}
+    }
+    for (uint32_t i = 0; i < num; i++)
+    {
+	bix_t bix0 = ring_mod(hashes[i], tbl->nbkts);
+	PREFETCH_FOR_WRITE(&tbl->buckets[bix0]);
+	bix_t bix1 = ring_mod(scramble(hashes[i]), tbl->nbkts);
+	if (UNLIKELY(bix1 == bix0))
+	{
+	    bix1 = ring_add(bix1, 1, tbl->nbkts);
+	}
+	PREFETCH_FOR_WRITE(&tbl->buckets[bix1]);
+    }
+}
+
+bool
+p64_cuckooht_insert(p64_cuckooht_t *ht,
+		    p64_cuckooelem_t *elem,
+		    p64_cuckoohash_t hash)
+{
+    if (UNLIKELY(HAS_ANY(elem)))
+    {
+	report_error("cuckooht", "element has low bits set", elem);
+	return false;
+    }
+    elem->hash = hash;
+    smr_enter(ht);
+    bool success = insert_one(ht, elem, hash);
+    smr_exit(ht);
+    return success;
+}
+
+uint32_t
+p64_cuckooht_insert_vec(p64_cuckooht_t *ht,
+			uint32_t num,
+			p64_cuckooelem_t *elems[num],
+			p64_cuckoohash_t hashes[num],
+			bool success[num])
+{
+    smr_enter(ht);
+    prefetch_vec(ht, num, hashes, true);
+    uint32_t ninserted = 0;
+    for (uint32_t i = 0; i < num; i++)
+    {
+	if (UNLIKELY(HAS_ANY(elems[i])))
+	{
+	    report_error("cuckooht", "element has low bits set", elems[i]);
+	    success[i] = false;
+	    continue;
+	}
+	elems[i]->hash = hashes[i];
+	success[i] = insert_one(ht, elems[i], hashes[i]);
+	ninserted += success[i];
+    }
+    smr_exit(ht);
+    return ninserted;
+}
+
+bool
+p64_cuckooht_remove(p64_cuckooht_t *ht,
+		    p64_cuckooelem_t *elem,
+		    p64_cuckoohash_t hash)
+{
+    if (UNLIKELY(HAS_ANY(elem)))
+    {
+	report_error("cuckooht", "element has low bits set", elem);
+	return false;
     }
+    smr_enter(ht);
+    bool success = remove_one(ht, elem, hash);
+    smr_exit(ht);
     return success;
 }
+
+uint32_t
+p64_cuckooht_remove_vec(p64_cuckooht_t *ht,
+			uint32_t num,
+			p64_cuckooelem_t *elems[num],
+			p64_cuckoohash_t hashes[num],
+			bool success[num])
+{
+    smr_enter(ht);
+    prefetch_vec(ht, num, hashes, false);
+    uint32_t nremoved = 0;
+    for (uint32_t i = 0; i < num; i++)
+    {
+	if (UNLIKELY(HAS_ANY(elems[i])))
+	{
+	    report_error("cuckooht", "element has low bits set", elems[i]);
+	    success[i] = false;
+	    continue;
+	}
+	success[i] = remove_one(ht, elems[i], hashes[i]);
+	nremoved += success[i];
+    }
+    smr_exit(ht);
+    return nremoved;
+}
+
+void
+p64_cuckooht_stats(p64_cuckooht_t *ht,
+		   p64_hashstats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    if (ht->stats != NULL)
+    {
+	hashstats_read(ht->stats, st);
+    }
+    smr_enter(ht);
+    //Elements in cellar may be migrated during grow, count them instead
+    struct cuckoo_table *tbl = current_table(ht);
+    st->capacity = (uint64_t)tbl->nbkts * BKT_SIZE;
+    st->cellar_size = tbl->ncells;
+    st->cellar_used = 0;
+    for (bix_t i = 0; i < tbl->ncells; i++)
+    {
+	st->cellar_used +=
+	    CLR_ALL(atomic_load_ptr(&tbl->cellar[i].elem,
+				    __ATOMIC_RELAXED)) != NULL;
+    }
+    smr_exit(ht);
+}
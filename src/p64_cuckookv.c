@@ -0,0 +1,460 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "p64_cuckookv.h"
+#include "p64_rwsync.h"
+#include "build_config.h"
+
+#include "common.h"
+#include "os_abstraction.h"
+#include "err_hnd.h"
+#include "atomic.h"
+
+//Maximum number of buckets visited when searching for a cuckoo path
+#define MAX_BFS 128
+
+//Table size is increased by 1/MAX_LOAD_INV => 80% load when full
+#define MAX_LOAD_INV 4
+
+static_assert(sizeof(p64_cuckookv_t) <= CACHE_LINE,
+	      "sizeof(p64_cuckookv_t) <= CACHE_LINE");
+static_assert(P64_CUCKOOKV_BKTSIZE % sizeof(p64_rwsync_t) == 0,
+	      "P64_CUCKOOKV_BKTSIZE % sizeof(p64_rwsync_t) == 0");
+
+//Parameters derived from key size
+struct layout
+{
+    uint32_t nslots;
+    size_t kstride;
+    size_t bktsize;
+    size_t valoff;
+    size_t keyoff;
+};
+
+static inline struct layout
+get_layout(const p64_cuckookv_t *kv)
+{
+    struct layout lo;
+    lo.nslots = p64_cuckookv_nslots_(kv->ksize);
+    lo.kstride = p64_cuckookv_kstride_(kv->ksize);
+    lo.bktsize = p64_cuckookv_bktsize_(kv->ksize);
+    lo.valoff = p64_cuckookv_valoff_(lo.nslots);
+    lo.keyoff = p64_cuckookv_keyoff_(lo.nslots);
+    return lo;
+}
+
+static inline char *
+bucket(const p64_cuckookv_t *kv, const struct layout *lo, uint32_t bix)
+{
+    return kv->buckets + lo->bktsize * bix;
+}
+
+static inline p64_rwsync_t *
+bkt_sync(char *bkt)
+{
+    return (p64_rwsync_t *)bkt;
+}
+
+static inline uint32_t *
+bkt_sigs(char *bkt)
+{
+    return (uint32_t *)bkt + 1;
+}
+
+static inline uintptr_t *
+bkt_vals(char *bkt, const struct layout *lo)
+{
+    return (uintptr_t *)(bkt + lo->valoff);
+}
+
+static inline char *
+bkt_key(char *bkt, const struct layout *lo, uint32_t idx)
+{
+    return bkt + lo->keyoff + idx * lo->kstride;
+}
+
+//Return the other bucket an element with signature 'sig' may reside in
+static inline uint32_t
+alt_bix(const p64_cuckookv_t *kv, uint32_t sig, uint32_t bix)
+{
+    uint32_t bix0 = p64_cuckookv_bix0_(sig, kv->nbkts);
+    return bix == bix0 ? p64_cuckookv_bix1_(sig, kv->nbkts) : bix0;
+}
+
+p64_cuckookv_t *
+p64_cuckookv_alloc(size_t nelems, size_t ksize)
+{
+    if (UNLIKELY(ksize == 0 || ksize > UINT32_MAX))
+    {
+	report_error("cuckookv", "invalid key size", ksize);
+	return NULL;
+    }
+    uint32_t nslots = p64_cuckookv_nslots_(ksize);
+    //Cuckoo hashing cannot fill all slots, leave some headroom
+    size_t nslots_tot = nelems + nelems / MAX_LOAD_INV;
+    size_t nbkts = (nslots_tot + nslots - 1) / nslots;
+    //Must have at least two buckets
+    if (nbkts < 2)
+    {
+	nbkts = 2;
+    }
+    if (UNLIKELY(nelems == 0 || nbkts > UINT32_MAX))
+    {
+	report_error("cuckookv", "invalid number of elements", nelems);
+	return NULL;
+    }
+    size_t sz = CACHE_LINE + nbkts * p64_cuckookv_bktsize_(ksize);
+    p64_cuckookv_t *kv = p64_malloc(sz, CACHE_LINE);
+    if (kv != NULL)
+    {
+	//All signatures zero => all slots empty
+	//All seqlocks zero => no write in progress
+	memset(kv, 0, sz);
+	kv->nbkts = nbkts;
+	kv->ksize = ksize;
+	kv->buckets = (char *)kv + CACHE_LINE;
+    }
+    return kv;
+}
+
+void
+p64_cuckookv_free(p64_cuckookv_t *kv)
+{
+    if (kv != NULL)
+    {
+	struct layout lo = get_layout(kv);
+	for (uint32_t bix = 0; bix < kv->nbkts; bix++)
+	{
+	    const uint32_t *sigs = bkt_sigs(bucket(kv, &lo, bix));
+	    for (uint32_t i = 0; i < lo.nslots; i++)
+	    {
+		if (sigs[i] != 0)
+		{
+		    report_error("cuckookv", "hash table not empty", 0);
+		    return;
+		}
+	    }
+	}
+	p64_mfree(kv);
+    }
+}
+
+bool
+p64_cuckookv_lookup(p64_cuckookv_t *kv,
+		    const void *key,
+		    p64_cuckookvhash_t hash,
+		    uintptr_t *val)
+{
+    return p64_cuckookv_lookup_(kv, key, hash, val, kv->ksize);
+}
+
+//Lock both buckets, always in the same order to avoid deadlock
+static void
+lock_pair(char *bkt0, char *bkt1)
+{
+    if (bkt0 > bkt1)
+    {
+	char *tmp = bkt0;
+	bkt0 = bkt1;
+	bkt1 = tmp;
+    }
+    p64_rwsync_acquire_wr(bkt_sync(bkt0));
+    p64_rwsync_acquire_wr(bkt_sync(bkt1));
+}
+
+static void
+unlock_pair(char *bkt0, char *bkt1)
+{
+    p64_rwsync_release_wr(bkt_sync(bkt0));
+    p64_rwsync_release_wr(bkt_sync(bkt1));
+}
+
+//Find slot with matching key, caller must hold bucket lock
+static int32_t
+find_key(char *bkt,
+	 const struct layout *lo,
+	 uint32_t sig,
+	 const void *key,
+	 size_t ksize,
+	 p64_cuckookv_keycmp_ eq)
+{
+    const uint32_t *sigs = bkt_sigs(bkt);
+    for (uint32_t i = 0; i < lo->nslots; i++)
+    {
+	if (sigs[i] == sig)
+	{
+	    const char *slot = bkt_key(bkt, lo, i);
+	    if (eq != NULL ? eq(slot, key) : memcmp(slot, key, ksize) == 0)
+	    {
+		return i;
+	    }
+	}
+    }
+    return -1;
+}
+
+//Find empty slot, caller must hold bucket lock
+static int32_t
+find_empty(char *bkt, const struct layout *lo)
+{
+    const uint32_t *sigs = bkt_sigs(bkt);
+    for (uint32_t i = 0; i < lo->nslots; i++)
+    {
+	if (sigs[i] == 0)
+	{
+	    return i;
+	}
+    }
+    return -1;
+}
+
+//Copy key to bucket, concurrent readers use word loads of the same size
+static void
+write_key(char *dst, const char *src, size_t ksize)
+{
+#if __SIZEOF_POINTER__ == 8
+    for (; ksize >= sizeof(uint64_t); ksize -= sizeof(uint64_t))
+    {
+	uint64_t k;
+	memcpy(&k, src, sizeof k);
+	atomic_store_n((uint64_t *)dst, k, __ATOMIC_RELAXED);
+	dst += sizeof k;
+	src += sizeof k;
+    }
+#endif
+    for (; ksize >= sizeof(uint32_t); ksize -= sizeof(uint32_t))
+    {
+	uint32_t k;
+	memcpy(&k, src, sizeof k);
+	atomic_store_n((uint32_t *)dst, k, __ATOMIC_RELAXED);
+	dst += sizeof k;
+	src += sizeof k;
+    }
+    if (ksize >= sizeof(uint16_t))
+    {
+	uint16_t k;
+	memcpy(&k, src, sizeof k);
+	atomic_store_n((uint16_t *)dst, k, __ATOMIC_RELAXED);
+	dst += sizeof k;
+	src += sizeof k;
+	ksize -= sizeof k;
+    }
+    if (ksize != 0)
+    {
+	atomic_store_n((uint8_t *)dst, *(const uint8_t *)src, __ATOMIC_RELAXED);
+    }
+}
+
+//Write slot, caller must hold bucket lock
+static void
+write_slot(char *bkt,
+	   const struct layout *lo,
+	   uint32_t idx,
+	   uint32_t sig,
+	   const void *key,
+	   size_t ksize,
+	   uintptr_t val)
+{
+    write_key(bkt_key(bkt, lo, idx), key, ksize);
+    atomic_store_n(&bkt_vals(bkt, lo)[idx], val, __ATOMIC_RELAXED);
+    atomic_store_n(&bkt_sigs(bkt)[idx], sig, __ATOMIC_RELAXED);
+}
+
+//Move element in source slot to its alternative bucket
+//Return false if the source slot or destination bucket changed
+static bool
+move_slot(p64_cuckookv_t *kv,
+	  const struct layout *lo,
+	  uint32_t src_bix,
+	  uint32_t src_idx,
+	  uint32_t dst_bix)
+{
+    char *src = bucket(kv, lo, src_bix);
+    char *dst = bucket(kv, lo, dst_bix);
+    lock_pair(src, dst);
+    bool success = false;
+    uint32_t sig = bkt_sigs(src)[src_idx];
+    if (sig != 0 && alt_bix(kv, sig, src_bix) == dst_bix)
+    {
+	int32_t dst_idx = find_empty(dst, lo);
+	if (dst_idx >= 0)
+	{
+	    //Both buckets are locked so readers will see the element in
+	    //either bucket
+	    write_slot(dst, lo, dst_idx, sig,
+		       bkt_key(src, lo, src_idx), kv->ksize,
+		       bkt_vals(src, lo)[src_idx]);
+	    atomic_store_n(&bkt_sigs(src)[src_idx], 0, __ATOMIC_RELAXED);
+	    success = true;
+	}
+    }
+    unlock_pair(src, dst);
+    return success;
+}
+
+struct bfs_node
+{
+    uint32_t bix;//Bucket index
+    int32_t parent;//Index of parent node, -1 for root
+    uint32_t idx;//Slot in parent bucket whose element moves to this bucket
+};
+
+//Free up a slot in one of the two buckets by moving elements along a path
+//of alternative buckets, found using breadth-first search
+//Return false if no path was found (table too full)
+static bool
+make_room(p64_cuckookv_t *kv,
+	  const struct layout *lo,
+	  uint32_t bix0,
+	  uint32_t bix1)
+{
+    struct bfs_node queue[MAX_BFS];
+    uint32_t head = 0, tail = 0;
+    queue[tail++] = (struct bfs_node){ .bix = bix0, .parent = -1 };
+    queue[tail++] = (struct bfs_node){ .bix = bix1, .parent = -1 };
+    while (head < tail)
+    {
+	const struct bfs_node *node = &queue[head];
+	//Signatures are read without locking, the path is validated when the
+	//elements are moved
+	const uint32_t *sigs = bkt_sigs(bucket(kv, lo, node->bix));
+	uint32_t empty = lo->nslots;
+	for (uint32_t i = 0; i < lo->nslots; i++)
+	{
+	    uint32_t sig = atomic_load_n(&sigs[i], __ATOMIC_RELAXED);
+	    if (sig == 0)
+	    {
+		empty = i;
+		break;
+	    }
+	    if (tail < MAX_BFS)
+	    {
+		queue[tail++] = (struct bfs_node){
+		    .bix = alt_bix(kv, sig, node->bix),
+		    .parent = head,
+		    .idx = i };
+	    }
+	}
+	if (empty != lo->nslots)
+	{
+	    //Found bucket with empty slot, move elements backwards along path
+	    //starting with the last element
+	    for (int32_t n = head; queue[n].parent >= 0; n = queue[n].parent)
+	    {
+		const struct bfs_node *parent = &queue[queue[n].parent];
+		if (!move_slot(kv, lo, parent->bix, queue[n].idx, queue[n].bix))
+		{
+		    //Path changed, caller will retry
+		    break;
+		}
+	    }
+	    return true;
+	}
+	head++;
+    }
+    return false;
+}
+
+bool
+p64_cuckookv_insert_(p64_cuckookv_t *kv,
+		     const void *key,
+		     p64_cuckookvhash_t hash,
+		     uintptr_t val,
+		     p64_cuckookv_keycmp_ eq)
+{
+    struct layout lo = get_layout(kv);
+    uint32_t sig = p64_cuckookv_sig_(hash);
+    uint32_t bix0 = p64_cuckookv_bix0_(sig, kv->nbkts);
+    uint32_t bix1 = p64_cuckookv_bix1_(sig, kv->nbkts);
+    char *bkt0 = bucket(kv, &lo, bix0);
+    char *bkt1 = bucket(kv, &lo, bix1);
+    PREFETCH_FOR_WRITE(bkt0);
+    PREFETCH_FOR_WRITE(bkt1);
+    for (;;)
+    {
+	lock_pair(bkt0, bkt1);
+	if (find_key(bkt0, &lo, sig, key, kv->ksize, eq) >= 0 ||
+	    find_key(bkt1, &lo, sig, key, kv->ksize, eq) >= 0)
+	{
+	    //Key already present
+	    unlock_pair(bkt0, bkt1);
+	    return false;
+	}
+	int32_t idx;
+	if ((idx = find_empty(bkt0, &lo)) >= 0)
+	{
+	    write_slot(bkt0, &lo, idx, sig, key, kv->ksize, val);
+	    unlock_pair(bkt0, bkt1);
+	    return true;
+	}
+	if ((idx = find_empty(bkt1, &lo)) >= 0)
+	{
+	    write_slot(bkt1, &lo, idx, sig, key, kv->ksize, val);
+	    unlock_pair(bkt0, bkt1);
+	    return true;
+	}
+	unlock_pair(bkt0, bkt1);
+	//Both buckets full, try to move some element away
+	if (!make_room(kv, &lo, bix0, bix1))
+	{
+	    return false;
+	}
+    }
+}
+
+bool
+p64_cuckookv_remove_(p64_cuckookv_t *kv,
+		     const void *key,
+		     p64_cuckookvhash_t hash,
+		     uintptr_t *val,
+		     p64_cuckookv_keycmp_ eq)
+{
+    struct layout lo = get_layout(kv);
+    uint32_t sig = p64_cuckookv_sig_(hash);
+    char *bkt0 = bucket(kv, &lo, p64_cuckookv_bix0_(sig, kv->nbkts));
+    char *bkt1 = bucket(kv, &lo, p64_cuckookv_bix1_(sig, kv->nbkts));
+    //Lock both buckets so that the element cannot move between them
+    lock_pair(bkt0, bkt1);
+    char *bkt = bkt0;
+    int32_t idx = find_key(bkt0, &lo, sig, key, kv->ksize, eq);
+    if (idx < 0)
+    {
+	bkt = bkt1;
+	idx = find_key(bkt1, &lo, sig, key, kv->ksize, eq);
+    }
+    if (idx >= 0)
+    {
+	if (val != NULL)
+	{
+	    *val = bkt_vals(bkt, &lo)[idx];
+	}
+	atomic_store_n(&bkt_sigs(bkt)[idx], 0, __ATOMIC_RELAXED);
+    }
+    unlock_pair(bkt0, bkt1);
+    return idx >= 0;
+}
+
+bool
+p64_cuckookv_insert(p64_cuckookv_t *kv,
+		    const void *key,
+		    p64_cuckookvhash_t hash,
+		    uintptr_t val)
+{
+    return p64_cuckookv_insert_(kv, key, hash, val, NULL);
+}
+
+bool
+p64_cuckookv_remove(p64_cuckookv_t *kv,
+		    const void *key,
+		    p64_cuckookvhash_t hash,
+		    uintptr_t *val)
+{
+    return p64_cuckookv_remove_(kv, key, hash, val, NULL);
+}
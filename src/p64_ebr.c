@@ -0,0 +1,313 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "p64_ebr.h"
+#include "build_config.h"
+#include "os_abstraction.h"
+
+#include "arch.h"
+#include "lockfree.h"
+#include "common.h"
+#include "err_hnd.h"
+#include "thr_idx.h"
+
+static void
+report_thread_not_registered(void)
+{
+    report_error("ebr", "thread not registered", 0);
+}
+
+//Per-thread epoch in separate cache line to avoid false sharing
+struct epoch
+{
+    uint64_t val;
+} ALIGNED(CACHE_LINE);
+
+struct p64_ebrdomain
+{
+    uint64_t epoch;//Global epoch
+    uint32_t maxobjs;
+    uint32_t ringmask;//(Power-of-two of maxobjs) - 1
+    uint32_t high_wm;//High watermark of thread index
+    uint32_t maxthreads;
+    p64_memsrc_t mem;//Source of thread state
+    uint64_t *registered;//Bitmap of registered threads
+    //Epoch observed when each thread entered its critical section
+    struct epoch epochs[] ALIGNED(CACHE_LINE);
+};
+
+//Value larger than all possible epochs, thread is outside critical section
+#define INFINITE (~(uint64_t)0)
+
+p64_ebrdomain_t *
+p64_ebr_alloc(uint32_t maxobjs)
+{
+    if (maxobjs < 1 || maxobjs > (UINT32_C(1) << 31))
+    {
+	report_error("ebr", "invalid maxobjs", maxobjs);
+	return NULL;
+    }
+    uint32_t maxthreads = p64_idx_maxthreads();
+    size_t nbytes = sizeof(p64_ebrdomain_t) +
+		    maxthreads * sizeof(struct epoch) +
+		    IDXMAP_NWORDS(maxthreads) * sizeof(uint64_t);
+    p64_ebrdomain_t *ebr = p64_malloc(nbytes, CACHE_LINE);
+    if (ebr != NULL)
+    {
+	ebr->epoch = 0;
+	ebr->maxobjs = maxobjs;
+	ebr->ringmask = ROUNDUP_POW2(maxobjs) - 1;
+	ebr->high_wm = 0;
+	ebr->maxthreads = maxthreads;
+	p64_memsrc_get(&ebr->mem);
+	ebr->registered = (uint64_t *)&ebr->epochs[maxthreads];
+	for (uint32_t i = 0; i < maxthreads; i++)
+	{
+	    ebr->epochs[i].val = INFINITE;
+	}
+	for (uint32_t i = 0; i < IDXMAP_NWORDS(maxthreads); i++)
+	{
+	    ebr->registered[i] = 0;
+	}
+	return ebr;
+    }
+    return NULL;
+}
+
+//Find the smallest epoch of all registered threads
+//Return INFINITE if no thread is in a critical section
+static uint64_t
+find_min(p64_ebrdomain_t *ebr)
+{
+    uint32_t numthrs = __atomic_load_n(&ebr->high_wm, __ATOMIC_ACQUIRE);
+    uint64_t min = INFINITE;
+    uint32_t t;
+    IDXMAP_FOREACH(ebr->registered, numthrs, t)
+    {
+	uint64_t e = __atomic_load_n(&ebr->epochs[t].val, __ATOMIC_RELAXED);
+	if (e < min)
+	{
+	    min = e;
+	}
+    }
+    return min;
+}
+
+void
+p64_ebr_free(p64_ebrdomain_t *ebr)
+{
+    if (ebr != NULL)
+    {
+	if (find_min(ebr) != INFINITE)
+	{
+	    report_error("ebr", "threads in critical section", 0);
+	    return;
+	}
+	p64_mfree(ebr);
+    }
+}
+
+struct object
+{
+    void *ptr;
+    void (*cb)(void *);
+    uint64_t epoch;
+};
+
+struct thread_state
+{
+    p64_ebrdomain_t *ebr;
+    uint32_t nesting;//Critical section nesting level
+    uint32_t idx;//Thread index
+    //Removed but not yet reclaimed objects
+    uint32_t head, tail;
+    uint32_t ringmask;
+    uint32_t maxobjs;
+    struct object objs[];
+} ALIGNED(CACHE_LINE);
+
+static THREAD_LOCAL struct thread_state *TS = NULL;
+
+void
+p64_ebr_register(p64_ebrdomain_t *ebr)
+{
+    if (TS != NULL)
+    {
+	report_error("ebr", "thread already registered", 0);
+	return;
+    }
+    //Attempt to allocate a thread index
+    int32_t idx = p64_idx_alloc();
+    if (idx < 0)
+    {
+	report_error("ebr", "too many registered threads", 0);
+	return;
+    }
+    size_t nbytes = sizeof(struct thread_state) +
+		    (ebr->ringmask + 1) * sizeof(struct object);
+    struct thread_state *ts = p64_malloc_src(&ebr->mem, nbytes,
+					     CACHE_LINE);
+    if (ts == NULL)
+    {
+	report_error("ebr", "failed to allocate thread-local data", 0);
+	p64_idx_free(idx);
+	return;
+    }
+    ts->ebr = ebr;
+    ts->nesting = 0;
+    ts->idx = idx;
+    ts->head = 0;
+    ts->tail = 0;
+    ts->ringmask = ebr->ringmask;
+    ts->maxobjs = ebr->maxobjs;
+    assert((uint32_t)idx < ebr->maxthreads);
+    assert(ebr->epochs[idx].val == INFINITE);
+    //Conditionally update high watermark of indexes
+    lockfree_fetch_umax_4(&ebr->high_wm, (uint32_t)idx + 1, __ATOMIC_RELAXED);
+    idxmap_set(ebr->registered, idx);
+    TS = ts;
+}
+
+void
+p64_ebr_unregister(void)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return;
+    }
+    if (TS->nesting != 0)
+    {
+	report_error("ebr", "thread in critical section", TS->nesting);
+	return;
+    }
+    if (TS->head != TS->tail)
+    {
+	report_error("ebr", "thread has unreclaimed objects",
+		     TS->head - TS->tail);
+	return;
+    }
+    idxmap_clr(TS->ebr->registered, TS->idx);
+    p64_idx_free(TS->idx);
+    p64_mfree(TS);
+    TS = NULL;
+}
+
+void
+p64_ebr_enter(void)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return;
+    }
+    if (TS->nesting++ == 0)
+    {
+	p64_ebrdomain_t *ebr = TS->ebr;
+	uint64_t epoch = __atomic_load_n(&ebr->epoch, __ATOMIC_RELAXED);
+	__atomic_store_n(&ebr->epochs[TS->idx].val, epoch, __ATOMIC_RELAXED);
+	//Ensure our epoch is observable before any reads of shared objects
+	//A reclaimer which misses our epoch has removed its objects before
+	//we can observe them
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+void
+p64_ebr_exit(void)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return;
+    }
+    if (UNLIKELY(TS->nesting == 0))
+    {
+	report_error("ebr", "excess exit call", 0);
+	return;
+    }
+    if (--TS->nesting == 0)
+    {
+	//Release order to contain all our previous access to shared objects
+	__atomic_store_n(&TS->ebr->epochs[TS->idx].val, INFINITE,
+			 __ATOMIC_RELEASE);
+    }
+}
+
+//Traverse all pending objects and reclaim those that have no references
+static uint32_t
+garbage_collect(void)
+{
+    //Order removal of objects before reading epochs, pairs with fence in
+    //p64_ebr_enter()
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint64_t min_epoch = find_min(TS->ebr);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    //Traverse list of pending objects
+    while (TS->tail != TS->head)
+    {
+	struct object *obj = &TS->objs[TS->tail & TS->ringmask];
+	if (min_epoch <= obj->epoch)
+	{
+	    //At least one thread entered its critical section before the
+	    //object was retired
+	    break;
+	}
+	//All threads in critical sections entered after the object was
+	//removed, no thread has any reference to this object, reclaim it
+	obj->cb(obj->ptr);
+	TS->tail++;
+    }
+    return TS->head - TS->tail;
+}
+
+bool
+p64_ebr_retire(void *ptr,
+	       void (*cb)(void *ptr))
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return false;
+    }
+    if (UNLIKELY(TS->head - TS->tail == TS->maxobjs))
+    {
+	if (garbage_collect() == TS->maxobjs)
+	{
+	    return false;//No space for object
+	}
+    }
+    assert(TS->head - TS->tail < TS->maxobjs);
+    //Start a new epoch, threads entering critical sections from now on
+    //cannot observe the removed object
+    uint64_t previous = __atomic_fetch_add(&TS->ebr->epoch,
+					   1,
+					   __ATOMIC_RELEASE);
+    TS->objs[TS->head & TS->ringmask].ptr = ptr;
+    TS->objs[TS->head & TS->ringmask].cb = cb;
+    TS->objs[TS->head & TS->ringmask].epoch = previous;
+    TS->head++;
+    return true;
+}
+
+uint32_t
+p64_ebr_reclaim(void)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return 0;
+    }
+    if (TS->head == TS->tail)
+    {
+	//Nothing to reclaim
+	return 0;
+    }
+    return garbage_collect();
+}
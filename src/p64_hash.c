@@ -0,0 +1,408 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "p64_hash.h"
+
+#include "common.h"
+
+#if defined __ARM_NEON
+#include <arm_neon.h>
+#elif defined __SSE2__
+#include <immintrin.h>
+#endif
+
+//Unaligned little endian loads
+static inline uint64_t
+rd64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof v);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint32_t
+rd32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+//CRC32C
+
+#if defined __ARM_FEATURE_CRC32
+#define CRC32C_HW
+#define crc32c_u8(c, d) __crc32cb((c), (d))
+#define crc32c_u32(c, d) __crc32cw((c), (d))
+#define crc32c_u64(c, d) __crc32cd((c), (d))
+#elif defined __SSE4_2__ && defined __x86_64__
+#define CRC32C_HW
+#define crc32c_u8(c, d) _mm_crc32_u8((c), (d))
+#define crc32c_u32(c, d) _mm_crc32_u32((c), (d))
+#define crc32c_u64(c, d) (uint32_t)_mm_crc32_u64((c), (d))
+#else
+//CRC32C (reflected polynomial 0x82F63B78) of all 4-bit values
+static const uint32_t crc32c_nibble[16] =
+{
+    0x00000000, 0x105ec76f, 0x20bd8ede, 0x30e349b1,
+    0x417b1dbc, 0x5125dad3, 0x61c69362, 0x7198540d,
+    0x82f63b78, 0x92a8fc17, 0xa24bb5a6, 0xb21572c9,
+    0xc38d26c4, 0xd3d3e1ab, 0xe330a81a, 0xf36e6f75
+};
+
+static inline uint32_t
+crc32c_u8(uint32_t crc, uint8_t data)
+{
+    crc ^= data;
+    crc = (crc >> 4) ^ crc32c_nibble[crc & 15];
+    crc = (crc >> 4) ^ crc32c_nibble[crc & 15];
+    return crc;
+}
+
+static inline uint32_t
+crc32c_u32(uint32_t crc, uint32_t data)
+{
+    for (uint32_t i = 0; i < 4; i++)
+    {
+	crc = crc32c_u8(crc, data & 0xff);
+	data >>= 8;
+    }
+    return crc;
+}
+
+static inline uint32_t
+crc32c_u64(uint32_t crc, uint64_t data)
+{
+    crc = crc32c_u32(crc, (uint32_t)data);
+    return crc32c_u32(crc, (uint32_t)(data >> 32));
+}
+#endif
+
+uint32_t
+p64_hash_crc32c(const void *data, size_t len, uint32_t seed)
+{
+    const uint8_t *p = data;
+    uint32_t crc = seed;
+    for (; len >= 8; len -= 8, p += 8)
+    {
+	crc = crc32c_u64(crc, rd64(p));
+    }
+    if (len >= 4)
+    {
+	crc = crc32c_u32(crc, rd32(p));
+	len -= 4;
+	p += 4;
+    }
+    for (; len != 0; len--, p++)
+    {
+	crc = crc32c_u8(crc, *p);
+    }
+    return crc;
+}
+
+void
+p64_hash_crc32c_vec(uint32_t num,
+		    const void *keys[num],
+		    size_t len,
+		    uint32_t seed,
+		    uint32_t hashes[num])
+{
+    uint32_t i = 0;
+#ifdef CRC32C_HW
+    //The CRC instruction has a latency of several cycles but can start
+    //every cycle, interleave four independent computations
+    for (; i + 4 <= num; i += 4)
+    {
+	const uint8_t *p0 = keys[i + 0];
+	const uint8_t *p1 = keys[i + 1];
+	const uint8_t *p2 = keys[i + 2];
+	const uint8_t *p3 = keys[i + 3];
+	uint32_t c0 = seed, c1 = seed, c2 = seed, c3 = seed;
+	size_t off = 0;
+	for (; off + 8 <= len; off += 8)
+	{
+	    c0 = crc32c_u64(c0, rd64(p0 + off));
+	    c1 = crc32c_u64(c1, rd64(p1 + off));
+	    c2 = crc32c_u64(c2, rd64(p2 + off));
+	    c3 = crc32c_u64(c3, rd64(p3 + off));
+	}
+	if (off + 4 <= len)
+	{
+	    c0 = crc32c_u32(c0, rd32(p0 + off));
+	    c1 = crc32c_u32(c1, rd32(p1 + off));
+	    c2 = crc32c_u32(c2, rd32(p2 + off));
+	    c3 = crc32c_u32(c3, rd32(p3 + off));
+	    off += 4;
+	}
+	for (; off < len; off++)
+	{
+	    c0 = crc32c_u8(c0, p0[off]);
+	    c1 = crc32c_u8(c1, p1[off]);
+	    c2 = crc32c_u8(c2, p2[off]);
+	    c3 = crc32c_u8(c3, p3[off]);
+	}
+	hashes[i + 0] = c0;
+	hashes[i + 1] = c1;
+	hashes[i + 2] = c2;
+	hashes[i + 3] = c3;
+    }
+#endif
+    for (; i < num; i++)
+    {
+	hashes[i] = p64_hash_crc32c(keys[i], len, seed);
+    }
+}
+
+//wyhash (by Wang Yi, public domain), final version 4
+
+static const uint64_t wysecret[4] =
+{
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+//128-bit multiply, return low and high halves in '*a' and '*b'
+static inline void
+wymum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t
+wymix(uint64_t a, uint64_t b)
+{
+    wymum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t
+wyr3(const uint8_t *p, size_t k)
+{
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+ALWAYS_INLINE
+static inline uint64_t
+wyhash(const uint8_t *p, size_t len, uint64_t seed)
+{
+    uint64_t a, b;
+    seed ^= wymix(seed ^ wysecret[0], wysecret[1]);
+    if (LIKELY(len <= 16))
+    {
+	if (LIKELY(len >= 4))
+	{
+	    a = ((uint64_t)rd32(p) << 32) | rd32(p + ((len >> 3) << 2));
+	    b = ((uint64_t)rd32(p + len - 4) << 32) |
+		rd32(p + len - 4 - ((len >> 3) << 2));
+	}
+	else if (LIKELY(len > 0))
+	{
+	    a = wyr3(p, len);
+	    b = 0;
+	}
+	else
+	{
+	    a = b = 0;
+	}
+    }
+    else
+    {
+	size_t i = len;
+	if (UNLIKELY(i > 48))
+	{
+	    uint64_t see1 = seed, see2 = seed;
+	    do
+	    {
+		seed = wymix(rd64(p) ^ wysecret[1], rd64(p + 8) ^ seed);
+		see1 = wymix(rd64(p + 16) ^ wysecret[2], rd64(p + 24) ^ see1);
+		see2 = wymix(rd64(p + 32) ^ wysecret[3], rd64(p + 40) ^ see2);
+		p += 48;
+		i -= 48;
+	    }
+	    while (LIKELY(i > 48));
+	    seed ^= see1 ^ see2;
+	}
+	while (UNLIKELY(i > 16))
+	{
+	    seed = wymix(rd64(p) ^ wysecret[1], rd64(p + 8) ^ seed);
+	    i -= 16;
+	    p += 16;
+	}
+	a = rd64(p + i - 16);
+	b = rd64(p + i - 8);
+    }
+    a ^= wysecret[1];
+    b ^= seed;
+    wymum(&a, &b);
+    return wymix(a ^ wysecret[0] ^ len, b ^ wysecret[1]);
+}
+
+uint64_t
+p64_hash_wyhash(const void *data, size_t len, uint64_t seed)
+{
+    return wyhash(data, len, seed);
+}
+
+void
+p64_hash_wyhash_vec(uint32_t num,
+		    const void *keys[num],
+		    size_t len,
+		    uint64_t seed,
+		    uint64_t hashes[num])
+{
+    uint32_t i = 0;
+    if (len >= 4 && len <= 16)
+    {
+	//Short keys, the seed is mixed once and four independent chains of
+	//multiplies are interleaved
+	uint64_t s = seed ^ wymix(seed ^ wysecret[0], wysecret[1]);
+	size_t off = (len >> 3) << 2;
+	for (; i + 4 <= num; i += 4)
+	{
+	    uint64_t a[4], b[4];
+	    for (uint32_t j = 0; j < 4; j++)
+	    {
+		const uint8_t *p = keys[i + j];
+		a[j] = ((uint64_t)rd32(p) << 32) | rd32(p + off);
+		b[j] = ((uint64_t)rd32(p + len - 4) << 32) |
+		       rd32(p + len - 4 - off);
+		a[j] ^= wysecret[1];
+		b[j] ^= s;
+	    }
+	    for (uint32_t j = 0; j < 4; j++)
+	    {
+		wymum(&a[j], &b[j]);
+	    }
+	    for (uint32_t j = 0; j < 4; j++)
+	    {
+		hashes[i + j] = wymix(a[j] ^ wysecret[0] ^ len,
+				      b[j] ^ wysecret[1]);
+	    }
+	}
+    }
+    for (; i < num; i++)
+    {
+	hashes[i] = wyhash(keys[i], len, seed);
+    }
+}
+
+//Vectorised MurmurHash3 finalisation
+
+void
+p64_hash_mix32_vec(uint32_t num,
+		   const uint32_t keys[num],
+		   uint32_t hashes[num])
+{
+    uint32_t i = 0;
+#if defined __AVX2__
+    const __m256i m1 = _mm256_set1_epi32(0x85ebca6b);
+    const __m256i m2 = _mm256_set1_epi32(0xc2b2ae35);
+    for (; i + 8 <= num; i += 8)
+    {
+	__m256i x = _mm256_loadu_si256((const __m256i *)&keys[i]);
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	x = _mm256_mullo_epi32(x, m1);
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 13));
+	x = _mm256_mullo_epi32(x, m2);
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	_mm256_storeu_si256((__m256i *)&hashes[i], x);
+    }
+#elif defined __SSE4_1__
+    const __m128i m1 = _mm_set1_epi32(0x85ebca6b);
+    const __m128i m2 = _mm_set1_epi32(0xc2b2ae35);
+    for (; i + 4 <= num; i += 4)
+    {
+	__m128i x = _mm_loadu_si128((const __m128i *)&keys[i]);
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	x = _mm_mullo_epi32(x, m1);
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 13));
+	x = _mm_mullo_epi32(x, m2);
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	_mm_storeu_si128((__m128i *)&hashes[i], x);
+    }
+#elif defined __ARM_NEON
+    const uint32x4_t m1 = vdupq_n_u32(0x85ebca6b);
+    const uint32x4_t m2 = vdupq_n_u32(0xc2b2ae35);
+    for (; i + 4 <= num; i += 4)
+    {
+	uint32x4_t x = vld1q_u32(&keys[i]);
+	x = veorq_u32(x, vshrq_n_u32(x, 16));
+	x = vmulq_u32(x, m1);
+	x = veorq_u32(x, vshrq_n_u32(x, 13));
+	x = vmulq_u32(x, m2);
+	x = veorq_u32(x, vshrq_n_u32(x, 16));
+	vst1q_u32(&hashes[i], x);
+    }
+#endif
+    for (; i < num; i++)
+    {
+	hashes[i] = p64_hash_mix32(keys[i]);
+    }
+}
+
+#if defined __AVX2__
+//Low 64 bits of 64x64-bit multiply using 32x32->64-bit multiplies
+static inline __m256i
+mullo64(__m256i x, __m256i m, __m256i m_hi)
+{
+    __m256i lo = _mm256_mul_epu32(x, m);
+    __m256i c1 = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+    __m256i c2 = _mm256_mul_epu32(x, m_hi);
+    __m256i cross = _mm256_add_epi64(c1, c2);
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+#endif
+
+void
+p64_hash_mix64_vec(uint32_t num,
+		   const uint64_t keys[num],
+		   uint64_t hashes[num])
+{
+    uint32_t i = 0;
+#if defined __AVX2__
+    const __m256i m1 = _mm256_set1_epi64x(0xff51afd7ed558ccdULL);
+    const __m256i m1_hi = _mm256_set1_epi64x(0xff51afd7ed558ccdULL >> 32);
+    const __m256i m2 = _mm256_set1_epi64x(0xc4ceb9fe1a85ec53ULL);
+    const __m256i m2_hi = _mm256_set1_epi64x(0xc4ceb9fe1a85ec53ULL >> 32);
+    for (; i + 4 <= num; i += 4)
+    {
+	__m256i x = _mm256_loadu_si256((const __m256i *)&keys[i]);
+	x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+	x = mullo64(x, m1, m1_hi);
+	x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+	x = mullo64(x, m2, m2_hi);
+	x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+	_mm256_storeu_si256((__m256i *)&hashes[i], x);
+    }
+#endif
+    //Scalar 64-bit multiply is fast on AArch64, NEON lacks 64-bit multiply
+    for (; i < num; i++)
+    {
+	hashes[i] = p64_hash_mix64(keys[i]);
+    }
+}
@@ -13,24 +13,39 @@
 #include "p64_hashtable.h"
 #undef p64_hashtable_lookup
 #undef p64_hashtable_remove_by_key
+#include "p64_ebr.h"
 #include "p64_hazardptr.h"
 #include "p64_qsbr.h"
 #include "build_config.h"
 
 #include "common.h"
+#include "arch.h"
 #include "atomic.h"
 #include "os_abstraction.h"
 #include "err_hnd.h"
+#include "hashstats.h"
 
 #define MARK_REMOVE (uintptr_t)1
+#define MARK_FROZEN (uintptr_t)2
+#define MARK_ALL (MARK_REMOVE | MARK_FROZEN)
 #define HAS_MARK(ptr) (((uintptr_t)(ptr) & MARK_REMOVE) != 0)
 #define SET_MARK(ptr) (void *)((uintptr_t)(ptr) |  MARK_REMOVE)
 #define REM_MARK(ptr) (void *)((uintptr_t)(ptr) & ~MARK_REMOVE)
+#define HAS_FROZEN(ptr) (((uintptr_t)(ptr) & MARK_FROZEN) != 0)
+#define SET_FROZEN(ptr) (void *)((uintptr_t)(ptr) |  MARK_FROZEN)
+#define REM_ALL(ptr) (void *)((uintptr_t)(ptr) & ~MARK_ALL)
 
 //CACHE_LINE == 32, __SIZEOF_POINTER__ == 4 => BKT_SIZE == 4
 //CACHE_LINE == 64, __SIZEOF_POINTER__ == 8 => BKT_SIZE == 4
 #define BKT_SIZE (CACHE_LINE / (2 * __SIZEOF_POINTER__))
 
+//Number of buckets migrated when a thread helps an ongoing resize
+#define MIGRATE_STEP 4
+//Max number of elements moved per traversal of a frozen list
+#define MIGRATE_BATCH 32U
+//Number of element counters, spread out to avoid contention
+#define NUM_STRIPES 8
+
 static inline void *
 atomic_load_acquire(struct p64_hashelem **pptr,
                     p64_hazardptr_t *hp,
@@ -67,40 +82,449 @@ union heui
     ptrpair_t pp;
 };
 
+//A resize allocates a new table which is linked from the current table
+//Buckets in the current table are frozen and their elements moved to the new
+//table, the last element of a list is moved first so that every element is
+//always reachable from either the old or the new table
+//The end of each list is tagged with the generation of the table so that
+//lagging threads cannot append elements to a list that has been moved
+//Once all lists of a bucket are frozen, any thread which needs the bucket to
+//be migrated can move elements itself instead of waiting for the thread which
+//froze the bucket
+struct hash_table
+{
+    struct hash_table *next;//Destination table when resize is in progress
+    size_t nbkts;
+    p64_hashvalue_t gen;//Table generation, tags end of lists
+    uint8_t *ready;//Per bucket, all lists frozen and ready for migration
+    size_t migrate ALIGNED(CACHE_LINE);//Next bucket to migrate
+    size_t nmigrated;//Number of buckets migrated
+    struct hash_bucket buckets[] ALIGNED(CACHE_LINE);
+};
+
+struct stripe
+{
+    size_t count;
+} ALIGNED(CACHE_LINE);
+
 struct p64_hashtable
 {
+    struct hash_table *cur;//Current table
     p64_hashtable_compare cf;
-    size_t nbkts;
+    size_t min_nbkts;//Automatic resize will not shrink table below this size
     uint8_t use_hp;
-    struct hash_bucket buckets[] ALIGNED(CACHE_LINE);
+    uint8_t use_ebr;
+    p64_qsbrdomain_t *qsbr;//Domain of retired tables when using QSBR
+    uint8_t resizable;
+    uint8_t autoresize;
+    uint8_t compact;
+    struct hashstats *stats;//NULL unless statistics enabled
+    p64_memsrc_t mem;//Source of tables allocated by resize
+    struct stripe nelems[NUM_STRIPES];//Number of elements in hash table
 };
 
+static inline void
+smr_enter(p64_hashtable_t *ht)
+{
+    if (UNLIKELY(ht->use_ebr))
+    {
+	p64_ebr_enter();
+    }
+    else if (LIKELY(!ht->use_hp))
+    {
+	p64_qsbr_acquire();
+    }
+}
+
+static inline void
+smr_exit(p64_hashtable_t *ht)
+{
+    if (UNLIKELY(ht->use_ebr))
+    {
+	p64_ebr_exit();
+    }
+    else if (LIKELY(!ht->use_hp))
+    {
+	p64_qsbr_release();
+    }
+}
+
+static inline size_t
+hash_to_bix(struct hash_table *tbl, p64_hashvalue_t hash)
+{
+    return (hash / BKT_SIZE) % tbl->nbkts;
+}
+
+static inline struct hash_table *
+current_table(p64_hashtable_t *ht)
+{
+    return atomic_load_ptr(&ht->cur, __ATOMIC_ACQUIRE);
+}
+
+//The first list head is frozen first, it indicates a frozen bucket
+static inline bool
+bucket_is_frozen(struct hash_bucket *bkt)
+{
+    return HAS_FROZEN(atomic_load_ptr(&bkt->elems[0].next, __ATOMIC_RELAXED));
+}
+
+static struct hash_table *
+table_alloc(const p64_memsrc_t *mem, size_t nbkts, p64_hashvalue_t gen)
+{
+    size_t sz = sizeof(struct hash_table) +
+		sizeof(struct hash_bucket) * nbkts +
+		sizeof(uint8_t) * nbkts;
+    struct hash_table *tbl = p64_malloc_src(mem, sz, CACHE_LINE);
+    if (tbl != NULL)
+    {
+	memset(tbl, 0, sz);
+	tbl->next = NULL;
+	tbl->nbkts = nbkts;
+	tbl->gen = gen;
+	tbl->ready = (uint8_t *)&tbl->buckets[nbkts];
+	tbl->migrate = 0;
+	tbl->nmigrated = 0;
+	//All buckets already cleared (NULL pointers)
+	//Tag the empty lists with the table generation
+	for (size_t i = 0; gen != 0 && i < nbkts; i++)
+	{
+	    for (uint32_t j = 0; j < BKT_SIZE; j++)
+	    {
+		tbl->buckets[i].elems[j].hash = gen;
+	    }
+	}
+    }
+    return tbl;
+}
+
+//Compact mode stores element pointers and signatures (hash fragments)
+//directly in the buckets, elements do not embed any p64_hashelem_t
+//Elements which do not fit in their home bucket overflow into the following
+//buckets, each bucket counts the elements which have overflowed past it so
+//that searches know when to stop
+//CACHE_LINE == 64, __SIZEOF_POINTER__ == 8 => CBKT_SIZE == 6
+//CACHE_LINE == 64, __SIZEOF_POINTER__ == 4 => CBKT_SIZE == 10
+typedef uint16_t sign_t;
+
+#define CBKT_SIZE ((CACHE_LINE - sizeof(uint32_t)) / \
+		   (__SIZEOF_POINTER__ + sizeof(sign_t)))
+
+struct compact_bucket
+{
+    uint32_t overflow;//Number of elements which have overflowed past bucket
+    sign_t sigs[CBKT_SIZE];
+    p64_hashelem_t *elems[CBKT_SIZE];
+} ALIGNED(CACHE_LINE);
+
+//Compact buckets use the bucket array of the normal table
+static_assert(sizeof(struct compact_bucket) == sizeof(struct hash_bucket),
+	      "sizeof(struct compact_bucket) == sizeof(struct hash_bucket)");
+
+static inline struct compact_bucket *
+compact_bucket(struct hash_table *tbl, size_t bix)
+{
+    return (struct compact_bucket *)&tbl->buckets[bix];
+}
+
+static inline size_t
+compact_bix(struct hash_table *tbl, p64_hashvalue_t hash)
+{
+    return hash % tbl->nbkts;
+}
+
+//Signature uses the hash bits not consumed by the bucket index
+static inline sign_t
+compact_sig(struct hash_table *tbl, p64_hashvalue_t hash)
+{
+    return (sign_t)(hash / tbl->nbkts);
+}
+
 static inline size_t
-hash_to_bix(p64_hashtable_t *ht, p64_hashvalue_t hash)
+compact_next(struct hash_table *tbl, size_t bix)
+{
+    return bix + 1 == tbl->nbkts ? 0 : bix + 1;
+}
+
+UNROLL_LOOPS ALWAYS_INLINE
+static inline uint32_t
+compact_match(struct compact_bucket *bkt, sign_t sig)
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < CBKT_SIZE; i++)
+    {
+	if (atomic_load_n(&bkt->sigs[i], __ATOMIC_RELAXED) == sig)
+	{
+	    mask |= 1U << i;
+	}
+    }
+    //Order the loads of elems after the loads of sigs
+    atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return mask;
+}
+
+ALWAYS_INLINE
+static inline p64_hashelem_t *
+compact_lookup(p64_hashtable_t *ht,
+	       struct hash_table *tbl,
+	       const void *key,
+	       p64_hashvalue_t hash,
+	       p64_hazardptr_t *hazpp,
+	       bool check_key)
+{
+    size_t bix = compact_bix(tbl, hash);
+    sign_t sig = compact_sig(tbl, hash);
+    uint32_t nprobes = 0;
+    do
+    {
+	struct compact_bucket *bkt = compact_bucket(tbl, bix);
+	nprobes++;
+	uint32_t mask = compact_match(bkt, sig);
+	while (mask != 0)
+	{
+	    uint32_t i = __builtin_ctz(mask);
+	    p64_hashelem_t *he = atomic_load_acquire(&bkt->elems[i],
+						     hazpp,
+						     ~(uintptr_t)0,
+						     ht->use_hp);
+	    if (he != NULL)
+	    {
+		if (check_key)
+		{
+		    if (ht->cf(he, key) == 0)
+		    {
+			//Found our element
+			hashstats_lookup(ht->stats, nprobes, true);
+			return he;
+		    }
+		    //Else false positive
+		}
+		else//Check key later
+		{
+		    PREFETCH_FOR_READ(he);
+		    hashstats_lookup(ht->stats, nprobes, true);
+		    return he;
+		}
+	    }
+	    //Clear least significant bit
+	    mask &= mask - 1;
+	}
+	//Continue with next bucket only if elements have overflowed past
+	//this bucket
+	if (atomic_load_n(&bkt->overflow, __ATOMIC_ACQUIRE) == 0)
+	{
+	    break;
+	}
+	bix = compact_next(tbl, bix);
+    }
+    while (nprobes < tbl->nbkts);
+    hashstats_lookup(ht->stats, nprobes, false);
+    return NULL;
+}
+
+//Write signature to bucket
+static inline void
+compact_write_sig(struct compact_bucket *bkt,
+		  uint32_t idx,
+		  sign_t oldsig,
+		  p64_hashelem_t *he,
+		  sign_t newsig)
+{
+    while (!atomic_compare_exchange_n(&bkt->sigs[idx],
+				      &oldsig,//Updated on failure
+				      newsig,
+				      __ATOMIC_RELEASE,
+				      __ATOMIC_RELAXED))
+    {
+	//Some other thread has written sig and possibly also elem after our
+	//write to elem, check if our element is still present
+	if (atomic_load_ptr(&bkt->elems[idx], __ATOMIC_RELAXED) != he)
+	{
+	    //No, don't write sig
+	    return;
+	}
+    }
+}
+
+//Decrement overflow counts of the 'num' buckets starting with 'bix'
+static void
+compact_underflow(struct hash_table *tbl,
+		  size_t bix,
+		  size_t num)
+{
+    while (num-- != 0)
+    {
+	atomic_fetch_sub(&compact_bucket(tbl, bix)->overflow,
+			 1,
+			 __ATOMIC_RELAXED);
+	bix = compact_next(tbl, bix);
+    }
+}
+
+static bool
+compact_insert(p64_hashtable_t *ht,
+	       struct hash_table *tbl,
+	       p64_hashelem_t *he,
+	       p64_hashvalue_t hash)
+{
+    size_t home = compact_bix(tbl, hash);
+    size_t bix = home;
+    for (size_t n = 0; n < tbl->nbkts; n++)
+    {
+	struct compact_bucket *bkt = compact_bucket(tbl, bix);
+	for (uint32_t i = 0; i < CBKT_SIZE; i++)
+	{
+	    p64_hashelem_t *old = atomic_load_ptr(&bkt->elems[i],
+						  __ATOMIC_RELAXED);
+	    if (old != NULL)
+	    {
+		continue;
+	    }
+	    sign_t oldsig = atomic_load_n(&bkt->sigs[i], __ATOMIC_RELAXED);
+	    //Release order so that the overflow increments are visible
+	    //before the element
+	    if (atomic_compare_exchange_ptr(&bkt->elems[i],
+					    &old,
+					    he,
+					    __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+	    {
+		compact_write_sig(bkt, i, oldsig, he, compact_sig(tbl, hash));
+		return true;
+	    }
+	    //Else slot grabbed by some other thread
+	    hashstats_add(ht->stats, HS_CAS_RETRY, 1);
+	}
+	//Bucket full, element overflows into next bucket
+	atomic_fetch_add(&bkt->overflow, 1, __ATOMIC_RELAXED);
+	bix = compact_next(tbl, bix);
+    }
+    //Table full
+    compact_underflow(tbl, home, tbl->nbkts);
+    return false;
+}
+
+static bool
+compact_remove(struct hash_table *tbl,
+	       p64_hashelem_t *he,
+	       p64_hashvalue_t hash)
+{
+    size_t home = compact_bix(tbl, hash);
+    size_t bix = home;
+    for (size_t n = 0; n < tbl->nbkts; n++)
+    {
+	struct compact_bucket *bkt = compact_bucket(tbl, bix);
+	//Match on element pointer, the signature might not be written yet
+	for (uint32_t i = 0; i < CBKT_SIZE; i++)
+	{
+	    p64_hashelem_t *old = he;
+	    if (atomic_load_ptr(&bkt->elems[i], __ATOMIC_RELAXED) == he &&
+		atomic_compare_exchange_ptr(&bkt->elems[i],
+					    &old,
+					    NULL,
+					    __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+	    {
+		compact_underflow(tbl, home, n);
+		return true;
+	    }
+	}
+	if (atomic_load_n(&bkt->overflow, __ATOMIC_RELAXED) == 0)
+	{
+	    break;
+	}
+	bix = compact_next(tbl, bix);
+    }
+    return false;
+}
+
+static p64_hashelem_t *
+compact_remove_by_key(p64_hashtable_t *ht,
+		      struct hash_table *tbl,
+		      const void *key,
+		      p64_hashvalue_t hash,
+		      p64_hazardptr_t *hazpp)
+{
+    size_t home = compact_bix(tbl, hash);
+    sign_t sig = compact_sig(tbl, hash);
+    size_t bix = home;
+    for (size_t n = 0; n < tbl->nbkts; n++)
+    {
+	struct compact_bucket *bkt = compact_bucket(tbl, bix);
+	uint32_t mask = compact_match(bkt, sig);
+	while (mask != 0)
+	{
+	    uint32_t i = __builtin_ctz(mask);
+	    p64_hashelem_t *he = atomic_load_acquire(&bkt->elems[i],
+						     hazpp,
+						     ~(uintptr_t)0,
+						     ht->use_hp);
+	    if (he != NULL && ht->cf(he, key) == 0)
+	    {
+		p64_hashelem_t *old = he;
+		if (atomic_compare_exchange_ptr(&bkt->elems[i],
+						&old,
+						NULL,
+						__ATOMIC_RELAXED,
+						__ATOMIC_RELAXED))
+		{
+		    compact_underflow(tbl, home, n);
+		    return he;
+		}
+		//Else element removed by some other thread
+	    }
+	    //Clear least significant bit
+	    mask &= mask - 1;
+	}
+	if (atomic_load_n(&bkt->overflow, __ATOMIC_RELAXED) == 0)
+	{
+	    break;
+	}
+	bix = compact_next(tbl, bix);
+    }
+    return NULL;
+}
+
+static void
+compact_traverse_bucket(p64_hashtable_t *ht,
+			struct hash_table *tbl,
+			size_t bix,
+			p64_hashtable_trav_cb cb,
+			void *arg)
 {
-    return (hash / BKT_SIZE) % ht->nbkts;
+    p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
+    struct compact_bucket *bkt = compact_bucket(tbl, bix);
+    for (uint32_t i = 0; i < CBKT_SIZE; i++)
+    {
+	p64_hashelem_t *he = atomic_load_acquire(&bkt->elems[i],
+						 &hp,
+						 ~(uintptr_t)0,
+						 ht->use_hp);
+	if (he != NULL)
+	{
+	    cb(arg, he, bix * CBKT_SIZE + i);
+	}
+    }
+    atomic_ptr_release(&hp, ht->use_hp);
 }
 
 static void
-traverse_list(p64_hashelem_t *prnt,
+traverse_list(p64_hashtable_t *ht,
+	      p64_hashelem_t *prnt,
 	      p64_hashtable_trav_cb cb,
 	      void *arg,
-	      size_t idx,
-	      bool use_hp)
+	      size_t idx)
 {
+    bool use_hp = ht->use_hp;
     p64_hazardptr_t hpprnt = P64_HAZARDPTR_NULL;
     p64_hazardptr_t hpthis = P64_HAZARDPTR_NULL;
-    if (!use_hp)
-    {
-	p64_qsbr_acquire();
-    }
+    smr_enter(ht);
     for (;;)
     {
 	p64_hashelem_t *this = atomic_load_acquire(&prnt->next,
 						   &hpthis,
-						   ~MARK_REMOVE,
+						   ~MARK_ALL,
 						   use_hp);
-	this = REM_MARK(this);
+	this = REM_ALL(this);
 	if (this == NULL)
 	{
 	    break;
@@ -109,24 +533,27 @@ traverse_list(p64_hashelem_t *prnt,
 	prnt = this;
 	SWAP(hpprnt, hpthis);
     }
-    if (!use_hp)
-    {
-	p64_qsbr_release();
-    }
+    smr_exit(ht);
     atomic_ptr_release(&hpprnt, use_hp);
     atomic_ptr_release(&hpthis, use_hp);
 }
 
 static void
 traverse_bucket(p64_hashtable_t *ht,
+		struct hash_table *tbl,
 		size_t bix,
 		p64_hashtable_trav_cb cb,
 		void *arg)
 {
-    struct hash_bucket *bkt = &ht->buckets[bix];
+    if (ht->compact)
+    {
+	compact_traverse_bucket(ht, tbl, bix, cb, arg);
+	return;
+    }
+    struct hash_bucket *bkt = &tbl->buckets[bix];
     for (uint32_t i = 0; i < BKT_SIZE; i++)
     {
-	traverse_list(&bkt->elems[i], cb, arg, bix * BKT_SIZE + i, ht->use_hp);
+	traverse_list(ht, &bkt->elems[i], cb, arg, bix * BKT_SIZE + i);
     }
 }
 
@@ -135,13 +562,25 @@ p64_hashtable_traverse(p64_hashtable_t *ht,
 		       p64_hashtable_trav_cb cb,
 		       void *arg)
 {
-    for (size_t i = 0; i < ht->nbkts; i++)
+    smr_enter(ht);
+    //If a resize is in progress, traverse both the old and the new table
+    //Elements moved during the traversal may be reported twice
+    struct hash_table *tbl = current_table(ht);
+    do
     {
-	traverse_bucket(ht, i, cb, arg);
+	for (size_t i = 0; i < tbl->nbkts; i++)
+	{
+	    traverse_bucket(ht, tbl, i, cb, arg);
+	}
+	tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
     }
+    while (tbl != NULL);
+    smr_exit(ht);
 }
 
-#define VALID_FLAGS P64_HASHTAB_F_HP
+#define VALID_FLAGS (P64_HASHTAB_F_HP | P64_HASHTAB_F_RESIZE | \
+		     P64_HASHTAB_F_AUTORESIZE | P64_HASHTAB_F_STATS | \
+		     P64_HASHTAB_F_COMPACT | P64_HASHTAB_F_EBR)
 
 p64_hashtable_t *
 p64_hashtable_alloc(size_t nelems,
@@ -158,17 +597,57 @@ p64_hashtable_alloc(size_t nelems,
         report_error("hashtable", "invalid flags", flags);
         return NULL;
     }
-    size_t nbkts = (nelems + BKT_SIZE - 1) / BKT_SIZE;
-    size_t sz = sizeof(p64_hashtable_t) +
-		sizeof(struct hash_bucket) * nbkts;
-    p64_hashtable_t *ht = p64_malloc(sz, CACHE_LINE);
+    if (UNLIKELY((flags & P64_HASHTAB_F_HP) != 0 &&
+		 (flags & P64_HASHTAB_F_EBR) != 0))
+    {
+	report_error("hashtable", "conflicting SMR flags", flags);
+	return NULL;
+    }
+    bool resizable = (flags & (P64_HASHTAB_F_RESIZE |
+			       P64_HASHTAB_F_AUTORESIZE)) != 0;
+    if (UNLIKELY(resizable && (flags & P64_HASHTAB_F_HP) != 0))
+    {
+	report_error("hashtable", "resize requires QSBR or EBR", flags);
+	return NULL;
+    }
+    bool compact = (flags & P64_HASHTAB_F_COMPACT) != 0;
+    if (UNLIKELY(resizable && compact))
+    {
+	report_error("hashtable", "compact mode does not support resize",
+		     flags);
+	return NULL;
+    }
+    size_t nbkts = compact ? (nelems + CBKT_SIZE - 1) / CBKT_SIZE :
+			     (nelems + BKT_SIZE - 1) / BKT_SIZE;
+    p64_hashtable_t *ht = p64_malloc(sizeof(p64_hashtable_t), CACHE_LINE);
     if (ht != NULL)
     {
-	memset(ht, 0, sz);
+	memset(ht, 0, sizeof(p64_hashtable_t));
+	p64_memsrc_get(&ht->mem);
+	ht->cur = table_alloc(&ht->mem, nbkts, 0);
+	if (ht->cur == NULL)
+	{
+	    p64_mfree(ht);
+	    return NULL;
+	}
 	ht->cf = cf;
-	ht->nbkts = nbkts;
+	ht->min_nbkts = nbkts;
 	ht->use_hp = (flags & P64_HASHTAB_F_HP) != 0;
-	//All buckets already cleared (NULL pointers)
+	ht->use_ebr = (flags & P64_HASHTAB_F_EBR) != 0;
+	ht->qsbr = !ht->use_hp && !ht->use_ebr ? p64_qsbr_domain() : NULL;
+	ht->resizable = resizable;
+	ht->autoresize = (flags & P64_HASHTAB_F_AUTORESIZE) != 0;
+	ht->compact = compact;
+	if ((flags & P64_HASHTAB_F_STATS) != 0)
+	{
+	    ht->stats = hashstats_alloc();
+	    if (ht->stats == NULL)
+	    {
+		p64_mfree(ht->cur);
+		p64_mfree(ht);
+		return NULL;
+	    }
+	}
     }
     return ht;
 }
@@ -180,19 +659,42 @@ p64_hashtable_free(p64_hashtable_t *ht)
 {
     if (ht != NULL)
     {
-	//Check if hash table is empty
-	for (size_t i = 0; i < ht->nbkts; i++)
+	//Check if hash table is empty, including any unfinished resize
+	for (struct hash_table *tbl = ht->cur; tbl != NULL; tbl = tbl->next)
 	{
-	    for (uint32_t j = 0; j < BKT_SIZE; j++)
+	    for (size_t i = 0; i < tbl->nbkts; i++)
 	    {
 		//No need to use HP or QSBR, elements are not accessed
-		if (ht->buckets[i].elems[j].next != NULL)
+		bool empty = true;
+		if (ht->compact)
+		{
+		    for (uint32_t j = 0; j < CBKT_SIZE; j++)
+		    {
+			empty &= compact_bucket(tbl, i)->elems[j] == NULL;
+		    }
+		}
+		else
+		{
+		    for (uint32_t j = 0; j < BKT_SIZE; j++)
+		    {
+			empty &= REM_ALL(tbl->buckets[i].elems[j].next) == NULL;
+		    }
+		}
+		if (!empty)
 		{
 		    report_error("hashtable", "hash table not empty", 0);
 		    return;
 		}
 	    }
 	}
+	struct hash_table *tbl = ht->cur;
+	while (tbl != NULL)
+	{
+	    struct hash_table *next = tbl->next;
+	    p64_mfree(tbl);
+	    tbl = next;
+	}
+	hashstats_free(ht->stats);
 	p64_mfree(ht);
     }
 }
@@ -221,10 +723,12 @@ bucket_lookup(p64_hashtable_t *ht,
 	p64_hashelem_t *prnt = &bkt->elems[i];
 	p64_hashelem_t *he = atomic_load_acquire(&prnt->next,
 						 hazpp,
-						 ~MARK_REMOVE,
+						 ~MARK_ALL,
 						 ht->use_hp);
 	//The head element pointers cannot be marked for REMOVAL
 	assert(REM_MARK(he) == he);
+	//But they can be frozen
+	he = REM_ALL(he);
 	if (he != NULL)
 	{
 	    //Already matched on hash above
@@ -249,26 +753,29 @@ bucket_lookup(p64_hashtable_t *ht,
     return NULL;
 }
 
+//Number of list elements visited is added to '*nprobes'
 static p64_hashelem_t *
 list_lookup(p64_hashtable_t *ht,
 	    p64_hashelem_t *prnt,
 	    const void *key,
 	    p64_hazardptr_t *hazpp,
-	    bool check_key)
+	    bool check_key,
+	    uint32_t *nprobes)
 {
     p64_hazardptr_t hpprnt = P64_HAZARDPTR_NULL;
     for (;;)
     {
 	p64_hashelem_t *this = atomic_load_acquire(&prnt->next,
 						   hazpp,
-						   ~MARK_REMOVE,
+						   ~MARK_ALL,
 						   ht->use_hp);
-	this = REM_MARK(this);
+	this = REM_ALL(this);
 	if (this == NULL)
 	{
 	    atomic_ptr_release(&hpprnt, ht->use_hp);
 	    return NULL;
 	}
+	(*nprobes)++;
 	if (check_key)
 	{
 	    if (ht->cf(this, key) == 0)
@@ -304,14 +811,42 @@ lookup(p64_hashtable_t *ht,
     he = bucket_lookup(ht, bkt, key, hash, hazpp, check_key);
     if (he != NULL)
     {
+	hashstats_lookup(ht->stats, 1, true);
 	return he;
     }
-    he = list_lookup(ht, &bkt->elems[hash % BKT_SIZE], key, hazpp, check_key);
-    if (he != NULL)
+    uint32_t nprobes = 1;
+    he = list_lookup(ht, &bkt->elems[hash % BKT_SIZE], key, hazpp, check_key,
+		     &nprobes);
+    hashstats_lookup(ht->stats, nprobes, he != NULL);
+    return he;
+}
+
+//Element not found in bucket, if the bucket is frozen then the element
+//may have been moved to the next table
+static p64_hashelem_t *
+lookup_next(p64_hashtable_t *ht,
+	    struct hash_table *tbl,
+	    struct hash_bucket *bkt,
+	    const void *key,
+	    p64_hashvalue_t hash)
+{
+    for (;;)
     {
-	return he;
+	//Order the frozen check after the loads of the bucket and lists
+	atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (LIKELY(!bucket_is_frozen(bkt)))
+	{
+	    return NULL;
+	}
+	tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+	bkt = &tbl->buckets[hash_to_bix(tbl, hash)];
+	p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
+	p64_hashelem_t *he = lookup(ht, bkt, key, hash, &hp, true);
+	if (he != NULL)
+	{
+	    return he;
+	}
     }
-    return NULL;
 }
 
 p64_hashelem_t *
@@ -326,9 +861,18 @@ p64_hashtable_lookup(p64_hashtable_t *ht,
     {
 	hazpp = &hp;
     }
-    size_t bix = hash_to_bix(ht, hash);
-    struct hash_bucket *bkt = &ht->buckets[bix];
+    struct hash_table *tbl = current_table(ht);
+    if (ht->compact)
+    {
+	return compact_lookup(ht, tbl, key, hash, hazpp, true);
+    }
+    size_t bix = hash_to_bix(tbl, hash);
+    struct hash_bucket *bkt = &tbl->buckets[bix];
     p64_hashelem_t *he = lookup(ht, bkt, key, hash, hazpp, true);
+    if (UNLIKELY(he == NULL && ht->resizable))
+    {
+	he = lookup_next(ht, tbl, bkt, key, hash);
+    }
     return he;
 }
 
@@ -344,17 +888,26 @@ p64_hashtable_lookup_vec(p64_hashtable_t *ht,
     {
 	report_error("hashtable", "hazard pointers not supported", 0);
     }
+    struct hash_table *tbl = current_table(ht);
     struct hash_bucket *bkts[num];
     for (uint32_t i = 0; i < num; i++)
     {
-	size_t bix = hash_to_bix(ht, hashes[i]);
-	bkts[i] = &ht->buckets[bix];
+	size_t bix = ht->compact ? compact_bix(tbl, hashes[i]) :
+				   hash_to_bix(tbl, hashes[i]);
+	bkts[i] = &tbl->buckets[bix];
 	PREFETCH_FOR_READ(bkts[i]);
     }
     for (uint32_t i = 0; i < num; i++)
     {
 	p64_hazardptr_t hp = P64_HAZARDPTR_NULL;
-	result[i] = lookup(ht, bkts[i], keys[i], hashes[i], &hp, false);
+	if (ht->compact)
+	{
+	    result[i] = compact_lookup(ht, tbl, keys[i], hashes[i], &hp, false);
+	}
+	else
+	{
+	    result[i] = lookup(ht, bkts[i], keys[i], hashes[i], &hp, false);
+	}
     }
     for (uint32_t i = 0; i < num; i++)
     {
@@ -366,17 +919,29 @@ p64_hashtable_lookup_vec(p64_hashtable_t *ht,
 		result[i] = p64_hashtable_lookup(ht, keys[i], hashes[i], &hp);
 	    }
 	}
+	else if (UNLIKELY(ht->resizable))
+	{
+	    result[i] = lookup_next(ht, tbl, bkts[i], keys[i], hashes[i]);
+	}
     }
 }
 
-//Remove node, return true if element removed by us or some other thread
-//Returns fails if element cannot be removed due to parent marked for removal
-static inline bool
+enum remove_result
+{
+    rem_ok,//Element removed by us or some other thread
+    rem_retry,//Parent marked for removal
+    rem_frozen//Parent frozen, element marked for removal but not unlinked
+};
+
+//Remove node
+//Fails if element cannot be removed due to parent marked for removal or
+//parent frozen
+static inline enum remove_result
 remove_node(p64_hashelem_t *prnt,
 	    p64_hashelem_t *this,
 	    p64_hashvalue_t hash)
 {
-    assert(this == REM_MARK(this));
+    assert(this == REM_ALL(this));
     //Set our REMOVE mark (it may already be set)
     atomic_fetch_or(&this->next, MARK_REMOVE, __ATOMIC_RELAXED);
     //Now nobody may update our next pointer
@@ -386,33 +951,39 @@ remove_node(p64_hashelem_t *prnt,
     //Expect prnt->this to be unmarked or parent is also marked for removal
     union heui old = {.he.next = this, .he.hash = hash };
     //New prnt->next should not have REMOVAL mark
-    union heui neu = {.he.next = REM_MARK(this->next), .he.hash = this->hash };
+    union heui neu = {.he.next = REM_ALL(this->next), .he.hash = this->hash };
     if (atomic_compare_exchange_n((ptrpair_t *)prnt,
 				  &old.pp,
 				  neu.pp,
 				  __ATOMIC_RELAXED,
 				  __ATOMIC_RELAXED))
     {
-	return true;
+	return rem_ok;
     }
-    else if (REM_MARK(old.he.next) != this)
+    else if (UNLIKELY(HAS_FROZEN(old.he.next)))
+    {
+	//Parent frozen, 'this' may have been moved to the next table and
+	//must be removed from there
+	return rem_frozen;
+    }
+    else if (REM_ALL(old.he.next) != this)
     {
 	//prnt->next doesn't point to 'this', 'this' already removed
-	return true;
+	return rem_ok;
     }
     //Else prnt->next does point to 'this' but parent marked for removal
     assert(old.he.next == SET_MARK(this));
-    return false;
+    return rem_retry;
 }
 
 static inline p64_hashelem_t *
 insert_node(p64_hashelem_t *prnt,
 	    p64_hashelem_t *he,
-	    p64_hashvalue_t hash)
+	    p64_hashvalue_t hash,
+	    p64_hashvalue_t gen)
 {
-    assert(he->hash == 0);
-    assert(he->next == NULL);
-    union heui old = {.he.next = NULL, .he.hash = 0 };
+    //End of list is tagged with the table generation
+    union heui old = {.he.next = NULL, .he.hash = gen };
     union heui neu = {.he.next = he, .he.hash = hash };
     if (atomic_compare_exchange_n((ptrpair_t *)prnt,
 				  &old.pp,
@@ -424,6 +995,11 @@ insert_node(p64_hashelem_t *prnt,
 	return NULL;
     }
     //CAS failed, unexpected value returned
+    if (UNLIKELY(old.he.next == NULL))
+    {
+	//End of list has been moved to a new table, our list is frozen
+	return SET_FROZEN(NULL);
+    }
     return old.he.next;
 }
 
@@ -431,7 +1007,8 @@ UNROLL_LOOPS ALWAYS_INLINE
 static inline bool
 bucket_insert(struct hash_bucket *bkt,
 	      p64_hashelem_t *he,
-	      p64_hashvalue_t hash)
+	      p64_hashvalue_t hash,
+	      p64_hashvalue_t gen)
 {
     uint32_t mask = 0;
     //We want this loop unrolled
@@ -445,7 +1022,7 @@ bucket_insert(struct hash_bucket *bkt,
     while (mask != 0)
     {
 	uint32_t i = __builtin_ctz(mask);
-	if (insert_node(&bkt->elems[i], he, hash) == NULL)
+	if (insert_node(&bkt->elems[i], he, hash, gen) == NULL)
 	{
 	    //Success
 	    return true;
@@ -456,8 +1033,10 @@ bucket_insert(struct hash_bucket *bkt,
     return false;
 }
 
-static void
+//Return false if the list is frozen
+static bool
 list_insert(p64_hashtable_t *ht,
+	    struct hash_table *tbl,
 	    p64_hashelem_t *prnt,
 	    p64_hashelem_t *he,
 	    p64_hashvalue_t hash)
@@ -465,25 +1044,35 @@ list_insert(p64_hashtable_t *ht,
     p64_hazardptr_t hpprnt = P64_HAZARDPTR_NULL;
     p64_hazardptr_t hpthis = P64_HAZARDPTR_NULL;
     p64_hashelem_t *const org = prnt;
+    bool success = true;
     for (;;)
     {
 	p64_hashelem_t *this = atomic_load_acquire(&prnt->next,
 						   &hpthis,
-						   ~MARK_REMOVE,
+						   ~MARK_ALL,
 						   ht->use_hp);
+	if (UNLIKELY(HAS_FROZEN(this)))
+	{
+	    success = false;
+	    break;
+	}
 	this = REM_MARK(this);
 	if (this == NULL)
 	{
 	    //Next pointer is NULL => end of list, try to swap in our element
-	    p64_hashelem_t *old = insert_node(prnt, he, hash);
+	    p64_hashelem_t *old = insert_node(prnt, he, hash, tbl->gen);
 	    if (old == NULL)
 	    {
 		//CAS succeeded, our element added to end of list
-		atomic_ptr_release(&hpprnt, ht->use_hp);
-		atomic_ptr_release(&hpthis, ht->use_hp);
-		return;//Element inserted
+		break;//Element inserted
 	    }
 	    //Else CAS failed, next pointer unexpectedly changed
+	    hashstats_add(ht->stats, HS_CAS_RETRY, 1);
+	    if (UNLIKELY(HAS_FROZEN(old)))
+	    {
+		success = false;
+		break;
+	    }
 	    if (HAS_MARK(old))
 	    {
 		//Parent marked for removal and must be removed before we
@@ -498,21 +1087,25 @@ list_insert(p64_hashtable_t *ht,
 	else if (UNLIKELY(this == he))
 	{
 	    report_error("hashtable", "element already present", he);
-	    atomic_ptr_release(&hpprnt, ht->use_hp);
-	    atomic_ptr_release(&hpthis, ht->use_hp);
-	    return;
+	    break;
 	}
 	else if (UNLIKELY(HAS_MARK(this->next)))
 	{
 	    //Found other element ('this' != 'he') marked for removal
 	    //Let's give a helping hand
 	    //FIXME prnt->hash not read atomically with prnt->next, problem?
-	    if (remove_node(prnt, this, prnt->hash))
+	    enum remove_result res = remove_node(prnt, this, prnt->hash);
+	    if (res == rem_ok)
 	    {
 		//'this' node removed, '*prnt' points to 'next'
 		//Continue from current position
 		continue;
 	    }
+	    else if (UNLIKELY(res == rem_frozen))
+	    {
+		success = false;
+		break;
+	    }
 	    //Else parent node is also marked for removal
 	    //Parent must be removed before we remove 'this'
 	    //Restart from beginning
@@ -523,42 +1116,48 @@ list_insert(p64_hashtable_t *ht,
 	prnt = this;
 	SWAP(hpprnt, hpthis);
     }
+    atomic_ptr_release(&hpprnt, ht->use_hp);
+    atomic_ptr_release(&hpthis, ht->use_hp);
+    return success;
 }
 
-#define HAS_ANY(ptr) (((uintptr_t)(ptr) & MARK_REMOVE) != 0)
-
-void
-p64_hashtable_insert(p64_hashtable_t *ht,
-		     p64_hashelem_t *he,
-		     p64_hashvalue_t hash)
+//Insert element, follow any ongoing resize
+static void
+insert_elem(p64_hashtable_t *ht,
+	    struct hash_table *tbl,
+	    p64_hashelem_t *he,
+	    p64_hashvalue_t hash)
 {
-    if (UNLIKELY(HAS_ANY(he)))
-    {
-	report_error("hashtable", "element has low bits set", he);
-	return;
-    }
-    if (!ht->use_hp)
-    {
-	p64_qsbr_acquire();
-    }
-    size_t bix = hash_to_bix(ht, hash);
-    struct hash_bucket *bkt = &ht->buckets[bix];
-    he->hash = 0;
-    he->next = NULL;
-    bool success = bucket_insert(bkt, he, hash);
-    if (!success)
+    for (;;)
     {
+	size_t bix = hash_to_bix(tbl, hash);
+	struct hash_bucket *bkt = &tbl->buckets[bix];
+	if (bucket_insert(bkt, he, hash, tbl->gen))
+	{
+	    return;
+	}
 	p64_hashelem_t *prnt = &bkt->elems[hash % BKT_SIZE];
-	list_insert(ht, prnt, he, hash);
-    }
-    if (!ht->use_hp)
-    {
-	p64_qsbr_release();
+	if (LIKELY(list_insert(ht, tbl, prnt, he, hash)))
+	{
+	    return;
+	}
+	//Bucket frozen, insert into next table instead
+	//Element is not yet visible so can be updated non-atomically
+	tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+	he->hash = tbl->gen;
     }
 }
 
+enum search_result
+{
+    found_removed,//Element found and removed
+    found_marked,//Element found and marked for removal but not unlinked
+    not_found,//Element not found
+    list_frozen//List frozen before element was found
+};
+
 UNROLL_LOOPS ALWAYS_INLINE
-static inline bool
+static inline enum search_result
 bucket_remove(struct hash_bucket *bkt,
 	      p64_hashelem_t *he,
 	      p64_hashvalue_t hash)
@@ -578,13 +1177,16 @@ bucket_remove(struct hash_bucket *bkt,
 	p64_hashelem_t *prnt = &bkt->elems[i];
 	//No need to atomic_load_acquire(), we already have a reference
 	//Cannot fail due to parent marked for removal
-	(void)remove_node(prnt, he, hash);
-	return true;
+	if (UNLIKELY(remove_node(prnt, he, hash) == rem_frozen))
+	{
+	    return found_marked;
+	}
+	return found_removed;
     }
-    return false;
+    return not_found;
 }
 
-static bool
+static enum search_result
 list_remove(p64_hashtable_t *ht,
 	    p64_hashelem_t *prnt,
 	    p64_hashelem_t *he,
@@ -594,33 +1196,44 @@ list_remove(p64_hashtable_t *ht,
     p64_hazardptr_t hpthis = P64_HAZARDPTR_NULL;
     p64_hazardptr_t hpnext = P64_HAZARDPTR_NULL;
     p64_hashelem_t *const org = prnt;
+    enum search_result result;
+    bool marked = false;
     for (;;)
     {
 	p64_hashelem_t *this = atomic_load_acquire(&prnt->next,
 						   &hpthis,
-						   ~MARK_REMOVE,
+						   ~MARK_ALL,
 						   ht->use_hp);
+	if (UNLIKELY(HAS_FROZEN(this)))
+	{
+	    result = marked ? found_marked : list_frozen;
+	    break;
+	}
 	this = REM_MARK(this);
 	if (UNLIKELY(this == NULL))
 	{
 	    //End of list
-	    atomic_ptr_release(&hpprnt, ht->use_hp);
-	    atomic_ptr_release(&hpthis, ht->use_hp);
-	    atomic_ptr_release(&hpnext, ht->use_hp);
-	    return false;//Element not found
+	    //If we marked our element, some other thread has removed it
+	    result = marked ? found_removed : not_found;
+	    break;
 	}
 	else if (this == he)
 	{
 	    //Found our element, now remove it
-	    if (remove_node(prnt, this, hash))
+	    enum remove_result res = remove_node(prnt, this, hash);
+	    if (res == rem_ok)
 	    {
 		//Success, 'this' node is removed
-		atomic_ptr_release(&hpprnt, ht->use_hp);
-		atomic_ptr_release(&hpthis, ht->use_hp);
-		atomic_ptr_release(&hpnext, ht->use_hp);
-		return true;
+		result = found_removed;
+		break;
+	    }
+	    else if (UNLIKELY(res == rem_frozen))
+	    {
+		result = found_marked;
+		break;
 	    }
 	    //Else parent node is also marked for removal
+	    marked = true;
 	    //Parent must be removed before we remove 'this'
 	    //Restart from beginning
 	    prnt = org;
@@ -631,12 +1244,18 @@ list_remove(p64_hashtable_t *ht,
 	    //Found other element ('this' != 'he') marked for removal
 	    //Let's give a helping hand
 	    //FIXME prnt->hash not read atomically with prnt->next, problem?
-	    if (remove_node(prnt, this, prnt->hash))
+	    enum remove_result res = remove_node(prnt, this, prnt->hash);
+	    if (res == rem_ok)
 	    {
 		//'this' node removed, '*prnt' points to 'next'
 		//Continue from current position
 		continue;
 	    }
+	    else if (UNLIKELY(res == rem_frozen))
+	    {
+		result = marked ? found_marked : list_frozen;
+		break;
+	    }
 	    //Else parent node is also marked for removal
 	    //Parent must be removed before we remove 'this'
 	    //Restart from beginning
@@ -647,32 +1266,515 @@ list_remove(p64_hashtable_t *ht,
 	prnt = this;
 	SWAP(hpprnt, hpthis);
     }
+    atomic_ptr_release(&hpprnt, ht->use_hp);
+    atomic_ptr_release(&hpthis, ht->use_hp);
+    atomic_ptr_release(&hpnext, ht->use_hp);
+    return result;
+}
+
+static void
+help_migrate(p64_hashtable_t *ht,
+	     struct hash_table *src,
+	     struct hash_bucket *bkt);
+
+//Remove element, follow any ongoing resize
+static bool
+remove_elem(p64_hashtable_t *ht,
+	    struct hash_table *tbl,
+	    p64_hashelem_t *he,
+	    p64_hashvalue_t hash)
+{
+    bool marked = false;
+    for (;;)
+    {
+	size_t bix = hash_to_bix(tbl, hash);
+	struct hash_bucket *bkt = &tbl->buckets[bix];
+	enum search_result result = bucket_remove(bkt, he, hash);
+	if (result == not_found)
+	{
+	    p64_hashelem_t *prnt = &bkt->elems[hash % BKT_SIZE];
+	    result = list_remove(ht, prnt, he, hash);
+	}
+	//Both results mean that the element is marked for removal
+	marked |= result == found_removed || result == found_marked;
+	if (LIKELY(result != list_frozen))
+	{
+	    //If the bucket was not frozen, no elements have been moved and
+	    //the result is reliable
+	    atomic_thread_fence(__ATOMIC_ACQUIRE);
+	    if (LIKELY(!bucket_is_frozen(bkt)))
+	    {
+		return marked;
+	    }
+	}
+	//Bucket frozen, element must not remain in the old table when we
+	//return so complete the migration and remove it from the next table
+	help_migrate(ht, tbl, bkt);
+	tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+    }
+}
+
+//Move element to destination table, then unlink it from the frozen list
+//Several threads may migrate the same list, the thread which claims an
+//element (clears its frozen mark) is the only one to insert it in the
+//destination table
+//Return false if 'this' is no longer the last element of the frozen list
+static bool
+migrate_elem(p64_hashtable_t *ht,
+	     struct hash_table *src,
+	     struct hash_table *dst,
+	     p64_hashelem_t *prnt,
+	     p64_hashelem_t *this)
+{
+    //prnt->hash is stable since prnt is frozen
+    p64_hashvalue_t hash = atomic_load_n(&prnt->hash, __ATOMIC_RELAXED);
+    //Make element end of list in destination table
+    //Element may concurrently be marked for removal
+    union heui old, neu;
+    old.he.next = atomic_load_ptr(&this->next, __ATOMIC_ACQUIRE);
+    old.he.hash = atomic_load_n(&this->hash, __ATOMIC_RELAXED);
+    bool removed;
+    for (;;)
+    {
+	if (!HAS_FROZEN(old.he.next) || REM_ALL(old.he.next) != NULL)
+	{
+	    //Element claimed by another thread or not last in list
+	    return false;
+	}
+	if (HAS_MARK(old.he.next))
+	{
+	    //Element removed, don't move it
+	    removed = true;
+	    break;
+	}
+	neu.he.next = NULL;
+	neu.he.hash = dst->gen;
+	if (atomic_compare_exchange_n((ptrpair_t *)this,
+				      &old.pp,
+				      neu.pp,
+				      __ATOMIC_RELEASE,
+				      __ATOMIC_ACQUIRE))
+	{
+	    removed = false;
+	    break;
+	}
+    }
+    if (!removed)
+    {
+	//Insert into destination table before unlinking from source table
+	insert_elem(ht, dst, this, hash);
+	hashstats_add(ht->stats, HS_RELOC, 1);
+    }
+    //Unlink element, keep frozen and remove marks of parent
+    old.he.next = atomic_load_ptr(&prnt->next, __ATOMIC_RELAXED);
+    old.he.hash = hash;
+    do
+    {
+	if (REM_ALL(old.he.next) != this)
+	{
+	    //Removed element already unlinked by another thread
+	    assert(removed);
+	    break;
+	}
+	neu.he.next = (void *)((uintptr_t)old.he.next & MARK_ALL);
+	neu.he.hash = src->gen;
+    }
+    while (!atomic_compare_exchange_n((ptrpair_t *)prnt,
+				      &old.pp,
+				      neu.pp,
+				      __ATOMIC_RELEASE,
+				      __ATOMIC_RELAXED));
+    return true;
+}
+
+//Move all elements of frozen list, last element first
+static void
+migrate_list(p64_hashtable_t *ht,
+	     struct hash_table *src,
+	     struct hash_table *dst,
+	     p64_hashelem_t *head)
+{
+    //Circular buffer with the last elements of the list and their parents
+    p64_hashelem_t *path[MIGRATE_BATCH + 1];
+    for (;;)
+    {
+	uint32_t n = 0;
+	p64_hashelem_t *this = head;
+	void *next;
+	do
+	{
+	    path[n++ % (MIGRATE_BATCH + 1)] = this;
+	    next = atomic_load_ptr(&this->next, __ATOMIC_ACQUIRE);
+	    this = REM_ALL(next);
+	}
+	while (this != NULL && HAS_FROZEN(next));
+	if (n == 1)
+	{
+	    //List empty
+	    return;
+	}
+	if (this != NULL)
+	{
+	    //Last element claimed by another thread, wait for it to be
+	    //unlinked
+	    doze();
+	    continue;
+	}
+	//Move elements last first, stop at oldest parent in buffer
+	uint32_t m = MIN(n, MIGRATE_BATCH + 1);
+	for (uint32_t i = n - 1; i != n - m; i--)
+	{
+	    if (!migrate_elem(ht, src, dst,
+			      path[(i - 1) % (MIGRATE_BATCH + 1)],
+			      path[i % (MIGRATE_BATCH + 1)]))
+	    {
+		//Another thread is migrating the same list
+		doze();
+		break;
+	    }
+	}
+    }
+}
+
+static void
+migrate_lists(p64_hashtable_t *ht,
+	      struct hash_table *src,
+	      struct hash_bucket *bkt)
+{
+    struct hash_table *dst = atomic_load_ptr(&src->next, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < BKT_SIZE; i++)
+    {
+	migrate_list(ht, src, dst, &bkt->elems[i]);
+    }
+}
+
+static void
+migrate_bucket(p64_hashtable_t *ht,
+	       struct hash_table *src,
+	       size_t bix)
+{
+    struct hash_bucket *bkt = &src->buckets[bix];
+    //Freeze all list heads, the first list head indicates a frozen bucket
+    for (uint32_t i = 0; i < BKT_SIZE; i++)
+    {
+	atomic_fetch_or(&bkt->elems[i].next, MARK_FROZEN, __ATOMIC_ACQUIRE);
+    }
+    //Freeze all lists, after this only we can unlink elements but other
+    //threads can still mark elements for removal
+    for (uint32_t i = 0; i < BKT_SIZE; i++)
+    {
+	p64_hashelem_t *this = &bkt->elems[i];
+	while ((this = REM_ALL(atomic_load_ptr(&this->next,
+					       __ATOMIC_RELAXED))) != NULL)
+	{
+	    atomic_fetch_or(&this->next, MARK_FROZEN, __ATOMIC_ACQUIRE);
+	}
+    }
+    //From now on other threads may also move elements
+    atomic_store_n(&src->ready[bix], 1, __ATOMIC_RELEASE);
+    migrate_lists(ht, src, bkt);
+}
+
+//Complete migration of frozen bucket, all elements which are not marked for
+//removal have then been moved to the next table
+static void
+help_migrate(p64_hashtable_t *ht,
+	     struct hash_table *src,
+	     struct hash_bucket *bkt)
+{
+    size_t bix = bkt - src->buckets;
+    //Wait for the thread which froze the bucket to freeze all lists, this
+    //does not depend on any other thread
+    while (atomic_load_n(&src->ready[bix], __ATOMIC_ACQUIRE) == 0)
+    {
+	doze();
+    }
+    migrate_lists(ht, src, bkt);
+}
+
+//Migrate up to 'num' buckets from source table to destination table
+static void
+migrate_buckets(p64_hashtable_t *ht,
+		struct hash_table *src,
+		size_t num)
+{
+    size_t bix = atomic_fetch_add(&src->migrate, num, __ATOMIC_RELAXED);
+    if (bix >= src->nbkts)
+    {
+	//All buckets already claimed
+	return;
+    }
+    num = MIN(num, src->nbkts - bix);
+    for (size_t i = 0; i < num; i++)
+    {
+	migrate_bucket(ht, src, bix + i);
+    }
+    size_t done = atomic_fetch_add(&src->nmigrated, num, __ATOMIC_ACQ_REL);
+    if (done + num == src->nbkts)
+    {
+	//All buckets migrated, make destination table current
+	atomic_store_ptr(&ht->cur, src->next, __ATOMIC_RELEASE);
+	//Retire old table, memory will be reclaimed when all threads
+	//have stopped referencing it
+	while (!(ht->use_ebr ? p64_ebr_retire(src, p64_mfree) :
+				p64_qsbr_retire_domain(ht->qsbr, src,
+						       p64_mfree)))
+	{
+	    doze();
+	}
+    }
+}
+
+//Return the source table if resize was started
+static struct hash_table *
+start_resize(p64_hashtable_t *ht, size_t nbkts)
+{
+    struct hash_table *cur = current_table(ht);
+    if (atomic_load_ptr(&cur->next, __ATOMIC_RELAXED) != NULL)
+    {
+	//Resize already in progress
+	return NULL;
+    }
+    struct hash_table *neu = table_alloc(&ht->mem, nbkts, cur->gen + 1);
+    if (UNLIKELY(neu == NULL))
+    {
+	return NULL;
+    }
+    struct hash_table *old = NULL;
+    if (!atomic_compare_exchange_ptr(&cur->next,
+				     &old,
+				     neu,
+				     __ATOMIC_RELEASE,
+				     __ATOMIC_RELAXED))
+    {
+	//Some other thread started a resize
+	p64_mfree(neu);
+	return NULL;
+    }
+    return cur;
+}
+
+//Help any ongoing resize
+static inline void
+help_resize(p64_hashtable_t *ht)
+{
+    struct hash_table *cur = current_table(ht);
+    if (UNLIKELY(atomic_load_ptr(&cur->next, __ATOMIC_RELAXED) != NULL))
+    {
+	migrate_buckets(ht, cur, MIGRATE_STEP);
+    }
+}
+
+static size_t
+count_elems(p64_hashtable_t *ht)
+{
+    size_t nelems = 0;
+    for (uint32_t i = 0; i < NUM_STRIPES; i++)
+    {
+	nelems += atomic_load_n(&ht->nelems[i].count, __ATOMIC_RELAXED);
+    }
+    return nelems;
+}
+
+//Update element count and check load factor
+//Grow when there is on average more than one element per slot
+//Shrink when there is on average less than one element per four slots
+static void
+update_count(p64_hashtable_t *ht, p64_hashvalue_t hash, size_t delta)
+{
+    struct stripe *st = &ht->nelems[hash % NUM_STRIPES];
+    size_t cnt = atomic_fetch_add(&st->count, delta, __ATOMIC_RELAXED) + delta;
+    if (!ht->autoresize)
+    {
+	return;
+    }
+    struct hash_table *cur = current_table(ht);
+    size_t capacity = cur->nbkts * BKT_SIZE;
+    //Only sum all counters when our counter indicates a resize is needed
+    if (delta == 1)
+    {
+	if (UNLIKELY(cnt > capacity / NUM_STRIPES) &&
+	    count_elems(ht) > capacity)
+	{
+	    (void)start_resize(ht, 2 * cur->nbkts);
+	}
+    }
+    else if (UNLIKELY(cur->nbkts > ht->min_nbkts))
+    {
+	if (cnt < capacity / (4 * NUM_STRIPES) &&
+	    count_elems(ht) < capacity / 4)
+	{
+	    (void)start_resize(ht, MAX(cur->nbkts / 2, ht->min_nbkts));
+	}
+    }
+}
+
+#define HAS_ANY(ptr) (((uintptr_t)(ptr) & MARK_ALL) != 0)
+
+static bool
+insert_one(p64_hashtable_t *ht,
+	   p64_hashelem_t *he,
+	   p64_hashvalue_t hash)
+{
+    struct hash_table *tbl = current_table(ht);
+    if (ht->compact)
+    {
+	bool success = compact_insert(ht, tbl, he, hash);
+	hashstats_add(ht->stats, success ? HS_INSERT : HS_INSERT_FAIL, 1);
+	return success;
+    }
+    size_t bix = hash_to_bix(tbl, hash);
+    struct hash_bucket *bkt = &tbl->buckets[bix];
+    he->hash = tbl->gen;
+    he->next = NULL;
+    bool success = bucket_insert(bkt, he, hash, tbl->gen);
+    if (!success)
+    {
+	p64_hashelem_t *prnt = &bkt->elems[hash % BKT_SIZE];
+	success = list_insert(ht, tbl, prnt, he, hash);
+	if (UNLIKELY(!success))
+	{
+	    //Bucket frozen, insert into next table
+	    tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+	    he->hash = tbl->gen;
+	    insert_elem(ht, tbl, he, hash);
+	}
+    }
+    hashstats_add(ht->stats, HS_INSERT, 1);
+    if (UNLIKELY(ht->resizable))
+    {
+	update_count(ht, hash, 1);
+	help_resize(ht);
+    }
+    return true;
 }
 
 bool
-p64_hashtable_remove(p64_hashtable_t *ht,
+p64_hashtable_insert(p64_hashtable_t *ht,
 		     p64_hashelem_t *he,
 		     p64_hashvalue_t hash)
 {
-    if (!ht->use_hp)
+    if (UNLIKELY(!ht->compact && HAS_ANY(he)))
     {
-	p64_qsbr_acquire();
+	report_error("hashtable", "element has low bits set", he);
+	return false;
     }
-    size_t bix = hash_to_bix(ht, hash);
-    struct hash_bucket *bkt = &ht->buckets[bix];
-    bool success = bucket_remove(bkt, he, hash);
-    if (!success)
+    smr_enter(ht);
+    bool success = insert_one(ht, he, hash);
+    smr_exit(ht);
+    return success;
+}
+
+uint32_t
+p64_hashtable_insert_vec(p64_hashtable_t *ht,
+			 uint32_t num,
+			 p64_hashelem_t *hes[num],
+			 p64_hashvalue_t hashes[num],
+			 bool success[num])
+{
+    smr_enter(ht);
+    //Prefetch all target buckets and elements before doing any CAS so that
+    //the cache misses overlap
+    struct hash_table *tbl = current_table(ht);
+    for (uint32_t i = 0; i < num; i++)
     {
-	p64_hashelem_t *prnt = &bkt->elems[hash % BKT_SIZE];
-	success = list_remove(ht, prnt, he, hash);
+	size_t bix = ht->compact ? compact_bix(tbl, hashes[i]) :
+				   hash_to_bix(tbl, hashes[i]);
+	PREFETCH_FOR_WRITE(&tbl->buckets[bix]);
+	if (!ht->compact)
+	{
+	    //Compact mode does not write to the elements
+	    PREFETCH_FOR_WRITE(hes[i]);
+	}
     }
-    if (!ht->use_hp)
+    uint32_t ninserted = 0;
+    for (uint32_t i = 0; i < num; i++)
     {
-	p64_qsbr_release();
+	if (UNLIKELY(!ht->compact && HAS_ANY(hes[i])))
+	{
+	    report_error("hashtable", "element has low bits set", hes[i]);
+	    success[i] = false;
+	    continue;
+	}
+	success[i] = insert_one(ht, hes[i], hashes[i]);
+	ninserted += success[i];
+    }
+    smr_exit(ht);
+    return ninserted;
+}
+
+static bool
+remove_one(p64_hashtable_t *ht,
+	   p64_hashelem_t *he,
+	   p64_hashvalue_t hash)
+{
+    struct hash_table *tbl = current_table(ht);
+    bool success;
+    if (ht->compact)
+    {
+	success = compact_remove(tbl, he, hash);
+    }
+    else if (LIKELY(!ht->resizable))
+    {
+	size_t bix = hash_to_bix(tbl, hash);
+	struct hash_bucket *bkt = &tbl->buckets[bix];
+	enum search_result result = bucket_remove(bkt, he, hash);
+	if (result == not_found)
+	{
+	    p64_hashelem_t *prnt = &bkt->elems[hash % BKT_SIZE];
+	    result = list_remove(ht, prnt, he, hash);
+	}
+	success = result == found_removed;
     }
+    else
+    {
+	success = remove_elem(ht, tbl, he, hash);
+	if (success)
+	{
+	    update_count(ht, hash, -(size_t)1);
+	}
+	help_resize(ht);
+    }
+    hashstats_add(ht->stats, success ? HS_REMOVE : HS_REMOVE_FAIL, 1);
     return success;
 }
 
+bool
+p64_hashtable_remove(p64_hashtable_t *ht,
+		     p64_hashelem_t *he,
+		     p64_hashvalue_t hash)
+{
+    smr_enter(ht);
+    bool success = remove_one(ht, he, hash);
+    smr_exit(ht);
+    return success;
+}
+
+uint32_t
+p64_hashtable_remove_vec(p64_hashtable_t *ht,
+			 uint32_t num,
+			 p64_hashelem_t *hes[num],
+			 p64_hashvalue_t hashes[num],
+			 bool success[num])
+{
+    smr_enter(ht);
+    struct hash_table *tbl = current_table(ht);
+    for (uint32_t i = 0; i < num; i++)
+    {
+	size_t bix = ht->compact ? compact_bix(tbl, hashes[i]) :
+				   hash_to_bix(tbl, hashes[i]);
+	PREFETCH_FOR_WRITE(&tbl->buckets[bix]);
+    }
+    uint32_t nremoved = 0;
+    for (uint32_t i = 0; i < num; i++)
+    {
+	success[i] = remove_one(ht, hes[i], hashes[i]);
+	nremoved += success[i];
+    }
+    smr_exit(ht);
+    return nremoved;
+}
+
 UNROLL_LOOPS ALWAYS_INLINE
 static inline p64_hashelem_t *
 bucket_remove_by_key(p64_hashtable_t *ht,
@@ -696,17 +1798,25 @@ bucket_remove_by_key(p64_hashtable_t *ht,
 	p64_hashelem_t *prnt = &bkt->elems[i];
 	p64_hashelem_t *he = atomic_load_acquire(&prnt->next,
 						 hazpp,
-						 ~MARK_REMOVE,
+						 ~MARK_ALL,
 						 ht->use_hp);
 	//The head element pointers cannot be marked for REMOVAL
 	assert(REM_MARK(he) == he);
+	if (UNLIKELY(HAS_FROZEN(he)))
+	{
+	    return SET_FROZEN(NULL);
+	}
 	if (he != NULL)
 	{
 	    if (ht->cf(he, key) == 0)
 	    {
 		//Found our element
 		//Cannot fail due to parent marked for removal
-		(void)remove_node(prnt, he, hash);
+		if (UNLIKELY(remove_node(prnt, he, hash) == rem_frozen))
+		{
+		    //Element marked for removal but not unlinked
+		    return SET_FROZEN(he);
+		}
 		return he;
 	    }
 	}
@@ -716,6 +1826,8 @@ bucket_remove_by_key(p64_hashtable_t *ht,
     return NULL;
 }
 
+//A frozen list is indicated by a frozen return value, with a non-NULL
+//element if it was marked for removal but not unlinked
 static p64_hashelem_t *
 list_remove_by_key(p64_hashtable_t *ht,
 		   p64_hashelem_t *prnt,
@@ -727,12 +1839,18 @@ list_remove_by_key(p64_hashtable_t *ht,
     p64_hazardptr_t hpthis = P64_HAZARDPTR_NULL;
     p64_hazardptr_t hpnext = P64_HAZARDPTR_NULL;
     p64_hashelem_t *const org = prnt;
+    p64_hashelem_t *marked = NULL;
     for (;;)
     {
 	p64_hashelem_t *this = atomic_load_acquire(&prnt->next,
 						   &hpthis,
-						   ~MARK_REMOVE,
+						   ~MARK_ALL,
 						   ht->use_hp);
+	if (UNLIKELY(HAS_FROZEN(this)))
+	{
+	    //Only with QSBR, no hazard pointers to release
+	    return SET_FROZEN(marked);
+	}
 	this = REM_MARK(this);
 	if (UNLIKELY(this == NULL))
 	{
@@ -740,20 +1858,24 @@ list_remove_by_key(p64_hashtable_t *ht,
 	    atomic_ptr_release(&hpprnt, ht->use_hp);
 	    atomic_ptr_release(&hpthis, ht->use_hp);
 	    atomic_ptr_release(&hpnext, ht->use_hp);
-	    return NULL;//Element not found
+	    //If we marked an element, some other thread has removed it
+	    //It cannot be reclaimed before we have returned it
+	    return marked;//Else element not found
 	}
 	else if (ht->cf(this, key) == 0)
 	{
 	    //Found our element, now remove it
-	    if (remove_node(prnt, this, hash))
+	    enum remove_result res = remove_node(prnt, this, hash);
+	    if (res != rem_retry)
 	    {
-		//Success, 'this' node is removed
+		//Success, 'this' node is removed (or marked if frozen)
 		atomic_ptr_release(&hpprnt, ht->use_hp);
 		atomic_ptr_release(&hpnext, ht->use_hp);
 		*hazpp = hpthis;
-		return this;
+		return res == rem_ok ? this : SET_FROZEN(this);
 	    }
 	    //Else parent node is also marked for removal
+	    marked = this;
 	    //Parent must be removed before we remove 'this'
 	    //Restart from beginning
 	    prnt = org;
@@ -764,12 +1886,17 @@ list_remove_by_key(p64_hashtable_t *ht,
 	    //Found other element ('this' != 'he') marked for removal
 	    //Let's give a helping hand
 	    //FIXME prnt->hash not read atomically with prnt->next, problem?
-	    if (remove_node(prnt, this, prnt->hash))
+	    enum remove_result res = remove_node(prnt, this, prnt->hash);
+	    if (res == rem_ok)
 	    {
 		//'this' node removed, '*prnt' points to 'next'
 		//Continue from current position
 		continue;
 	    }
+	    else if (UNLIKELY(res == rem_frozen))
+	    {
+		return SET_FROZEN(marked);
+	    }
 	    //Else parent node is also marked for removal
 	    //Parent must be removed before we remove 'this'
 	    //Restart from beginning
@@ -789,13 +1916,175 @@ p64_hashtable_remove_by_key(p64_hashtable_t *ht,
 			    p64_hazardptr_t *hazpp)
 {
     //Caller must call QSBR acquire/release/quiescent as appropriate
-    size_t bix = hash_to_bix(ht, hash);
-    struct hash_bucket *bkt = &ht->buckets[bix];
-    p64_hashelem_t *he = bucket_remove_by_key(ht, bkt, key, hash, hazpp);
-    if (he == NULL)
+    struct hash_table *tbl = current_table(ht);
+    p64_hashelem_t *he;
+    if (ht->compact)
     {
-	p64_hashelem_t *prnt = &bkt->elems[hash % BKT_SIZE];
-	he = list_remove_by_key(ht, prnt, key, hash, hazpp);
+	he = compact_remove_by_key(ht, tbl, key, hash, hazpp);
+	hashstats_add(ht->stats, he != NULL ? HS_REMOVE : HS_REMOVE_FAIL, 1);
+	return he;
+    }
+    for (;;)
+    {
+	size_t bix = hash_to_bix(tbl, hash);
+	struct hash_bucket *bkt = &tbl->buckets[bix];
+	he = bucket_remove_by_key(ht, bkt, key, hash, hazpp);
+	if (he == NULL)
+	{
+	    p64_hashelem_t *prnt = &bkt->elems[hash % BKT_SIZE];
+	    he = list_remove_by_key(ht, prnt, key, hash, hazpp);
+	}
+	if (LIKELY(!ht->resizable))
+	{
+	    hashstats_add(ht->stats, he != NULL ? HS_REMOVE : HS_REMOVE_FAIL, 1);
+	    return he;
+	}
+	if (LIKELY(!HAS_FROZEN(he)))
+	{
+	    //If the bucket was not frozen, no elements have been moved and
+	    //the result is reliable
+	    atomic_thread_fence(__ATOMIC_ACQUIRE);
+	    if (LIKELY(!bucket_is_frozen(bkt)))
+	    {
+		break;
+	    }
+	}
+	//Bucket frozen, complete migration and continue with next table
+	he = REM_ALL(he);
+	help_migrate(ht, tbl, bkt);
+	tbl = atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE);
+	if (he != NULL)
+	{
+	    //Element marked for removal but it may already have been moved,
+	    //remove it from the next table
+	    (void)remove_elem(ht, tbl, he, hash);
+	    break;
+	}
+	//Else search next table
+    }
+    if (he != NULL)
+    {
+	update_count(ht, hash, -(size_t)1);
     }
+    hashstats_add(ht->stats, he != NULL ? HS_REMOVE : HS_REMOVE_FAIL, 1);
+    help_resize(ht);
     return he;
 }
+
+bool
+p64_hashtable_resize(p64_hashtable_t *ht, size_t nelems)
+{
+    if (UNLIKELY(!ht->resizable))
+    {
+	report_error("hashtable", "resize not supported", ht);
+	return false;
+    }
+    if (UNLIKELY(nelems == 0))
+    {
+	report_error("hashtable", "invalid number of elements", nelems);
+	return false;
+    }
+    size_t nbkts = (nelems + BKT_SIZE - 1) / BKT_SIZE;
+    smr_enter(ht);
+    struct hash_table *src = start_resize(ht, nbkts);
+    if (src != NULL)
+    {
+	//Migrate all buckets not claimed by other threads
+	while (atomic_load_n(&src->migrate, __ATOMIC_RELAXED) < src->nbkts)
+	{
+	    migrate_buckets(ht, src, MIGRATE_STEP);
+	}
+    }
+    smr_exit(ht);
+    return src != NULL;
+}
+
+void
+p64_hashtable_stats(p64_hashtable_t *ht,
+		    p64_hashstats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    if (ht->stats != NULL)
+    {
+	hashstats_read(ht->stats, st);
+    }
+    smr_enter(ht);
+    struct hash_table *tbl = current_table(ht);
+    st->capacity = (uint64_t)tbl->nbkts * (ht->compact ? CBKT_SIZE : BKT_SIZE);
+    smr_exit(ht);
+}
+
+//Cursor not yet positioned in any table
+#define CURSOR_RESTART (~(p64_hashvalue_t)0)
+
+static inline size_t
+part_start(size_t nbkts, uint32_t part, uint32_t nparts)
+{
+    return (size_t)((uint64_t)nbkts * part / nparts);
+}
+
+void
+p64_hashtable_cursor_init(p64_hashtable_cursor_t *cur,
+			  uint32_t part,
+			  uint32_t nparts)
+{
+    if (UNLIKELY(part >= nparts))
+    {
+	report_error("hashtable", "invalid partition", part);
+	return;
+    }
+    cur->gen = CURSOR_RESTART;
+    cur->next = 0;
+    cur->end = 0;
+    cur->part = part;
+    cur->nparts = nparts;
+}
+
+bool
+p64_hashtable_traverse_step(p64_hashtable_t *ht,
+			    p64_hashtable_cursor_t *cur,
+			    size_t nbkts,
+			    p64_hashtable_trav_cb cb,
+			    void *arg)
+{
+    bool more = true;
+    smr_enter(ht);
+    struct hash_table *tbl = current_table(ht);
+    if (UNLIKELY(atomic_load_ptr(&tbl->next, __ATOMIC_ACQUIRE) != NULL))
+    {
+	//Resize in progress, elements are moving between tables
+	//Help with the migration and restart once the resize is complete
+	migrate_buckets(ht, tbl, nbkts);
+	cur->gen = CURSOR_RESTART;
+	goto done;
+    }
+    if (cur->gen != tbl->gen)
+    {
+	//Start the partition in the current table, earlier progress in any
+	//previous table is lost
+	cur->gen = tbl->gen;
+	cur->next = part_start(tbl->nbkts, cur->part, cur->nparts);
+	cur->end = part_start(tbl->nbkts, cur->part + 1, cur->nparts);
+    }
+    for (; nbkts != 0 && cur->next < cur->end; nbkts--)
+    {
+	traverse_bucket(ht, tbl, cur->next, cb, arg);
+	if (UNLIKELY(ht->resizable))
+	{
+	    //Order the frozen check after the loads of the bucket and lists
+	    atomic_thread_fence(__ATOMIC_ACQUIRE);
+	    if (bucket_is_frozen(&tbl->buckets[cur->next]))
+	    {
+		//Resize started, elements of this and later buckets may
+		//already have moved
+		cur->gen = CURSOR_RESTART;
+		goto done;
+	    }
+	}
+	cur->next++;
+    }
+    more = cur->next < cur->end;
+done:
+    smr_exit(ht);
+    return more;
+}
@@ -0,0 +1,435 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "p64_hazardera.h"
+#undef p64_hazera_acquire
+#include "build_config.h"
+#include "os_abstraction.h"
+#include "err_hnd.h"
+#include "arch.h"
+#include "lockfree.h"
+#include "common.h"
+#include "thr_idx.h"
+
+static inline uint32_t
+bitmask(uint32_t n)
+{
+    return n < 32 ? (1U << n) - 1U : ~(uint32_t)0;
+}
+
+static void
+report_thread_not_registered(void)
+{
+    report_error("hazardera", "thread not registered", 0);
+}
+
+//Eras start from 1, 0 indicates an unused hazard era
+#define NONE 0
+
+static inline uint32_t
+roundup(uint32_t n)
+{
+    return ROUNDUP(n, CACHE_LINE / sizeof(uint64_t));
+}
+
+struct p64_hedomain
+{
+    uint64_t era ALIGNED(CACHE_LINE);//Global era clock
+    uint32_t nrefs;//Number of references per thread
+    uint32_t maxobjs;
+    uint32_t high_wm;//High watermark of thread index
+    uint32_t maxthreads;
+    p64_memsrc_t mem;//Source of thread state and era buffers
+    uint64_t *registered;//Bitmap of registered threads
+    uint64_t he[] ALIGNED(CACHE_LINE);
+};
+
+p64_hedomain_t *
+p64_hazera_alloc(uint32_t maxobjs, uint32_t nrefs)
+{
+    if (nrefs < 1 || nrefs > 32)
+    {
+	report_error("hazardera", "invalid number of references", nrefs);
+	return NULL;
+    }
+    if (maxobjs < 1)
+    {
+	report_error("hazardera", "invalid maxobjs", maxobjs);
+	return NULL;
+    }
+    uint32_t nrefs_rounded = roundup(nrefs);
+    uint32_t maxthreads = p64_idx_maxthreads();
+    size_t nbytes = sizeof(p64_hedomain_t) +
+		    nrefs_rounded * maxthreads * sizeof(uint64_t) +
+		    IDXMAP_NWORDS(maxthreads) * sizeof(uint64_t);
+    p64_hedomain_t *hed = p64_malloc(nbytes, CACHE_LINE);
+    if (hed != NULL)
+    {
+	hed->era = 1;
+	hed->nrefs = nrefs;
+	hed->maxobjs = maxobjs;
+	hed->high_wm = 0;
+	hed->maxthreads = maxthreads;
+	p64_memsrc_get(&hed->mem);
+	hed->registered = &hed->he[nrefs_rounded * maxthreads];
+	for (uint32_t i = 0; i < nrefs_rounded * maxthreads; i++)
+	{
+	    hed->he[i] = NONE;
+	}
+	for (uint32_t i = 0; i < IDXMAP_NWORDS(maxthreads); i++)
+	{
+	    hed->registered[i] = 0;
+	}
+	return hed;
+    }
+    return NULL;
+}
+
+void
+p64_hazera_free(p64_hedomain_t *hed)
+{
+    if (hed != NULL)
+    {
+	uint32_t nrefs_rounded = roundup(hed->nrefs);
+	uint32_t nthreads = __atomic_load_n(&hed->high_wm, __ATOMIC_ACQUIRE);
+	uint32_t t;
+	IDXMAP_FOREACH(hed->registered, nthreads, t)
+	{
+	    for (uint32_t i = 0; i < hed->nrefs; i++)
+	    {
+		if (hed->he[t * nrefs_rounded + i] != NONE)
+		{
+		    report_error("hazardera", "references still present",
+				 hed->he[t * nrefs_rounded + i]);
+		    return;
+		}
+	    }
+	}
+	p64_mfree(hed);
+    }
+}
+
+struct object
+{
+    void *ptr;
+    void (*cb)(void *);
+    uint64_t birth;//Era when object was allocated
+    uint64_t death;//Era when object was retired
+};
+
+struct thread_state
+{
+    p64_hedomain_t *hed;
+    uint32_t idx;//Thread index
+    uint32_t free;//Bitmask of free hazard eras
+    uint32_t nrefs;
+    uint64_t *he;//Ptr to actual hazard era array
+    //Scratch array for active eras, grown when more threads have registered
+    uint64_t *eras;
+    uint32_t maxeras;
+    //Removed but not yet reclaimed objects
+    uint32_t nobjs;
+    uint32_t maxobjs;
+    struct object objs[];
+} ALIGNED(CACHE_LINE);
+
+static THREAD_LOCAL struct thread_state *TS = NULL;
+
+void
+p64_hazera_register(p64_hedomain_t *hed)
+{
+    if (TS != NULL)
+    {
+	report_error("hazardera", "thread already registered", 0);
+	return;
+    }
+    //Attempt to allocate a thread index
+    int32_t idx = p64_idx_alloc();
+    if (idx < 0)
+    {
+	report_error("hazardera", "too many registered threads", 0);
+	return;
+    }
+    size_t nbytes = sizeof(struct thread_state) +
+		    hed->maxobjs * sizeof(struct object);
+    struct thread_state *ts = p64_malloc_src(&hed->mem, nbytes,
+					     CACHE_LINE);
+    if (ts == NULL)
+    {
+	report_error("hazardera", "failed to allocate thread-local data", 0);
+	p64_idx_free(idx);
+	return;
+    }
+    ts->hed = hed;
+    ts->idx = idx;
+    ts->free = bitmask(hed->nrefs);
+    ts->nrefs = hed->nrefs;
+    ts->he = &hed->he[idx * roundup(hed->nrefs)];
+    ts->eras = NULL;
+    ts->maxeras = 0;
+    ts->nobjs = 0;
+    ts->maxobjs = hed->maxobjs;
+    assert((uint32_t)idx < hed->maxthreads);
+    //Conditionally update high watermark of indexes
+    lockfree_fetch_umax_4(&hed->high_wm, (uint32_t)idx + 1, __ATOMIC_RELAXED);
+    idxmap_set(hed->registered, idx);
+    TS = ts;
+}
+
+void
+p64_hazera_unregister(void)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return;
+    }
+    if (TS->nobjs != 0)
+    {
+	report_error("hazardera", "thread has unreclaimed objects", TS->nobjs);
+	return;
+    }
+    if (TS->free != bitmask(TS->nrefs))
+    {
+	report_error("hazardera", "thread has allocated hazard eras", 0);
+	return;
+    }
+    idxmap_clr(TS->hed->registered, TS->idx);
+    p64_idx_free(TS->idx);
+    p64_mfree(TS->eras);
+    p64_mfree(TS);
+    TS = NULL;
+}
+
+uint64_t
+p64_hazera_birth(void)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return NONE;
+    }
+    return __atomic_load_n(&TS->hed->era, __ATOMIC_RELAXED);
+}
+
+void *
+p64_hazera_acquire(void **pptr, p64_hazardera_t *he)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return NULL;
+    }
+    if (*he == P64_HAZARDERA_NULL)
+    {
+	if (UNLIKELY(TS->free == 0))
+	{
+	    report_error("hazardera", "no free hazard eras", 0);
+	    return NULL;
+	}
+	uint32_t idx = __builtin_ctz(TS->free);
+	TS->free &= ~(1U << idx);
+	assert(TS->he[idx] == NONE);
+	*he = &TS->he[idx];
+    }
+    uint64_t *hazard = *he;
+    uint64_t prev = *hazard;
+    for (;;)
+    {
+	void *ptr = __atomic_load_n(pptr, __ATOMIC_ACQUIRE);
+	uint64_t era = __atomic_load_n(&TS->hed->era, __ATOMIC_ACQUIRE);
+	if (LIKELY(era == prev))
+	{
+	    //Our published era has not changed since we read the pointer, the
+	    //object cannot have been retired before our era was published
+	    return ptr;
+	}
+	__atomic_store_n(hazard, era, __ATOMIC_RELAXED);
+	//Ensure our hazard era is observable before we re-read the pointer
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	prev = era;
+    }
+}
+
+void
+p64_hazera_release(p64_hazardera_t *he)
+{
+    if (*he != P64_HAZARDERA_NULL)
+    {
+	if (UNLIKELY(TS == NULL))
+	{
+	    report_thread_not_registered();
+	    return;
+	}
+	uint32_t idx = *he - &TS->he[0];
+	if (UNLIKELY(idx >= TS->nrefs || (TS->free & (1U << idx)) != 0))
+	{
+	    report_error("hazardera", "invalid hazard era", *he);
+	    return;
+	}
+	//Reset hazard era
+	__atomic_store_n(*he, NONE, __ATOMIC_RELEASE);
+	TS->free |= 1U << idx;
+	*he = P64_HAZARDERA_NULL;
+    }
+}
+
+//Qsort call-back: compare two eras
+static int
+compare_era(const void *vpa,
+	    const void *vpb)
+{
+    const uint64_t *pa = vpa;
+    const uint64_t *pb = vpb;
+    return *pa < *pb ? -1 : *pa > *pb ? 1 : 0;
+}
+
+//Collect sorted active hazard eras from all registered threads
+static uint32_t
+collect_eras(uint64_t eras[],
+	     p64_hedomain_t *hed,
+	     uint32_t nthreads,
+	     uint32_t maxrefs)
+{
+    uint32_t nrefs = 0;
+    uint32_t nrefs_rounded = roundup(maxrefs);
+    uint32_t t;
+    IDXMAP_FOREACH(hed->registered, nthreads, t)
+    {
+	const uint64_t *he0 = &hed->he[t * nrefs_rounded];
+	for (uint32_t i = 0; i < maxrefs; i++)
+	{
+	    uint64_t era = __atomic_load_n(&he0[i], __ATOMIC_RELAXED);
+	    if (era != NONE)
+	    {
+		eras[nrefs++] = era;
+	    }
+	}
+    }
+    if (nrefs >= 2)
+    {
+	qsort(eras, nrefs, sizeof eras[0], compare_era);
+    }
+    return nrefs;
+}
+
+//Check if any hazard era lies in the lifetime of the object
+static bool
+find_era(const uint64_t eras[],
+	 uint32_t nrefs,
+	 uint64_t birth,
+	 uint64_t death)
+{
+    //Find first era not before birth of object
+    uint32_t lo = 0, hi = nrefs;
+    while (lo < hi)
+    {
+	uint32_t mid = lo + (hi - lo) / 2;
+	if (eras[mid] < birth)
+	{
+	    lo = mid + 1;
+	}
+	else
+	{
+	    hi = mid;
+	}
+    }
+    return lo < nrefs && eras[lo] <= death;
+}
+
+//Traverse all pending objects and reclaim those that have no references
+static uint32_t
+garbage_collect(void)
+{
+    uint32_t numthrs = __atomic_load_n(&TS->hed->high_wm, __ATOMIC_ACQUIRE);
+    uint32_t maxrefs = numthrs * TS->nrefs;
+    if (UNLIKELY(TS->eras == NULL || maxrefs > TS->maxeras))
+    {
+	uint64_t *eras = p64_malloc_src(&TS->hed->mem,
+					maxrefs * sizeof(uint64_t), 0);
+	if (UNLIKELY(eras == NULL))
+	{
+	    //Cannot scan, nothing reclaimed
+	    return TS->nobjs;
+	}
+	p64_mfree(TS->eras);
+	TS->eras = eras;
+	TS->maxeras = maxrefs;
+    }
+    uint64_t *eras = TS->eras;
+    //Order removal of objects before reading hazard eras, pairs with fence
+    //in p64_hazera_acquire()
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint32_t nrefs = collect_eras(eras, TS->hed, numthrs, TS->nrefs);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    //Traverse list of pending objects
+    uint32_t nobjs = 0;
+    for (uint32_t i = 0; i < TS->nobjs; i++)
+    {
+	struct object obj = TS->objs[i];
+	if (!find_era(eras, nrefs, obj.birth, obj.death))
+	{
+	    //No thread published an era in the lifetime of the object
+	    obj.cb(obj.ptr);
+	}
+	else
+	{
+	    //Retired object possibly still referenced, keep it
+	    TS->objs[nobjs++] = obj;
+	}
+    }
+    TS->nobjs = nobjs;
+    return nobjs;
+}
+
+bool
+p64_hazera_retire(void *ptr,
+		  uint64_t birth,
+		  void (*cb)(void *ptr))
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return false;
+    }
+    if (UNLIKELY(TS->nobjs == TS->maxobjs))
+    {
+	if (garbage_collect() == TS->maxobjs)
+	{
+	    return false;//No space for object
+	}
+    }
+    assert(TS->nobjs < TS->maxobjs);
+    //Advance the era clock, readers which publish the new era cannot
+    //observe the removed object
+    uint64_t death = __atomic_fetch_add(&TS->hed->era, 1, __ATOMIC_RELEASE);
+    uint32_t i = TS->nobjs++;
+    TS->objs[i].ptr = ptr;
+    TS->objs[i].cb = cb;
+    TS->objs[i].birth = birth;
+    TS->objs[i].death = death;
+    return true;
+}
+
+uint32_t
+p64_hazera_reclaim(void)
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return 0;
+    }
+    if (TS->nobjs == 0)
+    {
+	//Nothing to reclaim
+	return 0;
+    }
+    return garbage_collect();
+}
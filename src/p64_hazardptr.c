@@ -9,7 +9,6 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
-#include <stdlib.h>
 
 #include "p64_hazardptr.h"
 #undef p64_hazptr_acquire
@@ -21,6 +20,7 @@
 #include "lockfree.h"
 #include "common.h"
 #include "thr_idx.h"
+#include "reclaimer.h"
 
 #ifdef HP_ZEROREF_QSBR
 #define HAS_QSBR(ptr)          ((uintptr_t)(ptr) & 1)
@@ -31,7 +31,6 @@
 #endif
 
 #define report_thread_not_registered hp_report_thread_not_registered
-#define object hp_object
 #define thread_state hp_thread_state
 #define TS hp_TS
 #define alloc_ts hp_alloc_ts
@@ -57,6 +56,14 @@ struct hazard_pointer
     userptr_t ref;
 };
 
+//Scratch space for scans, array of active references followed by hash set
+//Grown when more threads have registered, reused between scans
+struct scan_buf
+{
+    userptr_t *refs;
+    uint32_t maxrefs;
+};
+
 static inline uint32_t
 roundup(uint32_t n)
 {
@@ -68,6 +75,11 @@ struct p64_hpdomain
     uint32_t nrefs;//Number of references per thread
     uint32_t maxobjs;
     uint32_t high_wm;//High watermark of thread index
+    uint32_t maxthreads;
+    p64_reclaimer_t *rcl;//Optional background reclaimer
+    struct scan_buf rclbuf;//Only used by the reclaimer
+    p64_memsrc_t mem;//Source of thread state and scan buffers
+    uint64_t *registered;//Bitmap of registered threads
     struct hazard_pointer hp[] ALIGNED(CACHE_LINE);
 };
 
@@ -91,18 +103,30 @@ p64_hazptr_alloc(uint32_t maxobjs, uint32_t nrefs)
 	return NULL;
     }
     uint32_t nrefs_rounded = roundup(nrefs);
+    uint32_t maxthreads = p64_idx_maxthreads();
     size_t nbytes = sizeof(p64_hpdomain_t) +
-		    nrefs_rounded * MAXTHREADS * sizeof(struct hazard_pointer);
+		    nrefs_rounded * maxthreads * sizeof(struct hazard_pointer) +
+		    IDXMAP_NWORDS(maxthreads) * sizeof(uint64_t);
     p64_hpdomain_t *hpd = p64_malloc(nbytes, CACHE_LINE);
     if (hpd != NULL)
     {
 	hpd->nrefs = nrefs;
 	hpd->maxobjs = maxobjs;
 	hpd->high_wm = 0;
-	for (uint32_t i = 0; i < nrefs_rounded * MAXTHREADS; i++)
+	hpd->maxthreads = maxthreads;
+	hpd->rcl = NULL;
+	hpd->rclbuf.refs = NULL;
+	hpd->rclbuf.maxrefs = 0;
+	p64_memsrc_get(&hpd->mem);
+	hpd->registered = (uint64_t *)&hpd->hp[nrefs_rounded * maxthreads];
+	for (uint32_t i = 0; i < nrefs_rounded * maxthreads; i++)
 	{
 	    hpd->hp[i].ref = NULL;
 	}
+	for (uint32_t i = 0; i < IDXMAP_NWORDS(maxthreads); i++)
+	{
+	    hpd->registered[i] = 0;
+	}
 	return hpd;
     }
     return NULL;
@@ -120,7 +144,8 @@ p64_hazptr_free(p64_hpdomain_t *hpd)
 #endif
     uint32_t nrefs_rounded = roundup(hpd->nrefs);
     uint32_t nthreads = __atomic_load_n(&hpd->high_wm, __ATOMIC_ACQUIRE);
-    for (uint32_t t = 0; t < nthreads; t++)
+    uint32_t t;
+    IDXMAP_FOREACH(hpd->registered, nthreads, t)
     {
 	for (uint32_t i = 0; i < hpd->nrefs; i++)
 	{
@@ -132,14 +157,22 @@ p64_hazptr_free(p64_hpdomain_t *hpd)
 	    }
 	}
     }
+    p64_mfree(hpd->rclbuf.refs);
     p64_mfree(hpd);
 }
 
-struct object
+void
+p64_hazptr_set_reclaimer(p64_hpdomain_t *hpd, p64_reclaimer_t *rcl)
 {
-    userptr_t ptr;
-    void (*cb)(userptr_t);
-};
+#ifdef HP_ZEROREF_QSBR
+    if (HAS_QSBR(hpd))
+    {
+	p64_qsbr_set_reclaimer(CLR_QSBR(hpd), rcl);
+	return;
+    }
+#endif
+    __atomic_store_n(&hpd->rcl, rcl, __ATOMIC_RELAXED);
+}
 
 //File & line annotation for debugging
 struct file_line
@@ -159,7 +192,8 @@ struct thread_state
     //Removed but not yet reclaimed objects
     uint32_t nobjs;
     uint32_t maxobjs;
-    struct object objs[];
+    struct scan_buf buf;
+    struct reclaim_object objs[];
     //File&line array follows
 } ALIGNED(CACHE_LINE);
 
@@ -178,9 +212,10 @@ alloc_ts(p64_hpdomain_t *hpd)
     }
 
     size_t nbytes = sizeof(struct thread_state) +
-		    hpd->maxobjs * sizeof(struct object) +
+		    hpd->maxobjs * sizeof(struct reclaim_object) +
 		    hpd->nrefs * sizeof(struct file_line);
-    struct thread_state *ts = p64_malloc(nbytes, CACHE_LINE);
+    struct thread_state *ts = p64_malloc_src(&hpd->mem, nbytes,
+					     CACHE_LINE);
     if (ts == NULL)
     {
 	report_error("hazardptr", "failed to allocate thread-local data", 0);
@@ -195,13 +230,17 @@ alloc_ts(p64_hpdomain_t *hpd)
     ts->fl = (void *)&ts->objs[hpd->maxobjs];
     ts->nobjs = 0;
     ts->maxobjs = hpd->maxobjs;
+    ts->buf.refs = NULL;
+    ts->buf.maxrefs = 0;
     for (uint32_t i = 0; i < hpd->nrefs; i++)
     {
 	ts->fl[i].file = NULL;
 	ts->fl[i].line = 0;
     }
+    assert((uint32_t)idx < hpd->maxthreads);
     //Conditionally update high watermark of indexes
     lockfree_fetch_umax_4(&hpd->high_wm, (uint32_t)idx + 1, __ATOMIC_RELAXED);
+    idxmap_set(hpd->registered, idx);
     return ts;
 }
 
@@ -290,7 +329,9 @@ p64_hazptr_unregister(void)
 	return;
     }
     p64_hazptr_deactivate();
+    idxmap_clr(TS->hpd->registered, TS->idx);
     p64_idx_free(TS->idx);
+    p64_mfree(TS->buf.refs);
     p64_mfree(TS);
     TS = NULL;
 }
@@ -632,140 +673,198 @@ p64_hazptr_release_ro(p64_hazardptr_t *hp)
     }
 }
 
-//Qsort call-back: compare two pointers
-static int
-compare_ptr(const void *vpa,
-	    const void *vpb)
-{
-    //Compare pointers using uintptr_t types to avoid undefined behaviour
-    //when comparing pointers
-    const uintptr_t *upa = vpa;
-    const uintptr_t *upb = vpb;
-    return *upa < *upb ? -1 : *upa > *upb ? 1 : 0;
-}
-
-//Collect active references from all threads
+//Collect active references from all registered threads
 static uint32_t
 collect_refs(userptr_t refs[],
-	     struct hazard_pointer hp[],
+	     p64_hpdomain_t *hpd,
 	     uint32_t nthreads,
 	     uint32_t maxrefs)
 {
     uint32_t nrefs = 0;
     uint32_t nrefs_rounded = roundup(maxrefs);
     uint32_t t;
-    for (t = 0; t + 1 < nthreads;)
+    ASSUME(maxrefs != 0);
+    IDXMAP_FOREACH(hpd->registered, nthreads, t)
     {
-	//Unroll loop to create some memory level parallelism
-	userptr_t *hp0 = &hp[t++ * nrefs_rounded].ref;
-	userptr_t *hp1 = &hp[t++ * nrefs_rounded].ref;
-	ASSUME(maxrefs != 0);
+	userptr_t *hp0 = &hpd->hp[t * nrefs_rounded].ref;
 	for (uint32_t i = 0; i < maxrefs; i++)
 	{
 	    //Read the hazard pointers atomically but using relaxed semantics
 	    //since we don't care about any ordering vs. the SEQ_CST write
-	    userptr_t ptr0 = __atomic_load_n(hp0, __ATOMIC_RELAXED);
-	    userptr_t ptr1 = __atomic_load_n(hp1, __ATOMIC_RELAXED);
-	    hp0++;
-	    hp1++;
+	    userptr_t ptr0 = __atomic_load_n(&hp0[i], __ATOMIC_RELAXED);
 	    if (ptr0 != NULL)
 	    {
 		refs[nrefs++] = ptr0;
 	    }
-	    if (ptr1 != NULL)
-	    {
-		refs[nrefs++] = ptr1;
-	    }
 	}
     }
-    //Handle any trailing element
-    if (t < nthreads)
+    return nrefs;
+}
+
+//Hash a reference, the upper bits of the product are well mixed
+static inline uint32_t
+hash_ref(userptr_t ptr)
+{
+    uint64_t h = (uint64_t)(uintptr_t)ptr * UINT64_C(0x9E3779B97F4A7C15);
+    return (uint32_t)(h >> 32);
+}
+
+//Insert the active references into an open addressing hash set with linear
+//probing, the set has at least twice as many slots as there are references
+//so probe sequences stay short
+static void
+build_refset(userptr_t set[],
+	     uint32_t mask,
+	     const userptr_t refs[],
+	     uint32_t nrefs)
+{
+    for (uint32_t i = 0; i <= mask; i++)
     {
-	userptr_t *hp0 = &hp[t * nrefs_rounded].ref;
-	for (uint32_t i = 0; i < maxrefs; i++)
-	{
-	    userptr_t ptr0 = __atomic_load_n(hp0, __ATOMIC_RELAXED);
-	    hp0++;
-	    if (ptr0 != NULL)
-	    {
-		refs[nrefs++] = ptr0;
-	    }
-	}
+	set[i] = NULL;
     }
-    if (nrefs >= 2)
+    for (uint32_t i = 0; i < nrefs; i++)
     {
-	qsort(refs, nrefs, sizeof refs[0], compare_ptr);
+	uint32_t h = hash_ref(refs[i]) & mask;
+	//Duplicate references (same object referenced by multiple hazard
+	//pointers) are only inserted once
+	while (set[h] != NULL && set[h] != refs[i])
+	{
+	    h = (h + 1) & mask;
+	}
+	set[h] = refs[i];
     }
-    return nrefs;
 }
 
-//Check if a specific reference exists in the array
-static bool
-find_ptr(userptr_t refs[],
-	 uint32_t nrefs,
+//Check if a specific reference exists in the set
+static inline bool
+find_ptr(const userptr_t set[],
+	 uint32_t mask,
 	 userptr_t ptr)
 {
-    assert((int32_t)nrefs >= 0);
-    if (nrefs != 0)
+    uint32_t h = hash_ref(ptr) & mask;
+    for (;;)
     {
-	uint32_t half = nrefs / 2;
-	if (ptr < refs[half])
+	if (set[h] == ptr)
 	{
-	    return find_ptr(refs, half, ptr);
+	    return true;
 	}
-	else if (ptr > refs[half])
+	if (set[h] == NULL)
 	{
-	    assert(nrefs >= half + 1);
-	    return find_ptr(refs + half + 1, nrefs - half - 1, ptr);
-	}
-	else//ptr == refs[half]
-	{
-	    return true;
+	    return false;
 	}
+	h = (h + 1) & mask;
     }
-    return false;
 }
 
-//Traverse all pending objects and reclaim those that have no references
-static uint32_t
-garbage_collect(void)
+//Ensure scratch space for 'maxrefs' references and their hash set
+static bool
+scan_buf_reserve(p64_hpdomain_t *hpd, struct scan_buf *buf, uint32_t maxrefs)
 {
-    PREFETCH_FOR_READ(       &TS->hpd->hp[0]);
-    PREFETCH_FOR_READ((char*)&TS->hpd->hp[0] + CACHE_LINE);
-    uint32_t numthrs = __atomic_load_n(&TS->hpd->high_wm, __ATOMIC_ACQUIRE);
-    uint32_t maxrefs = numthrs * TS->nrefs;
-    userptr_t refs[maxrefs];
-    //Get sorted list of active references
-    uint32_t nrefs = collect_refs(refs, TS->hpd->hp, numthrs, TS->nrefs);
+    if (LIKELY(buf->refs != NULL && maxrefs <= buf->maxrefs))
+    {
+	return true;
+    }
+    size_t nbytes = (maxrefs + ROUNDUP_POW2(2 * maxrefs)) * sizeof(userptr_t);
+    userptr_t *refs = p64_malloc_src(&hpd->mem, nbytes, 0);
+    if (UNLIKELY(refs == NULL))
+    {
+	return false;
+    }
+    p64_mfree(buf->refs);
+    buf->refs = refs;
+    buf->maxrefs = maxrefs;
+    return true;
+}
+
+//Reclaim those objects which are not referenced by any hazard pointer in
+//the domain, remaining objects are compacted
+//Return number of remaining unreclaimed objects
+static uint32_t
+scan_objects(p64_hpdomain_t *hpd,
+	     uint32_t nrefs_thr,
+	     struct scan_buf *buf,
+	     struct reclaim_object objs[],
+	     uint32_t nobjs)
+{
+    PREFETCH_FOR_READ(       &hpd->hp[0]);
+    PREFETCH_FOR_READ((char*)&hpd->hp[0] + CACHE_LINE);
+    uint32_t numthrs = __atomic_load_n(&hpd->high_wm, __ATOMIC_ACQUIRE);
+    uint32_t maxrefs = numthrs * nrefs_thr;
+    if (UNLIKELY(!scan_buf_reserve(hpd, buf, maxrefs)))
+    {
+	//Cannot scan, nothing reclaimed
+	return nobjs;
+    }
+    userptr_t *refs = buf->refs;
+    //Get list of active references
+    uint32_t nrefs = collect_refs(refs, hpd, numthrs, nrefs_thr);
+    //Build hash set of active references, cost is linear in the number of
+    //active references and each lookup below is O(1) expected
+    uint32_t mask = ROUNDUP_POW2(2 * nrefs) - 1;
+    userptr_t *set = &refs[buf->maxrefs];
+    build_refset(set, mask, refs, nrefs);
     //Traverse list of pending objects
-    uint32_t nobjs = 0;
-    for (uint32_t i = 0; i < TS->nobjs; i++)
+    uint32_t nremaining = 0;
+    for (uint32_t i = 0; i < nobjs; i++)
     {
-	struct object obj = TS->objs[i];
-	if (!find_ptr(refs, nrefs, obj.ptr))
+	struct reclaim_object obj = objs[i];
+	if (!find_ptr(set, mask, obj.ptr))
 	{
-	    for (uint32_t j = 0; j < nrefs; j++)
-	    {
-		assert(refs[j] != obj.ptr);
-	    }
 	    //No references found to retired object, reclaim it
 	    obj.cb(obj.ptr);
 	}
 	else
 	{
 	    //Retired object still referenced, keep it in rlist
-	    TS->objs[nobjs++] = obj;
+	    objs[nremaining++] = obj;
 	}
     }
+    return nremaining;
+}
+
+//Traverse all pending objects and reclaim those that have no references
+static uint32_t
+garbage_collect(void)
+{
     //Some objects may remain in the list of retired objects
-    TS->nobjs = nobjs;
+    TS->nobjs = scan_objects(TS->hpd, TS->nrefs, &TS->buf,
+			     TS->objs, TS->nobjs);
     //Return number of remaining unreclaimed objects
     //Caller can compute number of available slots
-    return nobjs;
+    return TS->nobjs;
+}
+
+//Reclaim a batch of objects handed off to a reclaimer
+static uint32_t
+reclaim_hp_batch(struct reclaim_batch *batch)
+{
+    p64_hpdomain_t *hpd = batch->domain;
+    return scan_objects(hpd, hpd->nrefs, &hpd->rclbuf,
+			batch->objs, batch->nobjs);
+}
+
+//Hand off all pending objects to a reclaimer
+//Return true if successful
+static bool
+hp_handoff(p64_reclaimer_t *rcl)
+{
+    struct reclaim_batch *batch = reclaimer_batch_get(rcl, TS->nobjs);
+    if (UNLIKELY(batch == NULL))
+    {
+	return false;
+    }
+    batch->reclaim = reclaim_hp_batch;
+    batch->domain = TS->hpd;
+    memcpy(batch->objs, TS->objs, TS->nobjs * sizeof(struct reclaim_object));
+    batch->nobjs = TS->nobjs;
+    reclaimer_handoff(rcl, batch);
+    TS->nobjs = 0;
+    return true;
 }
 
 //Retire an object
-//If necessary, perform garbage collection on retired objects
+//If necessary, hand off retired objects to the reclaimer or perform garbage
+//collection on retired objects
 bool
 p64_hazptr_retire(void *ptr,
 		  void (*cb)(void *ptr))
@@ -783,7 +882,13 @@ p64_hazptr_retire(void *ptr,
 #endif
     if (UNLIKELY(TS->nobjs == TS->maxobjs))
     {
-	if (garbage_collect() == TS->maxobjs)
+	p64_reclaimer_t *rcl = __atomic_load_n(&TS->hpd->rcl,
+					       __ATOMIC_RELAXED);
+	if (rcl != NULL && hp_handoff(rcl))
+	{
+	    //Retired objects will be reclaimed by the reclaimer
+	}
+	else if (garbage_collect() == TS->maxobjs)
 	{
 	    return false;//No space for object
 	}
@@ -825,7 +930,6 @@ p64_hazptr_reclaim(void)
 }
 
 #undef report_thread_not_registered
-#undef object
 #undef thread_state
 #undef TS
 #undef alloc_ts
@@ -11,6 +11,7 @@
 #include "p64_hopscotch.h"
 #undef p64_hopscotch_lookup
 #undef p64_hopscotch_remove_by_key
+#include "p64_ebr.h"
 #include "p64_hazardptr.h"
 #include "p64_qsbr.h"
 #include "build_config.h"
@@ -19,6 +20,7 @@
 #include "os_abstraction.h"
 #include "err_hnd.h"
 #include "atomic.h"
+#include "hashstats.h"
 
 typedef size_t bix_t;
 
@@ -113,6 +115,8 @@ struct p64_hopscotch
     bix_t nbkts;
     bix_t ncells;
     uint8_t use_hp;
+    uint8_t use_ebr;
+    struct hashstats *stats;//NULL unless statistics enabled
     struct cell *cellar;//Pointer to cell array
     struct bucket buckets[] ALIGNED(CACHE_LINE);
     //Cell array follows the last bucket
@@ -142,6 +146,32 @@ atomic_ptr_release(p64_hazardptr_t *hp, bool use_hp)
     }
 }
 
+static inline void
+smr_enter(p64_hopscotch_t *ht)
+{
+    if (UNLIKELY(ht->use_ebr))
+    {
+	p64_ebr_enter();
+    }
+    else if (LIKELY(!ht->use_hp))
+    {
+	p64_qsbr_acquire();
+    }
+}
+
+static inline void
+smr_exit(p64_hopscotch_t *ht)
+{
+    if (UNLIKELY(ht->use_ebr))
+    {
+	p64_ebr_exit();
+    }
+    else if (LIKELY(!ht->use_hp))
+    {
+	p64_qsbr_release();
+    }
+}
+
 void
 p64_hopscotch_traverse(p64_hopscotch_t *ht,
 		       p64_hopscotch_trav_cb cb,
@@ -157,9 +187,9 @@ p64_hopscotch_traverse(p64_hopscotch_t *ht,
 	{
 	    if (!ht->use_hp)
 	    {
-		p64_qsbr_acquire();
+		smr_enter(ht);
 		cb(arg, elem, idx);
-		p64_qsbr_release();
+		smr_exit(ht);
 	    }
 	    else
 	    {
@@ -178,9 +208,9 @@ p64_hopscotch_traverse(p64_hopscotch_t *ht,
 	{
 	    if (!ht->use_hp)
 	    {
-		p64_qsbr_acquire();
+		smr_enter(ht);
 		cb(arg, elem, idx | CELLAR_BIT);
-		p64_qsbr_release();
+		smr_exit(ht);
 	    }
 	    else
 	    {
@@ -282,7 +312,8 @@ p64_hopscotch_check(p64_hopscotch_t *ht)
     printf("%zu (%.3f) neighbourhoods are completely full\n", nfull, nfull / (float)ht->nbkts);
 }
 
-#define VALID_FLAGS P64_HOPSCOTCH_F_HP
+#define VALID_FLAGS (P64_HOPSCOTCH_F_HP | P64_HOPSCOTCH_F_STATS | \
+		     P64_HOPSCOTCH_F_EBR)
 
 p64_hopscotch_t *
 p64_hopscotch_alloc(size_t nbkts,
@@ -300,6 +331,12 @@ p64_hopscotch_alloc(size_t nbkts,
 	report_error("hopscotch", "invalid flags", flags);
 	return NULL;
     }
+    if (UNLIKELY((flags & P64_HOPSCOTCH_F_HP) != 0 &&
+		 (flags & P64_HOPSCOTCH_F_EBR) != 0))
+    {
+	report_error("hopscotch", "conflicting SMR flags", flags);
+	return NULL;
+    }
     size_t sz = sizeof(p64_hopscotch_t) +
 		sizeof(struct bucket) * nbkts +
 		sizeof(struct cell) * ncells;
@@ -311,9 +348,19 @@ p64_hopscotch_alloc(size_t nbkts,
 	ht->nbkts = nbkts;
 	ht->ncells = ncells;
 	ht->use_hp = (flags & P64_HOPSCOTCH_F_HP) != 0;
+	ht->use_ebr = (flags & P64_HOPSCOTCH_F_EBR) != 0;
 	ht->cellar = (struct cell *)&ht->buckets[nbkts];
 	//All buckets already cleared (NULL elements pointers & null bitmaps)
 	//All cells already cleared (NULL element pointers)
+	if ((flags & P64_HOPSCOTCH_F_STATS) != 0)
+	{
+	    ht->stats = hashstats_alloc();
+	    if (ht->stats == NULL)
+	    {
+		p64_mfree(ht);
+		return NULL;
+	    }
+	}
     }
     return ht;
 }
@@ -345,6 +392,7 @@ p64_hopscotch_free(p64_hopscotch_t *ht)
 		return;
 	    }
 	}
+	hashstats_free(ht->stats);
 	p64_mfree(ht);
     }
 }
@@ -410,6 +458,7 @@ lookup(p64_hopscotch_t *ht,
        bool use_hp,
        bool check_key)
 {
+    uint32_t nprobes = 0;
     union bmc cur;
     cur.atom = atomic_load_n(&ht->buckets[bix].bmc.atom, __ATOMIC_ACQUIRE);
     while (cur.bitmap != 0)
@@ -418,6 +467,7 @@ lookup(p64_hopscotch_t *ht,
 	//elements which hash to this bucket
 	uint32_t bit = __builtin_ctz(cur.bitmap);
 	bix_t idx = ring_add(bix, bit, ht->nbkts);
+	nprobes++;
 	union bmc elem_bmc;
 	void *elem = atomic_load_acquire(&ht->buckets[idx].elem,
 					 hazpp,
@@ -426,6 +476,9 @@ lookup(p64_hopscotch_t *ht,
 	if (LIKELY(elem != NULL))
 	{
 #if SIG_BITS != 0
+	    //Signatures are stored one per bucket in the bmc word, a SIMD
+	    //compare would need a strided gather over the neighbourhood
+	    //while the bitmap already limits probes to matching buckets
 	    uint32_t sig = hash_to_sig(hash);
 	    if (LIKELY(elem_bmc.sig == sig))
 #endif
@@ -436,6 +489,7 @@ lookup(p64_hopscotch_t *ht,
 		    {
 			//Found our element
 			//Keep hazard pointer set
+			hashstats_lookup(ht->stats, nprobes, true);
 			return elem;
 		    }
 		    //Else false positive
@@ -443,6 +497,7 @@ lookup(p64_hopscotch_t *ht,
 		else//Check key later
 		{
 		    PREFETCH_FOR_READ(elem);
+		    hashstats_lookup(ht->stats, nprobes, true);
 		    return elem;
 		}
 	    }
@@ -468,14 +523,17 @@ lookup(p64_hopscotch_t *ht,
     }
     if (cur.cellar)
     {
+	nprobes++;
 	void *elem = search_cellar(ht, key, hash, hazpp, use_hp, check_key);
 	if (elem)
 	{
 	    //Found our element
 	    //Keep hazard pointer set
+	    hashstats_lookup(ht->stats, nprobes, true);
 	    return elem;
 	}
     }
+    hashstats_lookup(ht->stats, nprobes, false);
     return NULL;
 }
 
@@ -763,9 +821,11 @@ move_elem(p64_hopscotch_t *ht,
 	    atomic_store_ptr(&ht->buckets[src_idx].elem,
 			     NULL, __ATOMIC_RELAXED);
 	    *empty = src_idx;
+	    hashstats_add(ht->stats, HS_RELOC, 1);
 	    return move_ok;
 	}
 	//Else home_bix bitmap changed, our element could have been moved
+	hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 	//Undo move
 	atomic_store_ptr(&ht->buckets[dst_idx].elem, NULL, __ATOMIC_RELAXED);
 	//Restart from beginning
@@ -865,25 +925,76 @@ insert_cell(p64_hopscotch_t *ht,
     return false;
 }
 
+static inline bool
+insert_one(p64_hopscotch_t *ht,
+	   void *elem,
+	   p64_hopschash_t hash)
+{
+    if (LIKELY(insert_bkt(ht, elem, hash)))
+    {
+	hashstats_add(ht->stats, HS_INSERT, 1);
+	return true;
+    }
+    if (insert_cell(ht, elem, hash))
+    {
+	hashstats_add(ht->stats, HS_INSERT, 1);
+	hashstats_add(ht->stats, HS_CELLAR_INS, 1);
+	return true;
+    }
+    hashstats_add(ht->stats, HS_INSERT_FAIL, 1);
+    return false;
+}
+
 bool
 p64_hopscotch_insert(p64_hopscotch_t *ht,
 		     void *elem,
 		     p64_hopschash_t hash)
 {
-    if (LIKELY(!ht->use_hp))
-    {
-	p64_qsbr_acquire();
-    }
-    bool success = insert_bkt(ht, elem, hash);
-    if (UNLIKELY(!success))
+    smr_enter(ht);
+    bool success = insert_one(ht, elem, hash);
+    smr_exit(ht);
+    return success;
+}
+
+//Prefetch bucket metadata for all elements before doing any CAS so that the
+//cache misses overlap
+static void
+prefetch_vec(p64_hopscotch_t *ht,
+	     uint32_t num,
+	     p64_hopschash_t hashes[num])
+{
+    for (uint32_t i = 0; i < num; i++)
     {
-	success = insert_cell(ht, elem, hash);
+	bix_t bix = ring_mod(hashes[i], ht->nbkts);
+	PREFETCH_FOR_WRITE((char *)&ht->buckets[bix]);
+	//The neighbourhood of a bucket extends into the next cache line where
+	//displaced elements and free buckets are found, prefetch it only for
+	//small vectors so the number of outstanding prefetches stays within
+	//what the cache can track (like p64_hopscotch_lookup_vec())
+	if (num <= 8)
+	{
+	    PREFETCH_FOR_WRITE((char *)&ht->buckets[bix] + CACHE_LINE);
+	}
     }
-    if (LIKELY(!ht->use_hp))
+}
+
+uint32_t
+p64_hopscotch_insert_vec(p64_hopscotch_t *ht,
+			 uint32_t num,
+			 void *elems[num],
+			 p64_hopschash_t hashes[num],
+			 bool success[num])
+{
+    prefetch_vec(ht, num, hashes);
+    smr_enter(ht);
+    uint32_t ninserted = 0;
+    for (uint32_t i = 0; i < num; i++)
     {
-	p64_qsbr_release();
+	success[i] = insert_one(ht, elems[i], hashes[i]);
+	ninserted += success[i];
     }
-    return success;
+    smr_exit(ht);
+    return ninserted;
 }
 
 static bool
@@ -931,6 +1042,7 @@ remove_bkt_by_ptr(p64_hopscotch_t *ht,
 		    return true;
 		}
 		//Else bitmap changed
+		hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 		break;//Quit inner loop early
 	    }
 	    //Clear least significant bit
@@ -979,25 +1091,54 @@ remove_cell_by_ptr(p64_hopscotch_t *ht,
     return false;
 }
 
-bool
-p64_hopscotch_remove(p64_hopscotch_t *ht,
-		     void *elem,
-		     p64_hopschash_t hash)
+static inline bool
+remove_one(p64_hopscotch_t *ht,
+	   void *elem,
+	   p64_hopschash_t hash)
 {
-    if (LIKELY(!ht->use_hp))
+    if (LIKELY(remove_bkt_by_ptr(ht, elem, hash)))
     {
-	p64_qsbr_acquire();
+	hashstats_add(ht->stats, HS_REMOVE, 1);
+	return true;
     }
-    bool success = remove_bkt_by_ptr(ht, elem, hash);
-    if (UNLIKELY(!success))
+    if (remove_cell_by_ptr(ht, elem, hash))
     {
-	success = remove_cell_by_ptr(ht, elem, hash);
+	hashstats_add(ht->stats, HS_REMOVE, 1);
+	hashstats_add(ht->stats, HS_CELLAR_REM, 1);
+	return true;
     }
-    if (LIKELY(!ht->use_hp))
+    hashstats_add(ht->stats, HS_REMOVE_FAIL, 1);
+    return false;
+}
+
+bool
+p64_hopscotch_remove(p64_hopscotch_t *ht,
+		     void *elem,
+		     p64_hopschash_t hash)
+{
+    smr_enter(ht);
+    bool success = remove_one(ht, elem, hash);
+    smr_exit(ht);
+    return success;
+}
+
+uint32_t
+p64_hopscotch_remove_vec(p64_hopscotch_t *ht,
+			 uint32_t num,
+			 void *elems[num],
+			 p64_hopschash_t hashes[num],
+			 bool success[num])
+{
+    prefetch_vec(ht, num, hashes);
+    smr_enter(ht);
+    uint32_t nremoved = 0;
+    for (uint32_t i = 0; i < num; i++)
     {
-	p64_qsbr_release();
+	success[i] = remove_one(ht, elems[i], hashes[i]);
+	nremoved += success[i];
     }
-    return success;
+    smr_exit(ht);
+    return nremoved;
 }
 
 static void *
@@ -1056,6 +1197,7 @@ remove_bkt_by_key(p64_hopscotch_t *ht,
 			    return elem;
 			}
 			//Else bitmap changed
+			hashstats_add(ht->stats, HS_CAS_RETRY, 1);
 			break;//Quit inner loop early
 		    }
 		    //Else false positive
@@ -1126,18 +1268,38 @@ p64_hopscotch_remove_by_key(p64_hopscotch_t *ht,
 			    p64_hazardptr_t *hazpp)
 {
     //Caller must call QSBR acquire/release/quiescent as appropriate
-    if (LIKELY(!ht->use_hp))
+    smr_enter(ht);
+    void *elem = remove_bkt_by_key(ht, key, hash, hazpp);
+    if (LIKELY(elem != NULL))
     {
-	p64_qsbr_acquire();
+	hashstats_add(ht->stats, HS_REMOVE, 1);
     }
-    void *elem = remove_bkt_by_key(ht, key, hash, hazpp);
-    if (UNLIKELY(!elem))
+    else
     {
 	elem = remove_cell_by_key(ht, key, hash, hazpp);
+	if (elem != NULL)
+	{
+	    hashstats_add(ht->stats, HS_REMOVE, 1);
+	    hashstats_add(ht->stats, HS_CELLAR_REM, 1);
+	}
+	else
+	{
+	    hashstats_add(ht->stats, HS_REMOVE_FAIL, 1);
+	}
     }
-    if (LIKELY(!ht->use_hp))
+    smr_exit(ht);
+    return elem;
+}
+
+void
+p64_hopscotch_stats(p64_hopscotch_t *ht,
+		    p64_hashstats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    if (ht->stats != NULL)
     {
-	p64_qsbr_release();
+	hashstats_read(ht->stats, st);
     }
-    return elem;
+    st->capacity = ht->nbkts;
+    st->cellar_size = ht->ncells;
 }
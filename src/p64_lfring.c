@@ -15,9 +15,12 @@
 #include "atomic.h"
 #include "common.h"
 #include "err_hnd.h"
+#include "ringset.h"
+#include "ringwait.h"
 
 #define SUPPORTED_FLAGS (P64_LFRING_F_SPENQ | P64_LFRING_F_MPENQ | \
-			 P64_LFRING_F_SCDEQ | P64_LFRING_F_MCDEQ)
+			 P64_LFRING_F_SCDEQ | P64_LFRING_F_MCDEQ | \
+			 P64_LFRING_F_WAIT)
 
 typedef uintptr_t ringidx_t;
 struct element
@@ -36,42 +39,102 @@ struct p64_lfring
 #endif
     uint32_t mask;
     uint32_t flags;
+    struct ringset_member *member;//Ring set to mark on enqueue
+    uint32_t notempty ALIGNED(CACHE_LINE);//Futex word for waiting consumers
+    uint32_t notfull;//Futex word for waiting producers
     struct element ring[] ALIGNED(CACHE_LINE);
 } ALIGNED(CACHE_LINE);
 
-p64_lfring_t *
-p64_lfring_alloc(uint32_t nelems, uint32_t flags)
+static bool
+check_params(uint32_t nelems, uint32_t flags)
 {
     unsigned long ringsz = ROUNDUP_POW2(nelems);
     if (nelems == 0 || ringsz == 0 || ringsz > 0x80000000)
     {
 	report_error("lfring", "invalid number of elements", nelems);
-	return NULL;
+	return false;
     }
     if ((flags & ~SUPPORTED_FLAGS) != 0)
     {
 	report_error("lfring", "invalid flags", flags);
-	return NULL;
+	return false;
     }
+    return true;
+}
 
-    size_t nbytes = sizeof(p64_lfring_t) + ringsz * sizeof(struct element);
-    p64_lfring_t *lfr = p64_malloc(nbytes, CACHE_LINE);
-    if (lfr != NULL)
+static p64_lfring_t *
+init_ring(void *mem, uint32_t nelems, uint32_t flags)
+{
+    p64_lfring_t *lfr = mem;
+    unsigned long ringsz = ROUNDUP_POW2(nelems);
+    lfr->head = 0;
+    lfr->tail = 0;
+    lfr->mask = ringsz - 1;
+    lfr->flags = flags;
+    lfr->member = NULL;
+    lfr->notempty = 0;
+    lfr->notfull = 0;
+    for (ringidx_t i = 0; i < ringsz; i++)
     {
-	lfr->head = 0;
-	lfr->tail = 0;
-	lfr->mask = ringsz - 1;
-	lfr->flags = flags;
-	for (ringidx_t i = 0; i < ringsz; i++)
-	{
-	    lfr->ring[i].ptr = NULL;
-	    lfr->ring[i].idx = i - ringsz;
-	}
-	return lfr;
+	lfr->ring[i].ptr = NULL;
+	lfr->ring[i].idx = i - ringsz;
+    }
+    return lfr;
+}
+
+size_t
+p64_lfring_size(uint32_t nelems)
+{
+    if (!check_params(nelems, 0))
+    {
+	return 0;
+    }
+    unsigned long ringsz = ROUNDUP_POW2(nelems);
+    return sizeof(p64_lfring_t) + ringsz * sizeof(struct element);
+}
+
+p64_lfring_t *
+p64_lfring_alloc(uint32_t nelems, uint32_t flags)
+{
+    if (!check_params(nelems, flags))
+    {
+	return NULL;
+    }
+    void *mem = p64_malloc(p64_lfring_size(nelems), CACHE_LINE);
+    if (mem != NULL)
+    {
+	return init_ring(mem, nelems, flags);
     }
     return NULL;
 }
 
+p64_lfring_t *
+p64_lfring_init(void *mem, uint32_t nelems, uint32_t flags)
+{
+    if ((uintptr_t)mem % CACHE_LINE != 0)
+    {
+	report_error("lfring", "invalid memory alignment", mem);
+	return NULL;
+    }
+    if (!check_params(nelems, flags))
+    {
+	return NULL;
+    }
+    return init_ring(mem, nelems, flags);
+}
+
+p64_lfring_t *
+p64_lfring_attach(void *mem)
+{
+    if ((uintptr_t)mem % CACHE_LINE != 0)
+    {
+	report_error("lfring", "invalid memory alignment", mem);
+	return NULL;
+    }
+    //All metadata is located in the ring buffer itself
+    return mem;
+}
+
 void
 p64_lfring_free(p64_lfring_t *lfr)
 {
@@ -161,6 +224,14 @@ p64_lfring_enqueue(p64_lfring_t *lfr,
 	}
 	//B0: write tail, synchronize with B1
 	atomic_store_n(&lfr->tail, tail, __ATOMIC_RELEASE);
+	if (UNLIKELY(lfr->flags & P64_LFRING_F_WAIT))
+	{
+	    ringwait_signal(&lfr->notempty);
+	}
+	if (UNLIKELY(lfr->member != NULL))
+	{
+	    ringset_mark(lfr->member);
+	}
 	return (uint32_t)actual;
     }
     //Else lock-free multi-producer
@@ -213,6 +284,14 @@ restart:
 	tail++;//Continue with next slot
     }
     (void)cond_update(&lfr->tail, tail);
+    if (UNLIKELY(lfr->flags & P64_LFRING_F_WAIT) && actual != 0)
+    {
+	ringwait_signal(&lfr->notempty);
+    }
+    if (UNLIKELY(lfr->member != NULL) && actual != 0)
+    {
+	ringset_mark(lfr->member);
+    }
     return (uint32_t)actual;
 }
 
@@ -239,12 +318,30 @@ find_tail(p64_lfring_t *lfr, ringidx_t head, ringidx_t tail)
     return tail;
 }
 
-//Dequeue elements from head
-uint32_t
-p64_lfring_dequeue(p64_lfring_t *lfr,
-		   void **restrict elems,
-		   uint32_t nelems,
-		   uint32_t *index)
+static inline intptr_t
+dequeue_avail(p64_lfring_t *lfr,
+	      ringidx_t head,
+	      ringidx_t tail,
+	      uint32_t nelems,
+	      uint32_t min)
+{
+    intptr_t actual = MIN((intptr_t)(tail - head), (intptr_t)nelems);
+    if (UNLIKELY(actual < (intptr_t)min))
+    {
+	//Too few elements, scan for new but unreleased elements
+	tail = find_tail(lfr, head, tail);
+	actual = MIN((intptr_t)(tail - head), (intptr_t)nelems);
+    }
+    return actual;
+}
+
+//Dequeue at least 'min' (>= 1) and at most 'nelems' elements from head
+static inline uint32_t
+dequeue(p64_lfring_t *lfr,
+	void **restrict elems,
+	uint32_t nelems,
+	uint32_t *index,
+	uint32_t min)
 {
     ringidx_t mask = lfr->mask;
     intptr_t actual;
@@ -253,16 +350,10 @@ p64_lfring_dequeue(p64_lfring_t *lfr,
     ringidx_t tail = atomic_load_n(&lfr->tail, __ATOMIC_ACQUIRE);
     do
     {
-	actual = MIN((intptr_t)(tail - head), (intptr_t)nelems);
-	if (UNLIKELY(actual <= 0))
+	actual = dequeue_avail(lfr, head, tail, nelems, min);
+	if (actual < (intptr_t)min)
 	{
-	    //Ring looks empty, scan for new but unreleased elements
-	    tail = find_tail(lfr, head, tail);
-	    actual = MIN((intptr_t)(tail - head), (intptr_t)nelems);
-	    if (actual <= 0)
-	    {
-		return 0;
-	    }
+	    return 0;
 	}
 	for (uint32_t i = 0; i < (uint32_t)actual; i++)
 	{
@@ -283,6 +374,225 @@ p64_lfring_dequeue(p64_lfring_t *lfr,
 				      head + actual,
 				      __ATOMIC_RELEASE,
 				      __ATOMIC_RELAXED));
+    if (UNLIKELY(lfr->flags & P64_LFRING_F_WAIT))
+    {
+	ringwait_signal(&lfr->notfull);
+    }
     *index = (uint32_t)head;
     return (uint32_t)actual;
 }
+
+uint32_t
+p64_lfring_dequeue(p64_lfring_t *lfr,
+		   void **restrict elems,
+		   uint32_t nelems,
+		   uint32_t *index)
+{
+    return dequeue(lfr, elems, nelems, index, 1);
+}
+
+uint32_t
+p64_lfring_dequeue_min(p64_lfring_t *lfr,
+		       void **restrict elems,
+		       uint32_t nelems,
+		       uint32_t *index,
+		       uint32_t min)
+{
+    if (UNLIKELY(min > nelems))
+    {
+	report_error("lfring", "invalid minimum number of elements", min);
+	return 0;
+    }
+    return dequeue(lfr, elems, nelems, index, MAX(min, 1U));
+}
+
+p64_lfring_result_t
+p64_lfring_acquire(p64_lfring_t *lfr,
+		   uint32_t num,
+		   bool enqueue)
+{
+    p64_lfring_result_t r = { 0, lfr->mask, 0, lfr->ring };
+    intptr_t actual;
+    if (enqueue)
+    {
+	if (UNLIKELY(!(lfr->flags & P64_LFRING_F_SPENQ)))
+	{
+	    //Lock-free enqueue writes each slot with one atomic operation,
+	    //there is no reservation which can be filled in later
+	    report_error("lfring", "in-place enqueue requires single producer",
+			 lfr->flags);
+	    return r;
+	}
+	ringidx_t size = (ringidx_t)lfr->mask + 1;
+	ringidx_t tail = atomic_load_n(&lfr->tail, __ATOMIC_RELAXED);
+	//A0: read head, synchronize with A1/A3
+	ringidx_t head = atomic_load_n(&lfr->head, __ATOMIC_ACQUIRE);
+	actual = MIN((intptr_t)(head + size - tail), (intptr_t)num);
+	r.index = tail;
+    }
+    else
+    {
+	ringidx_t head = atomic_load_n(&lfr->head, __ATOMIC_RELAXED);
+	//B1: read tail, synchronize with B3
+	ringidx_t tail = atomic_load_n(&lfr->tail, __ATOMIC_ACQUIRE);
+	actual = dequeue_avail(lfr, head, tail, num, 1);
+	r.index = head;
+    }
+    r.actual = actual > 0 ? (uint32_t)actual : 0;
+    return r;
+}
+
+bool
+p64_lfring_release(p64_lfring_t *lfr,
+		   p64_lfring_result_t r,
+		   bool enqueue)
+{
+    ringidx_t mask = lfr->mask;
+    if (enqueue)
+    {
+	ringidx_t tail = r.index;
+	for (uint32_t i = 0; i < r.actual; i++)
+	{
+	    assert(lfr->ring[tail & mask].idx == tail - (mask + 1));
+	    lfr->ring[tail & mask].idx = tail;
+	    tail++;
+	}
+	//B0: write tail, synchronize with B1
+	atomic_store_n(&lfr->tail, tail, __ATOMIC_RELEASE);
+	if (UNLIKELY(lfr->flags & P64_LFRING_F_WAIT))
+	{
+	    ringwait_signal(&lfr->notempty);
+	}
+	if (UNLIKELY(lfr->member != NULL))
+	{
+	    ringset_mark(lfr->member);
+	}
+	return true;
+    }
+    if (lfr->flags & P64_LFRING_F_SCDEQ)
+    {
+	//Single-consumer
+	//A1: write head, synchronize with A0/A2
+	atomic_store_n(&lfr->head, r.index + r.actual, __ATOMIC_RELEASE);
+    }
+    else
+    {
+	//Lock-free multi-consumer
+	ringidx_t head = r.index;
+	//A3: write head, synchronize with A0/A2
+	if (!atomic_compare_exchange_n(&lfr->head,
+				       &head,
+				       r.index + r.actual,
+				       __ATOMIC_RELEASE,
+				       __ATOMIC_RELAXED))
+	{
+	    return false;
+	}
+    }
+    if (UNLIKELY(lfr->flags & P64_LFRING_F_WAIT))
+    {
+	ringwait_signal(&lfr->notfull);
+    }
+    return true;
+}
+
+void
+lfring_set_member(p64_lfring_t *lfr, struct ringset_member *m)
+{
+    lfr->member = m;
+}
+
+struct waitarg
+{
+    p64_lfring_t *lfr;
+    uint32_t min;
+};
+
+//Check if at least 'min' elements are available to consumers
+static bool
+elems_avail(void *arg)
+{
+    const struct waitarg *wa = arg;
+    p64_lfring_t *lfr = wa->lfr;
+    ringidx_t head = atomic_load_n(&lfr->head, __ATOMIC_RELAXED);
+    ringidx_t tail = atomic_load_n(&lfr->tail, __ATOMIC_ACQUIRE);
+    return dequeue_avail(lfr, head, tail, wa->min, wa->min) >= (intptr_t)wa->min;
+}
+
+//Check if any slots are available to producers
+static bool
+space_avail(void *arg)
+{
+    const struct waitarg *wa = arg;
+    p64_lfring_t *lfr = wa->lfr;
+    ringidx_t size = (ringidx_t)lfr->mask + 1;
+    ringidx_t tail = atomic_load_n(&lfr->tail, __ATOMIC_RELAXED);
+    ringidx_t head = atomic_load_n(&lfr->head, __ATOMIC_RELAXED);
+    return before(tail, head + size);
+}
+
+uint32_t
+p64_lfring_enqueue_wait(p64_lfring_t *lfr,
+			void *const elems[],
+			uint32_t nelems,
+			uint64_t tmo_ns)
+{
+    if (UNLIKELY(!(lfr->flags & P64_LFRING_F_WAIT)))
+    {
+	report_error("lfring", "ring buffer not allocated with F_WAIT", 0);
+	return 0;
+    }
+    struct waitarg wa = { lfr, 1 };
+    uint64_t deadline = ringwait_deadline(tmo_ns);
+    uint32_t actual = 0;
+    for (;;)
+    {
+	actual += p64_lfring_enqueue(lfr, elems + actual, nelems - actual);
+	if (actual == nelems)
+	{
+	    return actual;
+	}
+	//Ring buffer full, wait for consumers to release slots
+	//Only the address of 'head' is used for monitoring
+	if (!ringwait_wait(&lfr->notfull, (const uint32_t *)&lfr->head,
+			   space_avail, &wa, deadline))
+	{
+	    //Timeout
+	    return actual;
+	}
+    }
+}
+
+uint32_t
+p64_lfring_dequeue_wait(p64_lfring_t *lfr,
+			void *elems[],
+			uint32_t nelems,
+			uint32_t *index,
+			uint32_t min,
+			uint64_t tmo_ns)
+{
+    if (UNLIKELY(!(lfr->flags & P64_LFRING_F_WAIT)))
+    {
+	report_error("lfring", "ring buffer not allocated with F_WAIT", 0);
+	return 0;
+    }
+    if (UNLIKELY(nelems == 0))
+    {
+	return 0;
+    }
+    struct waitarg wa = { lfr, MIN(MAX(min, 1U), nelems) };
+    uint64_t deadline = ringwait_deadline(tmo_ns);
+    for (;;)
+    {
+	//Only the address of 'tail' is used for monitoring
+	bool avail = ringwait_wait(&lfr->notempty, (const uint32_t *)&lfr->tail,
+				   elems_avail, &wa, deadline);
+	//On timeout, dequeue any (less than 'min') available elements
+	uint32_t actual = p64_lfring_dequeue(lfr, elems, nelems, index);
+	if (actual != 0 || !avail)
+	{
+	    return actual;
+	}
+	//Else other consumers took the elements, wait again
+    }
+}
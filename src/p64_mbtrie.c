@@ -28,6 +28,8 @@ struct p64_mbtrie
     p64_mbtrie_free_cb refcnt_zero_cb;
     p64_mbtrie_elem_t *default_pfx;
     void *refcnt_zero_arg;
+    p64_qsbrdomain_t *qsbr;//Domain of retired vectors when using QSBR
+    p64_memsrc_t mem;//Source of vectors
     uint8_t use_hp;
     uint8_t maxlen;//Max length of prefixes
     uint8_t nstrides;//Number of strides in strides array
@@ -264,6 +266,8 @@ invalid_stride:
 	mbt->refcnt_zero_cb = refcnt_zero_cb;
 	mbt->refcnt_zero_arg = refcnt_zero_arg;
 	mbt->use_hp = (flags & P64_MBTRIE_F_HP) != 0;
+	mbt->qsbr = mbt->use_hp ? NULL : p64_qsbr_domain();
+	p64_memsrc_get(&mbt->mem);
 	mbt->nstrides = nstrides;
 	mbt->maxlen = maxlen;
 	for (uint32_t i = 0; i < nstrides; i++)
@@ -316,7 +320,7 @@ alloc_vec(p64_mbtrie_t *mbt,
 {
     assert(depth < mbt->nstrides);
     size_t nslots = stride_to_nslots(mbt->strides[depth]);
-    void **vec = p64_malloc(nslots * sizeof(void *), ALIGNMENT);
+    void **vec = p64_malloc_src(&mbt->mem, nslots * sizeof(void *), ALIGNMENT);
     if (UNLIKELY(vec == NULL))
     {
 	report_error("mbtrie", "malloc failed", mbt);
@@ -390,7 +394,7 @@ free_vec(p64_mbtrie_t *mbt,
 	}
 	else
 	{
-	    while (!p64_qsbr_retire(vec, p64_mfree))
+	    while (!p64_qsbr_retire_domain(mbt->qsbr, vec, p64_mfree))
 	    {
 		doze();
 	    }
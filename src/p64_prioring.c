@@ -0,0 +1,162 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "p64_prioring.h"
+#include "build_config.h"
+#include "os_abstraction.h"
+
+#include "atomic.h"
+#include "common.h"
+#include "err_hnd.h"
+#include "ringbuf.h"
+
+struct p64_prioring
+{
+    //Weighted round robin state: current level << 32 | remaining weight
+    uint64_t wrr ALIGNED(CACHE_LINE);
+    uint32_t nprios ALIGNED(CACHE_LINE);
+    bool strict;
+    uint32_t weights[P64_PRIORING_MAXPRIOS];
+    p64_ringbuf_t *rings[P64_PRIORING_MAXPRIOS];
+    //Ring buffers follow, each one ringbuf_size() bytes
+};
+
+#define HDR_SIZE ROUNDUP(sizeof(p64_prioring_t), RINGBUF_ALIGNMENT)
+
+p64_prioring_t *
+p64_prioring_alloc(uint32_t nprios,
+		   uint32_t nelems,
+		   const uint32_t weights[],
+		   uint32_t flags)
+{
+    if (nprios == 0 || nprios > P64_PRIORING_MAXPRIOS)
+    {
+	report_error("prioring", "invalid number of priorities", nprios);
+	return NULL;
+    }
+    if (flags & P64_RINGBUF_F_WAIT)
+    {
+	report_error("prioring", "invalid flags", flags);
+	return NULL;
+    }
+    if (!ringbuf_check(nelems, flags))
+    {
+	return NULL;
+    }
+    for (uint32_t i = 0; weights != NULL && i < nprios; i++)
+    {
+	if (weights[i] == 0)
+	{
+	    report_error("prioring", "invalid weight", i);
+	    return NULL;
+	}
+    }
+    size_t ringsz = ringbuf_size(nelems, sizeof(void *));
+    size_t nbytes = HDR_SIZE + nprios * ringsz;
+    p64_prioring_t *pr = p64_malloc(nbytes, RINGBUF_ALIGNMENT);
+    if (pr != NULL)
+    {
+	pr->nprios = nprios;
+	pr->strict = weights == NULL;
+	for (uint32_t i = 0; i < nprios; i++)
+	{
+	    pr->weights[i] = weights != NULL ? weights[i] : 0;
+	    pr->rings[i] = ringbuf_init((char *)pr + HDR_SIZE + i * ringsz,
+					nelems, flags);
+	}
+	pr->wrr = pr->weights[0];
+    }
+    return pr;
+}
+
+void
+p64_prioring_free(p64_prioring_t *pr)
+{
+    if (pr != NULL)
+    {
+	for (uint32_t i = 0; i < pr->nprios; i++)
+	{
+	    if (!ringbuf_empty(pr->rings[i]))
+	    {
+		report_error("prioring", "priority ring not empty", i);
+		return;
+	    }
+	}
+	p64_mfree(pr);
+    }
+}
+
+uint32_t
+p64_prioring_enqueue(p64_prioring_t *pr,
+		     void *const ev[],
+		     uint32_t num,
+		     uint32_t prio)
+{
+    if (UNLIKELY(prio >= pr->nprios))
+    {
+	report_error("prioring", "invalid priority", prio);
+	return 0;
+    }
+    return p64_ringbuf_enqueue(pr->rings[prio], ev, num);
+}
+
+static inline uint32_t
+dequeue_strict(p64_prioring_t *pr,
+	       void *ev[],
+	       uint32_t num)
+{
+    uint32_t n = 0, index;
+    for (uint32_t i = 0; i < pr->nprios && n < num; i++)
+    {
+	n += p64_ringbuf_dequeue(pr->rings[i], ev + n, num - n, &index);
+    }
+    return n;
+}
+
+static inline uint32_t
+dequeue_wrr(p64_prioring_t *pr,
+	    void *ev[],
+	    uint32_t num)
+{
+    uint64_t wrr = atomic_load_n(&pr->wrr, __ATOMIC_RELAXED);
+    uint32_t level = (uint32_t)(wrr >> 32);
+    uint32_t credit = (uint32_t)wrr;
+    uint32_t n = 0, index;
+    //Stop when all levels have been found empty in a row
+    uint32_t nempty = 0;
+    while (n < num && nempty < pr->nprios)
+    {
+	uint32_t want = MIN(num - n, credit);
+	uint32_t actual = p64_ringbuf_dequeue(pr->rings[level],
+					      ev + n, want, &index);
+	n += actual;
+	credit -= actual;
+	if (credit == 0 || actual < want)
+	{
+	    //Weight used up or level empty, continue with next level
+	    nempty = actual == 0 ? nempty + 1 : 0;
+	    level = level + 1 < pr->nprios ? level + 1 : 0;
+	    credit = pr->weights[level];
+	}
+    }
+    wrr = (uint64_t)level << 32 | credit;
+    atomic_store_n(&pr->wrr, wrr, __ATOMIC_RELAXED);
+    return n;
+}
+
+uint32_t
+p64_prioring_dequeue(p64_prioring_t *pr,
+		     void *ev[],
+		     uint32_t num)
+{
+    if (pr->strict)
+    {
+	return dequeue_strict(pr, ev, num);
+    }
+    return dequeue_wrr(pr, ev, num);
+}
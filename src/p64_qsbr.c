@@ -16,6 +16,7 @@
 #else
 typedef struct p64_qsbrdomain p64_qsbrdomain_t;
 #define PUBLIC static inline
+#define P64_QSBR_MAXDOMAINS 8
 #endif
 #include "build_config.h"
 #include "os_abstraction.h"
@@ -25,6 +26,7 @@ typedef struct p64_qsbrdomain p64_qsbrdomain_t;
 #include "common.h"
 #include "err_hnd.h"
 #include "thr_idx.h"
+#include "reclaimer.h"
 
 #ifndef PRIVATE
 static void
@@ -36,13 +38,23 @@ report_thread_not_registered(void)
 #define report_thread_not_registered(x)
 #endif
 
+//Per-thread interval in separate cache line to avoid false sharing
+struct interval
+{
+    uint64_t val;
+} ALIGNED(CACHE_LINE);
+
 struct p64_qsbrdomain
 {
     uint64_t current;//Current interval
     uint32_t maxobjs;
     uint32_t ringmask;//(Power-of-two of maxobjs) - 1
     uint32_t high_wm;//High watermark of thread index
-    uint64_t intervals[MAXTHREADS] ALIGNED(CACHE_LINE);//Each thread's last quiescent interval
+    uint32_t maxthreads;
+    p64_reclaimer_t *rcl;//Optional background reclaimer
+    p64_memsrc_t mem;//Source of thread state
+    uint64_t *registered;//Bitmap of registered threads
+    struct interval intervals[] ALIGNED(CACHE_LINE);//Each thread's last quiescent interval
 };
 
 //Value larger than all possible intervals
@@ -56,34 +68,48 @@ p64_qsbr_alloc(uint32_t maxobjs)
 	report_error("qsbr", "invalid maxobjs", maxobjs);
 	return NULL;
     }
-    p64_qsbrdomain_t *qsbr = p64_malloc(sizeof(p64_qsbrdomain_t), CACHE_LINE);
+    uint32_t maxthreads = p64_idx_maxthreads();
+    size_t nbytes = sizeof(p64_qsbrdomain_t) +
+		    maxthreads * sizeof(struct interval) +
+		    IDXMAP_NWORDS(maxthreads) * sizeof(uint64_t);
+    p64_qsbrdomain_t *qsbr = p64_malloc(nbytes, CACHE_LINE);
     if (qsbr != NULL)
     {
 	qsbr->current = 0;
 	qsbr->maxobjs = maxobjs;
 	qsbr->ringmask = ROUNDUP_POW2(maxobjs) - 1;
 	qsbr->high_wm = 0;
-	for (uint32_t i = 0; i < MAXTHREADS; i++)
+	qsbr->maxthreads = maxthreads;
+	qsbr->rcl = NULL;
+	p64_memsrc_get(&qsbr->mem);
+	qsbr->registered = (uint64_t *)&qsbr->intervals[maxthreads];
+	for (uint32_t i = 0; i < maxthreads; i++)
 	{
-	    qsbr->intervals[i] = INFINITE;
+	    qsbr->intervals[i].val = INFINITE;
+	}
+	for (uint32_t i = 0; i < IDXMAP_NWORDS(maxthreads); i++)
+	{
+	    qsbr->registered[i] = 0;
 	}
 	return qsbr;
     }
     return NULL;
 }
 
-//Find the smallest value in the array
-//Return INFINITE if array is empty
+//Find the smallest interval of all registered threads
+//Return INFINITE if there are no active threads
 static uint64_t
-find_min(const uint64_t vec[], uint32_t num)
+find_min(p64_qsbrdomain_t *qsbr)
 {
+    uint32_t numthrs = __atomic_load_n(&qsbr->high_wm, __ATOMIC_ACQUIRE);
     uint64_t min = INFINITE;
-    for (uint32_t i = 0; i < num; i++)
+    uint32_t t;
+    IDXMAP_FOREACH(qsbr->registered, numthrs, t)
     {
-	uint64_t t = __atomic_load_n(&vec[i], __ATOMIC_RELAXED);
-	if (t < min)
+	uint64_t i = __atomic_load_n(&qsbr->intervals[t].val, __ATOMIC_RELAXED);
+	if (i < min)
 	{
-	    min = t;
+	    min = i;
 	}
     }
     return min;
@@ -92,7 +118,7 @@ find_min(const uint64_t vec[], uint32_t num)
 PUBLIC void
 p64_qsbr_free(p64_qsbrdomain_t *qsbr)
 {
-    uint64_t interval = find_min(qsbr->intervals, qsbr->high_wm);
+    uint64_t interval = find_min(qsbr);
     if (interval != INFINITE)
     {
 	report_error("qsbr", "registered threads still present", 0);
@@ -101,6 +127,12 @@ p64_qsbr_free(p64_qsbrdomain_t *qsbr)
     p64_mfree(qsbr);
 }
 
+PUBLIC void
+p64_qsbr_set_reclaimer(p64_qsbrdomain_t *qsbr, p64_reclaimer_t *rcl)
+{
+    __atomic_store_n(&qsbr->rcl, rcl, __ATOMIC_RELAXED);
+}
+
 typedef void *userptr_t;
 
 struct object
@@ -123,27 +155,67 @@ struct thread_state
     struct object objs[];
 } ALIGNED(CACHE_LINE);
 
+//Thread state of current domain
 static THREAD_LOCAL struct thread_state *TS = NULL;
+//Thread states of all domains the thread is registered in
+static THREAD_LOCAL struct thread_state *TSS[P64_QSBR_MAXDOMAINS];
+//Thread index is shared by all domains
+static THREAD_LOCAL int32_t IDX = -1;
+static THREAD_LOCAL uint32_t NDOMAINS = 0;
+
+static struct thread_state *
+find_ts(p64_qsbrdomain_t *qsbr)
+{
+    for (uint32_t i = 0; i < P64_QSBR_MAXDOMAINS; i++)
+    {
+	if (TSS[i] != NULL && TSS[i]->qsbr == qsbr)
+	{
+	    return TSS[i];
+	}
+    }
+    return NULL;
+}
 
 static struct thread_state *
 alloc_ts(p64_qsbrdomain_t *qsbr)
 {
-    assert(TS == NULL);
-    //Attempt to allocate a thread index
-    int32_t idx = p64_idx_alloc();
-    if (idx < 0)
+    uint32_t slot = 0;
+    while (slot < P64_QSBR_MAXDOMAINS && TSS[slot] != NULL)
+    {
+	slot++;
+    }
+    if (slot == P64_QSBR_MAXDOMAINS)
     {
-	report_error("qsbr", "too many registered threads", 0);
+	report_error("qsbr", "too many domains", P64_QSBR_MAXDOMAINS);
 	return NULL;
     }
+    if (NDOMAINS == 0)
+    {
+	//Attempt to allocate a thread index
+	IDX = p64_idx_alloc();
+	if (IDX < 0)
+	{
+	    report_error("qsbr", "too many registered threads", 0);
+	    return NULL;
+	}
+    }
+    int32_t idx = IDX;
     size_t nbytes = sizeof(struct thread_state) +
 		    (qsbr->ringmask + 1) * sizeof(struct object);
-    struct thread_state *ts = p64_malloc(nbytes, CACHE_LINE);
+    struct thread_state *ts = p64_malloc_src(&qsbr->mem, nbytes,
+					     CACHE_LINE);
     if (ts == NULL)
     {
 	report_error("qsbr", "failed to allocate thread-local data", 0);
+	if (NDOMAINS == 0)
+	{
+	    p64_idx_free(IDX);
+	    IDX = -1;
+	}
 	return NULL;
     }
+    TSS[slot] = ts;
+    NDOMAINS++;
     ts->qsbr = qsbr;
     ts->interval = INFINITE;
     ts->recur = 0;
@@ -152,9 +224,11 @@ alloc_ts(p64_qsbrdomain_t *qsbr)
     ts->tail = 0;
     ts->ringmask = qsbr->ringmask;
     ts->maxobjs = qsbr->maxobjs;
-    assert(qsbr->intervals[idx] == INFINITE);
+    assert((uint32_t)idx < qsbr->maxthreads);
+    assert(qsbr->intervals[idx].val == INFINITE);
     //Conditionally update high watermark of indexes
     lockfree_fetch_umax_4(&qsbr->high_wm, (uint32_t)idx + 1, __ATOMIC_RELAXED);
+    idxmap_set(qsbr->registered, idx);
     return ts;
 }
 
@@ -167,7 +241,8 @@ p64_qsbr_reactivate(void)
 	return;
     }
     uint64_t current = __atomic_load_n(&TS->qsbr->current, __ATOMIC_RELAXED);
-    __atomic_store_n(&TS->qsbr->intervals[TS->idx], current, __ATOMIC_RELAXED);
+    __atomic_store_n(&TS->qsbr->intervals[TS->idx].val, current,
+		     __ATOMIC_RELAXED);
     TS->interval = current;
     //Ensure our interval is observable before any reads are observed
     __atomic_thread_fence(__ATOMIC_SEQ_CST);
@@ -176,17 +251,39 @@ p64_qsbr_reactivate(void)
 PUBLIC void
 p64_qsbr_register(p64_qsbrdomain_t *qsbr)
 {
-    if (UNLIKELY(TS == NULL))
+    struct thread_state *ts = find_ts(qsbr);
+    if (ts == NULL)
     {
-	TS = alloc_ts(qsbr);
-	if (UNLIKELY(TS == NULL))
+	ts = alloc_ts(qsbr);
+	if (UNLIKELY(ts == NULL))
 	{
 	    return;
 	}
     }
+    TS = ts;
     p64_qsbr_reactivate();
 }
 
+PUBLIC p64_qsbrdomain_t *
+p64_qsbr_select(p64_qsbrdomain_t *qsbr)
+{
+    struct thread_state *ts = find_ts(qsbr);
+    if (UNLIKELY(ts == NULL))
+    {
+	report_thread_not_registered();
+	return NULL;
+    }
+    p64_qsbrdomain_t *prev = TS != NULL ? TS->qsbr : NULL;
+    TS = ts;
+    return prev;
+}
+
+PUBLIC p64_qsbrdomain_t *
+p64_qsbr_domain(void)
+{
+    return TS != NULL ? TS->qsbr : NULL;
+}
+
 PUBLIC void
 p64_qsbr_deactivate(void)
 {
@@ -196,7 +293,8 @@ p64_qsbr_deactivate(void)
 	return;
     }
     //Mark thread as inactive, no references kept
-    __atomic_store_n(&TS->qsbr->intervals[TS->idx], INFINITE, __ATOMIC_RELEASE);
+    __atomic_store_n(&TS->qsbr->intervals[TS->idx].val, INFINITE,
+		     __ATOMIC_RELEASE);
     TS->interval = INFINITE;
 }
 
@@ -215,21 +313,40 @@ p64_qsbr_unregister(void)
 	return;
     }
     p64_qsbr_deactivate();
-    p64_idx_free(TS->idx);
+    idxmap_clr(TS->qsbr->registered, TS->idx);
+    struct thread_state *next = NULL;
+    for (uint32_t i = 0; i < P64_QSBR_MAXDOMAINS; i++)
+    {
+	if (TSS[i] == TS)
+	{
+	    TSS[i] = NULL;
+	}
+	else if (TSS[i] != NULL && next == NULL)
+	{
+	    //Another registered domain becomes the current domain
+	    next = TSS[i];
+	}
+    }
+    if (--NDOMAINS == 0)
+    {
+	p64_idx_free(IDX);
+	IDX = -1;
+    }
     p64_mfree(TS);
-    TS = NULL;
+    TS = next;
 }
 
 static inline void
-quiescent(void)
+quiescent(struct thread_state *ts)
 {
-    p64_qsbrdomain_t *qsbr = TS->qsbr;
+    p64_qsbrdomain_t *qsbr = ts->qsbr;
     uint64_t current = __atomic_load_n(&qsbr->current, __ATOMIC_RELAXED);
-    if (current != TS->interval)
+    if (current != ts->interval)
     {
 	//Release order to contain all our previous access to shared objects
-	__atomic_store_n(&qsbr->intervals[TS->idx], current, __ATOMIC_RELEASE);
-	TS->interval = current;
+	__atomic_store_n(&qsbr->intervals[ts->idx].val, current,
+			 __ATOMIC_RELEASE);
+	ts->interval = current;
     }
 }
 
@@ -246,7 +363,20 @@ p64_qsbr_quiescent(void)
 	report_error("qsbr", "thread is inactive", 0);
 	return;
     }
-    quiescent();
+    quiescent(TS);
+    if (NDOMAINS > 1)
+    {
+	//No references are kept to objects in any domain
+	for (uint32_t i = 0; i < P64_QSBR_MAXDOMAINS; i++)
+	{
+	    struct thread_state *ts = TSS[i];
+	    if (ts != NULL && ts != TS && ts->interval != INFINITE &&
+		ts->recur == 0)
+	    {
+		quiescent(ts);
+	    }
+	}
+    }
 }
 
 PUBLIC void
@@ -280,21 +410,20 @@ p64_qsbr_release(void)
     }
     if (--TS->recur == 0)
     {
-	quiescent();
+	quiescent(TS);
     }
 }
 
 //Traverse all pending objects and reclaim those that have no references
 static uint32_t
-garbage_collect(void)
+garbage_collect(struct thread_state *ts)
 {
-    uint32_t numthrs = __atomic_load_n(&TS->qsbr->high_wm, __ATOMIC_ACQUIRE);
-    uint64_t min_interval = find_min(TS->qsbr->intervals, numthrs);
+    uint64_t min_interval = find_min(ts->qsbr);
     __atomic_thread_fence(__ATOMIC_ACQUIRE);
     //Traverse list of pending objects
-    while (TS->tail != TS->head)
+    while (ts->tail != ts->head)
     {
-	struct object *obj = &TS->objs[TS->tail & TS->ringmask];
+	struct object *obj = &ts->objs[ts->tail & ts->ringmask];
 	if (min_interval <= obj->interval)
 	{
 	    //At least one thread has not observed a later interval
@@ -303,49 +432,134 @@ garbage_collect(void)
 	//All threads have observed a later interval =>
 	//No thread has any reference to this object, reclaim it
 	obj->cb(obj->ptr);
-	TS->tail++;
+	ts->tail++;
     }
     //Some objects may remain in the list of retired objects
     //Return number of remaining unreclaimed objects
     //Caller can compute number of available slots
-    return TS->head - TS->tail;
+    return ts->head - ts->tail;
 }
 
-//Retire an object
-//If necessary, perform garbage collection on retired objects
-PUBLIC bool
-p64_qsbr_retire(void *ptr,
-		void (*cb)(void *ptr))
+//Reclaim a batch of objects handed off to a reclaimer
+//All objects in the batch are reclaimed together
+static uint32_t
+reclaim_qsbr_batch(struct reclaim_batch *batch)
 {
-    if (UNLIKELY(TS == NULL))
+    p64_qsbrdomain_t *qsbr = batch->domain;
+    uint64_t min_interval = find_min(qsbr);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (min_interval <= batch->interval)
+    {
+	//At least one thread has not observed a later interval
+	return batch->nobjs;
+    }
+    for (uint32_t i = 0; i < batch->nobjs; i++)
+    {
+	batch->objs[i].cb(batch->objs[i].ptr);
+    }
+    return 0;
+}
+
+//Hand off all pending objects to a reclaimer
+//Return true if successful
+static bool
+qsbr_handoff(struct thread_state *ts, p64_reclaimer_t *rcl)
+{
+    uint32_t nobjs = ts->head - ts->tail;
+    struct reclaim_batch *batch = reclaimer_batch_get(rcl, nobjs);
+    if (UNLIKELY(batch == NULL))
     {
-	report_thread_not_registered();
 	return false;
     }
-    if (UNLIKELY(TS->head - TS->tail == TS->maxobjs))
+    batch->reclaim = reclaim_qsbr_batch;
+    batch->domain = ts->qsbr;
+    for (uint32_t i = 0; i < nobjs; i++)
+    {
+	struct object *obj = &ts->objs[(ts->tail + i) & ts->ringmask];
+	batch->objs[i].ptr = obj->ptr;
+	batch->objs[i].cb = obj->cb;
+    }
+    //Intervals of retired objects are increasing, the last object has the
+    //latest interval
+    batch->interval = ts->objs[(ts->head - 1) & ts->ringmask].interval;
+    batch->nobjs = nobjs;
+    reclaimer_handoff(rcl, batch);
+    ts->tail = ts->head;
+    return true;
+}
+
+//Retire an object
+//If necessary, hand off retired objects to the reclaimer or perform garbage
+//collection on retired objects
+static bool
+retire(struct thread_state *ts,
+       void *ptr,
+       void (*cb)(void *ptr))
+{
+    if (UNLIKELY(ts->head - ts->tail == ts->maxobjs))
     {
-	if (garbage_collect() == TS->maxobjs)
+	p64_reclaimer_t *rcl = __atomic_load_n(&ts->qsbr->rcl,
+					       __ATOMIC_RELAXED);
+	if (rcl != NULL && qsbr_handoff(ts, rcl))
+	{
+	    //Retired objects will be reclaimed by the reclaimer
+	}
+	else if (garbage_collect(ts) == ts->maxobjs)
 	{
 	    return false;//No space for object
 	}
     }
-    assert(TS->head - TS->tail < TS->maxobjs);
+    assert(ts->head - ts->tail < ts->maxobjs);
     //Create a new interval
     //Release order to ensure removal is observable before new interval is
     //created and can be observed
-    uint64_t previous = __atomic_fetch_add(&TS->qsbr->current,
+    uint64_t previous = __atomic_fetch_add(&ts->qsbr->current,
 					   1,
 					   __ATOMIC_RELEASE);
     //Retired object belongs to previous interval
-    TS->objs[TS->head & TS->ringmask].ptr = ptr;
-    TS->objs[TS->head & TS->ringmask].cb = cb;
-    TS->objs[TS->head & TS->ringmask].interval = previous;
-    TS->head++;
+    ts->objs[ts->head & ts->ringmask].ptr = ptr;
+    ts->objs[ts->head & ts->ringmask].cb = cb;
+    ts->objs[ts->head & ts->ringmask].interval = previous;
+    ts->head++;
     //The object can be reclaimed when all threads have observed
     //the new interval
     return true;
 }
 
+PUBLIC bool
+p64_qsbr_retire(void *ptr,
+		void (*cb)(void *ptr))
+{
+    if (UNLIKELY(TS == NULL))
+    {
+	report_thread_not_registered();
+	return false;
+    }
+    return retire(TS, ptr, cb);
+}
+
+PUBLIC bool
+p64_qsbr_retire_domain(p64_qsbrdomain_t *qsbr,
+		       void *ptr,
+		       void (*cb)(void *ptr))
+{
+    if (qsbr == NULL)
+    {
+	return p64_qsbr_retire(ptr, cb);
+    }
+    struct thread_state *ts = TS;
+    if (UNLIKELY(ts == NULL || ts->qsbr != qsbr))
+    {
+	ts = find_ts(qsbr);
+	if (UNLIKELY(ts == NULL))
+	{
+	    report_error("qsbr", "thread not registered in domain", 0);
+	    return false;
+	}
+    }
+    return retire(ts, ptr, cb);
+}
+
 PUBLIC uint32_t
 p64_qsbr_reclaim(void)
 {
@@ -360,7 +574,7 @@ p64_qsbr_reclaim(void)
 	return 0;
     }
     //Try to reclaim objects
-    uint32_t nremaining = garbage_collect();
+    uint32_t nremaining = garbage_collect(TS);
     return nremaining;
 }
 
@@ -231,6 +231,8 @@ struct p64_reassemble
     uint32_t cur;//Index of current fragment table
     uint8_t extendable;
     uint8_t use_hp;
+    p64_qsbrdomain_t *qsbr;//Domain of retired tables when using QSBR
+    p64_memsrc_t mem;//Source of fragment tables
     p64_reassemble_cb complete_cb;
     void *complete_arg;
     p64_reassemble_cb stale_cb;
@@ -321,10 +323,11 @@ p64_reassemble_alloc(uint32_t size,
     if (re != NULL)
     {
 	size_t nbytes = size * sizeof(struct fraglist);
+	p64_memsrc_get(&re->mem);
 	re->ft[0].i_s.idx = 0;
 	re->ft[0].i_s.shift = SIZE_TO_SHIFT(size);
 	assert(SHIFT_TO_SIZE(re->ft[0].i_s.shift) == size);
-	re->ft[0].base = p64_malloc(nbytes, CACHE_LINE);
+	re->ft[0].base = p64_malloc_src(&re->mem, nbytes, CACHE_LINE);
 	if (re->ft[0].base != NULL)
 	{
 	    re->ft[1].i_s.idx = 0;
@@ -333,6 +336,7 @@ p64_reassemble_alloc(uint32_t size,
 	    re->cur = 0;
 	    re->extendable = (flags & P64_REASSEMBLE_F_EXT) != 0;
 	    re->use_hp = (flags & P64_REASSEMBLE_F_HP) != 0;
+	    re->qsbr = re->use_hp ? NULL : p64_qsbr_domain();
 	    re->complete_cb = complete_cb;
 	    re->stale_cb = stale_cb;
 	    re->complete_arg = complete_arg;
@@ -814,8 +818,9 @@ p64_reassemble_extend(p64_reassemble_t *re)
 	//Allocate a new fragment table with double the size
 	uint32_t old_size = SHIFT_TO_SIZE(old.i_s.shift);
 	uint32_t new_size = 2 * old_size;
-	struct fraglist *base = p64_malloc(new_size * sizeof(struct fraglist),
-					   CACHE_LINE);
+	struct fraglist *base = p64_malloc_src(&re->mem,
+					       new_size * sizeof(struct fraglist),
+					       CACHE_LINE);
 	if (LIKELY(base != NULL))
 	{
 	    //Write new fragtable to next position so that threads can start to
@@ -856,7 +861,8 @@ p64_reassemble_extend(p64_reassemble_t *re)
 	    }
 	    else
 	    {
-		while (!p64_qsbr_retire(prv.base, p64_mfree))
+		while (!p64_qsbr_retire_domain(re->qsbr, prv.base,
+						      p64_mfree))
 		{
 		    doze();
 		}
@@ -0,0 +1,214 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "p64_reclaimer.h"
+#include "reclaimer.h"
+#include "build_config.h"
+#include "os_abstraction.h"
+
+#include "common.h"
+#include "err_hnd.h"
+
+struct p64_reclaimer
+{
+    //Batches handed off by retiring threads (LIFO)
+    struct reclaim_batch *inbox ALIGNED(CACHE_LINE);
+    uint32_t backlog ALIGNED(CACHE_LINE);
+    uint32_t maxbacklog;
+    uint64_t batches;
+    uint64_t objects;
+    uint64_t overflows;
+    //Emptied batches available for reuse (LIFO)
+    struct reclaim_batch *idle ALIGNED(CACHE_LINE);
+    //Only accessed by the thread calling p64_reclaimer_run()
+    struct reclaim_batch *pending ALIGNED(CACHE_LINE);
+    uint64_t reclaimed;
+    p64_memsrc_t mem;//Source of batches
+};
+
+p64_reclaimer_t *
+p64_reclaimer_alloc(uint32_t maxbacklog)
+{
+    if (maxbacklog < 1)
+    {
+	report_error("reclaimer", "invalid maxbacklog", maxbacklog);
+	return NULL;
+    }
+    p64_reclaimer_t *rcl = p64_malloc(sizeof(p64_reclaimer_t), CACHE_LINE);
+    if (rcl != NULL)
+    {
+	rcl->inbox = NULL;
+	rcl->backlog = 0;
+	rcl->maxbacklog = maxbacklog;
+	rcl->batches = 0;
+	rcl->objects = 0;
+	rcl->overflows = 0;
+	rcl->idle = NULL;
+	p64_memsrc_get(&rcl->mem);
+	rcl->pending = NULL;
+	rcl->reclaimed = 0;
+    }
+    return rcl;
+}
+
+void
+p64_reclaimer_free(p64_reclaimer_t *rcl)
+{
+    if (rcl != NULL)
+    {
+	uint32_t backlog = __atomic_load_n(&rcl->backlog, __ATOMIC_ACQUIRE);
+	if (backlog != 0)
+	{
+	    report_error("reclaimer", "reclaimer has unreclaimed objects",
+			 backlog);
+	    return;
+	}
+	struct reclaim_batch *batch = rcl->idle;
+	while (batch != NULL)
+	{
+	    struct reclaim_batch *next = batch->next;
+	    p64_mfree(batch);
+	    batch = next;
+	}
+	p64_mfree(rcl);
+    }
+}
+
+//Push list of batches 'first'..'last' on stack, the stacks are only popped
+//by taking the whole stack so there is no ABA problem
+static void
+push_batches(struct reclaim_batch **stack,
+	     struct reclaim_batch *first,
+	     struct reclaim_batch *last)
+{
+    struct reclaim_batch *head = __atomic_load_n(stack, __ATOMIC_RELAXED);
+    do
+    {
+	last->next = head;
+    }
+    while (!__atomic_compare_exchange_n(stack,
+					&head,//Updated on failure
+					first,
+					/*weak=*/true,
+					__ATOMIC_RELEASE,
+					__ATOMIC_RELAXED));
+}
+
+struct reclaim_batch *
+reclaimer_batch_get(p64_reclaimer_t *rcl, uint32_t nobjs)
+{
+    //Reserve space in backlog before getting a batch
+    uint32_t old = __atomic_fetch_add(&rcl->backlog, nobjs, __ATOMIC_RELAXED);
+    if (old + nobjs > rcl->maxbacklog)
+    {
+	__atomic_fetch_sub(&rcl->backlog, nobjs, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&rcl->overflows, 1, __ATOMIC_RELAXED);
+	return NULL;
+    }
+    //Take an idle batch, return any other idle batches
+    struct reclaim_batch *batch = __atomic_exchange_n(&rcl->idle,
+						      NULL,
+						      __ATOMIC_ACQUIRE);
+    if (batch != NULL && batch->next != NULL)
+    {
+	struct reclaim_batch *last = batch->next;
+	while (last->next != NULL)
+	{
+	    last = last->next;
+	}
+	push_batches(&rcl->idle, batch->next, last);
+    }
+    if (batch != NULL && batch->maxobjs < nobjs)
+    {
+	//Batch from domain with smaller capacity
+	p64_mfree(batch);
+	batch = NULL;
+    }
+    if (batch == NULL)
+    {
+	size_t nbytes = sizeof(struct reclaim_batch) +
+			nobjs * sizeof(struct reclaim_object);
+	batch = p64_malloc_src(&rcl->mem, nbytes, 0);
+	if (UNLIKELY(batch == NULL))
+	{
+	    __atomic_fetch_sub(&rcl->backlog, nobjs, __ATOMIC_RELAXED);
+	    return NULL;
+	}
+	batch->maxobjs = nobjs;
+    }
+    batch->next = NULL;
+    batch->reclaim = NULL;
+    batch->domain = NULL;
+    batch->interval = 0;
+    batch->nobjs = 0;
+    return batch;
+}
+
+void
+reclaimer_handoff(p64_reclaimer_t *rcl, struct reclaim_batch *batch)
+{
+    //Backlog already reserved by reclaimer_batch_get()
+    uint32_t nobjs = batch->nobjs;
+    push_batches(&rcl->inbox, batch, batch);
+    __atomic_fetch_add(&rcl->batches, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&rcl->objects, nobjs, __ATOMIC_RELAXED);
+}
+
+uint32_t
+p64_reclaimer_run(p64_reclaimer_t *rcl)
+{
+    //Take all new batches and add them to our list of pending batches
+    struct reclaim_batch *batch = __atomic_exchange_n(&rcl->inbox,
+						      NULL,
+						      __ATOMIC_ACQUIRE);
+    while (batch != NULL)
+    {
+	struct reclaim_batch *next = batch->next;
+	batch->next = rcl->pending;
+	rcl->pending = batch;
+	batch = next;
+    }
+    //Attempt to reclaim objects in all pending batches
+    struct reclaim_batch **pprev = &rcl->pending;
+    while ((batch = *pprev) != NULL)
+    {
+	uint32_t nobjs = batch->nobjs;
+	uint32_t nremaining = batch->reclaim(batch);
+	batch->nobjs = nremaining;
+	if (nremaining != nobjs)
+	{
+	    __atomic_store_n(&rcl->reclaimed,
+			     rcl->reclaimed + (nobjs - nremaining),
+			     __ATOMIC_RELAXED);
+	    __atomic_fetch_sub(&rcl->backlog,
+			       nobjs - nremaining,
+			       __ATOMIC_RELEASE);
+	}
+	if (nremaining == 0)
+	{
+	    //Batch empty, remove it and make it available for reuse
+	    *pprev = batch->next;
+	    push_batches(&rcl->idle, batch, batch);
+	}
+	else
+	{
+	    pprev = &batch->next;
+	}
+    }
+    return __atomic_load_n(&rcl->backlog, __ATOMIC_RELAXED);
+}
+
+void
+p64_reclaimer_stats(p64_reclaimer_t *rcl, p64_reclaimer_stats_t *st)
+{
+    st->batches = __atomic_load_n(&rcl->batches, __ATOMIC_RELAXED);
+    st->objects = __atomic_load_n(&rcl->objects, __ATOMIC_RELAXED);
+    st->reclaimed = __atomic_load_n(&rcl->reclaimed, __ATOMIC_RELAXED);
+    st->overflows = __atomic_load_n(&rcl->overflows, __ATOMIC_RELAXED);
+    st->backlog = __atomic_load_n(&rcl->backlog, __ATOMIC_RELAXED);
+}
@@ -16,11 +16,14 @@
 #include "common.h"
 #include "err_hnd.h"
 #include "atomic.h"
+#include "ringbuf.h"
+#include "ringset.h"
+#include "ringwait.h"
 
 #define SUPPORTED_FLAGS (P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_MPENQ | \
 			 P64_RINGBUF_F_SCDEQ | P64_RINGBUF_F_MCDEQ | \
 			 P64_RINGBUF_F_NBENQ | P64_RINGBUF_F_NBDEQ | \
-			 P64_RINGBUF_F_LFDEQ)
+			 P64_RINGBUF_F_LFDEQ | P64_RINGBUF_F_WAIT)
 
 //0 means Single producer/consumer
 #define FLAG_BLK      0x0001
@@ -31,12 +34,8 @@
 #define PROD_FLAGS(rb) ((((uintptr_t)rb)     ) & FLAG_MASK)
 #define CONS_FLAGS(rb) ((((uintptr_t)rb) >> 3) & FLAG_MASK)
 #define RB(rb) ((p64_ringbuf_t *)((uintptr_t)rb & ~0x3FUL))
-//Need to ensure the ring buffer is at least 64-byte aligned
-#if CACHE_LINE >= 64
-#define RB_ALIGNMENT CACHE_LINE
-#else
-#define RB_ALIGNMENT 64
-#endif
+//RINGBUF_ALIGNMENT in ringbuf.h ensures the ring buffer is at least 64-byte
+//aligned
 
 typedef uint32_t ringidx_t;
 #define MAXELEMS 0xFFFFFFFF
@@ -68,22 +67,29 @@ struct p64_ringbuf
     _Alignas(CACHE_LINE)
     union endpoint prod;
     ringidx_t prod_mask;//Mask must be directly after the endpoint member
+    uint32_t prod_wake;//Producers wake up sleeping consumers
+    struct ringset_member *member;//Ring set to mark on enqueue
 #ifdef USE_SPLIT_PRODCONS
     _Alignas(CACHE_LINE)
 #endif
     union endpoint cons;//head & tail are swapped for consumer metadata
     ringidx_t cons_mask;//Mask must be directly after the endpoint member
+    uint32_t cons_wake;//Consumers wake up sleeping producers
+    _Alignas(CACHE_LINE)
+    uint32_t notempty;//Futex word for consumers waiting for elements
+    uint32_t notfull;//Futex word for producers waiting for space
+    uint32_t flags;//Allocation flags, used by attach
     _Alignas(CACHE_LINE)
     void *ring[];
 };
 
-p64_ringbuf_t *
-p64_ringbuf_alloc(uint32_t nelems, uint32_t flags, size_t esize)
+bool
+ringbuf_check(uint32_t nelems, uint32_t flags)
 {
     if (nelems == 0 || nelems > MAXELEMS)
     {
 	report_error("ringbuf", "invalid number of elements", nelems);
-	return NULL;
+	return false;
     }
     //Can't specify both single-producer and MP non-blocking enqueue
     uint32_t invalid_combo0 = P64_RINGBUF_F_SPENQ | P64_RINGBUF_F_NBENQ;
@@ -100,33 +106,115 @@ p64_ringbuf_alloc(uint32_t nelems, uint32_t flags, size_t esize)
 	(flags & invalid_combo3) == invalid_combo3)
     {
 	report_error("ringbuf", "invalid flags", flags);
-	return NULL;
+	return false;
     }
+    return true;
+}
+
+//Return ring buffer handle with producer and consumer flags in the lsb
+static inline p64_ringbuf_t *
+make_handle(p64_ringbuf_t *rb, uint32_t flags)
+{
+    uint32_t prod_flags, cons_flags;
+    prod_flags = (flags & P64_RINGBUF_F_SPENQ) ? 0 ://SPENQ
+		 (flags & P64_RINGBUF_F_NBENQ) ? FLAG_NONBLK ://NBENQ
+		 FLAG_BLK;//MPENQ
+    cons_flags = (flags & P64_RINGBUF_F_SCDEQ) ? 0 ://SCDEQ
+		 (flags & P64_RINGBUF_F_NBDEQ) ? FLAG_NONBLK ://NBDEQ
+		 FLAG_BLK;//MCDEQ
+    cons_flags |= (flags & P64_RINGBUF_F_LFDEQ) ? FLAG_LOCKFREE : 0;
+    return (p64_ringbuf_t *)((uintptr_t)rb | (cons_flags << 3) | prod_flags);
+}
+
+size_t
+ringbuf_size(uint32_t nelems, size_t esize)
+{
     uint64_t ringsz = ROUNDUP_POW2(nelems);
-    size_t nbytes = sizeof(p64_ringbuf_t) + ringsz * esize;
-    p64_ringbuf_t *rb = p64_malloc(nbytes, RB_ALIGNMENT);
-    if (rb != NULL)
+    return ROUNDUP(sizeof(p64_ringbuf_t) + ringsz * esize, RINGBUF_ALIGNMENT);
+}
+
+p64_ringbuf_t *
+ringbuf_init(void *mem, uint32_t nelems, uint32_t flags)
+{
+    p64_ringbuf_t *rb = mem;
+    uint64_t ringsz = ROUNDUP_POW2(nelems);
+    rb->prod.head.cur = 0;
+    rb->prod.head.pend = 0;
+    rb->prod.tail = 0;
+    rb->prod.capacity = nelems;
+    rb->prod_mask = ringsz - 1;
+    rb->prod_wake = (flags & P64_RINGBUF_F_WAIT) != 0;
+    rb->member = NULL;
+    rb->cons.head.cur = 0;
+    rb->cons.head.pend = 0;
+    rb->cons.tail = 0;
+    rb->cons.capacity = 0;
+    rb->cons_mask = ringsz - 1;
+    rb->cons_wake = (flags & P64_RINGBUF_F_WAIT) != 0;
+    rb->notempty = 0;
+    rb->notfull = 0;
+    rb->flags = flags;
+    return make_handle(rb, flags);
+}
+
+size_t
+p64_ringbuf_size(uint32_t nelems, size_t esize)
+{
+    if (nelems == 0 || nelems > MAXELEMS)
+    {
+	report_error("ringbuf", "invalid number of elements", nelems);
+	return 0;
+    }
+    return ringbuf_size(nelems, esize);
+}
+
+p64_ringbuf_t *
+p64_ringbuf_init(void *mem, uint32_t nelems, uint32_t flags, size_t esize)
+{
+    (void)esize;//Only needed for size
+    if ((uintptr_t)mem % RINGBUF_ALIGNMENT != 0)
+    {
+	report_error("ringbuf", "invalid memory alignment", mem);
+	return NULL;
+    }
+    if (!ringbuf_check(nelems, flags))
+    {
+	return NULL;
+    }
+    return ringbuf_init(mem, nelems, flags);
+}
+
+p64_ringbuf_t *
+p64_ringbuf_attach(void *mem)
+{
+    if ((uintptr_t)mem % RINGBUF_ALIGNMENT != 0)
+    {
+	report_error("ringbuf", "invalid memory alignment", mem);
+	return NULL;
+    }
+    //The handle is process-local, recreate it from the saved flags
+    p64_ringbuf_t *rb = mem;
+    return make_handle(rb, rb->flags);
+}
+
+bool
+ringbuf_empty(p64_ringbuf_t *rb)
+{
+    rb = RB(rb);
+    return rb->prod.head.cur == rb->cons.head/*tail*/.cur;
+}
+
+p64_ringbuf_t *
+p64_ringbuf_alloc(uint32_t nelems, uint32_t flags, size_t esize)
+{
+    if (!ringbuf_check(nelems, flags))
+    {
+	return NULL;
+    }
+    void *mem = p64_malloc(ringbuf_size(nelems, esize), RINGBUF_ALIGNMENT);
+    if (mem != NULL)
     {
-	uint32_t prod_flags, cons_flags;
-	rb->prod.head.cur = 0;
-	rb->prod.head.pend = 0;
-	rb->prod.tail = 0;
-	rb->prod.capacity = nelems;
-	rb->prod_mask = ringsz - 1;
-	    prod_flags = (flags & P64_RINGBUF_F_SPENQ) ? 0 ://SPENQ
-			 (flags & P64_RINGBUF_F_NBENQ) ? FLAG_NONBLK ://NBENQ
-			 FLAG_BLK;//MPENQ
-	rb->cons.head.cur = 0;
-	rb->cons.head.pend = 0;
-	rb->cons.tail = 0;
-	rb->cons.capacity = 0;
-	rb->cons_mask = ringsz - 1;
-	    cons_flags = (flags & P64_RINGBUF_F_SCDEQ) ? 0 ://SCDEQ
-			 (flags & P64_RINGBUF_F_NBDEQ) ? FLAG_NONBLK ://NBDEQ
-			 FLAG_BLK;//MCDEQ
-	    cons_flags |= (flags & P64_RINGBUF_F_LFDEQ) ? FLAG_LOCKFREE : 0;
-	rb = (p64_ringbuf_t *)((uintptr_t)rb | (cons_flags << 3) | prod_flags);
-	return rb;
+	return ringbuf_init(mem, nelems, flags);
     }
     return NULL;
 }
@@ -143,13 +231,12 @@ p64_ringbuf_free(p64_ringbuf_t *rb)
 {
     if (rb != NULL)
     {
-	rb = RB(rb);
-	if (rb->prod.head.cur != rb->cons.head/*tail*/.cur)
+	if (!ringbuf_empty(rb))
 	{
-	    report_error("ringbuf", "ring buffer not empty", rb);
+	    report_error("ringbuf", "ring buffer not empty", RB(rb));
 	    return;
 	}
-	p64_mfree(rb);
+	p64_mfree(RB(rb));
     }
 }
 
@@ -165,12 +252,14 @@ acquire_slots(ringidx_t *headp,
 	      ringidx_t *tailp,
 	      ringidx_t mask,
 	      int n,
+	      int min,
 	      ringidx_t capacity)
 {
     ringidx_t tail = atomic_load_n(tailp, __ATOMIC_RELAXED);
     ringidx_t head = atomic_load_n(headp, __ATOMIC_ACQUIRE);
     int actual = MIN(n, (int)(capacity + head - tail));
-    if (UNLIKELY(actual <= 0))
+    //Fail unless at least 'min' slots can be acquired
+    if (UNLIKELY(actual < min))
     {
 	return (p64_ringbuf_result_t){ .index = 0, .actual = 0, .mask = 0 };
     }
@@ -180,7 +269,8 @@ acquire_slots(ringidx_t *headp,
 //MT-safe multi producer/consumer code
 static inline p64_ringbuf_result_t
 acquire_slots_mtsafe(union endpoint *ep,
-		     int n)
+		     int n,
+		     int min)
 {
     union endpoint mem;
     uint32_t mask;
@@ -209,7 +299,7 @@ acquire_slots_mtsafe(union endpoint *ep,
 	mem.head.cur = atomic_load_n(&ep->head.cur, __ATOMIC_ACQUIRE);
 #endif
 	actual = MIN(n, (int)(mem.capacity + mem.head.cur - mem.tail));
-	if (UNLIKELY(actual <= 0))
+	if (UNLIKELY(actual < min))
 	{
 	    return (p64_ringbuf_result_t){ .index = 0, .actual = 0, .mask = 0 };
 	}
@@ -315,12 +405,12 @@ p64_ringbuf_acquire_(p64_ringbuf_t *rb,
 	    //Consumer metadata is swapped: cons.tail<->cons.head
 	    r = acquire_slots(&rb->prod.head.cur,
 			      &rb->cons.head/*tail*/.cur,
-			      rb->prod_mask, num, rb->prod.capacity);
+			      rb->prod_mask, num, 1, rb->prod.capacity);
 	}
 	else
 	{
 	    //MT-safe multi producer code
-	    r = acquire_slots_mtsafe(&rb->prod, num);
+	    r = acquire_slots_mtsafe(&rb->prod, num, 1);
 	}
     }
     else //dequeue
@@ -357,12 +447,12 @@ p64_ringbuf_acquire_(p64_ringbuf_t *rb,
 	    //Consumer metadata is swapped: cons.tail<->cons.head
 	    r = acquire_slots(&rb->cons.head/*tail*/.cur,
 			      &rb->prod.head.cur,
-			      rb->cons_mask, num, 0);
+			      rb->cons_mask, num, 1, 0);
 	}
 	else
 	{
 	    //MT-safe multi consumer code
-	    r = acquire_slots_mtsafe(&rb->cons, num);
+	    r = acquire_slots_mtsafe(&rb->cons, num, 1);
 	}
     }
     r.ring = rb->ring;
@@ -382,6 +472,14 @@ p64_ringbuf_release_(p64_ringbuf_t *rb,
     {
 	//Consumer metadata is swapped: cons.tail<->cons.head
 	release_slots(&rb->cons.head/*tail*/, r.index, r.actual, prod_flags);
+	if (UNLIKELY(rb->prod_wake))
+	{
+	    ringwait_signal(&rb->notempty);
+	}
+	if (UNLIKELY(rb->member != NULL))
+	{
+	    ringset_mark(rb->member);
+	}
 	return true;//Success
     }
     else //dequeue
@@ -393,9 +491,17 @@ p64_ringbuf_release_(p64_ringbuf_t *rb,
 						       r.index + r.actual,
 						       __ATOMIC_RELEASE,
 						       __ATOMIC_RELAXED);
+	    if (success && UNLIKELY(rb->cons_wake))
+	    {
+		ringwait_signal(&rb->notfull);
+	    }
 	    return success;
 	}
 	release_slots(&rb->prod.head, r.index, r.actual, cons_flags);
+	if (UNLIKELY(rb->cons_wake))
+	{
+	    ringwait_signal(&rb->notfull);
+	}
 	return true;//Success
     }
 }
@@ -455,12 +561,12 @@ p64_ringbuf_enqueue(p64_ringbuf_t *rb,
 	//Consumer metadata is swapped: cons.tail<->cons.head
 	r = acquire_slots(&rb->prod.head.cur,
 			  &rb->cons.head/*tail*/.cur,
-			  rb->prod_mask, num, rb->prod.capacity);
+			  rb->prod_mask, num, 1, rb->prod.capacity);
     }
     else//MPENQ or NBENQ
     {
 	//MT-safe multi producer code
-	r = acquire_slots_mtsafe(&rb->prod, num);
+	r = acquire_slots_mtsafe(&rb->prod, num, 1);
     }
     if (UNLIKELY(r.actual == 0))
     {
@@ -473,6 +579,14 @@ p64_ringbuf_enqueue(p64_ringbuf_t *rb,
     //Step 3: release slots to consumer
     //Consumer metadata is swapped: cons.tail<->cons.head
     release_slots(&rb->cons.head/*tail*/, r.index, r.actual, prod_flags);
+    if (UNLIKELY(rb->prod_wake))
+    {
+	ringwait_signal(&rb->notempty);
+    }
+    if (UNLIKELY(rb->member != NULL))
+    {
+	ringset_mark(rb->member);
+    }
 
     return r.actual;
 }
@@ -505,13 +619,14 @@ read_slots(void *const *restrict rbring,
     }
 }
 
-//Dequeue elements from head
+//Dequeue at least 'min' (>= 1) and at most 'num' elements from head
 UNROLL_LOOPS
-uint32_t
-p64_ringbuf_dequeue(p64_ringbuf_t *rb,
-		    void **restrict ev,
-		    uint32_t num,
-		    uint32_t *index)
+static inline uint32_t
+dequeue(p64_ringbuf_t *rb,
+	void **restrict ev,
+	uint32_t num,
+	uint32_t *index,
+	uint32_t min)
 {
     uint32_t cons_flags = CONS_FLAGS(rb);
     rb = RB(rb);
@@ -534,7 +649,7 @@ p64_ringbuf_dequeue(p64_ringbuf_t *rb,
 	do
 	{
 	    actual = MIN((int)num, (int)(tail - head));
-	    if (UNLIKELY(actual <= 0))
+	    if (UNLIKELY(actual < (int)min))
 	    {
 		return 0;
 	    }
@@ -552,6 +667,10 @@ p64_ringbuf_dequeue(p64_ringbuf_t *rb,
 					    head + actual,
 					    __ATOMIC_RELEASE,
 					    __ATOMIC_RELAXED));
+	if (UNLIKELY(rb->cons_wake))
+	{
+	    ringwait_signal(&rb->notfull);
+	}
 	*index = head;
 	return actual;
     }
@@ -564,12 +683,12 @@ p64_ringbuf_dequeue(p64_ringbuf_t *rb,
 	//Consumer metadata is swapped: cons.tail<->cons.head
 	r = acquire_slots(&rb->cons.head/*tail*/.cur,
 			  &rb->prod.head.cur,
-			  rb->cons_mask, num, 0);
+			  rb->cons_mask, num, min, 0);
     }
     else//MCDEQ or NBDEQ
     {
 	//MT-safe multi consumer code
-	r = acquire_slots_mtsafe(&rb->cons, num);
+	r = acquire_slots_mtsafe(&rb->cons, num, min);
     }
     if (UNLIKELY(r.actual == 0))
     {
@@ -581,7 +700,155 @@ p64_ringbuf_dequeue(p64_ringbuf_t *rb,
 
     //Step 3: release slots to producer
     release_slots(&rb->prod.head, r.index, r.actual, cons_flags);
+    if (UNLIKELY(rb->cons_wake))
+    {
+	ringwait_signal(&rb->notfull);
+    }
 
     *index = r.index;
     return r.actual;
 }
+
+uint32_t
+p64_ringbuf_dequeue(p64_ringbuf_t *rb,
+		    void **restrict ev,
+		    uint32_t num,
+		    uint32_t *index)
+{
+    return dequeue(rb, ev, num, index, 1);
+}
+
+uint32_t
+p64_ringbuf_dequeue_min(p64_ringbuf_t *rb,
+			void **restrict ev,
+			uint32_t num,
+			uint32_t *index,
+			uint32_t min)
+{
+    if (UNLIKELY(min > num))
+    {
+	report_error("ringbuf", "invalid minimum number of elements", min);
+	return 0;
+    }
+    return dequeue(rb, ev, num, index, MAX(min, 1U));
+}
+
+void
+ringbuf_set_member(p64_ringbuf_t *rb, struct ringset_member *m)
+{
+    RB(rb)->member = m;
+}
+
+struct waitarg
+{
+    p64_ringbuf_t *rb;
+    uint32_t flags;
+    uint32_t min;
+};
+
+//Check if at least 'min' elements are available to consumers
+static bool
+elems_avail(void *arg)
+{
+    const struct waitarg *wa = arg;
+    p64_ringbuf_t *rb = wa->rb;
+    //Consumer metadata is swapped: cons.tail<->cons.head
+    ringidx_t tail = atomic_load_n(&rb->cons.head/*tail*/.cur, __ATOMIC_RELAXED);
+    ringidx_t head;
+    if ((wa->flags & (FLAG_BLK | FLAG_NONBLK)) && !(wa->flags & FLAG_LOCKFREE))
+    {
+	//MT-safe multi consumer code acquires slots using cons.tail
+	head = atomic_load_n(&rb->cons.tail, __ATOMIC_RELAXED);
+    }
+    else
+    {
+	head = atomic_load_n(&rb->prod.head.cur, __ATOMIC_RELAXED);
+    }
+    return (int)(tail - head) >= (int)wa->min;
+}
+
+//Check if at least 'min' slots are available to producers
+static bool
+space_avail(void *arg)
+{
+    const struct waitarg *wa = arg;
+    p64_ringbuf_t *rb = wa->rb;
+    ringidx_t head = atomic_load_n(&rb->prod.head.cur, __ATOMIC_RELAXED);
+    ringidx_t tail;
+    if (wa->flags & (FLAG_BLK | FLAG_NONBLK))
+    {
+	//MT-safe multi producer code acquires slots using prod.tail
+	tail = atomic_load_n(&rb->prod.tail, __ATOMIC_RELAXED);
+    }
+    else
+    {
+	//Consumer metadata is swapped: cons.tail<->cons.head
+	tail = atomic_load_n(&rb->cons.head/*tail*/.cur, __ATOMIC_RELAXED);
+    }
+    return (int)(rb->prod.capacity + head - tail) >= (int)wa->min;
+}
+
+uint32_t
+p64_ringbuf_enqueue_wait(p64_ringbuf_t *rb,
+			 void *const ev[],
+			 uint32_t num,
+			 uint64_t tmo_ns)
+{
+    struct waitarg wa = { RB(rb), PROD_FLAGS(rb), 1 };
+    if (UNLIKELY(!wa.rb->prod_wake))
+    {
+	report_error("ringbuf", "ring buffer not allocated with F_WAIT", 0);
+	return 0;
+    }
+    uint64_t deadline = ringwait_deadline(tmo_ns);
+    uint32_t actual = 0;
+    for (;;)
+    {
+	actual += p64_ringbuf_enqueue(rb, ev + actual, num - actual);
+	if (actual == num)
+	{
+	    return actual;
+	}
+	//Ring buffer full, wait for consumers to release slots
+	if (!ringwait_wait(&wa.rb->notfull, &wa.rb->prod.head.cur,
+			   space_avail, &wa, deadline))
+	{
+	    //Timeout
+	    return actual;
+	}
+    }
+}
+
+uint32_t
+p64_ringbuf_dequeue_wait(p64_ringbuf_t *rb,
+			 void *ev[],
+			 uint32_t num,
+			 uint32_t *index,
+			 uint32_t min,
+			 uint64_t tmo_ns)
+{
+    struct waitarg wa = { RB(rb), CONS_FLAGS(rb), MIN(MAX(min, 1U), num) };
+    if (UNLIKELY(!wa.rb->cons_wake))
+    {
+	report_error("ringbuf", "ring buffer not allocated with F_WAIT", 0);
+	return 0;
+    }
+    if (UNLIKELY(num == 0))
+    {
+	return 0;
+    }
+    uint64_t deadline = ringwait_deadline(tmo_ns);
+    for (;;)
+    {
+	//Consumer metadata is swapped: cons.tail<->cons.head
+	bool avail = ringwait_wait(&wa.rb->notempty, &wa.rb->cons.head/*tail*/.cur,
+				   elems_avail, &wa, deadline);
+	//On timeout, dequeue any (less than 'min') available elements
+	uint32_t actual = p64_ringbuf_dequeue(rb, ev, num, index);
+	if (actual != 0 || !avail)
+	{
+	    return actual;
+	}
+	//Else other consumers took the elements, wait again
+    }
+}
@@ -0,0 +1,230 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "p64_ringset.h"
+#include "build_config.h"
+#include "os_abstraction.h"
+
+#include "atomic.h"
+#include "common.h"
+#include "err_hnd.h"
+#include "ringset.h"
+#include "ringwait.h"
+
+#define SUPPORTED_FLAGS P64_RINGSET_F_WAIT
+
+p64_ringset_t *
+p64_ringset_alloc(uint32_t flags)
+{
+    if ((flags & ~SUPPORTED_FLAGS) != 0)
+    {
+	report_error("ringset", "invalid flags", flags);
+	return NULL;
+    }
+    p64_ringset_t *set = p64_malloc(sizeof(p64_ringset_t), CACHE_LINE);
+    if (set != NULL)
+    {
+	set->ready = 0;
+	set->futex = 0;
+	set->wait = (flags & P64_RINGSET_F_WAIT) != 0;
+	set->next = 0;
+	for (uint32_t i = 0; i < RINGSET_MAXRINGS; i++)
+	{
+	    set->members[i].set = set;
+	    set->members[i].bit = UINT64_C(1) << i;
+	    set->members[i].ring = NULL;
+	    set->members[i].lfring = false;
+	}
+    }
+    return set;
+}
+
+void
+p64_ringset_free(p64_ringset_t *set)
+{
+    if (set != NULL)
+    {
+	for (uint32_t i = 0; i < RINGSET_MAXRINGS; i++)
+	{
+	    if (set->members[i].ring != NULL)
+	    {
+		p64_ringset_remove(set, i);
+	    }
+	}
+	p64_mfree(set);
+    }
+}
+
+static int32_t
+add_ring(p64_ringset_t *set, void *ring, bool lfring)
+{
+    for (uint32_t i = 0; i < RINGSET_MAXRINGS; i++)
+    {
+	struct ringset_member *m = &set->members[i];
+	if (m->ring == NULL)
+	{
+	    m->lfring = lfring;
+	    atomic_store_ptr(&m->ring, ring, __ATOMIC_RELEASE);
+	    if (lfring)
+	    {
+		lfring_set_member(ring, m);
+	    }
+	    else
+	    {
+		ringbuf_set_member(ring, m);
+	    }
+	    //The ring might already contain elements
+	    atomic_fetch_or(&set->ready, m->bit, __ATOMIC_RELEASE);
+	    return (int32_t)i;
+	}
+    }
+    report_error("ringset", "too many rings", RINGSET_MAXRINGS);
+    return -1;
+}
+
+int32_t
+p64_ringset_add_ringbuf(p64_ringset_t *set, p64_ringbuf_t *rb)
+{
+    return add_ring(set, rb, false);
+}
+
+int32_t
+p64_ringset_add_lfring(p64_ringset_t *set, p64_lfring_t *lfr)
+{
+    return add_ring(set, lfr, true);
+}
+
+void
+p64_ringset_remove(p64_ringset_t *set, uint32_t ringidx)
+{
+    if (ringidx >= RINGSET_MAXRINGS || set->members[ringidx].ring == NULL)
+    {
+	report_error("ringset", "invalid ring index", ringidx);
+	return;
+    }
+    struct ringset_member *m = &set->members[ringidx];
+    if (m->lfring)
+    {
+	lfring_set_member(m->ring, NULL);
+    }
+    else
+    {
+	ringbuf_set_member(m->ring, NULL);
+    }
+    atomic_store_ptr(&m->ring, NULL, __ATOMIC_RELAXED);
+    atomic_fetch_and(&set->ready, ~m->bit, __ATOMIC_RELAXED);
+}
+
+uint64_t
+p64_ringset_ready(p64_ringset_t *set)
+{
+    return atomic_load_n(&set->ready, __ATOMIC_ACQUIRE);
+}
+
+//Return index of first set bit at or after 'start', wrapping around
+static inline uint32_t
+find_ready(uint64_t ready, uint32_t start)
+{
+    uint64_t rot = start == 0 ? ready : (ready >> start) | (ready << (64 - start));
+    return (start + __builtin_ctzll(rot)) % RINGSET_MAXRINGS;
+}
+
+uint32_t
+p64_ringset_dequeue(p64_ringset_t *set,
+		    void *ev[],
+		    uint32_t num,
+		    uint32_t *ringidx)
+{
+    if (UNLIKELY(num == 0))
+    {
+	return 0;
+    }
+    uint32_t start = atomic_load_n(&set->next, __ATOMIC_RELAXED);
+    uint64_t ready = atomic_load_n(&set->ready, __ATOMIC_RELAXED);
+    while (ready != 0)
+    {
+	uint32_t i = find_ready(ready, start);
+	struct ringset_member *m = &set->members[i];
+	//Clear ready bit before dequeue, a producer which releases elements
+	//after our dequeue will set the bit again
+	//Order the clearing of the bit before reading the ring, pairs with
+	//the fence in ringset_mark()
+	ready = atomic_fetch_and(&set->ready, ~m->bit, __ATOMIC_SEQ_CST);
+	ready &= ~m->bit;
+	void *ring = atomic_load_ptr(&m->ring, __ATOMIC_ACQUIRE);
+	if (UNLIKELY(ring == NULL))
+	{
+	    //Ring was removed
+	    continue;
+	}
+	uint32_t index, actual;
+	if (m->lfring)
+	{
+	    actual = p64_lfring_dequeue(ring, ev, num, &index);
+	}
+	else
+	{
+	    actual = p64_ringbuf_dequeue(ring, ev, num, &index);
+	}
+	if (actual != 0)
+	{
+	    if (actual == num)
+	    {
+		//Ring might contain more elements
+		atomic_fetch_or(&set->ready, m->bit, __ATOMIC_RELAXED);
+	    }
+	    //Continue with next ring next time
+	    atomic_store_n(&set->next, (i + 1) % RINGSET_MAXRINGS, __ATOMIC_RELAXED);
+	    *ringidx = i;
+	    return actual;
+	}
+	//Else ring was empty
+    }
+    return 0;
+}
+
+static bool
+any_ready(void *arg)
+{
+    p64_ringset_t *set = arg;
+    return atomic_load_n(&set->ready, __ATOMIC_RELAXED) != 0;
+}
+
+uint32_t
+p64_ringset_dequeue_wait(p64_ringset_t *set,
+			 void *ev[],
+			 uint32_t num,
+			 uint32_t *ringidx,
+			 uint64_t tmo_ns)
+{
+    if (UNLIKELY(!set->wait))
+    {
+	report_error("ringset", "ring set not allocated with F_WAIT", 0);
+	return 0;
+    }
+    if (UNLIKELY(num == 0))
+    {
+	return 0;
+    }
+    uint64_t deadline = ringwait_deadline(tmo_ns);
+    for (;;)
+    {
+	uint32_t actual = p64_ringset_dequeue(set, ev, num, ringidx);
+	if (actual != 0)
+	{
+	    return actual;
+	}
+	//Only the address of the bitmap is used for monitoring
+	if (!ringwait_wait(&set->futex, (const uint32_t *)&set->ready,
+			   any_ready, set, deadline))
+	{
+	    //Timeout
+	    return 0;
+	}
+    }
+}
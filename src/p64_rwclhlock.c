@@ -120,6 +120,12 @@ p64_rwclhlock_fini(p64_rwclhlock_t *lock)
     p64_mfree(lock->tail);
 }
 
+void
+p64_rwclhlock_free_node(p64_rwclhnode_t *node)
+{
+    p64_mfree(node);
+}
+
 //Wait for previous thread to signal us (using their node)
 static void
 wait_prev(int *loc, int sig, uint32_t spin_tmo)
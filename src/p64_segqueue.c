@@ -0,0 +1,340 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Based on the FAA array queue by Correia & Ramalhete which simplifies the
+//LCRQ by Morrison & Afek, each segment is used only once so slots never
+//need to be recycled within a segment
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "p64_segqueue.h"
+#include "p64_ebr.h"
+#include "p64_hazardera.h"
+#include "p64_hazardptr.h"
+#include "p64_qsbr.h"
+#include "build_config.h"
+#include "os_abstraction.h"
+
+#include "atomic.h"
+#include "common.h"
+#include "err_hnd.h"
+
+//Marks a slot from which a consumer has dequeued (or attempted to dequeue)
+static const char taken_marker;
+#define TAKEN ((void *)&taken_marker)
+
+struct segment
+{
+    uint32_t deqidx ALIGNED(CACHE_LINE);
+    uint32_t enqidx ALIGNED(CACHE_LINE);
+    struct segment *next ALIGNED(CACHE_LINE);
+    uint64_t birth;//Birth era when using hazard eras
+    void *slots[] ALIGNED(CACHE_LINE);
+};
+
+struct p64_segqueue
+{
+    struct segment *head ALIGNED(CACHE_LINE);
+    struct segment *tail ALIGNED(CACHE_LINE);
+    uint32_t segsize;
+    uint32_t smr;
+    p64_qsbrdomain_t *qsbr;//Domain of segments when using QSBR
+    p64_memsrc_t mem;//Source of segments
+};
+
+#define SMR_QSBR 0
+#define SMR_HP   P64_SEGQUEUE_F_HP
+#define SMR_EBR  P64_SEGQUEUE_F_EBR
+#define SMR_HE   P64_SEGQUEUE_F_HE
+
+#define VALID_FLAGS (P64_SEGQUEUE_F_HP | P64_SEGQUEUE_F_EBR | P64_SEGQUEUE_F_HE)
+
+//Handle for a reference to a segment
+union smr_ref
+{
+    p64_hazardptr_t hp;
+    p64_hazardera_t he;
+};
+
+static struct segment *
+alloc_segment(const p64_memsrc_t *mem, uint32_t segsize)
+{
+    size_t sz = sizeof(struct segment) + segsize * sizeof(void *);
+    struct segment *seg = p64_malloc_src(mem, sz, CACHE_LINE);
+    if (seg != NULL)
+    {
+	seg->deqidx = 0;
+	seg->enqidx = 0;
+	seg->next = NULL;
+	seg->birth = 0;//Older than all eras, set when appended
+	for (uint32_t i = 0; i < segsize; i++)
+	{
+	    seg->slots[i] = NULL;
+	}
+    }
+    return seg;
+}
+
+static inline void
+smr_acquire(union smr_ref *ref, uint32_t smr)
+{
+    switch (smr)
+    {
+	case SMR_QSBR :
+	    p64_qsbr_acquire();
+	    break;
+	case SMR_HP :
+	    ref->hp = P64_HAZARDPTR_NULL;
+	    break;
+	case SMR_EBR :
+	    p64_ebr_enter();
+	    break;
+	case SMR_HE :
+	    ref->he = P64_HAZARDERA_NULL;
+	    break;
+    }
+}
+
+static inline struct segment *
+smr_load(struct segment **pptr, union smr_ref *ref, uint32_t smr)
+{
+    if (UNLIKELY(smr == SMR_HP))
+    {
+	return p64_hazptr_acquire(pptr, &ref->hp);
+    }
+    else if (UNLIKELY(smr == SMR_HE))
+    {
+	return p64_hazera_acquire(pptr, &ref->he);
+    }
+    return atomic_load_ptr(pptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+smr_release(union smr_ref *ref, uint32_t smr)
+{
+    switch (smr)
+    {
+	case SMR_QSBR :
+	    p64_qsbr_release();
+	    break;
+	case SMR_HP :
+	    p64_hazptr_release(&ref->hp);
+	    break;
+	case SMR_EBR :
+	    p64_ebr_exit();
+	    break;
+	case SMR_HE :
+	    p64_hazera_release(&ref->he);
+	    break;
+    }
+}
+
+static inline void
+smr_retire(p64_segqueue_t *sq, struct segment *seg)
+{
+    switch (sq->smr)
+    {
+	case SMR_QSBR :
+	    while (!p64_qsbr_retire_domain(sq->qsbr, seg, p64_mfree))
+	    {
+		doze();
+	    }
+	    break;
+	case SMR_HP :
+	    while (!p64_hazptr_retire(seg, p64_mfree))
+	    {
+		doze();
+	    }
+	    break;
+	case SMR_EBR :
+	    while (!p64_ebr_retire(seg, p64_mfree))
+	    {
+		doze();
+	    }
+	    break;
+	case SMR_HE :
+	    while (!p64_hazera_retire(seg, seg->birth, p64_mfree))
+	    {
+		doze();
+	    }
+	    break;
+    }
+}
+
+p64_segqueue_t *
+p64_segqueue_alloc(uint32_t segsize, uint32_t flags)
+{
+    if (segsize == 0 || segsize > 0x80000000)
+    {
+	report_error("segqueue", "invalid segment size", segsize);
+	return NULL;
+    }
+    if ((flags & ~VALID_FLAGS) || (flags & (flags - 1)) != 0)
+    {
+	report_error("segqueue", "invalid flags", flags);
+	return NULL;
+    }
+    p64_segqueue_t *sq = p64_malloc(sizeof(p64_segqueue_t), CACHE_LINE);
+    if (sq != NULL)
+    {
+	p64_memsrc_get(&sq->mem);
+	struct segment *seg = alloc_segment(&sq->mem, segsize);
+	if (seg == NULL)
+	{
+	    p64_mfree(sq);
+	    return NULL;
+	}
+	sq->head = seg;
+	sq->tail = seg;
+	sq->segsize = segsize;
+	sq->smr = flags;
+	sq->qsbr = flags == SMR_QSBR ? p64_qsbr_domain() : NULL;
+    }
+    return sq;
+}
+
+void
+p64_segqueue_free(p64_segqueue_t *sq)
+{
+    if (sq != NULL)
+    {
+	struct segment *seg = sq->head;
+	if (seg->next != NULL || seg->deqidx < MIN(seg->enqidx, sq->segsize))
+	{
+	    report_error("segqueue", "queue not empty", sq);
+	    return;
+	}
+	p64_mfree(seg);
+	p64_mfree(sq);
+    }
+}
+
+bool
+p64_segqueue_enqueue(p64_segqueue_t *sq, void *elem)
+{
+    union smr_ref ref;
+    uint32_t segsize = sq->segsize;
+    uint32_t smr = sq->smr;
+    smr_acquire(&ref, smr);
+    for (;;)
+    {
+	struct segment *seg = smr_load(&sq->tail, &ref, smr);
+	uint32_t idx = atomic_fetch_add(&seg->enqidx, 1, __ATOMIC_RELAXED);
+	if (LIKELY(idx < segsize))
+	{
+	    void *old = NULL;
+	    if (atomic_compare_exchange_ptr(&seg->slots[idx],
+					    &old,
+					    elem,
+					    __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+	    {
+		smr_release(&ref, smr);
+		return true;
+	    }
+	    //Else a consumer took the slot before we wrote it, try again
+	    continue;
+	}
+	//Segment is full
+	struct segment *next = atomic_load_ptr(&seg->next, __ATOMIC_ACQUIRE);
+	if (next == NULL)
+	{
+	    //Append a new segment with our element in the first slot
+	    struct segment *neu = alloc_segment(&sq->mem, segsize);
+	    if (UNLIKELY(neu == NULL))
+	    {
+		smr_release(&ref, smr);
+		return false;
+	    }
+	    neu->enqidx = 1;
+	    neu->slots[0] = elem;
+	    if (smr == SMR_HE)
+	    {
+		neu->birth = p64_hazera_birth();
+	    }
+	    if (atomic_compare_exchange_ptr(&seg->next,
+					    &next,//Updated on failure
+					    neu,
+					    __ATOMIC_RELEASE,
+					    __ATOMIC_ACQUIRE))
+	    {
+		(void)atomic_compare_exchange_ptr(&sq->tail,
+						  &seg,
+						  neu,
+						  __ATOMIC_RELEASE,
+						  __ATOMIC_RELAXED);
+		smr_release(&ref, smr);
+		return true;
+	    }
+	    //Else some other producer appended a segment first
+	    p64_mfree(neu);
+	}
+	//Help moving tail to the next segment
+	(void)atomic_compare_exchange_ptr(&sq->tail,
+					  &seg,
+					  next,
+					  __ATOMIC_RELEASE,
+					  __ATOMIC_RELAXED);
+    }
+}
+
+void *
+p64_segqueue_dequeue(p64_segqueue_t *sq)
+{
+    union smr_ref ref;
+    uint32_t segsize = sq->segsize;
+    uint32_t smr = sq->smr;
+    void *elem = NULL;
+    smr_acquire(&ref, smr);
+    for (;;)
+    {
+	struct segment *seg = smr_load(&sq->head, &ref, smr);
+	uint32_t deqidx = atomic_load_n(&seg->deqidx, __ATOMIC_RELAXED);
+	uint32_t enqidx = atomic_load_n(&seg->enqidx, __ATOMIC_RELAXED);
+	if (deqidx >= MIN(enqidx, segsize) &&
+	    (deqidx < segsize ||
+	     atomic_load_ptr(&seg->next, __ATOMIC_ACQUIRE) == NULL))
+	{
+	    //Queue is empty, avoid taking slots from producers
+	    break;
+	}
+	uint32_t idx = atomic_fetch_add(&seg->deqidx, 1, __ATOMIC_RELAXED);
+	if (LIKELY(idx < segsize))
+	{
+	    elem = atomic_exchange_ptr(&seg->slots[idx], TAKEN, __ATOMIC_ACQUIRE);
+	    if (elem != NULL)
+	    {
+		break;
+	    }
+	    //Else producer has not yet written slot, it will have to retry
+	    continue;
+	}
+	//Segment is exhausted
+	struct segment *next = atomic_load_ptr(&seg->next, __ATOMIC_ACQUIRE);
+	if (next == NULL)
+	{
+	    //Queue is empty
+	    break;
+	}
+	//Tail must not point to a retired segment
+	struct segment *tail = seg;
+	(void)atomic_compare_exchange_ptr(&sq->tail,
+					  &tail,
+					  next,
+					  __ATOMIC_RELEASE,
+					  __ATOMIC_RELAXED);
+	if (atomic_compare_exchange_ptr(&sq->head,
+					&seg,
+					next,
+					__ATOMIC_RELEASE,
+					__ATOMIC_RELAXED))
+	{
+	    smr_retire(sq, seg);
+	}
+    }
+    smr_release(&ref, smr);
+    return elem;
+}
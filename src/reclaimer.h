@@ -0,0 +1,43 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#ifndef _RECLAIMER_H
+#define _RECLAIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "p64_reclaimer.h"
+
+struct reclaim_object
+{
+    void *ptr;
+    void (*cb)(void *);
+};
+
+//Batch of retired objects handed off to a reclaimer
+struct reclaim_batch
+{
+    struct reclaim_batch *next;
+    //Attempt to reclaim objects, remaining objects are compacted
+    //Return number of remaining objects
+    uint32_t (*reclaim)(struct reclaim_batch *batch);
+    void *domain;
+    uint64_t interval;//Last interval of objects when using QSBR
+    uint32_t nobjs;
+    uint32_t maxobjs;//Capacity of batch
+    struct reclaim_object objs[];
+};
+
+//Reserve backlog space for 'nobjs' objects and get an empty batch with room
+//for them, emptied batches are reused so normally nothing is allocated
+//Return NULL if backlog limit would be exceeded or allocation failed
+struct reclaim_batch *reclaimer_batch_get(p64_reclaimer_t *rcl,
+					  uint32_t nobjs);
+
+//Hand off a batch from reclaimer_batch_get() with at most the reserved number
+//of objects, the batch is then owned by the reclaimer
+void reclaimer_handoff(p64_reclaimer_t *rcl, struct reclaim_batch *batch);
+
+#endif
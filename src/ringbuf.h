@@ -0,0 +1,45 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Ring buffer internals for objects which embed ring buffers in their own
+//allocation
+
+#ifndef _RINGBUF_H
+#define _RINGBUF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "p64_ringbuf.h"
+#include "build_config.h"
+
+//Ring buffers must be at least 64-byte aligned as the lsb of the ring buffer
+//pointer hold the producer and consumer flags
+#if CACHE_LINE >= 64
+#define RINGBUF_ALIGNMENT CACHE_LINE
+#else
+#define RINGBUF_ALIGNMENT 64
+#endif
+
+//Check ring buffer parameters, report error and return false if invalid
+bool
+ringbuf_check(uint32_t nelems, uint32_t flags);
+
+//Return the number of bytes (multiple of RINGBUF_ALIGNMENT) required for a
+//ring buffer with 'nelems' elements of size 'esize'
+size_t
+ringbuf_size(uint32_t nelems, size_t esize);
+
+//Initialise a ring buffer in 'mem' which must be RINGBUF_ALIGNMENT aligned
+//and at least ringbuf_size() bytes
+//The parameters must have been checked by ringbuf_check()
+p64_ringbuf_t *
+ringbuf_init(void *mem, uint32_t nelems, uint32_t flags);
+
+//Return true if the ring buffer is empty
+bool
+ringbuf_empty(p64_ringbuf_t *rb);
+
+#endif
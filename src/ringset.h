@@ -0,0 +1,66 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Ring set internals shared with the ring buffer implementations
+
+#ifndef _RINGSET_H
+#define _RINGSET_H
+
+#include <stdint.h>
+
+#include "p64_ringset.h"
+#include "p64_ringbuf.h"
+#include "p64_lfring.h"
+#include "common.h"
+#include "atomic.h"
+#include "ringwait.h"
+
+//Each member ring has one bit in the ready bitmap
+#define RINGSET_MAXRINGS 64
+
+struct ringset_member
+{
+    p64_ringset_t *set;
+    uint64_t bit;
+    void *ring;//NULL if member slot unused
+    bool lfring;
+};
+
+struct p64_ringset
+{
+    uint64_t ready ALIGNED(CACHE_LINE);//Bitmap of non-empty rings
+    uint32_t futex;//Futex word for waiting consumers
+    uint32_t wait;//Producers wake up sleeping consumers
+    uint32_t next ALIGNED(CACHE_LINE);//Ring to start searching from
+    struct ringset_member members[RINGSET_MAXRINGS];
+};
+
+//Mark ring as non-empty, call after elements have been released
+static inline void
+ringset_mark(struct ringset_member *m)
+{
+    p64_ringset_t *set = m->set;
+    //Order release of elements before the check of the ready bit
+    //If the bit is seen set, the consumer will see our elements after
+    //clearing it
+    atomic_thread_fence(__ATOMIC_SEQ_CST);
+    //Avoid writing the shared bitmap if the bit is already set
+    if (!(atomic_load_n(&set->ready, __ATOMIC_RELAXED) & m->bit))
+    {
+	atomic_fetch_or(&set->ready, m->bit, __ATOMIC_RELEASE);
+    }
+    if (set->wait)
+    {
+	ringwait_signal(&set->futex);
+    }
+}
+
+//Set or clear (m == NULL) the ring set member of a ring
+void
+ringbuf_set_member(p64_ringbuf_t *rb, struct ringset_member *m);
+
+void
+lfring_set_member(p64_lfring_t *lfr, struct ringset_member *m);
+
+#endif
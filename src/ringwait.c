@@ -0,0 +1,206 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <limits.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#endif
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include <time.h>
+#include <unistd.h>
+
+#include "ringwait.h"
+#include "build_config.h"
+
+#include "arch.h"
+#include "atomic.h"
+#include "common.h"
+
+//Time to spin before using WFE or sleeping
+#define SPIN_NS 2000
+//Time to wait for event before sleeping, only used with WFE support
+//WFE wakes up at least every 100us from the Linux event stream
+#define WFE_NS 50000
+
+#define NS_PER_S UINT64_C(1000000000)
+
+#ifdef __linux__
+static inline int
+futex(uint32_t *uaddr,
+      int op,
+      int val,
+      const struct timespec *ts)
+{
+    //Not FUTEX_PRIVATE_FLAG, rings may be located in memory shared between
+    //processes
+    return syscall(SYS_futex, uaddr, op, val, ts, NULL, 0);
+}
+#endif
+
+//Sleep while '*loc' == 'val' but at most 'ns' nanoseconds
+static inline void
+futex_wait(uint32_t *loc, uint32_t val, uint64_t ns)
+{
+#ifdef __linux__
+    struct timespec ts = { .tv_sec = ns / NS_PER_S, .tv_nsec = ns % NS_PER_S };
+    if (futex(loc, FUTEX_WAIT, (int)val, &ts) < 0 &&
+	errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+    {
+	perror("futex(WAIT)");
+	abort();
+    }
+#else
+    (void)loc;
+    (void)val;
+    (void)ns;
+    doze();
+#endif
+}
+
+static inline void
+futex_wake(uint32_t *loc)
+{
+#ifdef __linux__
+    if (futex(loc, FUTEX_WAKE, INT_MAX, NULL) < 0)
+    {
+	perror("futex(WAKE)");
+	abort();
+    }
+#else
+    (void)loc;
+#endif
+}
+
+//Convert nanoseconds to counter ticks and back without overflow
+static inline uint64_t
+ns_to_ticks(uint64_t ns, uint64_t freq)
+{
+    return ns / NS_PER_S * freq + ns % NS_PER_S * freq / NS_PER_S;
+}
+
+static inline uint64_t
+ticks_to_ns(uint64_t ticks, uint64_t freq)
+{
+    return ticks / freq * NS_PER_S + ticks % freq * NS_PER_S / freq;
+}
+
+uint64_t
+ringwait_deadline(uint64_t tmo_ns)
+{
+    if (tmo_ns == RINGWAIT_FOREVER)
+    {
+	return RINGWAIT_FOREVER;
+    }
+    return counter_read() + ns_to_ticks(tmo_ns, counter_freq());
+}
+
+bool
+ringwait_wait(uint32_t *word,
+	      const uint32_t *watch,
+	      bool (*cond)(void *arg),
+	      void *arg,
+	      uint64_t deadline)
+{
+    if (cond(arg))
+    {
+	return true;
+    }
+    uint64_t freq = counter_freq();
+    uint64_t now = counter_read();
+
+    //Spin until the condition is true or the spin time has passed
+    uint64_t spin_end = MIN(now + ns_to_ticks(SPIN_NS, freq), deadline);
+    while ((now = counter_read()) < spin_end)
+    {
+	if (cond(arg))
+	{
+	    return true;
+	}
+	doze();
+    }
+#ifdef USE_WFE
+    //Wait for event, the exclusive monitor covers the whole granule
+    //containing 'watch' so any write close to it will wake us up
+    uint64_t wfe_end = MIN(spin_end + ns_to_ticks(WFE_NS, freq), deadline);
+    while ((now = counter_read()) < wfe_end)
+    {
+	(void)LDX((uint32_t *)watch, __ATOMIC_ACQUIRE);
+	if (cond(arg))
+	{
+	    return true;
+	}
+	WFE();
+    }
+#else
+    (void)watch;
+#endif
+
+    //Sleep until woken up by a signaller or timeout
+    uint32_t seq = atomic_load_n(word, __ATOMIC_RELAXED);
+    while (now < deadline)
+    {
+	if (!(seq & RINGWAIT_SLEEPERS))
+	{
+	    //Tell signallers that there is a sleeper
+	    if (!atomic_compare_exchange_n(word,
+					   &seq,//Updated on failure
+					   seq | RINGWAIT_SLEEPERS,
+					   __ATOMIC_RELAXED,
+					   __ATOMIC_RELAXED))
+	    {
+		continue;
+	    }
+	    seq |= RINGWAIT_SLEEPERS;
+	}
+	//Order the setting of the flag before the check of the condition
+	//Pairs with the fence in ringwait_signal()
+	atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (cond(arg))
+	{
+	    return true;
+	}
+	//Sleep at most one second at a time
+	uint64_t left_ns = deadline == RINGWAIT_FOREVER ? NS_PER_S :
+			   ticks_to_ns(deadline - now, freq);
+	futex_wait(word, seq, MIN(left_ns, NS_PER_S));
+	if (cond(arg))
+	{
+	    return true;
+	}
+	seq = atomic_load_n(word, __ATOMIC_RELAXED);
+	now = counter_read();
+    }
+    //Timeout, perform a final check
+    return cond(arg);
+}
+
+void
+ringwait_wake_(uint32_t *word)
+{
+    uint32_t seq = atomic_load_n(word, __ATOMIC_RELAXED);
+    do
+    {
+	if (!(seq & RINGWAIT_SLEEPERS))
+	{
+	    //Some other thread already woke up the sleepers
+	    return;
+	}
+    }
+    while (!atomic_compare_exchange_n(word,
+				      &seq,//Updated on failure
+				      (seq & ~RINGWAIT_SLEEPERS) + 2,
+				      __ATOMIC_RELAXED,
+				      __ATOMIC_RELAXED));
+    futex_wake(word);
+}
@@ -0,0 +1,57 @@
+//Copyright (c) 2026, ARM Limited. All rights reserved.
+//
+//SPDX-License-Identifier:        BSD-3-Clause
+
+//Blocking wait for ring buffer elements or space
+//Waiters first spin, then wait for event (Arm WFE) and finally sleep on a
+//futex. Sleepers set a flag in the futex word, signallers only make a
+//system call when the flag is set
+
+#ifndef _RINGWAIT_H
+#define _RINGWAIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "atomic.h"
+
+//Bit 0 of the futex word indicates sleepers, the other bits are a sequence
+//number which is incremented on each wake-up
+#define RINGWAIT_SLEEPERS 1U
+
+#define RINGWAIT_FOREVER UINT64_MAX
+
+//Return the counter value 'tmo_ns' nanoseconds from now
+//RINGWAIT_FOREVER is returned unchanged
+uint64_t
+ringwait_deadline(uint64_t tmo_ns);
+
+//Wait until 'cond(arg)' returns true or the counter passes 'deadline'
+//Changes to the location 'watch' are monitored when using WFE, it should be
+//written when the condition may have changed
+//Return false on timeout
+bool
+ringwait_wait(uint32_t *word,
+	      const uint32_t *watch,
+	      bool (*cond)(void *arg),
+	      void *arg,
+	      uint64_t deadline);
+
+void
+ringwait_wake_(uint32_t *word);
+
+//Wake up any sleepers, call after elements or slots have been released
+static inline void
+ringwait_signal(uint32_t *word)
+{
+    //Order release of elements or slots before the check for sleepers
+    //Pairs with the fence after the sleeper sets its flag
+    atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (UNLIKELY(atomic_load_n(word, __ATOMIC_RELAXED) & RINGWAIT_SLEEPERS))
+    {
+	ringwait_wake_(word);
+    }
+}
+
+#endif
@@ -4,17 +4,53 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "p64_threads.h"
 #include "common.h"
 #include "thr_idx.h"
 #include "build_config.h"
+#include "err_hnd.h"
 
-#define NWORDS ((MAXTHREADS + 63) / 64)
+static uint64_t thread_words[IDXMAP_NWORDS(P64_THREADS_LIMIT)];
 
-static uint64_t thread_words[NWORDS];
+//Default maximum number of threads is set by build configuration
+static uint32_t max_threads = MAXTHREADS;
+//Set when max_threads has been used and cannot be changed anymore
+static bool max_threads_fixed = false;
+
+bool
+p64_threads_setmax(uint32_t maxthreads)
+{
+    if (maxthreads < 1 || maxthreads > P64_THREADS_LIMIT)
+    {
+	report_error("threads", "invalid maxthreads", maxthreads);
+	return false;
+    }
+    if (__atomic_load_n(&max_threads_fixed, __ATOMIC_ACQUIRE))
+    {
+	report_error("threads", "maxthreads already in use", max_threads);
+	return false;
+    }
+    __atomic_store_n(&max_threads, maxthreads, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t
+p64_threads_getmax(void)
+{
+    return __atomic_load_n(&max_threads, __ATOMIC_ACQUIRE);
+}
+
+uint32_t
+p64_idx_maxthreads(void)
+{
+    __atomic_store_n(&max_threads_fixed, true, __ATOMIC_RELEASE);
+    return __atomic_load_n(&max_threads, __ATOMIC_ACQUIRE);
+}
 
 static pthread_once_t once = PTHREAD_ONCE_INIT;
 static pthread_key_t key;
@@ -95,13 +131,14 @@ p64_idx_alloc(void)
 	return ic.idx;
     }
 
-    for (uint32_t i = 0; i < NWORDS; i++)
+    uint32_t maxthreads = p64_idx_maxthreads();
+    for (uint32_t i = 0; i < IDXMAP_NWORDS(maxthreads); i++)
     {
 	uint64_t word = thread_words[i];
 	while (~word != 0)
 	{
 	    uint32_t bit = __builtin_ctzl(~word);
-	    if (64 * i + bit >= MAXTHREADS)
+	    if (64 * i + bit >= maxthreads)
 	    {
 		return -1;
 	    }
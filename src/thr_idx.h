@@ -10,4 +10,35 @@
 int32_t p64_idx_alloc(void);
 void p64_idx_free(int32_t idx);
 
+//Return the maximum number of threads, thread indexes are smaller than this
+//The limit is fixed after the first call
+uint32_t p64_idx_maxthreads(void);
+
+//Bitmaps of registered thread indexes
+//Scans of per-thread data only need to visit registered threads
+#define IDXMAP_NWORDS(n) (((n) + 63) / 64)
+
+static inline void
+idxmap_set(uint64_t map[], uint32_t idx)
+{
+    //Sequentially consistent so that a registration is ordered with the
+    //thread's first publication of references
+    __atomic_fetch_or(&map[idx / 64], UINT64_C(1) << (idx % 64),
+		      __ATOMIC_SEQ_CST);
+}
+
+static inline void
+idxmap_clr(uint64_t map[], uint32_t idx)
+{
+    __atomic_fetch_and(&map[idx / 64], ~(UINT64_C(1) << (idx % 64)),
+		       __ATOMIC_RELEASE);
+}
+
+//Iterate over all registered thread indexes smaller than 'num'
+#define IDXMAP_FOREACH(map, num, idx) \
+    for (uint32_t _w = 0; _w < IDXMAP_NWORDS(num); _w++) \
+	for (uint64_t _b = __atomic_load_n(&(map)[_w], __ATOMIC_ACQUIRE); \
+	     _b != 0 && ((idx) = 64 * _w + __builtin_ctzll(_b), 1); \
+	     _b &= _b - 1)
+
 #endif